@@ -0,0 +1,14 @@
+10 REM ONERR BENCHMARK - TRIGGERS AND HANDLES 1000000 ERRORS
+20 REM RUN IT UNDER THE SHELL TIME COMMAND WITH --NO-GRAPHICS
+30 REM CYCLES THROUGH A BAD SUBSCRIPT STORE, OUT OF DATA, A MISSING
+40 REM GOTO TARGET AND A BAD SUBSCRIPT READ INSIDE AN EXPRESSION
+50 DIM A(10): N = 0: K = 0
+60 ONERR GOTO 200
+70 K = K + 1: IF K > 4 THEN K = 1
+80 ON K GOTO 100, 110, 120, 130
+100 A(20) = 1
+110 READ X
+120 GOTO 9999
+130 X = A(20) + 1
+200 N = N + 1: IF N < 1000000 THEN 70
+210 PRINT N; " ERRORS HANDLED"
@@ -0,0 +1,117 @@
+/**
+ * @file parser_bench.cpp
+ * @brief Parser throughput benchmark
+ *
+ * Tokenizes every line of the given program files once, then parses them
+ * a number of times and prints the time per line. Lines that do not parse
+ * are left out. With --raw, constant folding and superinstructions are
+ * off, so only the parser itself is timed.
+ *
+ * Usage: msbasic_parser_bench [-n passes] [--raw] file.bas...
+ *
+ * The figures in docs/architecture.md are for tests/ and examples/.
+ */
+
+#include "ast_arena.h"
+#include "parser.h"
+#include "tokenizer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+/** @brief A program line as the loader keeps it before parsing */
+struct Line {
+  std::string text;
+  std::vector<Token> tokens;
+  std::vector<Value> constants;
+};
+
+/** @brief Tokenized code of each numbered line of a program file */
+void readLines(const char *file, std::vector<Line> &lines, size_t &skipped) {
+  std::ifstream in(file);
+  Tokenizer tokenizer;
+  std::string text;
+  while (std::getline(in, text)) {
+    if (!text.empty() && text.back() == '\r') {
+      text.pop_back();
+    }
+    size_t code = text.find_first_not_of("0123456789");
+    if (code == 0 || code == std::string::npos) {
+      continue;
+    }
+    code = text.find_first_not_of(' ', code);
+    if (code == std::string::npos) {
+      continue;
+    }
+    Line line;
+    line.text = text.substr(code);
+    try {
+      line.tokens = tokenizer.tokenize(line.text, line.constants);
+      AstArena arena;
+      Parser(arena).parse(line.tokens, line.text, line.constants);
+    } catch (const std::exception &) {
+      ++skipped;
+      continue;
+    }
+    lines.push_back(std::move(line));
+  }
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  int passes = 100;
+  bool raw = false;
+  std::vector<Line> lines;
+  size_t skipped = 0;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      passes = std::max(1, std::atoi(argv[++i]));
+    } else if (std::strcmp(argv[i], "--raw") == 0) {
+      raw = true;
+    } else {
+      readLines(argv[i], lines, skipped);
+    }
+  }
+  if (lines.empty()) {
+    std::fprintf(stderr, "usage: %s [-n passes] [--raw] file.bas...\n",
+                 argv[0]);
+    return 1;
+  }
+
+  // Best of five runs: a single run is easily disturbed by other processes
+  double best = 0;
+  size_t nodes = 0;
+  for (int run = 0; run < 5; ++run) {
+    AstArena arena;
+    Parser parser(arena);
+    parser.setConstantFolding(!raw);
+    parser.setSuperinstructions(!raw);
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+      for (const auto &line : lines) {
+        parser.parse(line.tokens, line.text, line.constants);
+      }
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (run == 0 || elapsed.count() < best) {
+      best = elapsed.count();
+    }
+    nodes = arena.nodeCount();
+  }
+
+  double total =
+      static_cast<double>(passes) * static_cast<double>(lines.size());
+  std::printf("%zu lines (%zu skipped), %d passes, best run %.3f s\n",
+              lines.size(), skipped, passes, best);
+  std::printf("%.0f ns/line, %.1f AST nodes/line\n", best * 1e9 / total,
+              static_cast<double>(nodes) / total);
+  return 0;
+}
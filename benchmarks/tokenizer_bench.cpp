@@ -0,0 +1,87 @@
+/**
+ * @file tokenizer_bench.cpp
+ * @brief Tokenizer throughput benchmark
+ *
+ * Tokenizes every line of the given program files a number of times and
+ * prints lines, tokens and megabytes per second. Lines are taken as they
+ * are stored after LOAD: the text after the line number.
+ *
+ * Usage: msbasic_tokenizer_bench [-n passes] file.bas...
+ *
+ * The figures in docs/architecture.md are for tests/ and examples/.
+ */
+
+#include "tokenizer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+/** @brief Code of each numbered line of a program file */
+void readLines(const char *file, std::vector<std::string> &lines) {
+  std::ifstream in(file);
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    size_t code = line.find_first_not_of("0123456789");
+    if (code == 0 || code == std::string::npos) {
+      continue;
+    }
+    code = line.find_first_not_of(' ', code);
+    if (code != std::string::npos) {
+      lines.push_back(line.substr(code));
+    }
+  }
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  int passes = 1000;
+  std::vector<std::string> lines;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      passes = std::max(1, std::atoi(argv[++i]));
+    } else {
+      readLines(argv[i], lines);
+    }
+  }
+  if (lines.empty()) {
+    std::fprintf(stderr, "usage: %s [-n passes] file.bas...\n", argv[0]);
+    return 1;
+  }
+
+  size_t bytes = 0;
+  for (const auto &line : lines) {
+    bytes += line.size();
+  }
+
+  Tokenizer tokenizer;
+  std::vector<Value> constants;
+  size_t tokens = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < passes; ++pass) {
+    for (const auto &line : lines) {
+      constants.clear();
+      tokens += tokenizer.tokenize(line, constants).size();
+    }
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  double seconds = elapsed.count();
+  double total = static_cast<double>(passes);
+  std::printf("%zu lines, %zu bytes, %d passes in %.3f s\n", lines.size(),
+              bytes, passes, seconds);
+  std::printf("%.0f lines/s, %.0f tokens/s, %.1f MB/s\n",
+              total * static_cast<double>(lines.size()) / seconds,
+              static_cast<double>(tokens) / seconds,
+              total * static_cast<double>(bytes) / seconds / 1e6);
+  return 0;
+}
@@ -0,0 +1,20 @@
+# Run msbasic with standard input read from a file (used by ctest)
+#
+# Usage:
+#   cmake -DMSBASIC=<exe> -DINPUT=<file> [-DARGS="<args>"] -P RunWithInput.cmake
+#
+# The interpreter's output is echoed for the test's PASS_REGULAR_EXPRESSION;
+# a nonzero exit status fails the test.
+
+separate_arguments(ARGS)
+execute_process(
+    COMMAND ${MSBASIC} ${ARGS}
+    INPUT_FILE ${INPUT}
+    OUTPUT_VARIABLE OUTPUT
+    ERROR_VARIABLE OUTPUT
+    RESULT_VARIABLE RESULT
+)
+message("${OUTPUT}")
+if(NOT RESULT EQUAL 0)
+    message(FATAL_ERROR "msbasic exited with status ${RESULT}")
+endif()
@@ -0,0 +1,398 @@
+/**
+ * @file applesoft_format.cpp
+ * @brief Reading and writing Applesoft tokenized programs
+ */
+
+#include "applesoft_format.h"
+#include "errors.h"
+#include "program.h"
+#include "tokenizer.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace {
+constexpr uint8_t kFirstToken = 0x80;
+constexpr uint8_t kDataToken = 0x83;
+constexpr uint8_t kRemToken = 0xB2;
+constexpr uint8_t kFnToken = 0xC2;
+
+/** @brief Spelling of each Applesoft token, from $80 */
+constexpr std::string_view kTokenNames[] = {
+    "END",    "FOR",    "NEXT",    "DATA",   "INPUT",  "DEL",    "DIM",
+    "READ",   "GR",     "TEXT",    "PR#",    "IN#",    "CALL",   "PLOT",
+    "HLIN",   "VLIN",   "HGR2",    "HGR",    "HCOLOR=", "HPLOT", "DRAW",
+    "XDRAW",  "HTAB",   "HOME",    "ROT=",   "SCALE=", "SHLOAD", "TRACE",
+    "NOTRACE", "NORMAL", "INVERSE", "FLASH", "COLOR=", "POP",    "VTAB",
+    "HIMEM:", "LOMEM:", "ONERR",   "RESUME", "RECALL", "STORE",  "SPEED=",
+    "LET",    "GOTO",   "RUN",     "IF",     "RESTORE", "&",     "GOSUB",
+    "RETURN", "REM",    "STOP",    "ON",     "WAIT",   "LOAD",   "SAVE",
+    "DEF",    "POKE",   "PRINT",   "CONT",   "LIST",   "CLEAR",  "GET",
+    "NEW",    "TAB(",   "TO",      "FN",     "SPC(",   "THEN",   "AT",
+    "NOT",    "STEP",   "+",       "-",      "*",      "/",      "^",
+    "AND",    "OR",     ">",       "=",      "<",      "SGN",    "INT",
+    "ABS",    "USR",    "FRE",     "SCRN(",  "PDL",    "POS",    "SQR",
+    "RND",    "LOG",    "EXP",     "COS",    "SIN",    "TAN",    "ATN",
+    "PEEK",   "LEN",    "STR$",    "VAL",    "ASC",    "CHR$",   "LEFT$",
+    "RIGHT$", "MID$"};
+
+constexpr size_t kTokenCount = std::size(kTokenNames);
+
+bool isWordChar(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '.' ||
+         c == '$' || c == '%';
+}
+
+uint16_t readWord(std::string_view data, size_t pos) {
+  return static_cast<uint16_t>(static_cast<uint8_t>(data[pos]) |
+                               static_cast<uint8_t>(data[pos + 1]) << 8);
+}
+
+/** @brief Token bytes with the tokens of their spelling, built once */
+struct DecodeTable {
+  struct Keyword {
+    std::string_view name;
+    std::vector<Token> tokens;
+    bool spliced; // false: operators, &, FN and REM join the ASCII around
+                  // them (the tokenizer skips a remark from its REM on)
+  };
+  std::array<Keyword, kTokenCount> keywords;
+
+  DecodeTable() {
+    Tokenizer tokenizer;
+    std::vector<Value> constants; // keywords have none
+    for (size_t i = 0; i < kTokenCount; ++i) {
+      std::string_view name = kTokenNames[i];
+      Keyword &keyword = keywords[i];
+      keyword.name = name;
+      keyword.spliced = std::isalpha(static_cast<unsigned char>(name[0])) &&
+                        i + kFirstToken != kFnToken &&
+                        i + kFirstToken != kRemToken;
+      if (keyword.spliced) {
+        keyword.tokens = tokenizer.tokenize(name, constants);
+      }
+    }
+  }
+};
+
+/** @brief Token bytes by spelling, for SAVE */
+struct EncodeTable {
+  struct Keyword {
+    uint8_t token;
+    char trailing; // '=', '#', ':' or '(' that is part of the token, or 0
+  };
+  std::unordered_map<std::string, Keyword> words;
+  std::array<uint8_t, 128> symbols{}; // operators and &; 0 if none
+
+  EncodeTable() {
+    for (size_t i = 0; i < kTokenCount; ++i) {
+      std::string_view name = kTokenNames[i];
+      auto token = static_cast<uint8_t>(kFirstToken + i);
+      if (!std::isalpha(static_cast<unsigned char>(name[0]))) {
+        symbols[static_cast<unsigned char>(name[0])] = token;
+      } else if (token != kFnToken) {
+        size_t length = name.find_first_of("=#:(");
+        char trailing = length == std::string_view::npos ? 0 : name[length];
+        words.emplace(std::string(name.substr(0, length)),
+                      Keyword{token, trailing});
+      }
+    }
+  }
+};
+
+const DecodeTable &decodeTable() {
+  static const DecodeTable table;
+  return table;
+}
+
+const EncodeTable &encodeTable() {
+  static const EncodeTable table;
+  return table;
+}
+
+/**
+ * @brief The line records of a file, without a DOS 3.3 length
+ *
+ * @return The records up to and including the zero link, or nothing if
+ *         the file is not an Applesoft program
+ */
+std::optional<std::string_view> programImage(std::string_view file) {
+  auto chain = [](std::string_view image) -> std::optional<std::string_view> {
+    std::optional<size_t> base;
+    size_t pos = 0;
+    while (pos + 2 <= image.size()) {
+      size_t link = readWord(image, pos);
+      if (link == 0) {
+        return pos == 0 ? std::nullopt
+                        : std::optional(image.substr(0, pos + 2));
+      }
+      size_t end = pos + 4 <= image.size() ? image.find('\0', pos + 4)
+                                           : std::string_view::npos;
+      if (end == std::string_view::npos) {
+        return std::nullopt;
+      }
+      size_t next = end + 1;
+      if (!base) {
+        if (link < next) {
+          return std::nullopt;
+        }
+        base = link - next;
+      } else if (link != *base + next) {
+        return std::nullopt;
+      }
+      pos = next;
+    }
+    return std::nullopt;
+  };
+  if (auto image = chain(file)) {
+    return image;
+  }
+  if (file.size() > 2 && readWord(file, 0) <= file.size() - 2) {
+    return chain(file.substr(2));
+  }
+  return std::nullopt;
+}
+
+/** @brief Append tokens of a piece of a line, placed at @p offset */
+void splice(std::vector<Token> &tokens, const std::vector<Token> &piece,
+            size_t offset) {
+  for (const Token &token : piece) {
+    // Runs of unknown characters make one token, as in Tokenizer
+    if (token.type == TokenType::NEWLINE && !tokens.empty() &&
+        tokens.back().type == TokenType::NEWLINE) {
+      continue;
+    }
+    tokens.push_back(token);
+    tokens.back().offset += static_cast<uint32_t>(offset);
+  }
+}
+
+/**
+ * @brief Decode the code bytes of one line record
+ *
+ * Keywords that start with a letter take their tokens from the table;
+ * the text between them (names, numbers, strings, operators) is collected
+ * and tokenized in one piece. Strings, REM and DATA are copied as they
+ * are, as Applesoft never tokenizes them.
+ */
+void decodeLine(std::string_view code, ProgramLine &line,
+                Tokenizer &tokenizer) {
+  const DecodeTable &table = decodeTable();
+  std::string &text = line.text;
+  size_t runStart = 0;
+  bool quoted = false;
+  bool rem = false;
+  bool data = false;
+  bool afterKeyword = false;
+
+  auto flushRun = [&]() {
+    if (runStart < text.size()) {
+      splice(line.tokens,
+             tokenizer.tokenize(std::string_view(text).substr(runStart),
+                                line.constants),
+             runStart);
+    }
+    runStart = text.size();
+  };
+  // A space keeps a keyword apart from a name or number next to it
+  auto separate = [&](char next, bool keyword) {
+    if ((keyword || afterKeyword) && !text.empty() &&
+        isWordChar(text.back()) && isWordChar(next)) {
+      text += ' ';
+    }
+  };
+
+  for (char c : code) {
+    auto byte = static_cast<uint8_t>(c);
+    if (byte < kFirstToken || quoted || rem || data) {
+      separate(c, false);
+      afterKeyword = false;
+      text += c;
+      if (c == '"') {
+        quoted = !quoted;
+      } else if (c == ':' && !quoted) {
+        data = false;
+      }
+      continue;
+    }
+    if (static_cast<size_t>(byte - kFirstToken) >= kTokenCount) {
+      throw RuntimeError(ErrorKind::Syntax);
+    }
+    const auto &keyword = table.keywords[byte - kFirstToken];
+    separate(keyword.name.front(), true);
+    if (keyword.spliced) {
+      flushRun();
+      splice(line.tokens, keyword.tokens, text.size());
+      text += keyword.name;
+      runStart = text.size();
+    } else {
+      text += keyword.name;
+    }
+    // FN is written against its name: FNA(X)
+    afterKeyword = keyword.spliced || byte == kRemToken;
+    rem = byte == kRemToken;
+    data = byte == kDataToken;
+  }
+  flushRun();
+}
+
+/** @brief End of the values of a DATA statement starting at @p pos */
+size_t dataEnd(std::string_view text, size_t pos) {
+  bool quoted = false;
+  for (; pos < text.size(); ++pos) {
+    if (text[pos] == '"') {
+      quoted = !quoted;
+    } else if (text[pos] == ':' && !quoted) {
+      break;
+    }
+  }
+  return pos;
+}
+
+/**
+ * @brief Append the code bytes of one line
+ *
+ * The line's tokens locate its keywords and operators in the text; the
+ * text between them is copied.
+ */
+void encodeLine(std::string_view text, const std::vector<Token> &tokens,
+                std::vector<uint8_t> &out) {
+  const EncodeTable &table = encodeTable();
+  size_t codeStart = out.size();
+  size_t pos = 0;
+  bool quoted = false;
+  bool space = false;
+
+  auto putToken = [&](uint8_t token) {
+    out.push_back(token);
+    space = false;
+  };
+  auto putText = [&](std::string_view bytes) {
+    out.insert(out.end(), bytes.begin(), bytes.end());
+  };
+  auto copyTo = [&](size_t end) {
+    for (; pos < end; ++pos) {
+      char c = text[pos];
+      if (!quoted && (c == ' ' || c == '\t')) {
+        space = true;
+        continue;
+      }
+      if (space && isWordChar(c) && out.size() > codeStart &&
+          out.back() < kFirstToken &&
+          isWordChar(static_cast<char>(out.back()))) {
+        out.push_back(' ');
+      }
+      space = false;
+      out.push_back(static_cast<uint8_t>(c));
+      if (c == '"') {
+        quoted = !quoted;
+      }
+    }
+  };
+
+  for (const Token &token : tokens) {
+    size_t start = token.offset;
+    if (start < pos || token.type == TokenType::STRING ||
+        token.type == TokenType::NUMBER) {
+      continue;
+    }
+    std::string_view spelling = token.text(text);
+    std::string word(spelling);
+    std::transform(word.begin(), word.end(), word.begin(), ::toupper);
+
+    if (token.type == TokenType::IDENTIFIER && word.size() > 2 &&
+        word.compare(0, 2, "FN") == 0) {
+      copyTo(start);
+      putToken(kFnToken);
+      pos = start + 2;
+      continue;
+    }
+    if (auto it = table.words.find(word); it != table.words.end()) {
+      size_t end = start + spelling.size();
+      if (it->second.trailing != 0) {
+        end = text.find_first_not_of(" \t", end);
+        if (end == std::string_view::npos ||
+            text[end] != it->second.trailing) {
+          continue;
+        }
+        ++end;
+      }
+      copyTo(start);
+      putToken(it->second.token);
+      pos = end;
+      if (it->second.token == kRemToken) {
+        putText(text.substr(pos));
+        pos = text.size();
+        break;
+      }
+      if (it->second.token == kDataToken) {
+        size_t valuesEnd = dataEnd(text, pos);
+        putText(text.substr(pos, valuesEnd - pos));
+        pos = valuesEnd;
+      }
+      continue;
+    }
+    if (token.type != TokenType::IDENTIFIER &&
+        std::all_of(spelling.begin(), spelling.end(), [&](char c) {
+          return static_cast<unsigned char>(c) < table.symbols.size() &&
+                 table.symbols[static_cast<unsigned char>(c)] != 0;
+        })) {
+      copyTo(start);
+      for (char c : spelling) {
+        putToken(table.symbols[static_cast<unsigned char>(c)]);
+      }
+      pos = start + spelling.size();
+    }
+  }
+  copyTo(text.size());
+}
+} // namespace
+
+bool isApplesoftProgram(std::string_view file) {
+  return programImage(file).has_value();
+}
+
+std::vector<ProgramLine> decodeApplesoftProgram(std::string_view file) {
+  std::string_view image = programImage(file).value_or(std::string_view());
+  std::vector<ProgramLine> lines;
+  Tokenizer tokenizer;
+  size_t pos = 0;
+  while (pos + 4 <= image.size()) {
+    size_t end = image.find('\0', pos + 4);
+    ProgramLine &line = lines.emplace_back();
+    line.lineNumber = readWord(image, pos + 2);
+    decodeLine(image.substr(pos + 4, end - pos - 4), line, tokenizer);
+    pos = end + 1;
+  }
+  return lines;
+}
+
+std::vector<uint8_t> encodeApplesoftProgram(const Program &program) {
+  std::vector<uint8_t> image;
+  Tokenizer tokenizer;
+  std::vector<Value> constants;
+  for (const auto &line : program) {
+    if (line.lineNumber > kApplesoftMaxLine) {
+      throw RuntimeError(ErrorKind::IllegalQuantity);
+    }
+    size_t record = image.size();
+    image.insert(image.end(), {0, 0,
+                               static_cast<uint8_t>(line.lineNumber & 0xFF),
+                               static_cast<uint8_t>(line.lineNumber >> 8)});
+    constants.clear();
+    encodeLine(line.text, tokenizer.tokenize(line.text, constants), image);
+    image.push_back(0);
+    size_t link = kApplesoftProgramStart + image.size();
+    if (link > 0xFFFF) {
+      throw RuntimeError(ErrorKind::OutOfMemory);
+    }
+    image[record] = static_cast<uint8_t>(link & 0xFF);
+    image[record + 1] = static_cast<uint8_t>(link >> 8);
+  }
+  image.insert(image.end(), {0, 0});
+  return image;
+}
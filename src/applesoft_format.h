@@ -0,0 +1,87 @@
+/**
+ * @file applesoft_format.h
+ * @brief Applesoft tokenized program files
+ *
+ * Besides plain text, LOAD, CHAIN and "-" read programs in the layout
+ * Applesoft keeps in memory and BASIC.SYSTEM writes to BAS files: a chain
+ * of line records starting at $801,
+ *
+ *   link (2 bytes), line number (2 bytes), code bytes, 0
+ *
+ * ended by a zero link, all little-endian. In the code, keywords and
+ * operators are single bytes $80-$EA; everything else is ASCII. DOS 3.3
+ * files, which start with a 2-byte program length, are read as well.
+ *
+ * Keyword bytes are mapped straight to the tokens the tokenizer would
+ * produce for their spelling, so only the ASCII stretches between them
+ * are tokenized. Each line's text is its listing, with a space between a
+ * keyword and an adjacent name or number, and its tokens are the same as
+ * those of that text: a program behaves the same whichever format it was
+ * loaded from.
+ *
+ * SAVE writes this format for programs loaded from it (or always, with
+ * --save-format applesoft). Keywords Applesoft does not have, and
+ * keywords not written the Applesoft way (CLR for CLEAR, SCALE without
+ * "="), are kept as ASCII, so such programs still load back unchanged
+ * here even though Applesoft itself cannot run them.
+ */
+
+#pragma once
+
+#include "types.h"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+class Program;
+
+/**
+ * @brief File format of a BASIC program
+ */
+enum class ProgramFormat {
+  Text,     ///< one "<line number> <code>" line per program line
+  Applesoft ///< Applesoft tokenized line records
+};
+
+/** @brief Address of the first line record in an Applesoft program */
+inline constexpr uint16_t kApplesoftProgramStart = 0x801;
+
+/** @brief Largest line number Applesoft accepts */
+inline constexpr LineNumber kApplesoftMaxLine = 63999;
+
+/**
+ * @brief Whether a file holds an Applesoft tokenized program
+ *
+ * True if the file (after an optional DOS 3.3 length) is a chain of well
+ * formed line records whose links agree with one start address. Text
+ * files never qualify: every record needs a 0 byte.
+ *
+ * @param file Whole file contents
+ */
+bool isApplesoftProgram(std::string_view file);
+
+/**
+ * @brief Decode an Applesoft tokenized program
+ *
+ * The returned lines have their number, text and tokens set; they still
+ * have to be parsed.
+ *
+ * @param file Whole file contents, for which isApplesoftProgram() holds
+ * @return Lines in file order
+ * @throws RuntimeError SYNTAX ERROR on a byte that is no Applesoft token
+ */
+std::vector<ProgramLine> decodeApplesoftProgram(std::string_view file);
+
+/**
+ * @brief Encode a program as Applesoft line records at $801
+ *
+ * Spaces outside strings, REM and DATA are dropped unless they separate
+ * two names or numbers, as Applesoft does when it tokenizes a line.
+ *
+ * @param program Program to encode
+ * @return File contents
+ * @throws RuntimeError OUT OF MEMORY ERROR if the program does not fit
+ *         below $10000, ILLEGAL QUANTITY ERROR if a line number is above
+ *         kApplesoftMaxLine (the record holds 16 bits)
+ */
+std::vector<uint8_t> encodeApplesoftProgram(const Program &program);
@@ -0,0 +1,33 @@
+/**
+ * @file ast_arena.cpp
+ * @brief Block management for the AST arena
+ */
+
+#include "ast_arena.h"
+#include <algorithm>
+#include <cstdint>
+
+AstArena::~AstArena() {
+  for (auto it = destructors_.rbegin(); it != destructors_.rend(); ++it) {
+    it->destroy(it->object);
+  }
+}
+
+void *AstArena::allocate(size_t size, size_t align) {
+  auto address = reinterpret_cast<uintptr_t>(cursor_);
+  size_t padding = (align - address % align) % align;
+  if (!cursor_ || padding + size > static_cast<size_t>(end_ - cursor_)) {
+    size_t blockSize = std::max(nextBlockSize_, size + align);
+    blocks_.push_back(std::make_unique<std::byte[]>(blockSize));
+    cursor_ = blocks_.back().get();
+    end_ = cursor_ + blockSize;
+    reserved_ += blockSize;
+    nextBlockSize_ = std::min(nextBlockSize_ * 2, kMaxBlockSize);
+    address = reinterpret_cast<uintptr_t>(cursor_);
+    padding = (align - address % align) % align;
+  }
+  std::byte *result = cursor_ + padding;
+  cursor_ = result + size;
+  used_ += size;
+  return result;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file ast_arena.h
+ * @brief Bump allocator that owns the AST nodes of a program
+ *
+ * Parsed Expression and Statement nodes are placed in an AstArena instead of
+ * being allocated one by one. Nodes refer to their children with plain
+ * pointers; the arena owns all of them and destroys them together, so
+ * loading a program costs a handful of block allocations and freeing it
+ * releases the whole tree at once.
+ *
+ * Ownership:
+ * - The Program image owns one arena for all loaded lines, plus one per
+ *   worker of a parallel LOAD. Replacing or deleting a loaded line leaves
+ *   the old nodes in place until the program is cleared (NEW, LOAD, CHAIN).
+ * - A line entered in the editor has its own small arena, held by its
+ *   ProgramLine, so editing the same lines over and over does not grow the
+ *   program's memory.
+ * - Each immediate-mode line is parsed into its own short-lived arena.
+ * - Code that must outlive the program it came from (a DEF FN body kept
+ *   across CHAIN) holds a shared_ptr to the arena rather than to the node.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @class AstArena
+ * @brief Owns AST nodes allocated from large contiguous blocks
+ *
+ * Blocks start small, so a one-line immediate arena stays cheap, and grow
+ * geometrically up to kMaxBlockSize for whole programs. Nodes are destroyed
+ * in reverse order of construction when the arena is destroyed.
+ *
+ * Arenas are always created with std::make_shared, so a node that hands
+ * itself to longer-lived state (DEF FN, WHILE frames) can pin its arena with
+ * shared_from_this().
+ */
+class AstArena : public std::enable_shared_from_this<AstArena> {
+public:
+  /** @brief Size of the first block */
+  static constexpr size_t kMinBlockSize = 1024;
+  /** @brief Largest block size reached by geometric growth */
+  static constexpr size_t kMaxBlockSize = 64 * 1024;
+
+  AstArena() = default;
+  ~AstArena();
+  AstArena(const AstArena &) = delete;
+  AstArena &operator=(const AstArena &) = delete;
+
+  /**
+   * @brief Construct a node in the arena
+   * @return Pointer owned by the arena (valid until it is destroyed)
+   */
+  template <typename T, typename... Args> T *make(Args &&...args) {
+    void *memory = allocate(sizeof(T), alignof(T));
+    T *node = new (memory) T(std::forward<Args>(args)...);
+    ++nodes_;
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      destructors_.push_back(
+          Destructor{node, [](void *p) { static_cast<T *>(p)->~T(); }});
+    }
+    return node;
+  }
+
+  /** @brief Bytes handed out to nodes */
+  size_t bytesUsed() const { return used_; }
+
+  /** @brief Bytes reserved in blocks */
+  size_t bytesReserved() const { return reserved_; }
+
+  /** @brief Number of blocks allocated */
+  size_t blockCount() const { return blocks_.size(); }
+
+  /** @brief Number of nodes constructed */
+  size_t nodeCount() const { return nodes_; }
+
+private:
+  /** @brief Reserve aligned storage, starting a new block when needed */
+  void *allocate(size_t size, size_t align);
+
+  struct Destructor {
+    void *object;
+    void (*destroy)(void *);
+  };
+
+  std::vector<std::unique_ptr<std::byte[]>> blocks_;
+  std::vector<Destructor> destructors_;
+  std::byte *cursor_ = nullptr;
+  std::byte *end_ = nullptr;
+  size_t nextBlockSize_ = kMinBlockSize;
+  size_t used_ = 0;
+  size_t reserved_ = 0;
+  size_t nodes_ = 0;
+};
@@ -0,0 +1,261 @@
+/**
+ * @file bytecode.cpp
+ * @brief Bytecode compiler helpers and the VM dispatch loop
+ *
+ * The compiler side is deliberately thin: AST node classes in parser.cpp know
+ * how to lower themselves through their compile() hooks, and this file only
+ * provides the emit/pool helpers, the default (fallback) hooks and the
+ * per-line entry point.
+ *
+ * The VM keeps its operand stack in a thread-local vector that is reused
+ * across lines, so executing a compiled line does not allocate unless a
+ * string value is produced. Nested runs (CHAIN or RUN executed from inside a
+ * program) stack their frames on top of the current one.
+ */
+
+#include "bytecode.h"
+#include "functions.h"
+#include "interpreter.h"
+#include "parser.h"
+
+namespace bytecode {
+
+size_t Compiler::emit(OpCode op, int32_t operand, uint16_t count,
+                      uint8_t flags) {
+  chunk_.code.push_back(Instruction{op, flags, count, operand});
+  return chunk_.code.size() - 1;
+}
+
+void Compiler::patchJump(size_t at) {
+  chunk_.code[at].operand = static_cast<int32_t>(chunk_.code.size());
+}
+
+int32_t Compiler::addConstant(const Value &value) {
+  chunk_.constants.push_back(value);
+  return static_cast<int32_t>(chunk_.constants.size() - 1);
+}
+
+int32_t Compiler::addLineRef(LineRef &ref) {
+  chunk_.lineRefs.push_back(&ref);
+  return static_cast<int32_t>(chunk_.lineRefs.size() - 1);
+}
+
+void Compiler::compileExpression(Expression &expr) { expr.compile(*this); }
+
+void Compiler::compileStatement(Statement &stmt) { stmt.compile(*this); }
+
+void Compiler::emitStatementFallback(Statement *stmt) {
+  chunk_.statements.push_back(stmt);
+  emit(OpCode::ExecStatement,
+       static_cast<int32_t>(chunk_.statements.size() - 1));
+}
+
+void Compiler::emitExpressionFallback(Expression *expr) {
+  chunk_.expressions.push_back(expr);
+  emit(OpCode::EvalExpression,
+       static_cast<int32_t>(chunk_.expressions.size() - 1));
+}
+
+std::shared_ptr<Chunk> compileLine(const std::vector<Statement *> &statements) {
+  auto chunk = std::make_shared<Chunk>();
+  Compiler compiler(*chunk);
+  for (const auto &stmt : statements) {
+    chunk->statementStarts.push_back(
+        static_cast<uint32_t>(chunk->code.size()));
+    compiler.compileStatement(*stmt);
+    compiler.emit(OpCode::StatementEnd);
+  }
+  return chunk;
+}
+
+namespace {
+/**
+ * @brief Restores the shared VM stack to its entry depth on scope exit
+ *
+ * Keeps the stack balanced when a runtime error unwinds out of the dispatch
+ * loop, so an ONERR handler continues with a clean frame.
+ */
+class StackFrame {
+public:
+  explicit StackFrame(std::vector<Value> &stack)
+      : stack_(stack), base_(stack.size()) {}
+  ~StackFrame() { stack_.resize(base_); }
+  StackFrame(const StackFrame &) = delete;
+  StackFrame &operator=(const StackFrame &) = delete;
+
+private:
+  std::vector<Value> &stack_;
+  size_t base_;
+};
+
+/**
+ * @brief Convert the top @p count stack values to integer subscripts
+ */
+void popSubscripts(std::vector<Value> &stack, size_t count,
+                   std::vector<int> &out) {
+  out.resize(count);
+  size_t first = stack.size() - count;
+  for (size_t i = 0; i < count; ++i) {
+    out[i] = static_cast<int>(stack[first + i].getNumber());
+  }
+  stack.resize(first);
+}
+
+Value pop(std::vector<Value> &stack) {
+  Value v = std::move(stack.back());
+  stack.pop_back();
+  return v;
+}
+} // namespace
+
+void execute(const Chunk &chunk, Interpreter *interp, size_t firstStatement) {
+  if (firstStatement >= chunk.statementStarts.size()) {
+    return;
+  }
+  thread_local std::vector<Value> stack;
+  StackFrame frame(stack);
+  Variables &vars = interp->getVariables();
+  std::vector<int> subscripts;
+
+  const Instruction *code = chunk.code.data();
+  const size_t size = chunk.code.size();
+  size_t pc = chunk.statementStarts[firstStatement];
+
+  while (pc < size) {
+    const Instruction &ins = code[pc++];
+    switch (ins.op) {
+    case OpCode::PushConstant:
+      stack.push_back(chunk.constants[static_cast<size_t>(ins.operand)]);
+      break;
+    case OpCode::LoadVariable:
+      stack.push_back(vars.getVariable(static_cast<SymbolId>(ins.operand)));
+      break;
+    case OpCode::LoadArray:
+      popSubscripts(stack, ins.count, subscripts);
+      stack.emplace_back();
+      if (!vars.readArrayElement(static_cast<SymbolId>(ins.operand),
+                                 subscripts.data(), ins.count,
+                                 stack.back())) {
+        interp->raise(ErrorKind::BadSubscript);
+        return;
+      }
+      break;
+    case OpCode::Negate:
+      stack.back() = Value(-stack.back().getNumber());
+      break;
+    case OpCode::LogicalNot:
+      stack.back() = Value(stack.back().getNumber() == 0.0 ? 1.0 : 0.0);
+      break;
+    case OpCode::BinaryOp: {
+      Value rhs = pop(stack);
+      stack.back() = applyBinaryOperator(static_cast<TokenType>(ins.operand),
+                                         stack.back(), rhs);
+      break;
+    }
+    case OpCode::CallBuiltin: {
+      size_t first = stack.size() - ins.count;
+      Value result = callBuiltinFunction(static_cast<TokenType>(ins.operand),
+                                         stack.data() + first);
+      stack.resize(first);
+      stack.push_back(std::move(result));
+      break;
+    }
+    case OpCode::EvalExpression:
+      stack.push_back(
+          chunk.expressions[static_cast<size_t>(ins.operand)]->evaluate(
+              interp));
+      break;
+
+    case OpCode::StoreVariable:
+      vars.setVariable(static_cast<SymbolId>(ins.operand), stack.back());
+      stack.pop_back();
+      break;
+    case OpCode::StoreArray: {
+      Value value = pop(stack);
+      popSubscripts(stack, ins.count, subscripts);
+      if (!vars.writeArrayElement(static_cast<SymbolId>(ins.operand),
+                                  subscripts.data(), ins.count, value)) {
+        interp->raise(ErrorKind::BadSubscript);
+        return;
+      }
+      break;
+    }
+    case OpCode::PrintValue:
+      interp->printValue(stack.back());
+      stack.pop_back();
+      break;
+    case OpCode::PrintZone:
+      interp->printToNextZone();
+      break;
+    case OpCode::PrintNewline:
+      interp->printNewline();
+      break;
+    case OpCode::Goto:
+      interp->gotoLine(*chunk.lineRefs[static_cast<size_t>(ins.operand)]);
+      break;
+    case OpCode::Gosub:
+      interp->gosub(*chunk.lineRefs[static_cast<size_t>(ins.operand)]);
+      break;
+    case OpCode::Return:
+      interp->returnFromGosub();
+      break;
+    case OpCode::ForLoop: {
+      double step = ins.flags ? pop(stack).getNumber() : 1.0;
+      double limit = pop(stack).getNumber();
+      double start = pop(stack).getNumber();
+      SymbolId var = static_cast<SymbolId>(ins.operand);
+      vars.setVariable(var, Value(start));
+      interp->pushForLoop(var, limit, step);
+      break;
+    }
+    case OpCode::NextLoop:
+      // A repeating loop (or an error) ends the line like a jump
+      if (!interp->nextForLoop(static_cast<SymbolId>(ins.operand))) {
+        return;
+      }
+      break;
+    case OpCode::End:
+      interp->endProgram();
+      break;
+    case OpCode::ExecStatement:
+      chunk.statements[static_cast<size_t>(ins.operand)]->execute(interp);
+      if (interp->errorPending()) {
+        return;
+      }
+      break;
+
+    case OpCode::Jump:
+      pc = static_cast<size_t>(ins.operand);
+      break;
+    case OpCode::JumpIfFalse: {
+      bool truthy = stack.back().getNumber() != 0;
+      stack.pop_back();
+      if (!truthy) {
+        pc = static_cast<size_t>(ins.operand);
+      }
+      break;
+    }
+    case OpCode::StatementEnd:
+      if (!interp->finishStatement()) {
+        return;
+      }
+      break;
+    }
+  }
+}
+
+} // namespace bytecode
+
+/**
+ * @brief Default expression lowering: call back into the tree walker
+ */
+void Expression::compile(bytecode::Compiler &compiler) {
+  compiler.emitExpressionFallback(this);
+}
+
+/**
+ * @brief Default statement lowering: call back into the tree walker
+ */
+void Statement::compile(bytecode::Compiler &compiler) {
+  compiler.emitStatementFallback(this);
+}
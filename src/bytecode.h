@@ -0,0 +1,173 @@
+/**
+ * @file bytecode.h
+ * @brief Compact bytecode representation and dispatch-loop VM for program lines
+ *
+ * The bytecode engine is an optional alternative to the AST tree walker. Each
+ * ProgramLine's statement list is compiled once (lazily, on first execution)
+ * into a flat array of fixed-size instructions that operate on a small value
+ * stack. The interpreter then runs a line by executing that array from a
+ * single dispatch loop instead of issuing one virtual execute()/evaluate()
+ * call per AST node.
+ *
+ * Compilation model:
+ * - Statement::compile() and Expression::compile() emit instructions through
+ *   a Compiler. AST node classes override these hooks for the hot statement
+ *   and expression shapes (assignment, PRINT, IF, GOTO/GOSUB, arithmetic,
+ *   variables, arrays, built-in calls).
+ * - Nodes without an override fall back to ExecStatement / EvalExpression
+ *   instructions that call back into the tree walker, so every program runs
+ *   under the VM even when only part of it is compiled.
+ * - IF/THEN/ELSE becomes conditional jumps inside the line's code.
+ *
+ * Runtime semantics (errors, Float40 rounding, control flow flags) are shared
+ * with the tree walker through the Interpreter, Variables and the operator
+ * helpers in functions.h, so both engines produce identical output.
+ */
+
+#pragma once
+
+#include "types.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Expression;
+class Statement;
+class Interpreter;
+struct LineRef;
+
+namespace bytecode {
+
+/**
+ * @brief Instruction opcodes understood by the VM
+ */
+enum class OpCode : uint8_t {
+  // Expression ops (push results on the value stack)
+  PushConstant,   ///< Push constants[operand]
+  LoadVariable,   ///< Push simple variable in symbol slot operand
+  LoadArray,      ///< Pop count subscripts, push element of array in slot operand
+  Negate,         ///< Replace top with its numeric negation
+  LogicalNot,     ///< Replace top with 1 if it is zero, else 0
+  BinaryOp,       ///< Pop rhs, lhs; push applyBinaryOperator(operand, ...)
+  CallBuiltin,    ///< Pop count args; push callBuiltinFunction(operand, ...)
+  EvalExpression, ///< Push expressions[operand]->evaluate() (fallback)
+
+  // Statement ops
+  StoreVariable,  ///< Pop value into simple variable in symbol slot operand
+  StoreArray,     ///< Pop value, then count subscripts; store into slot operand
+  PrintValue,     ///< Pop value and print it
+  PrintZone,      ///< Advance to the next 14-column print zone
+  PrintNewline,   ///< Print a newline
+  Goto,           ///< Jump to line lineRefs[operand]
+  Gosub,          ///< Call subroutine at line lineRefs[operand]
+  Return,         ///< Return from GOSUB
+  ForLoop,        ///< Pop step (if flags), limit, start; FOR on slot operand
+  NextLoop,       ///< NEXT for variable slot operand (kNoSymbol for bare NEXT)
+  End,            ///< END
+  ExecStatement,  ///< statements[operand]->execute() (fallback)
+
+  // Line-local control flow
+  Jump,           ///< Continue at instruction operand
+  JumpIfFalse,    ///< Pop condition; continue at operand when it is zero
+  StatementEnd    ///< Top-level statement boundary (jump/stop check, SPEED)
+};
+
+/**
+ * @brief One fixed-size VM instruction
+ *
+ * The meaning of @c operand depends on the opcode (constant/node pool
+ * index, symbol slot, jump target or token type). @c count carries
+ * subscript and argument counts; @c flags carries per-op modifiers.
+ */
+struct Instruction {
+  OpCode op;
+  uint8_t flags;
+  uint16_t count;
+  int32_t operand;
+};
+
+/**
+ * @brief Compiled code for one program line
+ *
+ * Pools hold the data referenced by instruction operands. Fallback node and
+ * line reference pointers are non-owning: the chunk is stored next to the
+ * statements it was compiled from and never outlives them.
+ */
+struct Chunk {
+  std::vector<Instruction> code;
+  std::vector<Value> constants;
+  std::vector<Statement *> statements;
+  std::vector<Expression *> expressions;
+  std::vector<LineRef *> lineRefs;
+  /** @brief Code offset of each top-level statement (mid-line resume) */
+  std::vector<uint32_t> statementStarts;
+};
+
+/**
+ * @class Compiler
+ * @brief Emits instructions for AST nodes into a Chunk
+ *
+ * Statement::compile() and Expression::compile() overrides use the emit
+ * helpers; the default hooks use emitStatementFallback() and
+ * emitExpressionFallback().
+ */
+class Compiler {
+public:
+  explicit Compiler(Chunk &chunk) : chunk_(chunk) {}
+
+  /** @brief Append an instruction and return its index */
+  size_t emit(OpCode op, int32_t operand = 0, uint16_t count = 0,
+              uint8_t flags = 0);
+
+  /** @brief Point the jump at @p at to the next instruction to be emitted */
+  void patchJump(size_t at);
+
+  /** @brief Add a constant to the pool and return its index */
+  int32_t addConstant(const Value &value);
+
+  /** @brief Register a statement's jump target and return its index */
+  int32_t addLineRef(LineRef &ref);
+
+  /** @brief Compile a child expression (dispatches to its compile hook) */
+  void compileExpression(Expression &expr);
+
+  /** @brief Compile a nested statement (dispatches to its compile hook) */
+  void compileStatement(Statement &stmt);
+
+  /** @brief Emit a call back into the tree walker for @p stmt */
+  void emitStatementFallback(Statement *stmt);
+
+  /** @brief Emit a call back into the tree walker for @p expr */
+  void emitExpressionFallback(Expression *expr);
+
+private:
+  Chunk &chunk_;
+};
+
+/**
+ * @brief Compile a line's top-level statements into a chunk
+ *
+ * A StatementEnd instruction follows every top-level statement so the VM
+ * honours the same jump/stop/SPEED checks as the tree walker.
+ *
+ * @param statements Parsed statements of one program line
+ * @return Newly compiled chunk
+ */
+std::shared_ptr<Chunk> compileLine(const std::vector<Statement *> &statements);
+
+/**
+ * @brief Execute a compiled line
+ *
+ * Runs the chunk's instructions from one dispatch loop. Returns when the line
+ * is finished, when a statement transferred control (GOTO, RETURN, NEXT...)
+ * or when the program stopped. Runtime errors propagate as exceptions exactly
+ * as in the tree walker.
+ *
+ * @param chunk Compiled line
+ * @param interp Interpreter providing variables, I/O and control flow
+ * @param firstStatement Index of the top-level statement to start at
+ */
+void execute(const Chunk &chunk, Interpreter *interp, size_t firstStatement);
+
+} // namespace bytecode
@@ -0,0 +1,80 @@
+/**
+ * @file errors.cpp
+ * @brief Message and Applesoft number tables for runtime error codes
+ */
+
+#include "errors.h"
+
+const char *errorMessage(ErrorKind kind) {
+  switch (kind) {
+  case ErrorKind::None:
+    return "";
+  case ErrorKind::Syntax:
+    return "SYNTAX ERROR";
+  case ErrorKind::UndefinedStatement:
+    return "UNDEF'D STATEMENT ERROR";
+  case ErrorKind::ReturnWithoutGosub:
+    return "RETURN WITHOUT GOSUB ERROR";
+  case ErrorKind::PopWithoutGosub:
+    return "POP WITHOUT GOSUB ERROR";
+  case ErrorKind::NextWithoutFor:
+    return "NEXT WITHOUT FOR ERROR";
+  case ErrorKind::WendWithoutWhile:
+    return "WEND WITHOUT WHILE ERROR";
+  case ErrorKind::ResumeWithoutError:
+    return "RESUME WITHOUT ERROR";
+  case ErrorKind::OutOfData:
+    return "OUT OF DATA ERROR";
+  case ErrorKind::OutOfMemory:
+    return "OUT OF MEMORY ERROR";
+  case ErrorKind::BadSubscript:
+    return "BAD SUBSCRIPT ERROR";
+  case ErrorKind::UndefinedArray:
+    return "UNDEFINED ARRAY ERROR";
+  case ErrorKind::UndefinedFunction:
+    return "UNDEFINED FUNCTION ERROR";
+  case ErrorKind::DivisionByZero:
+    return "DIVISION BY ZERO ERROR";
+  case ErrorKind::IllegalQuantity:
+    return "ILLEGAL QUANTITY ERROR";
+  case ErrorKind::CantContinue:
+    return "CANT CONTINUE";
+  case ErrorKind::Other:
+    break;
+  }
+  return "ERROR";
+}
+
+uint8_t errorCode(ErrorKind kind) {
+  switch (kind) {
+  case ErrorKind::NextWithoutFor:
+  case ErrorKind::WendWithoutWhile:
+    return 0;
+  case ErrorKind::ReturnWithoutGosub:
+  case ErrorKind::PopWithoutGosub:
+    return 22;
+  case ErrorKind::OutOfData:
+    return 42;
+  case ErrorKind::IllegalQuantity:
+    return 53;
+  case ErrorKind::OutOfMemory:
+    return 77;
+  case ErrorKind::UndefinedStatement:
+    return 90;
+  case ErrorKind::BadSubscript:
+  case ErrorKind::UndefinedArray:
+    return 107;
+  case ErrorKind::DivisionByZero:
+    return 133;
+  case ErrorKind::CantContinue:
+    return 214;
+  case ErrorKind::UndefinedFunction:
+    return 224;
+  case ErrorKind::None:
+  case ErrorKind::Syntax:
+  case ErrorKind::ResumeWithoutError:
+  case ErrorKind::Other:
+    break;
+  }
+  return 16;
+}
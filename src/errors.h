@@ -0,0 +1,101 @@
+/**
+ * @file errors.h
+ * @brief Runtime error codes and the lightweight error exception
+ *
+ * Runtime errors are identified by an ErrorKind code. The message text is
+ * looked up only when an error is actually printed, so programs that use
+ * ONERR GOTO as control flow never build error strings.
+ *
+ * Errors travel in one of two ways:
+ * - Statement-level errors (GOTO to a missing line, RETURN without GOSUB,
+ *   NEXT without FOR, OUT OF DATA, array stores out of bounds, ...) are
+ *   raised with Interpreter::raise(). The statement returns normally and the
+ *   run loop dispatches the pending error to the ONERR handler, without any
+ *   stack unwinding.
+ * - Errors detected deep inside expression evaluation throw RuntimeError,
+ *   which carries only the code (no allocated message).
+ *
+ * Other exceptions (std::runtime_error with free text) remain for file,
+ * tape and host failures.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <exception>
+
+/**
+ * @brief Runtime error codes
+ *
+ * Each code maps to the exact message the interpreter prints for it and
+ * to the Applesoft error number an ONERR handler reads with PEEK(222)
+ * (see errorCode()).
+ */
+enum class ErrorKind : uint8_t {
+  None,               ///< No error
+  Syntax,             ///< SYNTAX ERROR
+  UndefinedStatement, ///< UNDEF'D STATEMENT ERROR
+  ReturnWithoutGosub, ///< RETURN WITHOUT GOSUB ERROR
+  PopWithoutGosub,    ///< POP WITHOUT GOSUB ERROR
+  NextWithoutFor,     ///< NEXT WITHOUT FOR ERROR
+  WendWithoutWhile,   ///< WEND WITHOUT WHILE ERROR
+  ResumeWithoutError, ///< RESUME WITHOUT ERROR
+  OutOfData,          ///< OUT OF DATA ERROR
+  OutOfMemory,        ///< OUT OF MEMORY ERROR (control stack full)
+  BadSubscript,       ///< BAD SUBSCRIPT ERROR
+  UndefinedArray,     ///< UNDEFINED ARRAY ERROR
+  UndefinedFunction,  ///< UNDEFINED FUNCTION ERROR
+  DivisionByZero,     ///< DIVISION BY ZERO ERROR
+  IllegalQuantity,    ///< ILLEGAL QUANTITY ERROR
+  CantContinue,       ///< CANT CONTINUE
+  Other               ///< Host exception; its text is in the exception
+};
+
+/**
+ * @brief Message printed for an error code (static storage)
+ */
+const char *errorMessage(ErrorKind kind);
+
+/**
+ * @brief Applesoft error number of an error code (stored at 222 by ONERR)
+ *
+ * 0 NEXT WITHOUT FOR, 16 SYNTAX, 22 RETURN WITHOUT GOSUB, 42 OUT OF DATA,
+ * 53 ILLEGAL QUANTITY, 77 OUT OF MEMORY, 90 UNDEF'D STATEMENT, 107 BAD
+ * SUBSCRIPT, 133 DIVISION BY ZERO, 214 CAN'T CONTINUE, 224 UNDEF'D
+ * FUNCTION. Errors Applesoft does not
+ * have take the number of the nearest one (POP WITHOUT GOSUB 22, WEND
+ * WITHOUT WHILE 0, UNDEFINED ARRAY 107); RESUME WITHOUT ERROR and host
+ * failures are 16.
+ */
+uint8_t errorCode(ErrorKind kind);
+
+/**
+ * @class RuntimeError
+ * @brief Exception carrying an ErrorKind
+ *
+ * what() returns the static message of the code, so throwing does not
+ * allocate a string.
+ */
+class RuntimeError : public std::exception {
+public:
+  explicit RuntimeError(ErrorKind kind) : kind_(kind) {}
+
+  const char *what() const noexcept override { return errorMessage(kind_); }
+
+  /** @brief Error code */
+  ErrorKind kind() const { return kind_; }
+
+private:
+  ErrorKind kind_;
+};
+
+/**
+ * @brief Error code of a caught exception (Other unless it is a
+ *        RuntimeError)
+ */
+inline ErrorKind errorKindOf(const std::exception &e) {
+  if (auto *error = dynamic_cast<const RuntimeError *>(&e)) {
+    return error->kind();
+  }
+  return ErrorKind::Other;
+}
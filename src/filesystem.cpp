@@ -33,7 +33,10 @@
 #define getcwd _getcwd
 #define chdir _chdir
 #else
+#include <cerrno>
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #endif
@@ -133,6 +136,65 @@ std::string readTextFile(const std::string &filename) {
   return buffer.str();
 }
 
+/**
+ * @brief Map a file into memory, or read it if it cannot be mapped
+ *
+ * Used by LOAD and CHAIN, so that program text goes from the page cache
+ * to the tokenizer without being copied into a string first. Files that
+ * cannot be mapped (pipes, process substitution, character devices) are
+ * read to the end into an internal buffer.
+ *
+ * @param filename Path to file
+ * @throws std::runtime_error with "PATH NOT FOUND ERROR" if the file cannot
+ * be opened
+ */
+MappedFile::MappedFile(const std::string &filename) {
+#ifdef PLATFORM_WINDOWS
+  std::ifstream file(filename, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("PATH NOT FOUND ERROR");
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  buffer_ = buffer.str();
+#else
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("PATH NOT FOUND ERROR");
+  }
+  struct stat info;
+  if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+    size_t size = static_cast<size_t>(info.st_size);
+    void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map != MAP_FAILED) {
+      close(fd);
+      data_ = std::string_view(static_cast<const char *>(map), size);
+      mapped_ = true;
+      return;
+    }
+  }
+  char chunk[64 * 1024];
+  for (;;) {
+    ssize_t n = read(fd, chunk, sizeof(chunk));
+    if (n > 0) {
+      buffer_.append(chunk, static_cast<size_t>(n));
+    } else if (n == 0 || errno != EINTR) {
+      break;
+    }
+  }
+  close(fd);
+#endif
+  data_ = buffer_;
+}
+
+MappedFile::~MappedFile() {
+#ifndef PLATFORM_WINDOWS
+  if (mapped_) {
+    munmap(const_cast<char *>(data_.data()), data_.size());
+  }
+#endif
+}
+
 /**
  * @brief Write an entire text file from a string
  *
@@ -33,6 +33,7 @@
 
 // File system operations for DOS/ProDOS compatibility
 #include <string>
+#include <string_view>
 #include <vector>
 #include <fstream>
 #include <map>
@@ -105,6 +106,37 @@ bool fileExists(const std::string& filename);
  */
 std::string readTextFile(const std::string& filename);
 
+/**
+ * @class MappedFile
+ * @brief Read-only view of a whole file without copying it
+ *
+ * Regular files are memory-mapped. Pipes and devices (and platforms
+ * without mmap) are read into a buffer owned by the object instead. The
+ * view stays valid for the lifetime of the object.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Map or read a file
+     * @param filename File path
+     * @throws std::runtime_error "PATH NOT FOUND ERROR" if the file cannot
+     *         be opened
+     */
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /** @brief Whole file contents */
+    std::string_view data() const { return data_; }
+
+private:
+    std::string_view data_;
+    std::string buffer_; ///< Contents when the file is not mapped
+    bool mapped_ = false;
+};
+
 /**
  * @brief Write string to text file
  * @param filename File path
@@ -22,6 +22,7 @@
  */
 
 #include "float40.h"
+#include "errors.h"
 #include <cmath>
 #include <iomanip>
 #include <random>
@@ -109,7 +110,7 @@ Float40 Float40::operator*(const Float40 &other) const {
 
 Float40 Float40::operator/(const Float40 &other) const {
   if (other.value_ == 0.0) {
-    throw std::runtime_error("DIVISION BY ZERO ERROR");
+    throw RuntimeError(ErrorKind::DivisionByZero);
   }
   return Float40(value_ / other.value_);
 }
@@ -172,14 +173,14 @@ Float40 Float40::exp() const { return Float40(std::exp(value_)); }
 
 Float40 Float40::log() const {
   if (value_ <= 0) {
-    throw std::runtime_error("ILLEGAL QUANTITY ERROR");
+    throw RuntimeError(ErrorKind::IllegalQuantity);
   }
   return Float40(std::log(value_));
 }
 
 Float40 Float40::sqr() const {
   if (value_ < 0) {
-    throw std::runtime_error("ILLEGAL QUANTITY ERROR");
+    throw RuntimeError(ErrorKind::IllegalQuantity);
   }
   return Float40(std::sqrt(value_));
 }
@@ -42,6 +42,7 @@
  */
 
 #include "functions.h"
+#include "errors.h"
 #include "float40.h"
 #include "graphics.h"
 #include <cmath>
@@ -57,6 +58,20 @@
 #include <unordered_map>
 
 namespace {
+/**
+ * @brief Characters of a string-function argument without copying
+ *
+ * String values are viewed in place; numbers are formatted into @p scratch
+ * (the view then refers to it).
+ */
+std::string_view textOf(const Value &value, std::string &scratch) {
+  if (value.isString()) {
+    return value.stringView();
+  }
+  scratch = value.getString();
+  return scratch;
+}
+
 /**
  * @brief Get the singleton memory map
  * 
@@ -403,8 +418,7 @@ void setMemoryBounds(int lomem, int himem) {
  * @return Sine of arg
  */
 Value funcSin(const Value &arg) {
-  Float40 f(arg.getNumber());
-  return Value(f.sin().toDouble());
+  return Value(callMathFunction(TokenType::SIN, arg.getNumber()));
 }
 
 /**
@@ -416,8 +430,7 @@ Value funcSin(const Value &arg) {
  * @return Cosine of arg
  */
 Value funcCos(const Value &arg) {
-  Float40 f(arg.getNumber());
-  return Value(f.cos().toDouble());
+  return Value(callMathFunction(TokenType::COS, arg.getNumber()));
 }
 
 /**
@@ -429,8 +442,7 @@ Value funcCos(const Value &arg) {
  * @return Tangent of arg
  */
 Value funcTan(const Value &arg) {
-  Float40 f(arg.getNumber());
-  return Value(f.tan().toDouble());
+  return Value(callMathFunction(TokenType::TAN, arg.getNumber()));
 }
 
 /**
@@ -443,8 +455,7 @@ Value funcTan(const Value &arg) {
  * @return Arctangent of arg in radians
  */
 Value funcAtn(const Value &arg) {
-  Float40 f(arg.getNumber());
-  return Value(f.atn().toDouble());
+  return Value(callMathFunction(TokenType::ATN, arg.getNumber()));
 }
 
 /**
@@ -456,8 +467,7 @@ Value funcAtn(const Value &arg) {
  * @return e raised to the power of arg
  */
 Value funcExp(const Value &arg) {
-  Float40 f(arg.getNumber());
-  return Value(f.exp().toDouble());
+  return Value(callMathFunction(TokenType::EXP, arg.getNumber()));
 }
 
 /**
@@ -471,8 +481,7 @@ Value funcExp(const Value &arg) {
  * @throws RuntimeError if arg <= 0
  */
 Value funcLog(const Value &arg) {
-  Float40 f(arg.getNumber());
-  return Value(f.log().toDouble());
+  return Value(callMathFunction(TokenType::LOG, arg.getNumber()));
 }
 
 /**
@@ -486,8 +495,7 @@ Value funcLog(const Value &arg) {
  * @throws RuntimeError if arg < 0
  */
 Value funcSqr(const Value &arg) {
-  Float40 f(arg.getNumber());
-  return Value(f.sqr().toDouble());
+  return Value(callMathFunction(TokenType::SQR, arg.getNumber()));
 }
 
 /**
@@ -499,8 +507,7 @@ Value funcSqr(const Value &arg) {
  * @return |arg| (always non-negative)
  */
 Value funcAbs(const Value &arg) {
-  Float40 f(arg.getNumber());
-  return Value(f.abs().toDouble());
+  return Value(callMathFunction(TokenType::ABS, arg.getNumber()));
 }
 
 /**
@@ -518,8 +525,7 @@ Value funcAbs(const Value &arg) {
  * @return Largest integer <= arg
  */
 Value funcInt(const Value &arg) {
-  Float40 f(arg.getNumber());
-  return Value(f.intPart().toDouble());
+  return Value(callMathFunction(TokenType::INT, arg.getNumber()));
 }
 
 /**
@@ -534,8 +540,7 @@ Value funcInt(const Value &arg) {
  * @return -1, 0, or 1 depending on sign of arg
  */
 Value funcSgn(const Value &arg) {
-  Float40 f(arg.getNumber());
-  return Value(f.sgn().toDouble());
+  return Value(callMathFunction(TokenType::SGN, arg.getNumber()));
 }
 
 /**
@@ -556,8 +561,7 @@ Value funcSgn(const Value &arg) {
  * @return Random number in [0, 1) or repeated/reseeded value
  */
 Value funcRnd(const Value &arg) {
-  Float40 f(arg.getNumber());
-  return Value(Float40::rnd(f).toDouble());
+  return Value(callMathFunction(TokenType::RND, arg.getNumber()));
 }
 
 // ============================================================================
@@ -573,7 +577,8 @@ Value funcRnd(const Value &arg) {
  * @return Length of string as a number
  */
 Value funcLen(const Value &arg) {
-  return Value(static_cast<double>(arg.getString().length()));
+  std::string scratch;
+  return Value(static_cast<double>(textOf(arg, scratch).length()));
 }
 
 /**
@@ -623,9 +628,10 @@ Value funcVal(const Value &arg) {
  * @throws std::runtime_error if string is empty
  */
 Value funcAsc(const Value &arg) {
-  std::string str = arg.getString();
+  std::string scratch;
+  std::string_view str = textOf(arg, scratch);
   if (str.empty()) {
-    throw std::runtime_error("ILLEGAL QUANTITY ERROR");
+    throw RuntimeError(ErrorKind::IllegalQuantity);
   }
   return Value(static_cast<double>(static_cast<unsigned char>(str[0])));
 }
@@ -657,7 +663,7 @@ Value funcAsc(const Value &arg) {
 Value funcChr(const Value &arg) {
   int code = static_cast<int>(arg.getNumber());
   if (code < 0 || code > 255) {
-    throw std::runtime_error("ILLEGAL QUANTITY ERROR");
+    throw RuntimeError(ErrorKind::IllegalQuantity);
   }
   return Value(std::string(1, static_cast<char>(code)));
 }
@@ -679,7 +685,8 @@ Value funcChr(const Value &arg) {
  * @return Leftmost len characters of str
  */
 Value funcLeft(const Value &str, const Value &len) {
-  std::string s = str.getString();
+  std::string scratch;
+  std::string_view s = textOf(str, scratch);
   int n = static_cast<int>(len.getNumber());
   if (n < 0)
     n = 0;
@@ -705,7 +712,8 @@ Value funcLeft(const Value &str, const Value &len) {
  * @return Rightmost len characters of str
  */
 Value funcRight(const Value &str, const Value &len) {
-  std::string s = str.getString();
+  std::string scratch;
+  std::string_view s = textOf(str, scratch);
   int n = static_cast<int>(len.getNumber());
   if (n < 0)
     n = 0;
@@ -739,7 +747,8 @@ Value funcRight(const Value &str, const Value &len) {
  * @return Substring from start position with length len
  */
 Value funcMid(const Value &str, const Value &start, const Value &len) {
-  std::string s = str.getString();
+  std::string scratch;
+  std::string_view s = textOf(str, scratch);
   int st = static_cast<int>(start.getNumber()) - 1; // BASIC is 1-indexed
   int ln = static_cast<int>(len.getNumber());
 
@@ -1040,4 +1049,276 @@ Value funcUsr(const Value &addr) {
   // Stub implementation: return 0
   (void)addr;
   return Value(0.0);
-}
\ No newline at end of file
+}
+/**
+ * @brief Apply a binary BASIC operator to two evaluated operands
+ *
+ * Shared by the AST tree walker (BinaryExpr) and the bytecode VM so both
+ * execution engines produce identical results. Arithmetic and comparisons go
+ * through Value/Float40 so rounding matches Applesoft.
+ *
+ * @param op Operator token (PLUS, MINUS, ..., AND, OR)
+ * @param lval Left operand
+ * @param rval Right operand
+ * @return Result value (relational and logical operators yield 1 or 0)
+ */
+Value applyBinaryOperator(TokenType op, const Value &lval, const Value &rval) {
+  if (lval.isNumber() && rval.isNumber()) {
+    return Value(applyNumericOperator(op, lval.getNumber(), rval.getNumber()));
+  }
+  switch (op) {
+  case TokenType::PLUS:
+    return lval + rval;
+  case TokenType::MINUS:
+    return lval - rval;
+  case TokenType::MULTIPLY:
+    return lval * rval;
+  case TokenType::DIVIDE:
+    return lval / rval;
+  case TokenType::POWER: {
+    Float40 a(lval.getNumber());
+    Float40 b(rval.getNumber());
+    return Value(a.power(b).toDouble());
+  }
+  case TokenType::MOD: {
+    Float40 a(lval.getNumber());
+    Float40 b(rval.getNumber());
+    return Value(a.mod(b).toDouble());
+  }
+  case TokenType::EQUAL:
+    return Value(lval == rval ? 1.0 : 0.0);
+  case TokenType::NOT_EQUAL:
+    return Value(lval != rval ? 1.0 : 0.0);
+  case TokenType::LESS:
+    return Value(lval < rval ? 1.0 : 0.0);
+  case TokenType::GREATER:
+    return Value(lval > rval ? 1.0 : 0.0);
+  case TokenType::LESS_EQUAL:
+    return Value(lval <= rval ? 1.0 : 0.0);
+  case TokenType::GREATER_EQUAL:
+    return Value(lval >= rval ? 1.0 : 0.0);
+  case TokenType::AND:
+    return Value((lval.getNumber() != 0 && rval.getNumber() != 0) ? 1.0 : 0.0);
+  case TokenType::OR:
+    return Value((lval.getNumber() != 0 || rval.getNumber() != 0) ? 1.0 : 0.0);
+  default:
+    return Value(0.0);
+  }
+}
+
+/**
+ * @brief Dispatch a built-in function call by token type
+ *
+ * Shared by FunctionCallExpr and the bytecode VM. The caller guarantees that
+ * @p args holds as many values as the function takes (one for most
+ * functions, two for LEFT$/RIGHT$/SCRN, three for MID$).
+ *
+ * @param func Function token (SIN, LEN, MID, ...)
+ * @param args Pointer to the evaluated arguments
+ * @return Function result, or 0 for tokens without an implementation
+ */
+Value callBuiltinFunction(TokenType func, const Value *args) {
+  switch (func) {
+  case TokenType::SIN:
+    return funcSin(args[0]);
+  case TokenType::COS:
+    return funcCos(args[0]);
+  case TokenType::TAN:
+    return funcTan(args[0]);
+  case TokenType::ATN:
+    return funcAtn(args[0]);
+  case TokenType::EXP:
+    return funcExp(args[0]);
+  case TokenType::LOG:
+    return funcLog(args[0]);
+  case TokenType::SQR:
+    return funcSqr(args[0]);
+  case TokenType::ABS:
+    return funcAbs(args[0]);
+  case TokenType::INT:
+    return funcInt(args[0]);
+  case TokenType::SGN:
+    return funcSgn(args[0]);
+  case TokenType::RND:
+    return funcRnd(args[0]);
+  case TokenType::LEN:
+    return funcLen(args[0]);
+  case TokenType::VAL:
+    return funcVal(args[0]);
+  case TokenType::ASC:
+    return funcAsc(args[0]);
+  case TokenType::CHR:
+    return funcChr(args[0]);
+  case TokenType::LEFT:
+    return funcLeft(args[0], args[1]);
+  case TokenType::RIGHT:
+    return funcRight(args[0], args[1]);
+  case TokenType::MID:
+    return funcMid(args[0], args[1], args[2]);
+  case TokenType::STR:
+    return funcStr(args[0]);
+  case TokenType::SCRN:
+    return funcScrn(args[0], args[1]);
+  case TokenType::USR:
+    return funcUsr(args[0]);
+  case TokenType::PEEK:
+    return funcPeek(args[0]);
+  case TokenType::FRE:
+    return funcFre(args[0]);
+  case TokenType::PDL:
+    return funcPdl(args[0]);
+  case TokenType::POS:
+    return funcPos(args[0]);
+  default:
+    return Value(0.0);
+  }
+}
+
+/**
+ * @brief Apply a binary operator to two numbers
+ *
+ * Numeric counterpart of applyBinaryOperator(): arithmetic and comparisons
+ * go through Float40 exactly as the Value operators do, so both paths give
+ * bit-identical results.
+ *
+ * @param op Operator token type
+ * @param lhs Left operand
+ * @param rhs Right operand
+ * @return Result; relational and logical operators yield 1 or 0
+ */
+double applyNumericOperator(TokenType op, double lhs, double rhs) {
+  switch (op) {
+  case TokenType::PLUS:
+    return (Float40(lhs) + Float40(rhs)).toDouble();
+  case TokenType::MINUS:
+    return (Float40(lhs) - Float40(rhs)).toDouble();
+  case TokenType::MULTIPLY:
+    return (Float40(lhs) * Float40(rhs)).toDouble();
+  case TokenType::DIVIDE:
+    return (Float40(lhs) / Float40(rhs)).toDouble();
+  case TokenType::POWER:
+    return Float40(lhs).power(Float40(rhs)).toDouble();
+  case TokenType::MOD:
+    return Float40(lhs).mod(Float40(rhs)).toDouble();
+  case TokenType::EQUAL:
+    return Float40(lhs) == Float40(rhs) ? 1.0 : 0.0;
+  case TokenType::NOT_EQUAL:
+    return Float40(lhs) == Float40(rhs) ? 0.0 : 1.0;
+  case TokenType::LESS:
+    return Float40(lhs) < Float40(rhs) ? 1.0 : 0.0;
+  case TokenType::GREATER:
+    return Float40(lhs) > Float40(rhs) ? 1.0 : 0.0;
+  case TokenType::LESS_EQUAL:
+    return Float40(lhs) > Float40(rhs) ? 0.0 : 1.0;
+  case TokenType::GREATER_EQUAL:
+    return Float40(lhs) < Float40(rhs) ? 0.0 : 1.0;
+  case TokenType::AND:
+    return (lhs != 0 && rhs != 0) ? 1.0 : 0.0;
+  case TokenType::OR:
+    return (lhs != 0 || rhs != 0) ? 1.0 : 0.0;
+  default:
+    return 0.0;
+  }
+}
+
+/**
+ * @brief Check whether a token is a one-argument math function
+ *
+ * These are the functions callMathFunction() evaluates directly on doubles.
+ */
+bool isMathFunction(TokenType func) {
+  switch (func) {
+  case TokenType::SIN:
+  case TokenType::COS:
+  case TokenType::TAN:
+  case TokenType::ATN:
+  case TokenType::EXP:
+  case TokenType::LOG:
+  case TokenType::SQR:
+  case TokenType::ABS:
+  case TokenType::INT:
+  case TokenType::SGN:
+  case TokenType::RND:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/**
+ * @brief Check whether a built-in function always returns a number
+ *
+ * True for everything except the string functions (CHR$, LEFT$, RIGHT$,
+ * MID$, STR$) and the PRINT helpers TAB/SPC.
+ */
+bool isNumericBuiltin(TokenType func) {
+  switch (func) {
+  case TokenType::CHR:
+  case TokenType::LEFT:
+  case TokenType::RIGHT:
+  case TokenType::MID:
+  case TokenType::STR:
+  case TokenType::TAB:
+  case TokenType::SPC:
+    return false;
+  default:
+    return true;
+  }
+}
+
+bool isPureBuiltin(TokenType func) {
+  switch (func) {
+  case TokenType::RND:
+    return false;
+  case TokenType::LEN:
+  case TokenType::VAL:
+  case TokenType::ASC:
+  case TokenType::CHR:
+  case TokenType::LEFT:
+  case TokenType::RIGHT:
+  case TokenType::MID:
+  case TokenType::STR:
+    return true;
+  default:
+    return isMathFunction(func);
+  }
+}
+
+/**
+ * @brief Evaluate a one-argument math function on a double
+ *
+ * Backs funcSin() ... funcRnd() and the numeric evaluation channel.
+ *
+ * @param func Math function token (see isMathFunction())
+ * @param arg Argument
+ * @return Float40-accurate result
+ */
+double callMathFunction(TokenType func, double arg) {
+  Float40 f(arg);
+  switch (func) {
+  case TokenType::SIN:
+    return f.sin().toDouble();
+  case TokenType::COS:
+    return f.cos().toDouble();
+  case TokenType::TAN:
+    return f.tan().toDouble();
+  case TokenType::ATN:
+    return f.atn().toDouble();
+  case TokenType::EXP:
+    return f.exp().toDouble();
+  case TokenType::LOG:
+    return f.log().toDouble();
+  case TokenType::SQR:
+    return f.sqr().toDouble();
+  case TokenType::ABS:
+    return f.abs().toDouble();
+  case TokenType::INT:
+    return f.intPart().toDouble();
+  case TokenType::SGN:
+    return f.sgn().toDouble();
+  case TokenType::RND:
+    return Float40::rnd(f).toDouble();
+  default:
+    return 0.0;
+  }
+}
@@ -271,6 +271,62 @@ Value funcScrn(const Value &x, const Value &y);
  */
 Value funcUsr(const Value &addr);
 
+// ============================================================================
+// Operator and Function Dispatch
+// ============================================================================
+
+/**
+ * @brief Apply a binary operator (+, -, *, /, ^, MOD, relational, AND, OR)
+ * @param op Operator token type
+ * @param lval Left operand
+ * @param rval Right operand
+ * @return Result value; relational and logical operators yield 1 or 0
+ *
+ * Shared by the tree-walking evaluator and the bytecode VM so that both
+ * execution engines produce identical results.
+ */
+Value applyBinaryOperator(TokenType op, const Value &lval, const Value &rval);
+
+/**
+ * @brief Call a built-in function by token type
+ * @param func Function token (SIN, LEN, MID, ...)
+ * @param args Evaluated arguments (1-3 values depending on the function)
+ * @return Function result, or 0 for tokens without an implementation
+ */
+Value callBuiltinFunction(TokenType func, const Value *args);
+
+/**
+ * @brief Apply a binary operator to two numbers
+ * @param op Operator token type
+ * @param lhs Left operand
+ * @param rhs Right operand
+ * @return Same result applyBinaryOperator() gives for numeric operands
+ */
+double applyNumericOperator(TokenType op, double lhs, double rhs);
+
+/** @brief True for SIN, COS, TAN, ATN, EXP, LOG, SQR, ABS, INT, SGN, RND */
+bool isMathFunction(TokenType func);
+
+/** @brief True if the built-in function always returns a number */
+bool isNumericBuiltin(TokenType func);
+
+/**
+ * @brief True if the built-in function depends only on its arguments
+ *
+ * Pure functions (math except RND, LEN, VAL, ASC, CHR$, LEFT$, RIGHT$,
+ * MID$, STR$) may be evaluated once at parse time when their arguments
+ * are constants.
+ */
+bool isPureBuiltin(TokenType func);
+
+/**
+ * @brief Evaluate a one-argument math function
+ * @param func Function token (isMathFunction() must be true)
+ * @param arg Argument
+ * @return Function result
+ */
+double callMathFunction(TokenType func, double arg);
+
 // ============================================================================
 // Memory Operations
 // ============================================================================
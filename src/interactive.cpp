@@ -75,6 +75,19 @@ void InteractiveMode::run() {
   printBanner();
 
   Interpreter interp(graphicsConfig_);
+  interp.setExecutionEngine(engine_);
+  interp.setConstantFolding(foldConstants_);
+  interp.setSuperinstructions(superinstructions_);
+  interp.setLoopTier(loopTier_);
+  interp.setLoopTierNative(loopTierNative_);
+  interp.setControlStackDepth(controlStackDepth_);
+  interp.setLazyParsing(lazyParsing_);
+  interp.setLoadThreads(loadThreads_);
+  interp.setProgramCache(programCache_);
+  interp.setDropTokens(dropTokens_);
+  if (saveFormat_) {
+    interp.setSaveFormat(*saveFormat_);
+  }
 
   while (true) {
     printPrompt();
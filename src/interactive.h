@@ -25,7 +25,10 @@
 
 #pragma once
 
+#include "applesoft_format.h"
 #include "graphics_config.h"
+#include "types.h"
+#include <optional>
 #include <string>
 
 /**
@@ -56,6 +59,73 @@ public:
      * commands until user exits (Ctrl+C or EXIT command).
      */
     void run();
+
+    /**
+     * @brief Select the engine used by RUN for stored program lines
+     * @param engine TreeWalker (default) or Bytecode
+     */
+    void setExecutionEngine(ExecutionEngine engine) { engine_ = engine; }
+
+    /**
+     * @brief Enable or disable constant folding of entered lines
+     * @param enabled true (default) to fold constant subexpressions
+     */
+    void setConstantFolding(bool enabled) { foldConstants_ = enabled; }
+
+    /**
+     * @brief Enable or disable superinstruction fusion of entered lines
+     * @param enabled true (default) to fuse hot statement shapes
+     */
+    void setSuperinstructions(bool enabled) { superinstructions_ = enabled; }
+
+    /**
+     * @brief Enable or disable the loop tier for hot numeric FOR loops
+     * @param enabled true (default) to run hot numeric loops compiled
+     */
+    void setLoopTier(bool enabled) { loopTier_ = enabled; }
+
+    /**
+     * @brief Run the loop tier as machine code where supported
+     * @param enabled false to always use the portable dispatch loop
+     */
+    void setLoopTierNative(bool enabled) { loopTierNative_ = enabled; }
+
+    /**
+     * @brief Limit the shared GOSUB/FOR/WHILE stack
+     * @param frames Maximum depth before OUT OF MEMORY ERROR
+     */
+    void setControlStackDepth(size_t frames) { controlStackDepth_ = frames; }
+
+    /**
+     * @brief Parse lines of LOADed programs on first use
+     * @param enabled true to defer parsing (typed lines are always parsed)
+     */
+    void setLazyParsing(bool enabled) { lazyParsing_ = enabled; }
+
+    /**
+     * @brief Threads that parse LOADed programs
+     * @param threads Worker count (0 = automatic, 1 = serial)
+     */
+    void setLoadThreads(size_t threads) { loadThreads_ = threads; }
+
+    /**
+     * @brief Use the tokenized program cache when LOADing programs
+     * @param enabled false to always load from the source text
+     */
+    void setProgramCache(bool enabled) { programCache_ = enabled; }
+
+    /**
+     * @brief Free program line tokens once the lines are parsed
+     * @param enabled true to keep only text and statements per line
+     */
+    void setDropTokens(bool enabled) { dropTokens_ = enabled; }
+
+    /**
+     * @brief File format written by SAVE
+     * @param format Format of every saved program (default: the format
+     *               the program was loaded from)
+     */
+    void setSaveFormat(ProgramFormat format) { saveFormat_ = format; }
     
 private:
     /**
@@ -75,4 +145,15 @@ private:
     void printBanner();
     
     GraphicsConfig graphicsConfig_;
+    ExecutionEngine engine_ = ExecutionEngine::TreeWalker;
+    bool foldConstants_ = true;
+    bool superinstructions_ = true;
+    bool loopTier_ = true;
+    bool loopTierNative_ = true;
+    size_t controlStackDepth_ = kDefaultControlStackDepth;
+    bool lazyParsing_ = false;
+    size_t loadThreads_ = 0;
+    bool programCache_ = true;
+    bool dropTokens_ = false;
+    std::optional<ProgramFormat> saveFormat_;
 };
@@ -31,15 +31,20 @@
  */
 
 #include "interpreter.h"
+#include "applesoft_format.h"
+#include "bytecode.h"
 #include "filesystem.h"
 #include "float40.h"
 #include "interactive.h"
 #include "parser.h"
+#include "program_cache.h"
 #include "tokenizer.h"
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <chrono>
 #include <cstring>
+#include <exception>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -91,6 +96,8 @@ Interpreter::Interpreter(const GraphicsConfig &config)
   pokeMemory(0x0074, (himem_ >> 8) & 0xFF);
   // Cursor vertical position (location 37)
   pokeMemory(0x0025, outputRow_);
+
+  controlStack_.reserve(controlStackDepth_);
 }
 
 /**
@@ -103,7 +110,7 @@ Interpreter::Interpreter(const GraphicsConfig &config)
  * @param lineNum Output line number (-1 for immediate)
  * @param code Output code string
  */
-void Interpreter::parseLine(const std::string &line, LineNumber &lineNum,
+void Interpreter::parseLine(std::string_view line, LineNumber &lineNum,
                             std::string &code) {
   // Check if line starts with a number
   size_t pos = 0;
@@ -116,15 +123,15 @@ void Interpreter::parseLine(const std::string &line, LineNumber &lineNum,
     while (numEnd < line.length() && std::isdigit(line[numEnd]))
       numEnd++;
 
-    lineNum = std::stoi(line.substr(pos, numEnd - pos));
+    lineNum = std::stoi(std::string(line.substr(pos, numEnd - pos)));
 
     // Rest is code
     while (numEnd < line.length() && std::isspace(line[numEnd]))
       numEnd++;
-    code = line.substr(numEnd);
+    code.assign(line.substr(numEnd));
   } else {
     lineNum = -1;
-    code = line;
+    code.assign(line);
   }
 }
 
@@ -147,28 +154,405 @@ bool Interpreter::isLineNumber(const std::string &text) const {
  * @brief Add or update a program line
  *
  * If text is empty, deletes the line. Otherwise, tokenizes and parses
- * the line, then stores it in the program map. Lines are kept sorted
- * by line number via std::map.
+ * the line, then stores it in the program image. Lines are kept sorted
+ * by line number and indexed for O(1) lookup (see Program).
+ *
+ * The line is parsed into an arena of its own, so the nodes of a line that
+ * is replaced or deleted later are freed with it instead of piling up in
+ * the program's arena for the rest of an editing session.
  *
  * @param lineNum Line number (0-32767)
- * @param text BASIC code for this line
+ * @param text BASIC code for this line (moved into the program)
  */
-void Interpreter::addLine(LineNumber lineNum, const std::string &text) {
+void Interpreter::addLine(LineNumber lineNum, std::string text) {
+  // Editing shifts line indices, so saved resume points are no longer valid
+  clearControlStacks();
   if (text.empty()) {
     // Empty line deletes the line
     program_.erase(lineNum);
   } else {
     ProgramLine pline;
     pline.lineNumber = lineNum;
-    pline.text = text;
+    pline.text = std::move(text);
+    pline.arena = std::make_shared<AstArena>();
+    parseProgramLine(pline);
+    program_.insert(std::move(pline));
+  }
+}
+
+namespace {
+/**
+ * @brief Free the tokens of a parsed line (see setDropTokens())
+ *
+ * The statements hold copies of every name and literal they need, and
+ * LIST prints the line's text, so nothing reads the tokens again.
+ */
+void dropTokens(ProgramLine &line) {
+  std::vector<Token>().swap(line.tokens);
+  std::vector<Value>().swap(line.constants);
+}
+} // namespace
+
+/**
+ * @brief Tokenize and parse a program line into its arena
+ *
+ * The nodes go to the line's own arena if it has one (lines entered in the
+ * editor), otherwise to the program's main arena.
+ *
+ * Lines that already carry tokens (read from the program cache) are only
+ * parsed. On a syntax error the exception propagates and the line stays
+ * unparsed, so a lazily loaded line reports the error again each time it
+ * runs.
+ *
+ * @param line Line whose text is parsed; tokens and statements are set
+ */
+void Interpreter::parseProgramLine(ProgramLine &line) {
+  if (line.tokens.empty()) {
+    Tokenizer tokenizer;
+    line.constants.clear();
+    line.tokens = tokenizer.tokenize(line.text, line.constants);
+  }
+
+  Parser parser(line.arena ? *line.arena : *program_.arena());
+  parser.setConstantFolding(foldConstants_);
+  parser.setSuperinstructions(superinstructions_);
+  line.statements = parser.parse(line.tokens, line.text, line.constants);
+  foldedNodes_ += parser.foldedNodes();
+  line.parsed = true;
+  if (dropTokens_) {
+    dropTokens(line);
+  }
+}
+
+
+/**
+ * @brief Store one line of a program file (LOAD, CHAIN, -)
+ *
+ * Lines without a line number are ignored. With lazy parsing only the
+ * number and text are recorded; otherwise the line is parsed now.
+ *
+ * @param line Source line as read from the file
+ */
+void Interpreter::storeLoadedLine(std::string_view line) {
+  LineNumber lineNum;
+  std::string code;
+  parseLine(line, lineNum, code);
+  if (lineNum < 0) {
+    return;
+  }
+  ProgramLine pline;
+  pline.lineNumber = lineNum;
+  pline.text = std::move(code);
+  storeLoadedLine(std::move(pline));
+}
+
+namespace {
+/**
+ * @brief Reset a line whose parse failed, so it is parsed again when it runs
+ *
+ * An eager LOAD stops at the first line that does not parse but keeps that
+ * line, as a lazy LOAD would: running it, or reading its DATA, reports the
+ * syntax error for its own line number.
+ */
+void markUnparsed(ProgramLine &line) {
+  line.statements.clear();
+  line.parsed = false;
+}
+} // namespace
+
+/**
+ * @brief Store one numbered program line (empty text deletes the line)
+ * @param line Line with its number and text, and possibly its tokens
+ * @throws std::exception on a syntax error, after storing the line unparsed
+ */
+void Interpreter::storeLoadedLine(ProgramLine line) {
+  // Editing shifts line indices, so saved resume points are no longer valid
+  clearControlStacks();
+  if (line.text.empty()) {
+    program_.erase(line.lineNumber);
+    return;
+  }
+  if (lazyParsing_) {
+    line.parsed = false;
+  } else {
+    try {
+      parseProgramLine(line);
+    } catch (const std::exception &) {
+      markUnparsed(line);
+      program_.insert(std::move(line));
+      throw;
+    }
+  }
+  program_.insert(std::move(line));
+}
+
+/**
+ * @brief A program line on its way from a file into the program
+ *
+ * Lines read from text carry their source and are split into number and
+ * code by the loader; lines read from the program cache arrive split and
+ * tokenized.
+ */
+struct Interpreter::LoadedLine {
+  std::string_view source; // into the file text; empty once split
+  ProgramLine line;
+  bool numbered = false;
+  size_t folded = 0;
+  std::exception_ptr error;
+};
+
+namespace {
+/** @brief Smallest file that the automatic thread count parses in parallel */
+constexpr size_t kParallelLoadMinLines = 2048;
+
+/** @brief Lines per worker that the automatic thread count aims for */
+constexpr size_t kLinesPerLoadThread = 1024;
+} // namespace
+
+/**
+ * @brief Number of workers used to parse a program file
+ * @param lines Number of non-empty lines in the file
+ * @return 1 for a serial load
+ */
+size_t Interpreter::loadThreadCount(size_t lines) const {
+  if (lazyParsing_ || lines < 2) {
+    return 1;
+  }
+  if (loadThreads_ != 0) {
+    return std::min(loadThreads_, lines);
+  }
+  if (lines < kParallelLoadMinLines) {
+    return 1;
+  }
+  size_t hardware = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  return std::min(hardware, lines / kLinesPerLoadThread);
+}
+
+/**
+ * @brief Store a program file, through the tokenized program cache
+ *
+ * Applesoft tokenized files (see applesoft_format.h) are decoded straight
+ * into tokenized lines. For text, a valid cache file (see program_cache.h)
+ * supplies the tokens of every line, so only parsing is left. Otherwise
+ * the text is loaded normally and, once it has been parsed without
+ * errors, its cache file is written for the next run. Lazy loads bypass
+ * the cache: they tokenize only the lines that run, which is cheaper than
+ * decoding every line's tokens.
+ *
+ * @param filename Path of the program file
+ * @param content Contents of the program file
+ */
+void Interpreter::storeProgramFile(const std::string &filename,
+                                   std::string_view content) {
+  if (isApplesoftProgram(content)) {
+    programFormat_ = ProgramFormat::Applesoft;
+    std::vector<ProgramLine> decoded = decodeApplesoftProgram(content);
+    std::vector<LoadedLine> lines(decoded.size());
+    for (size_t i = 0; i < decoded.size(); ++i) {
+      lines[i].line = std::move(decoded[i]);
+      lines[i].numbered = true;
+    }
+    storeLoadedLines(lines);
+    return;
+  }
+  programFormat_ = ProgramFormat::Text;
+  std::string cacheFile =
+      programCache_ && !lazyParsing_ ? programCachePath(filename) : "";
+  if (!cacheFile.empty()) {
+    std::vector<ProgramLine> cached;
+    if (readProgramCache(cacheFile, content, cached)) {
+      std::vector<LoadedLine> lines(cached.size());
+      for (size_t i = 0; i < cached.size(); ++i) {
+        lines[i].line = std::move(cached[i]);
+        lines[i].numbered = true;
+      }
+      storeLoadedLines(lines);
+      return;
+    }
+  }
+  storeProgramText(content);
+  if (!cacheFile.empty()) {
+    writeProgramCache(cacheFile, content, program_);
+  }
+}
+
+namespace {
+/**
+ * @brief Call @p visit with each non-empty line of @p text
+ *
+ * Lines are views into @p text, without their line ending; a CR before
+ * the LF is dropped, so CRLF files load the same on every platform.
+ */
+template <typename Visit> void forEachLine(std::string_view text,
+                                           Visit visit) {
+  while (!text.empty()) {
+    size_t end = text.find('\n');
+    std::string_view line = text.substr(0, end);
+    text.remove_prefix(end == std::string_view::npos ? text.size()
+                                                     : end + 1);
+    if (!line.empty() && line.back() == '\r') {
+      line.remove_suffix(1);
+    }
+    if (!line.empty()) {
+      visit(line);
+    }
+  }
+}
+} // namespace
+
+/**
+ * @brief Store the lines of a program text (LOAD, CHAIN, -)
+ *
+ * Lines are handed on as views into @p content. A serial load stores each
+ * line as soon as it is split off, so the only copy of its text is the
+ * one kept in the program.
+ *
+ * @param content Whole text of the program file
+ */
+void Interpreter::storeProgramText(std::string_view content) {
+  size_t lineCount = static_cast<size_t>(
+                         std::count(content.begin(), content.end(), '\n')) +
+                     1;
+  if (loadThreadCount(lineCount) <= 1) {
+    forEachLine(content, [this](std::string_view line) {
+      storeLoadedLine(line);
+    });
+    return;
+  }
+  std::vector<LoadedLine> lines;
+  lines.reserve(lineCount);
+  forEachLine(content, [&lines](std::string_view line) {
+    lines.emplace_back().source = line;
+  });
+  storeLoadedLines(lines);
+}
+
+/**
+ * @brief Store a program read line by line from a stream (LOAD "-")
+ *
+ * Used for programs piped in on standard input: each line is stored as
+ * soon as it arrives, so the text is never held as a whole.
+ *
+ * @param in Stream with the program text
+ */
+void Interpreter::storeProgramStream(std::istream &in) {
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (!line.empty()) {
+      storeLoadedLine(line);
+    }
+  }
+}
+
+/**
+ * @brief Store loaded lines in file order
+ *
+ * Small programs go through storeLoadedLine() one line at a time. Large
+ * ones are cut into contiguous blocks, one per worker thread; each worker
+ * tokenizes and parses its block into an arena of its own, which the
+ * program adopts. The parsed lines are then stored in file order, so later
+ * lines replace or delete earlier ones exactly as in a serial load.
+ *
+ * Syntax errors are reported deterministically: the lines before the first
+ * failing line (in file order) are stored, that line is stored unparsed
+ * and its error is rethrown, whichever worker hit an error first. Workers stop early once
+ * an earlier line is known to have failed.
+ *
+ * @param parsed Lines to store (consumed)
+ */
+void Interpreter::storeLoadedLines(std::vector<LoadedLine> &parsed) {
+  size_t threads = loadThreadCount(parsed.size());
+  if (threads <= 1) {
+    for (auto &loaded : parsed) {
+      if (!loaded.source.empty()) {
+        storeLoadedLine(loaded.source);
+      } else if (loaded.numbered) {
+        storeLoadedLine(std::move(loaded.line));
+      }
+    }
+    return;
+  }
+
+  std::atomic<size_t> firstError{parsed.size()};
 
+  auto parseBlock = [&](size_t begin, size_t end, AstArena &arena) {
     Tokenizer tokenizer;
-    pline.tokens = tokenizer.tokenize(text);
+    Parser parser(arena);
+    parser.setConstantFolding(foldConstants_);
+    parser.setSuperinstructions(superinstructions_);
+    for (size_t i = begin;
+         i < end && i < firstError.load(std::memory_order_relaxed); ++i) {
+      LoadedLine &result = parsed[i];
+      try {
+        if (!result.source.empty()) {
+          LineNumber lineNum;
+          parseLine(result.source, lineNum, result.line.text);
+          if (lineNum < 0) {
+            continue;
+          }
+          result.numbered = true;
+          result.line.lineNumber = lineNum;
+        }
+        if (result.line.text.empty()) {
+          continue;
+        }
+        size_t foldedBefore = parser.foldedNodes();
+        ProgramLine &line = result.line;
+        if (line.tokens.empty()) {
+          line.constants.clear();
+          line.tokens = tokenizer.tokenize(line.text, line.constants);
+        }
+        line.statements = parser.parse(line.tokens, line.text, line.constants);
+        result.folded = parser.foldedNodes() - foldedBefore;
+        if (dropTokens_) {
+          dropTokens(line);
+        }
+      } catch (...) {
+        result.error = std::current_exception();
+        size_t seen = firstError.load();
+        while (i < seen && !firstError.compare_exchange_weak(seen, i)) {
+        }
+        return;
+      }
+    }
+  };
 
-    Parser parser;
-    pline.statements = parser.parse(pline.tokens);
+  std::vector<std::shared_ptr<AstArena>> arenas;
+  std::vector<std::thread> workers;
+  size_t blockSize = (parsed.size() + threads - 1) / threads;
+  for (size_t begin = 0; begin < parsed.size(); begin += blockSize) {
+    size_t end = std::min(begin + blockSize, parsed.size());
+    arenas.push_back(std::make_shared<AstArena>());
+    workers.emplace_back(parseBlock, begin, end, std::ref(*arenas.back()));
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
 
-    program_[lineNum] = pline;
+  for (auto &arena : arenas) {
+    program_.adoptArena(std::move(arena));
+  }
+  clearControlStacks();
+  for (auto &result : parsed) {
+    if (result.error) {
+      if (result.numbered && !result.line.text.empty()) {
+        markUnparsed(result.line);
+        program_.insert(std::move(result.line));
+      }
+      std::rethrow_exception(result.error);
+    }
+    if (!result.numbered) {
+      continue;
+    }
+    if (result.line.text.empty()) {
+      program_.erase(result.line.lineNumber);
+      continue;
+    }
+    foldedNodes_ += result.folded;
+    program_.insert(std::move(result.line));
   }
 }
 
@@ -183,7 +567,10 @@ void Interpreter::addLine(LineNumber lineNum, const std::string &text) {
  *
  * @param lineNum Line number to delete
  */
-void Interpreter::deleteLine(LineNumber lineNum) { program_.erase(lineNum); }
+void Interpreter::deleteLine(LineNumber lineNum) {
+  clearControlStacks();
+  program_.erase(lineNum);
+}
 
 /**
  * @brief Clear program and all state (NEW command)
@@ -193,35 +580,127 @@ void Interpreter::deleteLine(LineNumber lineNum) { program_.erase(lineNum); }
  */
 void Interpreter::newProgram() {
   program_.clear();
+  programFormat_ = ProgramFormat::Text;
+  clearControlStacks();
   variables_.clear();
-  dataValues_.clear();
-  dataOffsets_.clear();
-  dataPointer_ = 0;
+  discardData();
   resetOutputPosition();
 }
 
 /**
  * @brief Clear variables and control stacks (CLR command)
  *
- * Clears variables, FOR/NEXT and GOSUB stacks, DATA state, and error
- * handlers. Preserves program lines. This is equivalent to the CLR
- * command in Applesoft BASIC.
+ * Clears variables, FOR/NEXT and GOSUB stacks and error handlers, and
+ * moves the DATA pointer back to the first item. Preserves program lines.
+ * This is equivalent to the CLR command in Applesoft BASIC.
  */
 void Interpreter::clearState() {
   variables_.clear();
-  forStack_.clear();
-  while (!gosubStack_.empty()) {
-    gosubStack_.pop();
-  }
-  dataValues_.clear();
-  dataOffsets_.clear();
-  dataPointer_ = 0;
+  clearControlStacks();
+  rewindData();
   errorHandlerLine_ = -1;
   errorLine_ = -1;
-  lastError_.clear();
+  lastError_ = ErrorKind::None;
   resetOutputPosition();
 }
 
+/**
+ * @brief Resolve GOTO/GOSUB/ON targets of the whole program
+ *
+ * Runs before execution when the program changed since the last pass, so
+ * jumps inside the run loop find their target index already cached. Targets
+ * that do not exist are left unresolved and raise UNDEF'D STATEMENT ERROR
+ * only when (and if) the jump executes.
+ */
+void Interpreter::linkProgram() {
+  if (linkedEpoch_ == program_.epoch()) {
+    return;
+  }
+  for (auto &line : program_) {
+    for (auto &stmt : line.statements) {
+      stmt->linkTargets(program_);
+    }
+  }
+  linkedEpoch_ = program_.epoch();
+}
+
+/**
+ * @brief Discard GOSUB, FOR and WHILE frames
+ *
+ * Frames hold resume points as line/statement indices into the program
+ * image, so they are dropped whenever the program is edited or a new run
+ * starts. Frames are plain data, so this only resets the stack size.
+ */
+void Interpreter::clearControlStacks() {
+  controlStack_.clear();
+  topGosub_ = kNoFrame;
+  pinnedArenas_.clear();
+}
+
+/**
+ * @brief Set the maximum depth of the control stack
+ *
+ * Reserves room for @p frames frames up front. Frames already on the stack
+ * are kept; a limit below the current depth only stops further pushes.
+ *
+ * @param frames Maximum number of GOSUB, FOR and WHILE frames (at least 1)
+ */
+void Interpreter::setControlStackDepth(size_t frames) {
+  controlStackDepth_ = std::max<size_t>(frames, 1);
+  controlStack_.reserve(controlStackDepth_);
+}
+
+/**
+ * @brief Push a GOSUB, FOR or WHILE frame
+ *
+ * Raises OUT OF MEMORY ERROR instead of growing past the depth limit, the
+ * way Applesoft reports a full stack.
+ *
+ * @param frame Frame to push
+ * @return false if the stack is full (the error is pending)
+ */
+bool Interpreter::pushFrame(const ControlFrame &frame) {
+  if (controlStack_.size() >= controlStackDepth_) {
+    raise(ErrorKind::OutOfMemory);
+    return false;
+  }
+  controlStack_.push_back(frame);
+  return true;
+}
+
+/**
+ * @brief Push a GOSUB frame resuming after the current statement
+ * @return false if the stack is full (the error is pending)
+ */
+bool Interpreter::pushGosub() {
+  ControlFrame frame;
+  frame.kind = ControlFrame::Kind::Gosub;
+  frame.outerGosub = topGosub_;
+  frame.resume = nextStatementPosition();
+  if (!pushFrame(frame)) {
+    return false;
+  }
+  topGosub_ = controlStack_.size() - 1;
+  return true;
+}
+
+/**
+ * @brief Pop the innermost GOSUB frame and the loops opened inside it
+ *
+ * Each GOSUB frame remembers the previous innermost GOSUB, so RETURN and
+ * POP find their frame without scanning.
+ *
+ * @return Resume point saved by the GOSUB
+ */
+Interpreter::ProgramPosition Interpreter::unwindGosub() {
+  const ControlFrame &frame = controlStack_[topGosub_];
+  ProgramPosition resume = frame.resume;
+  size_t index = topGosub_;
+  topGosub_ = frame.outerGosub;
+  controlStack_.resize(index);
+  return resume;
+}
+
 /**
  * @brief List program lines to stdout (LIST command)
  *
@@ -232,10 +711,10 @@ void Interpreter::clearState() {
  * @param endLine Last line to list (-1 for end)
  */
 void Interpreter::listProgram(int startLine, int endLine) {
-  for (const auto &pair : program_) {
-    if ((startLine < 0 || pair.first >= startLine) &&
-        (endLine < 0 || pair.first <= endLine)) {
-      std::cout << pair.first << " " << pair.second.text << "\n";
+  for (const auto &line : program_) {
+    if ((startLine < 0 || line.lineNumber >= startLine) &&
+        (endLine < 0 || line.lineNumber <= endLine)) {
+      std::cout << line.lineNumber << " " << line.text << "\n";
     }
   }
 }
@@ -248,6 +727,24 @@ void Interpreter::listProgram(int startLine, int endLine) {
  */
 void Interpreter::run() { runFrom(-1); }
 
+namespace {
+/**
+ * @brief Quick check whether an unparsed line could hold a DATA statement
+ *
+ * Case-insensitive search for the keyword anywhere in the text. False
+ * positives (DATA inside a string or REM) only cost a parse.
+ */
+bool mayContainData(const std::string &text) {
+  static const char kData[] = "DATA";
+  auto it = std::search(text.begin(), text.end(), kData, kData + 4,
+                        [](char a, char b) {
+                          return std::toupper(static_cast<unsigned char>(a)) ==
+                                 b;
+                        });
+  return it != text.end();
+}
+} // namespace
+
 /**
  * @brief Execute program starting from specified line
  *
@@ -257,9 +754,8 @@ void Interpreter::run() { runFrom(-1); }
  *
  * Execution process:
  * 1. Initialize execution state (running_ flag, immediate_ mode)
- * 2. Build DATA cache by scanning all program lines
- *    - This ensures READ can access DATA regardless of program flow
- *    - dataOffsets_ maps line numbers to positions in dataValues_
+ * 2. Move the DATA pointer to the first item (the items themselves are
+ *    collected by the first READ or RESTORE, see collectData())
  * 3. Set program counter to starting line
  * 4. Execute statements sequentially until:
  *    - END or STOP statement sets running_ = false
@@ -286,46 +782,47 @@ void Interpreter::run() { runFrom(-1); }
 void Interpreter::runFrom(LineNumber lineNum) {
   running_ = true;
   immediate_ = false;
+  paused_ = false; // A new run cannot be CONTinued into the old one
   resetOutputPosition();
 
-  // Prepare DATA cache before execution so READ works regardless of control
-  // flow. This scans all program lines and collects DATA statement values
-  // into a linear array (dataValues_) with an index mapping line numbers
-  // to positions (dataOffsets_). This allows RESTORE to reposition the
-  // data pointer to a specific line's data.
-  dataPointer_ = 0;
-  dataValues_.clear();
-  dataOffsets_.clear();
-  for (const auto &pair : program_) {
-    bool recorded = false;
-    for (const auto &stmt : pair.second.statements) {
-      size_t before = dataValues_.size();
-      stmt->collectData(dataValues_);
-      // Record the offset of the first DATA statement in this line
-      if (!recorded && dataValues_.size() > before) {
-        dataOffsets_.push_back({pair.first, before});
-        recorded = true;
-      }
-    }
-  }
+  // The DATA items of an unchanged program are kept from the last run
+  rewindData();
+
+  // Frames from an earlier run point into a program that may have changed
+  clearControlStacks();
+  pendingError_ = PendingError{};
+  linkProgram();
 
   // Set initial program counter position
+  statementIndex_ = 0;
   if (lineNum < 0 && !program_.empty()) {
     // Start from first line (RUN with no argument)
-    programCounter_ = program_.begin();
+    programCounter_ = 0;
   } else {
     // Start from specified line (RUN linenum or GOTO)
-    programCounter_ = program_.find(lineNum);
-    if (programCounter_ == program_.end()) {
+    programCounter_ = program_.indexOf(lineNum);
+    if (programCounter_ == Program::npos) {
       std::cout << "?UNDEF'D STATEMENT ERROR\n";
       return;
     }
   }
 
+  execute();
+}
+
+/**
+ * @brief Run program lines from the program counter
+ *
+ * The execution loop shared by RUN and CONT. Runs until END or STOP
+ * clears running_ or the last line finishes. Errors, whether thrown or
+ * raised, go to the ONERR handler; without one they are printed and
+ * stop the program.
+ */
+void Interpreter::execute() {
   try {
     // Main execution loop: iterate through program lines
-    while (running_ && programCounter_ != program_.end()) {
-      currentLine_ = programCounter_->first;
+    while (running_ && programCounter_ < program_.size()) {
+      currentLine_ = program_[programCounter_].lineNumber;
       jumped_ = false;
 
       // TRACE output if enabled: show line number before execution
@@ -335,62 +832,47 @@ void Interpreter::runFrom(LineNumber lineNum) {
 
       try {
         // Execute all statements on this line
-        for (auto &stmt : programCounter_->second.statements) {
-          stmt->execute(this);
-          // Stop executing statements if we've jumped or stopped
-          if (!running_ || jumped_)
-            break;
-          // Apply SPEED delay between statements if configured
-          applySpeedDelay();
-        }
+        executeLine(program_[programCounter_]);
       } catch (const std::exception &e) {
-        // Error occurred - check if we have an error handler
-        if (errorHandlerLine_ >= 0) {
-          // ONERR handler is active - prepare error state
-          errorLine_ = currentLine_;
-          lastError_ = e.what();
-
-          // Store error information in memory locations for PEEK access
-          // These locations match Applesoft BASIC conventions:
-          // Location 218-219 (0xDA-0xDB): error line number (little-endian)
-          // Location 222 (0xDE): error code
-          pokeMemory(0x00DA, errorLine_ & 0xFF);
-          pokeMemory(0x00DB, (errorLine_ >> 8) & 0xFF);
-
-          // Only set generic error code if no specific error code was set
-          // by handleError() or other error-generating code
-          int currentErrorCode = peekMemory(0x00DE);
-          if (currentErrorCode == 0) {
-            pokeMemory(0x00DE, 16); // Generic error code
-          }
-
-          // Jump to error handler line
-          gotoLine(errorHandlerLine_);
-          continue; // Continue executing from error handler
-        } else {
-          // No error handler - print error and stop
-          std::cout << "?" << e.what() << " IN LINE " << currentLine_ << "\n";
-          running_ = false;
-          break;
+        // Error thrown from expression evaluation or a host failure:
+        // continue in the ONERR handler, or print it and stop
+        if (trapError(errorKindOf(e), {programCounter_, statementIndex_})) {
+          continue;
         }
+        std::cout << "?" << e.what() << " IN LINE " << currentLine_ << "\n";
+        running_ = false;
+        break;
       }
 
       // Advance to next line if we didn't jump
       // (GOTO, GOSUB, or control flow statements set jumped_ flag)
       if (!jumped_) {
         ++programCounter_;
+        statementIndex_ = 0;
+      } else if (errorPending()) {
+        // Error raised by a statement: same handling, without unwinding
+        PendingError error = takeError();
+        if (error.line >= 0) {
+          currentLine_ = error.line;
+        }
+        if (trapError(error.kind, error.where)) {
+          continue;
+        }
+        std::cout << "?" << errorMessage(error.kind) << " IN LINE "
+                  << currentLine_ << "\n";
+        running_ = false;
+        break;
       }
     }
   } catch (const std::exception &e) {
     // Catch any unhandled exceptions from the main execution loop
     // This is a safety net for errors that escape the inner try-catch
     std::cout << "?" << e.what() << "\n";
-    running_ = false;
   }
 
-  // Ensure execution state is clean after run completes
+  // Ensure execution state is clean after run completes (a STOP leaves
+  // paused_ set for CONT)
   running_ = false;
-  paused_ = false;
 }
 
 /**
@@ -429,7 +911,7 @@ void Interpreter::executeImmediate(const std::string &line) {
 
   if (lineNum >= 0) {
     // Line with number - add to or delete from program
-    addLine(lineNum, code);
+    addLine(lineNum, std::move(code));
   } else {
     // Immediate command - execute directly
 
@@ -759,13 +1241,25 @@ void Interpreter::executeImmediate(const std::string &line) {
       immediate_ = true;
 
       Tokenizer tokenizer;
-      std::vector<Token> tokens = tokenizer.tokenize(code);
-
-      Parser parser;
-      std::vector<std::shared_ptr<Statement>> statements = parser.parse(tokens);
+      std::vector<Value> constants;
+      std::vector<Token> tokens = tokenizer.tokenize(code, constants);
+
+      // The line's nodes live until it finishes (or longer if DEF FN or a
+      // WHILE frame keeps the arena)
+      auto arena = std::make_shared<AstArena>();
+      Parser parser(*arena);
+      parser.setConstantFolding(foldConstants_);
+      parser.setSuperinstructions(superinstructions_);
+      std::vector<Statement *> statements =
+          parser.parse(tokens, code, constants);
+      foldedNodes_ += parser.foldedNodes();
 
       for (auto &stmt : statements) {
         stmt->execute(this);
+        if (errorPending()) {
+          // Immediate-mode errors are reported by the caller
+          throw RuntimeError(takeError().kind);
+        }
         applySpeedDelay();
       }
 
@@ -782,7 +1276,7 @@ void Interpreter::executeImmediate(const std::string &line) {
  * error handlers (ONERR), and ON...GOTO statements.
  *
  * The function validates that the target line exists in the program and
- * throws "UNDEF'D STATEMENT ERROR" if not found. The jumped_ flag is set
+ * raises "UNDEF'D STATEMENT ERROR" if not found. The jumped_ flag is set
  * to prevent automatic advancement to the next line.
  *
  * Implementation notes:
@@ -791,7 +1285,7 @@ void Interpreter::executeImmediate(const std::string &line) {
  * - Used by: GOTO, error handlers, ON...GOTO, RESTORE (for DATA)
  *
  * @param lineNum Target line number to jump to
- * @throws std::runtime_error if line number not found in program
+ * Raises UNDEF'D STATEMENT ERROR if the line is not in the program
  */
 /**
  * @brief Jump to a specific line (GOTO implementation)
@@ -800,8 +1294,8 @@ void Interpreter::executeImmediate(const std::string &line) {
  * core control flow primitive used by GOTO, IF...THEN, and ON...GOTO.
  *
  * Implementation:
- * - Searches program_ map for target line
- * - Updates programCounter_ to point to that line
+ * - Looks up the target line's index in the program image (O(1))
+ * - Updates programCounter_ to that index
  * - Sets jumped_ flag to prevent automatic advancement
  *
  * The jumped_ flag tells the main execution loop not to advance to the
@@ -813,91 +1307,157 @@ void Interpreter::executeImmediate(const std::string &line) {
  *   ON N GOTO 100,200,300
  *
  * @param lineNum Target line number to jump to
- * @throws std::runtime_error if line number not found
+ * Raises UNDEF'D STATEMENT ERROR if the line is not found
  */
 void Interpreter::gotoLine(LineNumber lineNum) {
-  auto it = program_.find(lineNum);
-  if (it == program_.end()) {
-    throw std::runtime_error("UNDEF'D STATEMENT ERROR");
+  transferTo(program_.indexOf(lineNum));
+}
+
+/**
+ * @brief Jump to a linked target line
+ *
+ * Same as gotoLine(LineNumber) but reuses the index cached in @p target
+ * while the program is unchanged.
+ *
+ * @param target Linked GOTO target
+ * Raises UNDEF'D STATEMENT ERROR if the target line does not exist
+ */
+void Interpreter::gotoLine(LineRef &target) {
+  transferTo(program_.resolve(target));
+}
+
+/**
+ * @brief Transfer control to the start of the line at @p index
+ *
+ * @param index Image index of the target line, or Program::npos
+ *
+ * Raises UNDEF'D STATEMENT ERROR if index is npos.
+ */
+void Interpreter::transferTo(size_t index) {
+  if (index == Program::npos) {
+    raise(ErrorKind::UndefinedStatement);
+    return;
+  }
+  programCounter_ = index;
+  statementIndex_ = 0;
+  jumped_ = true;
+}
+
+/**
+ * @brief Position of the statement after the one currently executing
+ *
+ * Used as the resume point for GOSUB, FOR and WHILE frames. In immediate
+ * mode there is no program position, so the frame is marked with npos.
+ */
+Interpreter::ProgramPosition Interpreter::nextStatementPosition() const {
+  if (immediate_) {
+    return {Program::npos, 0};
+  }
+  return {programCounter_, statementIndex_ + 1};
+}
+
+/**
+ * @brief Continue execution at a saved resume point
+ *
+ * A position just past the last statement of a line continues with the
+ * next line. Positions saved in immediate mode do not transfer control.
+ *
+ * @param pos Resume point from a GOSUB/FOR/WHILE frame or ONERR
+ */
+void Interpreter::jumpTo(const ProgramPosition &pos) {
+  if (pos.line == Program::npos) {
+    return;
+  }
+  programCounter_ = pos.line;
+  statementIndex_ = pos.statement;
+  if (programCounter_ < program_.size() &&
+      statementIndex_ >= program_[programCounter_].statements.size()) {
+    ++programCounter_;
+    statementIndex_ = 0;
   }
-  programCounter_ = it;
   jumped_ = true;
 }
 
 /**
  * @brief Call a subroutine (GOSUB implementation)
  *
- * Saves the current line number on the return stack and jumps to the
+ * Saves the resume point on the control stack and jumps to the
  * specified subroutine line. The RETURN statement will pop the stack
  * and continue execution after the GOSUB.
  *
  * Stack structure:
- * - Each GOSUB pushes the current line number (not program counter)
- * - RETURN pops the line and continues from the NEXT line
+ * - Each GOSUB pushes a frame with the position of the statement after it
+ *   (line index + statement index)
+ * - RETURN pops that frame, and any FOR/WHILE frames above it, and
+ *   continues there, even mid-line
  * - Nested GOSUBs work through standard stack behavior
  * - Stack is cleared by CLR or program termination
  *
  * Error conditions:
  * - Target line not found: "UNDEF'D STATEMENT ERROR"
- * - Stack overflow: Limited only by system memory
+ * - Stack full (see setControlStackDepth()): "OUT OF MEMORY ERROR"
  * - Unmatched RETURN: "RETURN WITHOUT GOSUB ERROR" (checked in returnFromGosub)
  *
  * Example:
- *   10 GOSUB 100  ' Push line 10, jump to 100
- *   20 PRINT "BACK"
+ *   10 GOSUB 100: PRINT "BACK"  ' Push (10, 2nd statement), jump to 100
  *   ...
  *   100 PRINT "SUB"
- *   110 RETURN     ' Pop line 10, continue at line 20
+ *   110 RETURN     ' Pop and continue with PRINT "BACK" on line 10
  *
  * @param lineNum Target subroutine line number
- * @throws std::runtime_error if line number not found
+ * Raises UNDEF'D STATEMENT ERROR if the line is not found, OUT OF MEMORY
+ * ERROR if the control stack is full
  */
 void Interpreter::gosub(LineNumber lineNum) {
-  gosubStack_.push(currentLine_);
-  auto it = program_.find(lineNum);
-  if (it == program_.end()) {
-    throw std::runtime_error("UNDEF'D STATEMENT ERROR");
+  if (!pushGosub()) {
+    return;
   }
-  programCounter_ = it;
-  jumped_ = true;
+  transferTo(program_.indexOf(lineNum));
+}
+
+/**
+ * @brief Call a subroutine at a linked target line
+ *
+ * Same as gosub(LineNumber) but reuses the index cached in @p target
+ * while the program is unchanged.
+ *
+ * @param target Linked GOSUB target
+ * Raises UNDEF'D STATEMENT ERROR if the target line does not exist
+ */
+void Interpreter::gosub(LineRef &target) {
+  if (!pushGosub()) {
+    return;
+  }
+  transferTo(program_.resolve(target));
 }
 
 /**
  * @brief Return from subroutine (RETURN implementation)
  *
- * Pops a line number from the GOSUB stack and continues execution at the
- * line immediately following that line. This completes a GOSUB/RETURN pair.
+ * Pops a resume point from the GOSUB stack and continues execution at the
+ * statement following the GOSUB. This completes a GOSUB/RETURN pair.
  *
  * Implementation details:
- * - Pops the return line from the stack
- * - Finds that line in the program
- * - Advances to the NEXT line (incrementing the iterator)
+ * - Pops the saved (line index, statement index) position, dropping FOR
+ *   and WHILE frames left open inside the subroutine
+ * - Jumps there directly without a line lookup
  * - Sets jumped_ flag to prevent further advancement
  *
- * Special case: If the return line no longer exists (deleted after GOSUB),
- * execution continues from the next available line.
+ * Program edits clear the GOSUB stack, so a saved position always refers
+ * to the program that pushed it.
  *
  * Error handling:
  * - Empty stack: "RETURN WITHOUT GOSUB ERROR"
- * - Missing return line: Advances to next line if available
  *
- * @throws std::runtime_error if GOSUB stack is empty
+ * Raises RETURN WITHOUT GOSUB ERROR if the GOSUB stack is empty
  */
 void Interpreter::returnFromGosub() {
-  if (gosubStack_.empty()) {
-    throw std::runtime_error("RETURN WITHOUT GOSUB ERROR");
-  }
-  LineNumber returnLine = gosubStack_.top();
-  gosubStack_.pop();
-
-  // Continue after the GOSUB line
-  // Find the line we returned from and advance to the next one
-  auto it = program_.find(returnLine);
-  if (it != program_.end()) {
-    ++it; // Move to next line
-    programCounter_ = it;
-    jumped_ = true;
+  if (topGosub_ == kNoFrame) {
+    raise(ErrorKind::ReturnWithoutGosub);
+    return;
   }
+  // Continue with the statement after the GOSUB
+  jumpTo(unwindGosub());
 }
 
 /**
@@ -958,7 +1518,7 @@ void Interpreter::stop() {
  * 1. Validate that program is in paused state
  * 2. Find the line where STOP occurred
  * 3. Advance to the NEXT line (don't re-execute STOP line)
- * 4. Resume normal execution loop
+ * 4. Resume the execution loop shared with RUN (see execute())
  *
  * State validation:
  * - Must have paused_ flag set (STOP was executed)
@@ -984,51 +1544,20 @@ void Interpreter::stop() {
  */
 void Interpreter::cont() {
   if (!paused_ || program_.empty() || continueAfterLine_ < 0) {
-    throw std::runtime_error("CANT CONTINUE");
+    throw RuntimeError(ErrorKind::CantContinue);
   }
   // Position to the line after the one that STOPped
-  auto it = program_.find(continueAfterLine_);
-  if (it == program_.end()) {
-    throw std::runtime_error("CANT CONTINUE");
+  size_t index = program_.indexOf(continueAfterLine_);
+  if (index == Program::npos) {
+    throw RuntimeError(ErrorKind::CantContinue);
   }
-  ++it; // Advance to next line
-  programCounter_ = it;
+  programCounter_ = index + 1; // Advance to next line
+  statementIndex_ = 0;
   running_ = true;
   immediate_ = false;
   paused_ = false;
 
-  try {
-    // Resume execution loop (similar to runFrom but continues where stopped)
-    while (running_ && programCounter_ != program_.end()) {
-      currentLine_ = programCounter_->first;
-      jumped_ = false;
-
-      // TRACE output if enabled
-      if (tracing_) {
-        std::cout << "[" << currentLine_ << "]";
-      }
-
-      for (auto &stmt : programCounter_->second.statements) {
-        stmt->execute(this);
-        if (!running_ || jumped_)
-          break;
-        applySpeedDelay();
-      }
-
-      if (!jumped_) {
-        ++programCounter_;
-      }
-    }
-  } catch (const std::exception &e) {
-    if (errorHandlerLine_ >= 0) {
-      errorLine_ = currentLine_;
-      lastError_ = e.what();
-      gotoLine(errorHandlerLine_);
-    } else {
-      std::cout << "?" << e.what() << " IN LINE " << currentLine_ << "\n";
-      running_ = false;
-    }
-  }
+  execute();
 }
 
 /**
@@ -1049,26 +1578,21 @@ void Interpreter::cont() {
  * - Parses each line and adds to program
  * - Silently ignores lines without valid line numbers
  * - On error, prints error message and continues
+ * - The file name "-" reads the program from standard input
  *
- * @param filename Path to BASIC program file
+ * @param filename Path to BASIC program file, or "-"
  */
 void Interpreter::loadProgram(const std::string &filename) {
   try {
-    std::string content = readTextFile(filename);
+    if (filename == "-") {
+      newProgram();
+      storeProgramStream(std::cin);
+      return;
+    }
+    MappedFile source(filename);
     newProgram();
 
-    std::istringstream iss(content);
-    std::string line;
-    while (std::getline(iss, line)) {
-      if (!line.empty()) {
-        LineNumber lineNum;
-        std::string code;
-        parseLine(line, lineNum, code);
-        if (lineNum >= 0) {
-          addLine(lineNum, code);
-        }
-      }
-    }
+    storeProgramFile(filename, source.data());
   } catch (const std::exception &e) {
     std::cout << "?" << e.what() << "\n";
   }
@@ -1085,6 +1609,9 @@ void Interpreter::loadProgram(const std::string &filename) {
  *
  * File Format:
  *   Each line: <line_number><space><code>
+ *   Programs loaded from an Applesoft tokenized file, or any program with
+ *   --save-format applesoft, are written in that format instead (see
+ *   applesoft_format.h)
  *
  * Behavior:
  * - Overwrites existing file without warning
@@ -1095,9 +1622,15 @@ void Interpreter::loadProgram(const std::string &filename) {
  */
 void Interpreter::saveProgram(const std::string &filename) {
   try {
+    if (saveFormat_.value_or(programFormat_) == ProgramFormat::Applesoft) {
+      FileManager::getInstance().saveBinaryFile(
+          filename, encodeApplesoftProgram(program_), kApplesoftProgramStart,
+          0);
+      return;
+    }
     std::ostringstream oss;
-    for (const auto &pair : program_) {
-      oss << pair.first << " " << pair.second.text << "\n";
+    for (const auto &line : program_) {
+      oss << line.lineNumber << " " << line.text << "\n";
     }
     writeTextFile(filename, oss.str());
   } catch (const std::exception &e) {
@@ -1130,27 +1663,14 @@ void Interpreter::saveProgram(const std::string &filename) {
  */
 void Interpreter::chainProgram(const std::string &filename) {
   try {
-    std::string content = readTextFile(filename);
+    MappedFile source(filename);
 
     // Clear program but keep variables
     program_.clear();
-    dataValues_.clear();
-    dataOffsets_.clear();
-    dataPointer_ = 0;
+    discardData();
 
     // Load new program
-    std::istringstream iss(content);
-    std::string line;
-    while (std::getline(iss, line)) {
-      if (!line.empty()) {
-        LineNumber lineNum;
-        std::string code;
-        parseLine(line, lineNum, code);
-        if (lineNum >= 0) {
-          addLine(lineNum, code);
-        }
-      }
-    }
+    storeProgramFile(filename, source.data());
 
     // Run the program
     run();
@@ -1179,27 +1699,14 @@ void Interpreter::chainProgram(const std::string &filename) {
  */
 void Interpreter::dashProgram(const std::string &filename) {
   try {
-    std::string content = readTextFile(filename);
+    MappedFile source(filename);
 
     // Clear program but keep variables
     program_.clear();
-    dataValues_.clear();
-    dataOffsets_.clear();
-    dataPointer_ = 0;
+    discardData();
 
     // Load new program
-    std::istringstream iss(content);
-    std::string line;
-    while (std::getline(iss, line)) {
-      if (!line.empty()) {
-        LineNumber lineNum;
-        std::string code;
-        parseLine(line, lineNum, code);
-        if (lineNum >= 0) {
-          addLine(lineNum, code);
-        }
-      }
-    }
+    storeProgramFile(filename, source.data());
 
     // Run the program
     run();
@@ -2008,11 +2515,12 @@ std::string sanitizeArrayName(const std::string &arrayName) {
  *   STORE A   (save to tape or A.arr)
  *
  * @param arrayName Name of array to save
- * @throws std::runtime_error if array undefined or I/O error
+ * @throws RuntimeError if the array is undefined, std::runtime_error on an
+ *         I/O error
  */
 void Interpreter::storeArray(const std::string &arrayName) {
   if (!variables_.hasArray(arrayName)) {
-    throw std::runtime_error("UNDEFINED ARRAY ERROR");
+    throw RuntimeError(ErrorKind::UndefinedArray);
   }
 
   // Use tape if available, otherwise fall back to file
@@ -2684,14 +3192,90 @@ void Interpreter::loadShapeTableFromFile(const std::string &filename) {
 }
 
 /**
- * @brief Add a data value to the DATA cache
+ * @brief Collect the DATA items of the program, unless already done
+ *
+ * Gathers the values of all DATA statements in line order into
+ * dataValues_, with the position of each line's first item in
+ * dataOffsets_ for RESTORE. The values were converted when their line
+ * was parsed, so READ only copies them.
+ *
+ * The result is kept until the program is edited (its epoch changes), so
+ * a program run many times collects its DATA once, and a run that never
+ * reads DATA does not collect it at all.
+ *
+ * Lines not parsed yet (lazy LOAD, or the line an eager LOAD stopped at)
+ * are parsed here only if their text may
+ * hold a DATA statement. One that fails to parse is recorded in
+ * dataSyntaxErrors_ at the position its items would have had: READ
+ * reaching it, or RESTORE to it, raises SYNTAX ERROR for that line, as
+ * loading it eagerly would have. (Its own syntax error is still reported
+ * if it executes.)
+ */
+void Interpreter::collectData() {
+  if (dataEpoch_ == program_.epoch()) {
+    return;
+  }
+  discardData();
+  for (auto &line : program_) {
+    if (!line.parsed) {
+      if (!mayContainData(line.text)) {
+        continue;
+      }
+      try {
+        parseProgramLine(line);
+      } catch (const std::exception &) {
+        dataSyntaxErrors_.push_back({line.lineNumber, dataValues_.size()});
+        continue;
+      }
+    }
+    size_t before = dataValues_.size();
+    for (const auto &stmt : line.statements) {
+      stmt->collectData(dataValues_);
+    }
+    if (dataValues_.size() > before) {
+      dataOffsets_.push_back({line.lineNumber, before});
+    }
+  }
+  dataEpoch_ = program_.epoch();
+  dataProgramItems_ = dataValues_.size();
+}
+
+/**
+ * @brief Point READ at the first DATA item of the program
+ *
+ * Drops items added by DATA statements typed at the prompt; the program's
+ * own items stay collected.
+ */
+void Interpreter::rewindData() {
+  dataPointer_ = 0;
+  dataNextSyntaxError_ = 0;
+  if (dataEpoch_ != 0) {
+    dataValues_.resize(dataProgramItems_);
+  }
+}
+
+/**
+ * @brief Forget the collected DATA items (the program is being replaced)
+ */
+void Interpreter::discardData() {
+  dataValues_.clear();
+  dataOffsets_.clear();
+  dataPointer_ = 0;
+  dataEpoch_ = 0;
+  dataProgramItems_ = 0;
+  dataSyntaxErrors_.clear();
+  dataNextSyntaxError_ = 0;
+}
+
+/**
+ * @brief Add a data value after the program's DATA items
  *
- * Called during program initialization to build the data cache. This is used
- * internally by the DATA statement collection process.
+ * Called by DATA statements executed at the prompt.
  *
  * @param value Value to add to data cache
  */
 void Interpreter::addDataValue(const Value &value) {
+  collectData();
   dataValues_.push_back(value);
 }
 
@@ -2708,18 +3292,27 @@ void Interpreter::addDataValue(const Value &value) {
  * Behavior:
  * - Returns next unread DATA value
  * - Advances data pointer
- * - Throws "OUT OF DATA ERROR" if no more data available
+ * - Raises "OUT OF DATA ERROR" if no more data available
+ * - Raises "SYNTAX ERROR" for a DATA line that did not parse (lazy LOAD)
+ *   when the next item would come from it or after it
  * - Works across multiple DATA statements
  * - Not affected by program control flow (GOTO, IF, etc.)
  *
- * @return Next value from DATA statements
- * @throws std::runtime_error if no more data available
+ * @return The next value, or nullptr if no more data was available (the
+ *         error is raised)
  */
-Value Interpreter::readData() {
+const Value *Interpreter::readData() {
+  collectData();
+  if (dataNextSyntaxError_ < dataSyntaxErrors_.size() &&
+      dataSyntaxErrors_[dataNextSyntaxError_].second == dataPointer_) {
+    raise(ErrorKind::Syntax, dataSyntaxErrors_[dataNextSyntaxError_].first);
+    return nullptr;
+  }
   if (dataPointer_ >= dataValues_.size()) {
-    throw std::runtime_error("OUT OF DATA ERROR");
+    raise(ErrorKind::OutOfData);
+    return nullptr;
   }
-  return dataValues_[dataPointer_++];
+  return &dataValues_[dataPointer_++];
 }
 
 /**
@@ -2736,27 +3329,39 @@ Value Interpreter::readData() {
  * - RESTORE with no argument: reset to first DATA value
  * - RESTORE line: reset to first DATA value at or after specified line
  * - If line has no DATA, pointer set to end (OUT OF DATA on next READ)
+ * - If the first line >= the target that may hold DATA did not parse
+ *   (lazy LOAD), SYNTAX ERROR is raised for it
  *
  * Algorithm:
- * - Uses dataOffsets_ map that links line numbers to positions in dataValues_
- * - Searches for first line >= target line that has DATA
- * - Sets dataPointer_ to corresponding position in dataValues_ array
+ * - dataOffsets_ lists the lines holding DATA, in line order, with the
+ *   position of each one's first item in dataValues_
+ * - A binary search finds the first such line >= the target line
  *
  * @param line Line number to restore to, or -1 for beginning
  */
 void Interpreter::restoreData(int line) {
+  collectData();
   if (line < 0) {
     dataPointer_ = 0;
+    dataNextSyntaxError_ = 0;
     return;
   }
 
-  dataPointer_ = dataValues_.size();
-  for (const auto &entry : dataOffsets_) {
-    if (entry.first >= line) {
-      dataPointer_ = entry.second;
-      break;
-    }
+  auto before = [](const auto &entry, int target) {
+    return entry.first < target;
+  };
+  auto it = std::lower_bound(dataOffsets_.begin(), dataOffsets_.end(), line,
+                             before);
+  auto bad = std::lower_bound(dataSyntaxErrors_.begin(),
+                              dataSyntaxErrors_.end(), line, before);
+  if (bad != dataSyntaxErrors_.end() &&
+      (it == dataOffsets_.end() || bad->first < it->first)) {
+    raise(ErrorKind::Syntax, bad->first);
+    return;
   }
+  dataPointer_ = it != dataOffsets_.end() ? it->second : dataValues_.size();
+  dataNextSyntaxError_ =
+      static_cast<size_t>(bad - dataSyntaxErrors_.begin());
 }
 
 /**
@@ -2948,7 +3553,7 @@ void Interpreter::updateTextAttributes() {
  *
  * @param text Text string to output
  */
-void Interpreter::printText(const std::string &text) {
+void Interpreter::printText(std::string_view text) {
   for (char ch : text) {
     std::cout << ch;
     if (ch == '\a') {
@@ -2963,6 +3568,14 @@ void Interpreter::printText(const std::string &text) {
   }
 }
 
+void Interpreter::printValue(const Value &value) {
+  if (value.isString()) {
+    printText(value.stringView());
+  } else {
+    printText(value.getString());
+  }
+}
+
 /**
  * @brief Print newline and update cursor tracking
  *
@@ -3054,10 +3667,11 @@ void Interpreter::resetOutputPosition() {
  * NEXT processing.
  *
  * Implementation details:
- * - Stores loop variable name, end value, step value, and return line
+ * - Stores the loop variable's symbol slot, end value, step value, and the
+ *   position of the statement after the FOR (so one-line loops work)
  * - Multiple nested FOR loops are supported through the stack
- * - Each FOR creates a new stack entry even if variable name reused
- * - NEXT processes loops from most recent (top of stack) backwards
+ * - A FOR on a variable that already controls an active loop drops that
+ *   loop and every loop inside it, as Applesoft does
  *
  * BASIC Usage:
  *   FOR I = 1 TO 10 STEP 2
@@ -3069,21 +3683,29 @@ void Interpreter::resetOutputPosition() {
  * Stack behavior:
  * - Nested loops push multiple entries
  * - NEXT pops completed loops
- * - Jumping out of loops leaves entries (cleaned by CLR or END)
+ * - Jumping out of loops leaves entries (cleaned by CLR, END, or the next
+ *   FOR on the same variable)
  *
- * @param varName Loop control variable name
+ * @param var Symbol slot of the loop control variable
  * @param endValue Final value for loop (TO value)
  * @param stepValue Increment per iteration (STEP value, default 1)
- * @param returnLine Line number where FOR appears (for loop restart)
  */
-void Interpreter::pushForLoop(const std::string &varName, double endValue,
-                              double stepValue, LineNumber returnLine) {
-  ForLoopInfo info;
-  info.varName = varName;
-  info.endValue = endValue;
-  info.stepValue = stepValue;
-  info.returnLine = returnLine;
-  forStack_.push_back(info);
+void Interpreter::pushForLoop(SymbolId var, double endValue,
+                              double stepValue) {
+  for (size_t i = controlStack_.size(); i > loopFramesBase(); --i) {
+    const ControlFrame &frame = controlStack_[i - 1];
+    if (frame.kind == ControlFrame::Kind::For && frame.var == var) {
+      controlStack_.resize(i - 1);
+      break;
+    }
+  }
+  ControlFrame frame;
+  frame.kind = ControlFrame::Kind::For;
+  frame.var = var;
+  frame.endValue = endValue;
+  frame.stepValue = stepValue;
+  frame.resume = nextStatementPosition();
+  pushFrame(frame);
 }
 
 /**
@@ -3093,12 +3715,12 @@ void Interpreter::pushForLoop(const std::string &varName, double endValue,
  * is currently controlling an active FOR loop. Used to prevent certain
  * operations that would corrupt loop state.
  *
- * @param varName Variable name to check
+ * @param var Symbol slot of the variable to check
  * @return true if variable is a FOR loop control variable, false otherwise
  */
-bool Interpreter::isInForLoop(const std::string &varName) {
-  for (const auto &loop : forStack_) {
-    if (loop.varName == varName)
+bool Interpreter::isInForLoop(SymbolId var) const {
+  for (const auto &frame : controlStack_) {
+    if (frame.kind == ControlFrame::Kind::For && frame.var == var)
       return true;
   }
   return false;
@@ -3107,19 +3729,24 @@ bool Interpreter::isInForLoop(const std::string &varName) {
 /**
  * @brief Process NEXT statement for loop iteration
  *
- * Handles the NEXT statement which increments the loop variable and either
- * continues the loop (jumping back to statement after FOR) or terminates it
- * (popping from stack and continuing forward).
+ * Handles one variable of a NEXT statement: increments the loop variable
+ * and either continues the loop (jumping back to statement after FOR) or
+ * terminates it (popping it from the stack and continuing forward).
  *
  * Algorithm:
- * 1. Find matching FOR loop (search backwards through stack)
+ * 1. Find matching FOR loop (search backwards through stack); loops
+ *    inside it are abandoned and dropped, as in Applesoft
  * 2. Increment loop variable by STEP value
  * 3. Check termination condition:
  *    - Positive STEP: continue if var <= end
  *    - Negative STEP: continue if var >= end
- * 4. If continuing: jump to line after FOR statement
+ * 4. If continuing: jump to the statement after FOR
  * 5. If done: pop loop from stack and continue forward
  *
+ * The frame already holds the variable slot, limit, step and resume
+ * position, so the common case (NEXT of the innermost loop) is one slot
+ * compare, one add and one limit test.
+ *
  * BASIC Usage:
  *   FOR I = 1 TO 10 STEP 2
  *     PRINT I
@@ -3130,49 +3757,145 @@ bool Interpreter::isInForLoop(const std::string &varName) {
  *   NEXT I
  *
  *   NEXT  (NEXT without variable matches most recent FOR)
+ *   NEXT J,I  (calls this once per variable until a loop repeats)
  *
  * Error handling:
  * - If no matching FOR found: "NEXT WITHOUT FOR ERROR"
- * - Variable name matching uses normalized names (2-char significance)
- * - Empty varName matches most recent loop (allows bare NEXT)
+ * - Variables match by symbol slot, so NEXT COUNT closes FOR CO
+ * - kNoSymbol matches most recent loop (allows bare NEXT)
  *
- * @param varName Loop variable name (empty string matches most recent loop)
- * @throws std::runtime_error if no matching FOR loop found
+ * @param var Symbol slot of the loop variable, or kNoSymbol for bare NEXT
+ * @return true if the loop finished and execution continues after it;
+ *         false if it jumped back to the loop body or raised an error
+ * Raises NEXT WITHOUT FOR ERROR if no matching FOR loop is found
  */
-void Interpreter::nextForLoop(const std::string &varName) {
-  // Find matching FOR loop
-  for (auto it = forStack_.rbegin(); it != forStack_.rend(); ++it) {
-    if (it->varName == varName || varName.empty()) {
+bool Interpreter::nextForLoop(SymbolId var) {
+  // Find matching FOR loop above the innermost GOSUB
+  for (size_t i = controlStack_.size(); i > loopFramesBase(); --i) {
+    ControlFrame &frame = controlStack_[i - 1];
+    if (frame.kind == ControlFrame::Kind::For &&
+        (frame.var == var || var == kNoSymbol)) {
+      controlStack_.resize(i);
+
       // Increment variable
-      Value current = variables_.getVariable(it->varName);
-      double newVal = current.getNumber() + it->stepValue;
-      variables_.setVariable(it->varName, Value(newVal));
+      double newVal =
+          variables_.getVariable(frame.var).getNumber() + frame.stepValue;
+      variables_.setNumber(frame.var, newVal);
 
       // Check if loop should continue
-      bool shouldContinue;
-      if (it->stepValue >= 0) {
-        shouldContinue = newVal <= it->endValue;
-      } else {
-        shouldContinue = newVal >= it->endValue;
-      }
-
+      bool shouldContinue = frame.stepValue >= 0 ? newVal <= frame.endValue
+                                                 : newVal >= frame.endValue;
       if (shouldContinue) {
-        // Jump back to line after FOR
-        auto lineIt = program_.find(it->returnLine);
-        if (lineIt != program_.end()) {
-          ++lineIt; // Move to next line
-          programCounter_ = lineIt;
-          jumped_ = true;
+        // A loop that keeps repeating is handed to the loop tier once
+        if (++frame.iterations == kHotLoopIterations && runLoopTier(frame)) {
+          return !jumped_;
         }
-      } else {
-        // Loop complete, remove from stack
-        forStack_.erase(std::next(it).base());
+        // Jump back to the statement after FOR
+        jumpTo(frame.resume);
+        return false;
       }
-      return;
+      if (frame.checked) {
+        checkLoopTier(i - 1);
+      }
+      // Loop complete, remove from stack
+      controlStack_.pop_back();
+      return true;
+    }
+  }
+
+  raise(ErrorKind::NextWithoutFor);
+  return false;
+}
+
+/**
+ * @brief Run the remainder of a hot FOR loop in the loop tier
+ *
+ * Called from NEXT when the innermost loop repeats for the
+ * kHotLoopIterations-th time. The loop body (from the statement after FOR
+ * to this NEXT) is compiled once per program edit; loops that are not
+ * purely numeric are remembered and stay in the interpreter. The tier is
+ * not used while TRACE or SPEED need to see every statement.
+ *
+ * On completion the FOR frame is popped and execution continues after the
+ * NEXT. On a bail-out the nested FOR frames that were open are recreated
+ * and execution continues at the statement that failed, which the
+ * interpreter then runs itself.
+ *
+ * In check mode the tier runs on a copy of the variables and the
+ * interpreter carries on normally; checkLoopTier() compares the two states
+ * when the loop ends.
+ */
+bool Interpreter::runLoopTier(ControlFrame &frame) {
+  if (!loopTier_ || tracing_ || speedDelayMs_ > 0 || immediate_ ||
+      frame.resume.line == Program::npos) {
+    return false;
+  }
+
+  if (loopTierEpoch_ != program_.epoch()) {
+    compiledLoops_.clear();
+    loopTierEpoch_ = program_.epoch();
+  }
+  std::array<size_t, 4> key{frame.resume.line, frame.resume.statement,
+                            programCounter_, statementIndex_};
+  auto [entry, inserted] = compiledLoops_.try_emplace(key);
+  if (inserted) {
+    entry->second = looptier::compile(
+        program_, {frame.resume.line, frame.resume.statement},
+        {programCounter_, statementIndex_}, frame.var, loopTierNative_);
+  }
+  std::shared_ptr<looptier::CompiledLoop> loop = entry->second;
+  if (!loop || loop->loops[0].var != frame.var) {
+    return false;
+  }
+
+  if (loopTierCheck_) {
+    auto shadow = std::make_shared<Variables>(variables_);
+    if (looptier::run(*loop, *shadow, frame.endValue, frame.stepValue)
+            .completed) {
+      size_t index = controlStack_.size() - 1;
+      if (loopTierShadows_.size() <= index) {
+        loopTierShadows_.resize(index + 1);
+      }
+      loopTierShadows_[index] = shadow;
+      frame.checked = true;
+    }
+    return false;
+  }
+
+  looptier::Exit exit =
+      looptier::run(*loop, variables_, frame.endValue, frame.stepValue);
+  if (exit.completed) {
+    controlStack_.pop_back();
+    return true;
+  }
+  for (const auto &open : exit.open) {
+    const looptier::Loop &nested = loop->loops[open.loop];
+    ControlFrame info;
+    info.kind = ControlFrame::Kind::For;
+    info.var = nested.var;
+    info.endValue = open.limit;
+    info.stepValue = open.step;
+    info.resume = {nested.resume.line, nested.resume.statement};
+    if (!pushFrame(info)) {
+      return true;
     }
   }
+  jumpTo({exit.position.line, exit.position.statement});
+  return true;
+}
 
-  throw std::runtime_error("NEXT WITHOUT FOR ERROR");
+/**
+ * @brief Compare a finished loop against its loop tier result (check mode)
+ */
+void Interpreter::checkLoopTier(size_t index) {
+  std::string difference =
+      variables_.firstDifference(*loopTierShadows_[index]);
+  if (!difference.empty()) {
+    ++loopTierMismatches_;
+    std::cerr << "LOOP TIER MISMATCH IN LINE " << currentLine_ << ": "
+              << difference << "\n";
+  }
+  loopTierShadows_[index].reset();
 }
 
 /**
@@ -3187,9 +3910,10 @@ void Interpreter::nextForLoop(const std::string &varName) {
  *
  * Error handler behavior:
  * - When error occurs, errorLine_ is set to the line where error happened
- * - lastError_ contains the error message text
+ * - lastError_ holds the error code
  * - Memory location 218-219 contains error line number
- * - Memory location 222 contains ProDOS error code
+ * - Memory location 222 contains the Applesoft error number (errorCode())
+ *   or, for file errors, the ProDOS error code
  * - RESUME statement returns to the error line
  *
  * @param lineNum Target line number for error handler
@@ -3198,6 +3922,77 @@ void Interpreter::setErrorHandler(LineNumber lineNum) {
   errorHandlerLine_ = lineNum;
 }
 
+/**
+ * @brief Raise a runtime error without throwing
+ *
+ * Records the error together with the statement that raised it and stops
+ * the current line the way a jump does. The raising statement returns
+ * without further effects; runFrom() then dispatches the error exactly as
+ * it would a thrown one (ONERR handler or message), but without unwinding
+ * the stack or formatting a message. Used for the statement-level errors
+ * that programs commonly trap with ONERR GOTO.
+ *
+ * @param kind Error code
+ * @param line Line to report, or -1 for the current line
+ */
+void Interpreter::raise(ErrorKind kind, LineNumber line) {
+  pendingError_ = {kind, {programCounter_, statementIndex_}, line};
+  jumped_ = true;
+}
+
+/**
+ * @brief Take the pending error raised by raise(), leaving none
+ */
+Interpreter::PendingError Interpreter::takeError() {
+  PendingError error = pendingError_;
+  pendingError_ = PendingError{};
+  return error;
+}
+
+/**
+ * @brief Pass a runtime error to the ONERR handler
+ *
+ * Records the error for RESUME and PEEK, then jumps to the handler line.
+ *
+ * @param kind Error code (Other for host exceptions)
+ * @param where Statement that failed
+ * @return false if no handler is set; the caller reports the error
+ * @throws RuntimeError UNDEF'D STATEMENT ERROR if the handler line is
+ *         missing (ends the run)
+ */
+bool Interpreter::trapError(ErrorKind kind, const ProgramPosition &where) {
+  if (errorHandlerLine_ < 0) {
+    return false;
+  }
+  errorLine_ = currentLine_;
+  errorPosition_ = where;
+  lastError_ = kind;
+
+  // Store error information in memory locations for PEEK access
+  // These locations match Applesoft BASIC conventions:
+  // Location 218-219 (0xDA-0xDB): error line number (little-endian)
+  // Location 222 (0xDE): error code
+  pokeMemory(0x00DA, errorLine_ & 0xFF);
+  pokeMemory(0x00DB, (errorLine_ >> 8) & 0xFF);
+
+  // Applesoft error number of the kind; a host failure keeps the ProDOS
+  // code handleError() gave it
+  int code = errorCode(kind);
+  if (kind == ErrorKind::Other && hostErrorCode_ >= 0) {
+    code = hostErrorCode_;
+  }
+  hostErrorCode_ = -1;
+  pokeMemory(0x00DE, code);
+
+  // Jump to error handler line
+  size_t handler = program_.indexOf(errorHandlerLine_);
+  if (handler == Program::npos) {
+    throw RuntimeError(ErrorKind::UndefinedStatement);
+  }
+  transferTo(handler);
+  return true;
+}
+
 /**
  * @brief Throw a runtime error
  *
@@ -3235,6 +4030,7 @@ void Interpreter::handleError(const std::string &message) {
 void Interpreter::handleError(const std::string &message, int errorCode) {
   // Store error code in memory location 222 for ProDOS compatibility
   pokeMemory(0x00DE, errorCode);
+  hostErrorCode_ = errorCode;
   throw std::runtime_error(message);
 }
 
@@ -3253,20 +4049,21 @@ void Interpreter::handleError(const std::string &message, int errorCode) {
  *   9020 RESUME
  *
  * Behavior:
- * - Jumps to the line number stored in errorLine_
+ * - Jumps back to the statement that raised the error (errorPosition_)
  * - Clears errorLine_ to prevent multiple RESUMEs
  * - If no error active: "RESUME WITHOUT ERROR"
  *
  * Note: Unlike some BASIC dialects, this implementation does not support
- * RESUME NEXT (continue after error line). Only RESUME (retry error line).
+ * RESUME NEXT (continue after error). Only RESUME (retry the statement).
  *
- * @throws std::runtime_error if no active error to resume from
+ * Raises RESUME WITHOUT ERROR if there is no error to resume from
  */
 void Interpreter::resume() {
   if (errorLine_ < 0) {
-    throw std::runtime_error("RESUME WITHOUT ERROR");
+    raise(ErrorKind::ResumeWithoutError);
+    return;
   }
-  gotoLine(errorLine_);
+  jumpTo(errorPosition_);
   errorLine_ = -1;
 }
 
@@ -3435,6 +4232,59 @@ void Interpreter::applySpeedDelay() {
   std::this_thread::sleep_for(std::chrono::milliseconds(speedDelayMs_));
 }
 
+/**
+ * @brief Finish a top-level statement (shared by both execution engines)
+ *
+ * Stops the rest of the line when the statement jumped (GOTO, GOSUB,
+ * RETURN, NEXT...) or halted the program; otherwise advances the statement
+ * index and applies the SPEED delay before the next statement.
+ *
+ * @return true if the next statement on the line should run
+ */
+bool Interpreter::finishStatement() {
+  if (!running_ || jumped_)
+    return false;
+  ++statementIndex_;
+  applySpeedDelay();
+  return true;
+}
+
+/**
+ * @brief Execute the statements of one stored program line
+ *
+ * Starts at statementIndex_, which is 0 for sequential flow and may point
+ * mid-line after RETURN, NEXT, WEND or RESUME. A line that is not parsed
+ * yet (lazy LOAD, or a line that failed an eager LOAD) is parsed first; its syntax error is thrown to the run loop, which reports
+ * it for this line. Uses the selected execution
+ * engine. Under the bytecode engine the line is compiled on first use and
+ * the chunk is cached on the ProgramLine; editing the line replaces the
+ * ProgramLine and therefore drops the stale chunk.
+ *
+ * @param line Program line to execute
+ */
+void Interpreter::executeLine(ProgramLine &line) {
+  if (!line.parsed) {
+    parseProgramLine(line);
+  }
+  if (engine_ == ExecutionEngine::Bytecode) {
+    if (!line.bytecode) {
+      line.bytecode = bytecode::compileLine(line.statements);
+    }
+    // Hold a reference so the chunk outlives the line if a statement
+    // replaces the program (CHAIN) while it is running
+    std::shared_ptr<bytecode::Chunk> chunk = line.bytecode;
+    bytecode::execute(*chunk, this, statementIndex_);
+    return;
+  }
+
+  while (statementIndex_ < line.statements.size()) {
+    line.statements[statementIndex_]->execute(this);
+    // Stop executing statements if we've jumped or stopped
+    if (!finishStatement())
+      break;
+  }
+}
+
 /**
  * @brief Push WHILE loop state onto stack (WHILE implementation helper)
  *
@@ -3449,7 +4299,7 @@ void Interpreter::applySpeedDelay() {
  *
  * Stack entry contains:
  * - condition: Expression to re-evaluate at WEND
- * - returnLine: Line number to jump to if continuing
+ * - resume: Position of the statement after WHILE
  *
  * BASIC Usage:
  *   10 X = 0
@@ -3458,15 +4308,39 @@ void Interpreter::applySpeedDelay() {
  *   40   X = X + 1
  *   50 WEND
  *
+ * Entering a WHILE whose frame is still open (the loop was left with
+ * GOTO) drops that frame and the ones above it, like FOR does for its
+ * variable, so such loops do not fill the stack.
+ *
  * @param condition Expression to evaluate for loop continuation
- * @param returnLine Line number to return to when continuing loop
+ * @param owner Arena holding @p condition (pinned if it is not the
+ *              program's or the current line's, since immediate lines are
+ *              freed after they run)
  */
-void Interpreter::pushWhileLoop(std::shared_ptr<Expression> condition,
-                                LineNumber returnLine) {
-  WhileLoopInfo info;
-  info.condition = condition;
-  info.returnLine = returnLine;
-  whileStack_.push_back(info);
+void Interpreter::pushWhileLoop(Expression *condition, AstArena &owner) {
+  for (size_t i = controlStack_.size(); i > loopFramesBase(); --i) {
+    const ControlFrame &frame = controlStack_[i - 1];
+    if (frame.kind == ControlFrame::Kind::While &&
+        frame.condition == condition) {
+      controlStack_.resize(i - 1);
+      break;
+    }
+  }
+  ControlFrame frame;
+  frame.kind = ControlFrame::Kind::While;
+  frame.condition = condition;
+  frame.resume = nextStatementPosition();
+  if (!pushFrame(frame)) {
+    return;
+  }
+  // A program line outlives the frame (editing clears the stack)
+  bool programLine = program_.ownsArena(&owner) ||
+                     (!immediate_ && programCounter_ < program_.size() &&
+                      program_[programCounter_].arena.get() == &owner);
+  if (!programLine &&
+      (pinnedArenas_.empty() || pinnedArenas_.back().get() != &owner)) {
+    pinnedArenas_.push_back(owner.shared_from_this());
+  }
 }
 
 /**
@@ -3476,9 +4350,10 @@ void Interpreter::pushWhileLoop(std::shared_ptr<Expression> condition,
  * This implements the WEND statement which closes a WHILE loop.
  *
  * Behavior:
- * - Pops WHILE loop info from stack
+ * - Finds the innermost WHILE frame above the innermost GOSUB and drops
+ *   any frames above it
  * - Re-evaluates the loop condition
- * - If true: Jumps back to line after WHILE statement
+ * - If true: Jumps back to the statement after WHILE
  * - If false: Continues to next statement (exits loop)
  *
  * Error conditions:
@@ -3489,36 +4364,39 @@ void Interpreter::pushWhileLoop(std::shared_ptr<Expression> condition,
  *     X = X + 1
  *   WEND  (check condition and loop or continue)
  *
- * @throws std::runtime_error if no matching WHILE found
+ * Raises WEND WITHOUT WHILE ERROR if no WHILE is active
  */
 void Interpreter::nextWhileLoop() {
-  if (whileStack_.empty()) {
-    throw std::runtime_error("WEND WITHOUT WHILE ERROR");
+  size_t i = controlStack_.size();
+  while (i > loopFramesBase() &&
+         controlStack_[i - 1].kind != ControlFrame::Kind::While) {
+    --i;
+  }
+  if (i == loopFramesBase()) {
+    raise(ErrorKind::WendWithoutWhile);
+    return;
   }
+  controlStack_.resize(i);
 
-  WhileLoopInfo &loop = whileStack_.back();
+  const ControlFrame &loop = controlStack_.back();
   Value val = loop.condition->evaluate(this);
 
   if (val.getNumber() != 0) {
-    // Condition still true, jump back to line after WHILE
-    auto it = program_.find(loop.returnLine);
-    if (it != program_.end()) {
-      ++it;
-      programCounter_ = it;
-      jumped_ = true;
-    }
+    // Condition still true, jump back to the statement after WHILE
+    jumpTo(loop.resume);
   } else {
     // Condition false, exit loop
-    whileStack_.pop_back();
+    controlStack_.pop_back();
   }
 }
 
 /**
  * @brief Pop GOSUB return address from stack (POP implementation)
  *
- * Removes the top entry from the GOSUB stack without returning. This
- * implements the POP command from Applesoft BASIC which allows exiting
- * from a subroutine without using RETURN.
+ * Removes the innermost GOSUB frame (and the loops opened inside the
+ * subroutine) without returning. This implements the POP command from
+ * Applesoft BASIC which allows exiting from a subroutine without using
+ * RETURN.
  *
  * Use cases:
  * - Exit subroutine early without returning
@@ -3535,13 +4413,14 @@ void Interpreter::nextWhileLoop() {
  *   1000 IF X < 0 THEN POP: GOTO 100  (restart instead of return)
  *   1010 RETURN
  *
- * @throws std::runtime_error if GOSUB stack is empty
+ * Raises POP WITHOUT GOSUB ERROR if the GOSUB stack is empty
  */
 void Interpreter::popGosub() {
-  if (gosubStack_.empty()) {
-    throw std::runtime_error("POP WITHOUT GOSUB ERROR");
+  if (topGosub_ == kNoFrame) {
+    raise(ErrorKind::PopWithoutGosub);
+    return;
   }
-  gosubStack_.pop();
+  unwindGosub();
 }
 
 /**
@@ -3658,27 +4537,14 @@ void Interpreter::catalogFiles(const std::string &path) {
  */
 void Interpreter::chainProgram(const std::string &filename, int startLine) {
   try {
-    std::string content = readTextFile(filename);
+    MappedFile source(filename);
 
     // Clear program but keep variables
     program_.clear();
-    dataValues_.clear();
-    dataOffsets_.clear();
-    dataPointer_ = 0;
+    discardData();
 
     // Load new program
-    std::istringstream iss(content);
-    std::string line;
-    while (std::getline(iss, line)) {
-      if (!line.empty()) {
-        LineNumber lineNum;
-        std::string code;
-        parseLine(line, lineNum, code);
-        if (lineNum >= 0) {
-          addLine(lineNum, code);
-        }
-      }
-    }
+    storeProgramFile(filename, source.data());
 
     // Run the program from the specified starting line
     if (startLine > 0) {
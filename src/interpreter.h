@@ -27,16 +27,23 @@
 
 #pragma once
 
+#include "applesoft_format.h"
+#include "errors.h"
 #include "functions.h"
+#include "loop_tier.h"
 #include "parser.h"
+#include "program.h"
 #include "types.h"
 #include "variables.h"
 #include "graphics_config.h"
 #include "tape_manager.h"
+#include <array>
+#include <iosfwd>
 #include <map>
 #include <memory>
-#include <stack>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 /**
@@ -171,9 +178,73 @@ public:
    * @param text Line content (statements)
    * 
    * If line exists, replaces it; otherwise inserts new line in sorted order.
-   * Empty text deletes the line.
+   * Empty text deletes the line. The text is moved into the program.
    */
-  void addLine(LineNumber lineNum, const std::string &text);
+  void addLine(LineNumber lineNum, std::string text);
+
+  /**
+   * @brief Defer parsing of loaded program lines
+   *
+   * With lazy parsing, LOAD and CHAIN only record each line's number and
+   * text. A line is tokenized and parsed the first time it executes (or
+   * when the first READ or RESTORE collects DATA, for lines that may hold
+   * DATA), so a large program whose run touches few lines loads almost
+   * instantly. A syntax
+   * error is then reported when the line first executes, with its line
+   * number, instead of stopping the LOAD. Lines typed at the prompt are
+   * always parsed at once.
+   *
+   * @param enabled true to parse loaded lines on first use
+   */
+  void setLazyParsing(bool enabled) { lazyParsing_ = enabled; }
+
+  /**
+   * @brief Number of threads that parse a loaded program
+   *
+   * LOAD and CHAIN split large files into blocks of lines that are
+   * tokenized and parsed in parallel, then stored in file order. The
+   * result, including which syntax error is reported, is the same as a
+   * serial load.
+   *
+   * @param threads Worker count; 0 picks one from the file size and the
+   *                hardware, 1 always loads serially
+   */
+  void setLoadThreads(size_t threads) { loadThreads_ = threads; }
+
+  /**
+   * @brief Use the tokenized program cache for LOAD and CHAIN
+   *
+   * With the cache enabled (the default), a program file that was loaded
+   * before and has not changed since is rebuilt from its cache file
+   * instead of being tokenized again (see program_cache.h).
+   *
+   * @param enabled false to always load from the source text
+   */
+  void setProgramCache(bool enabled) { programCache_ = enabled; }
+
+  /**
+   * @brief Free each program line's tokens once it is parsed
+   *
+   * Tokens are only the parser's input: statements keep their own copies
+   * of names and literals, and LIST prints each line's source text. For a
+   * large program the token vectors are the largest part of what stays in
+   * memory, and this drops them. Writing the program cache then tokenizes
+   * the lines again.
+   *
+   * @param enabled true to keep only text and statements per line
+   */
+  void setDropTokens(bool enabled) { dropTokens_ = enabled; }
+
+  /**
+   * @brief File format written by SAVE
+   *
+   * By default SAVE keeps the format the program was loaded from: text,
+   * or Applesoft tokenized (see applesoft_format.h). Setting a format
+   * makes SAVE always write it.
+   *
+   * @param format Format of every saved program
+   */
+  void setSaveFormat(ProgramFormat format) { saveFormat_ = format; }
   
   /**
    * @brief Delete program line
@@ -198,6 +269,94 @@ public:
    */
   void runFrom(LineNumber lineNum);
   
+  /**
+   * @brief Select how stored program lines are executed
+   * @param engine TreeWalker (default) or Bytecode
+   */
+  void setExecutionEngine(ExecutionEngine engine) { engine_ = engine; }
+
+  /**
+   * @brief Get the engine used for stored program lines
+   * @return Currently selected execution engine
+   */
+  ExecutionEngine getExecutionEngine() const { return engine_; }
+
+  /**
+   * @brief Enable or disable constant folding of newly parsed lines
+   * @param enabled true (default) to fold constant subexpressions
+   */
+  void setConstantFolding(bool enabled) { foldConstants_ = enabled; }
+
+  /**
+   * @brief Get the number of AST nodes removed by constant folding
+   * @return Total over every line parsed by this interpreter
+   */
+  size_t foldedNodes() const { return foldedNodes_; }
+
+  /**
+   * @brief Get the stored program image
+   * @return Program lines and the arena that owns their statements
+   */
+  const Program &program() const { return program_; }
+
+  /**
+   * @brief Enable or disable superinstruction fusion of newly parsed lines
+   * @param enabled true (default) to fuse hot statement shapes
+   */
+  void setSuperinstructions(bool enabled) { superinstructions_ = enabled; }
+
+  /**
+   * @brief Enable or disable the loop tier for hot numeric FOR loops
+   * @param enabled true (default) to run hot numeric loops compiled
+   */
+  void setLoopTier(bool enabled) { loopTier_ = enabled; }
+
+  /**
+   * @brief Run the loop tier as machine code where supported
+   * @param enabled true (default) for native code on Linux x86-64, false to
+   *        always use the portable dispatch loop
+   */
+  void setLoopTierNative(bool enabled) { loopTierNative_ = enabled; }
+
+  /**
+   * @brief Cross-check the loop tier against the interpreter
+   *
+   * Each hot loop is run by the tier on a copy of the variables while the
+   * interpreter runs it on the real ones; when the loop ends both states
+   * are compared and any difference is reported on stderr.
+   *
+   * @param enabled true to enable checking
+   */
+  void setLoopTierCheck(bool enabled) { loopTierCheck_ = enabled; }
+
+  /**
+   * @brief Get the number of loops whose tier result differed
+   * @return Mismatches found since the interpreter was created
+   */
+  size_t loopTierMismatches() const { return loopTierMismatches_; }
+
+  /**
+   * @brief Limit the shared GOSUB/FOR/WHILE stack
+   *
+   * A GOSUB, FOR or WHILE that would exceed the limit raises OUT OF MEMORY
+   * ERROR. The frames are preallocated, so running programs never allocate
+   * on the control stack.
+   *
+   * @param frames Maximum number of frames (at least 1)
+   */
+  void setControlStackDepth(size_t frames);
+
+  /**
+   * @brief Finish one top-level statement of a program line
+   * @return true to continue with the next statement on the line, false if
+   *         the statement jumped or stopped the program
+   *
+   * Advances the statement index and applies the SPEED delay when execution
+   * continues. Shared by the tree walker and the bytecode VM so both honour
+   * the same statement boundary.
+   */
+  bool finishStatement();
+
   /**
    * @brief Execute single line without line number (immediate mode)
    * @param line BASIC statement(s) to execute
@@ -255,6 +414,13 @@ public:
    * @throws RuntimeError if line not found
    */
   void gotoLine(LineNumber lineNum);
+
+  /**
+   * @brief Jump to a linked target line (GOTO, ON...GOTO)
+   * @param target Linked reference; re-resolved only after program edits
+   * @throws RuntimeError if line not found
+   */
+  void gotoLine(LineRef &target);
   
   /**
    * @brief Call subroutine at line (GOSUB)
@@ -264,6 +430,13 @@ public:
    * Pushes return address on GOSUB stack and jumps to target line.
    */
   void gosub(LineNumber lineNum);
+
+  /**
+   * @brief Call subroutine at a linked target line (GOSUB, ON...GOSUB)
+   * @param target Linked reference; re-resolved only after program edits
+   * @throws RuntimeError if line not found
+   */
+  void gosub(LineRef &target);
   
   /**
    * @brief Return from subroutine (RETURN)
@@ -331,7 +504,13 @@ public:
    * Respects current text attributes (inverse, flash) and handles
    * TAB/SPC positioning.
    */
-  void printText(const std::string &text);
+  void printText(std::string_view text);
+
+  /**
+   * @brief Output a value as PRINT shows it
+   * @param value Value to print (strings are written without copying)
+   */
+  void printValue(const Value &value);
   
   /**
    * @brief Output newline
@@ -365,19 +544,42 @@ public:
 
   // Data statements
   void addDataValue(const Value &value);
-  Value readData();
+  /**
+   * @brief Next DATA item, or nullptr once OUT OF DATA has been raised
+   *
+   * Valid until the next DATA statement runs or the program changes.
+   */
+  const Value *readData();
   void restoreData(int line = -1);
 
-  // FOR loops
-  void pushForLoop(const std::string &varName, double endValue,
-                   double stepValue, LineNumber returnLine);
-  bool isInForLoop(const std::string &varName);
-  void nextForLoop(const std::string &varName);
+  // FOR loops (the loop resumes at the statement after the FOR)
+  void pushForLoop(SymbolId var, double endValue, double stepValue);
+  bool isInForLoop(SymbolId var) const;
+  bool nextForLoop(SymbolId var);
 
   // Error handling
   void setErrorHandler(LineNumber lineNum);
   void handleError(const std::string &message);
   void handleError(const std::string &message, int errorCode);
+
+  /**
+   * @brief Raise a runtime error without throwing
+   *
+   * The caller must return without further side effects; the run loop
+   * dispatches the error after the statement. In immediate mode it is
+   * rethrown as RuntimeError once the statement returns.
+   *
+   * @param kind Error code
+   * @param line Line the error is reported for (and ONERR records), if
+   *        not the current one: READ reaching a DATA line that did not
+   *        parse reports that line
+   */
+  void raise(ErrorKind kind, LineNumber line = -1);
+
+  /** @brief true while an error from raise() has not been dispatched */
+  bool errorPending() const {
+    return pendingError_.kind != ErrorKind::None;
+  }
   void resume();
 
   // Debugging
@@ -397,9 +599,8 @@ public:
   int getOutputDevice() const { return outputDevice_; }
   int getInputDevice() const { return inputDevice_; }
 
-  // WHILE loops
-  void pushWhileLoop(std::shared_ptr<Expression> condition,
-                     LineNumber returnLine);
+  // WHILE loops (the loop resumes at the statement after the WHILE)
+  void pushWhileLoop(Expression *condition, AstArena &owner);
   void nextWhileLoop();
 
   // Memory management
@@ -482,38 +683,154 @@ public:
 
 private:
   Variables variables_;
-  std::map<LineNumber, ProgramLine> program_;
+  Program program_;
 
   // Execution state
   LineNumber currentLine_;
   bool running_;
   bool immediate_;
   bool jumped_; // Flag to prevent auto-increment after GOTO/GOSUB
-  std::map<LineNumber, ProgramLine>::iterator programCounter_;
+  size_t programCounter_ = 0; // Index of the executing line in program_
+  size_t statementIndex_ = 0; // Index of the executing statement in the line
   bool paused_ = false;
   LineNumber continueAfterLine_ = -1;
+  uint64_t linkedEpoch_ = 0; // Program epoch of the last link pass
+  ExecutionEngine engine_ = ExecutionEngine::TreeWalker;
+  bool foldConstants_ = true;
+  size_t foldedNodes_ = 0; // AST nodes removed by constant folding
+  bool superinstructions_ = true;
+  bool lazyParsing_ = false;
+  size_t loadThreads_ = 0; // 0 = choose from program size
+  bool programCache_ = true;
+  bool dropTokens_ = false;
+  ProgramFormat programFormat_ = ProgramFormat::Text; // of the last LOAD
+  std::optional<ProgramFormat> saveFormat_; // unset: save as loaded
+
+  // Loop tier (see loop_tier.h): compiled loops keyed by body start and
+  // NEXT position; null entries mark loops that cannot be compiled
+  static constexpr uint32_t kHotLoopIterations = 16;
+  bool loopTier_ = true;
+  bool loopTierNative_ = true;
+  bool loopTierCheck_ = false;
+  size_t loopTierMismatches_ = 0;
+  uint64_t loopTierEpoch_ = 0;
+  std::map<std::array<size_t, 4>, std::shared_ptr<looptier::CompiledLoop>>
+      compiledLoops_;
+
+  // Resume point for RETURN/NEXT/WEND/RESUME: line index into program_
+  // plus statement index within that line. line == Program::npos marks a
+  // frame pushed in immediate mode, which has no program position.
+  struct ProgramPosition {
+    size_t line;
+    size_t statement;
+  };
 
-  // GOSUB stack
-  std::stack<LineNumber> gosubStack_;
-
-  // FOR loop tracking
-  struct ForLoopInfo {
-    std::string varName;
-    double endValue;
-    double stepValue;
-    LineNumber returnLine;
+  /**
+   * @brief One frame of the control stack
+   *
+   * GOSUB, FOR and WHILE share one stack, as in Applesoft: RETURN and POP
+   * drop the loops opened inside the subroutine, and NEXT/WEND only see
+   * the loops above the innermost GOSUB. Frames are plain data, so dropping
+   * any number of them just shortens the stack.
+   */
+  struct ControlFrame {
+    enum class Kind : uint8_t { Gosub, For, While };
+    Kind kind;
+    bool checked = false; // FOR: a loop tier result waits in check mode
+    SymbolId var = kNoSymbol; // FOR: loop variable
+    uint32_t iterations = 0; // FOR: NEXTs that repeated the loop
+    size_t outerGosub = 0; // GOSUB: previous value of topGosub_
+    ProgramPosition resume{Program::npos, 0};
+    double endValue = 0; // FOR: TO value
+    double stepValue = 0; // FOR: STEP value
+    Expression *condition = nullptr; // WHILE: condition to re-test
   };
-  std::vector<ForLoopInfo> forStack_;
 
-  // DATA/READ support
+  static constexpr size_t kNoFrame = static_cast<size_t>(-1);
+
+  // Capacity is reserved up to the depth limit and never exceeded
+  std::vector<ControlFrame> controlStack_;
+  size_t controlStackDepth_ = kDefaultControlStackDepth;
+  size_t topGosub_ = kNoFrame; // Index of the innermost GOSUB frame
+
+  /** @brief Keeps immediate-line arenas of live WHILE frames alive */
+  std::vector<std::shared_ptr<AstArena>> pinnedArenas_;
+
+  /**
+   * @brief Push a frame, raising OUT OF MEMORY ERROR when the stack is full
+   * @return false if the frame was not pushed
+   */
+  bool pushFrame(const ControlFrame &frame);
+
+  /** @brief Push a GOSUB frame resuming after the current statement */
+  bool pushGosub();
+
+  /** @brief Index of the first frame above the innermost GOSUB */
+  size_t loopFramesBase() const {
+    return topGosub_ == kNoFrame ? 0 : topGosub_ + 1;
+  }
+
+  /** @brief Drop the GOSUB frame at topGosub_ and every frame above it */
+  ProgramPosition unwindGosub();
+
+  /**
+   * @brief Run the rest of a hot loop in the loop tier
+   * @param frame Innermost FOR frame, whose NEXT is executing
+   * @return true if the tier finished the loop or moved the program
+   *         counter to a bail-out position
+   */
+  bool runLoopTier(ControlFrame &frame);
+
+  /**
+   * @brief Compare a finished loop against its loop tier result
+   * @param index Control stack index of the loop's FOR frame
+   */
+  void checkLoopTier(size_t index);
+
+  // Check mode loop tier results, indexed like the FOR frames they belong to
+  std::vector<std::shared_ptr<Variables>> loopTierShadows_;
+
+  // DATA/READ support: every DATA item of the program in line order, the
+  // first item of each line holding DATA, and the program epoch they were
+  // collected at (0: not collected). Items from DATA statements typed at
+  // the prompt follow the program's dataProgramItems_.
   std::vector<Value> dataValues_;
   size_t dataPointer_;
-  std::vector<std::pair<int, size_t>> dataOffsets_;
+  std::vector<std::pair<LineNumber, size_t>> dataOffsets_;
+  uint64_t dataEpoch_ = 0;
+  size_t dataProgramItems_ = 0;
+  // Lines that may hold DATA but did not parse (lazy LOAD), each with the
+  // position in dataValues_ its items would have started at, and the
+  // first of them READ has not passed yet
+  std::vector<std::pair<LineNumber, size_t>> dataSyntaxErrors_;
+  size_t dataNextSyntaxError_ = 0;
 
   // Error handling
   LineNumber errorHandlerLine_;
-  std::string lastError_;
+  ErrorKind lastError_ = ErrorKind::None;
   LineNumber errorLine_;
+  ProgramPosition errorPosition_{Program::npos, 0};
+
+  /** @brief Error recorded by raise() and the statement that raised it */
+  struct PendingError {
+    ErrorKind kind = ErrorKind::None;
+    ProgramPosition where{Program::npos, 0};
+    LineNumber line = -1; ///< reported line, -1 for the current one
+  };
+  PendingError pendingError_;
+  int hostErrorCode_ = -1; // ProDOS code of the host error being thrown
+
+  /** @brief Take the pending error, leaving none */
+  PendingError takeError();
+
+  /**
+   * @brief Hand an error to the ONERR handler
+   * @return false if no handler is set (the caller reports the error)
+   */
+  bool trapError(ErrorKind kind, const ProgramPosition &where);
+
+  /** @brief Run lines from programCounter_ (the loop of RUN and CONT) */
+  void execute();
 
   // Debugging
   bool tracing_ = false;
@@ -541,17 +858,28 @@ private:
   TapeManager tapeManager_;
   std::string tapeHotkey_ = "\x1B" "T"; // ESC-T by default
 
-  // WHILE loop tracking
-  struct WhileLoopInfo {
-    std::shared_ptr<Expression> condition;
-    LineNumber returnLine;
-  };
-  std::vector<WhileLoopInfo> whileStack_;
-
   // Helper methods
-  void parseLine(const std::string &line, LineNumber &lineNum,
+  void parseLine(std::string_view line, LineNumber &lineNum,
                  std::string &code);
   bool isLineNumber(const std::string &text) const;
   void updateTextAttributes();
   void applySpeedDelay();
+  void executeLine(ProgramLine &line);
+  void parseProgramLine(ProgramLine &line);
+  struct LoadedLine;
+  void storeLoadedLine(std::string_view line);
+  void storeLoadedLine(ProgramLine line);
+  void storeLoadedLines(std::vector<LoadedLine> &lines);
+  void storeProgramText(std::string_view content);
+  void storeProgramFile(const std::string &filename, std::string_view content);
+  void storeProgramStream(std::istream &in);
+  size_t loadThreadCount(size_t lines) const;
+  ProgramPosition nextStatementPosition() const;
+  void jumpTo(const ProgramPosition &pos);
+  void transferTo(size_t index);
+  void linkProgram();
+  void clearControlStacks();
+  void collectData();
+  void rewindData();
+  void discardData();
 };
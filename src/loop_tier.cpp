@@ -0,0 +1,306 @@
+/**
+ * @file loop_tier.cpp
+ * @brief Compiler driver and dispatch loop of the numeric loop tier
+ *
+ * As with the bytecode engine, the AST node classes in parser.cpp lower
+ * themselves through their lowerNumeric() hooks; this file provides the
+ * emit helpers, the walk over the loop body and the portable executor.
+ */
+
+#include "loop_tier.h"
+#include "functions.h"
+#include "parser.h"
+#include "program.h"
+#include <exception>
+
+namespace looptier {
+
+namespace {
+/**
+ * @brief Net change of the value stack depth caused by an instruction
+ */
+std::ptrdiff_t stackEffect(OpCode op, uint16_t count, uint8_t flags) {
+  switch (op) {
+  case OpCode::Constant:
+  case OpCode::Load:
+    return 1;
+  case OpCode::LoadElement:
+    return 1 - static_cast<std::ptrdiff_t>(count);
+  case OpCode::Binary:
+  case OpCode::Store:
+  case OpCode::JumpIfFalse:
+    return -1;
+  case OpCode::StoreElement:
+    return -1 - static_cast<std::ptrdiff_t>(count);
+  case OpCode::ForEnter:
+    return flags ? -3 : -2;
+  default:
+    return 0;
+  }
+}
+} // namespace
+
+size_t Builder::emit(OpCode op, int32_t operand, uint16_t count,
+                     uint8_t flags) {
+  loop_.code.push_back(Instruction{op, flags, count, operand});
+  depth_ = static_cast<size_t>(static_cast<std::ptrdiff_t>(depth_) +
+                               stackEffect(op, count, flags));
+  if (depth_ > loop_.maxStack) {
+    loop_.maxStack = depth_;
+  }
+  return loop_.code.size() - 1;
+}
+
+void Builder::patchJump(size_t at) {
+  loop_.code[at].operand = static_cast<int32_t>(loop_.code.size());
+}
+
+int32_t Builder::addConstant(double value) {
+  loop_.constants.push_back(value);
+  return static_cast<int32_t>(loop_.constants.size() - 1);
+}
+
+void Builder::beginStatement(const Position &pos) {
+  current_ = pos;
+  loop_.positions.push_back(pos);
+  emit(OpCode::Statement, static_cast<int32_t>(loop_.positions.size() - 1));
+}
+
+bool Builder::lowerBranch(const std::vector<Statement *> &stmts) {
+  // A failure in a second branch statement would re-run the first one
+  // after the bail-out, so branches hold at most one statement
+  if (stmts.size() > 1) {
+    return false;
+  }
+  ++branchDepth_;
+  bool ok = stmts.empty() || stmts[0]->lowerNumeric(*this);
+  --branchDepth_;
+  return ok;
+}
+
+bool Builder::openLoop(SymbolId var, bool hasStep) {
+  if (branchDepth_ > 0) {
+    return false;
+  }
+  size_t index = loop_.loops.size();
+  loop_.loops.push_back(
+      Loop{var, 0, Position{current_.line, current_.statement + 1}});
+  emit(OpCode::ForEnter, static_cast<int32_t>(index), 0, hasStep ? 1 : 0);
+  loop_.loops[index].bodyStart = static_cast<uint32_t>(loop_.code.size());
+  open_.push_back(index);
+  return true;
+}
+
+bool Builder::closeLoop(SymbolId var) {
+  if (branchDepth_ > 0 || closed_) {
+    return false;
+  }
+  size_t index = open_.empty() ? 0 : open_.back();
+  if (var != kNoSymbol && var != loop_.loops[index].var) {
+    return false;
+  }
+  emit(OpCode::ForNext, static_cast<int32_t>(index));
+  if (open_.empty()) {
+    closed_ = true;
+  } else {
+    open_.pop_back();
+  }
+  return true;
+}
+
+std::shared_ptr<CompiledLoop> compile(const Program &program, Position body,
+                                      Position next, SymbolId var,
+                                      bool native) {
+  auto loop = std::make_shared<CompiledLoop>();
+  loop->loops.push_back(Loop{var, 0, body});
+  Builder builder(*loop);
+
+  Position pos = body;
+  while (!builder.closed()) {
+    if (pos.line >= program.size()) {
+      return nullptr;
+    }
+    const ProgramLine &line = program[pos.line];
+    if (!line.parsed) {
+      return nullptr;
+    }
+    if (pos.statement >= line.statements.size()) {
+      ++pos.line;
+      pos.statement = 0;
+      continue;
+    }
+    builder.beginStatement(pos);
+    if (!line.statements[pos.statement]->lowerNumeric(builder)) {
+      return nullptr;
+    }
+    // The walk must end exactly at the NEXT that made the loop hot
+    if (builder.closed() != (pos == next)) {
+      return nullptr;
+    }
+    ++pos.statement;
+  }
+  if (native) {
+    loop->native = emitNative(*loop);
+  }
+  return loop;
+}
+
+State::State(const CompiledLoop &loop, Variables &vars, double limit,
+             double step)
+    : loop(loop), vars(vars), stack(loop.maxStack + 1),
+      frames(loop.loops.size()) {
+  frames[0] = Frame{limit, step};
+}
+
+const int *State::toSubscripts(const double *values, size_t count) {
+  subscripts.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    subscripts[i] = static_cast<int>(values[i]);
+  }
+  return subscripts.data();
+}
+
+void State::enterLoop(size_t index, const double *values, bool hasStep) {
+  Frame &frame = frames[index];
+  frame.limit = values[1];
+  frame.step = hasStep ? values[2] : 1.0;
+  vars.setNumber(loop.loops[index].var, values[0]);
+  active.push_back(index);
+}
+
+bool State::nextLoop(size_t index) {
+  // Same update and test as Interpreter::nextForLoop()
+  const Frame &frame = frames[index];
+  SymbolId var = loop.loops[index].var;
+  double value = vars.getVariable(var).getNumber() + frame.step;
+  vars.setNumber(var, value);
+  bool more =
+      frame.step >= 0 ? value <= frame.limit : value >= frame.limit;
+  if (!more && index > 0) {
+    active.pop_back();
+  }
+  return more;
+}
+
+Exit State::bailOut() const {
+  Exit exit;
+  exit.position = loop.positions[statement];
+  for (size_t index : active) {
+    exit.open.push_back(OpenLoop{index, frames[index].limit,
+                                 frames[index].step});
+  }
+  return exit;
+}
+
+namespace {
+/**
+ * @brief Portable executor: run the loop instructions in a dispatch loop
+ * @return true if the hot loop completed, false on a bail-out
+ */
+bool dispatch(State &state) {
+  const CompiledLoop &loop = state.loop;
+  Variables &vars = state.vars;
+
+  const Instruction *code = loop.code.data();
+  double *sp = state.stack.data();
+  size_t pc = 0;
+
+  try {
+    for (;;) {
+      const Instruction &ins = code[pc++];
+      switch (ins.op) {
+      case OpCode::Constant:
+        *sp++ = loop.constants[static_cast<size_t>(ins.operand)];
+        break;
+      case OpCode::Load: {
+        const Value &value =
+            vars.getVariable(static_cast<SymbolId>(ins.operand));
+        if (!value.isNumber()) {
+          return false;
+        }
+        *sp++ = value.getNumber();
+        break;
+      }
+      case OpCode::LoadElement: {
+        sp -= ins.count;
+        Value value = vars.getArrayElement(static_cast<SymbolId>(ins.operand),
+                                           state.toSubscripts(sp, ins.count),
+                                           ins.count);
+        if (!value.isNumber()) {
+          return false;
+        }
+        *sp++ = value.getNumber();
+        break;
+      }
+      case OpCode::Negate:
+        sp[-1] = -sp[-1];
+        break;
+      case OpCode::Not:
+        sp[-1] = sp[-1] == 0.0 ? 1.0 : 0.0;
+        break;
+      case OpCode::Binary:
+        --sp;
+        sp[-1] = applyNumericOperator(static_cast<TokenType>(ins.operand),
+                                      sp[-1], sp[0]);
+        break;
+      case OpCode::Math:
+        sp[-1] = callMathFunction(static_cast<TokenType>(ins.operand), sp[-1]);
+        break;
+      case OpCode::Store:
+        vars.setNumber(static_cast<SymbolId>(ins.operand), *--sp);
+        break;
+      case OpCode::StoreElement: {
+        double value = *--sp;
+        sp -= ins.count;
+        vars.setArrayElement(static_cast<SymbolId>(ins.operand),
+                             state.toSubscripts(sp, ins.count), ins.count,
+                             Value(value));
+        break;
+      }
+      case OpCode::Jump:
+        pc = static_cast<size_t>(ins.operand);
+        break;
+      case OpCode::JumpIfFalse:
+        if (*--sp == 0) {
+          pc = static_cast<size_t>(ins.operand);
+        }
+        break;
+      case OpCode::ForEnter:
+        sp -= ins.flags ? 3 : 2;
+        state.enterLoop(static_cast<size_t>(ins.operand), sp, ins.flags != 0);
+        break;
+      case OpCode::ForNext: {
+        size_t index = static_cast<size_t>(ins.operand);
+        if (state.nextLoop(index)) {
+          pc = loop.loops[index].bodyStart;
+        } else if (index == 0) {
+          return true;
+        }
+        break;
+      }
+      case OpCode::Statement:
+        state.statement = static_cast<size_t>(ins.operand);
+        break;
+      }
+    }
+  } catch (const std::exception &) {
+    // Let the interpreter re-run the statement and report the error
+    return false;
+  }
+}
+} // namespace
+
+Exit run(const CompiledLoop &loop, Variables &vars, double limit,
+         double step) {
+  State state(loop, vars, limit, step);
+  bool completed =
+      loop.native ? runNative(*loop.native, state) : dispatch(state);
+  if (!completed) {
+    return state.bailOut();
+  }
+  Exit exit;
+  exit.completed = true;
+  return exit;
+}
+
+} // namespace looptier
@@ -0,0 +1,274 @@
+/**
+ * @file loop_tier.h
+ * @brief Compiled execution tier for hot numeric FOR/NEXT loops
+ *
+ * The interpreter counts the iterations of every FOR loop in nextForLoop().
+ * When a loop gets hot, the statements between its FOR and NEXT are lowered
+ * into a compact numeric program that runs the rest of the loop in a single
+ * dispatch loop: values live in a plain double stack, variables and array
+ * elements are read and written through their symbol slots, and there is no
+ * per-statement bookkeeping (jump flags, SPEED, TRACE, Value temporaries).
+ *
+ * Only purely numeric bodies are compiled: assignments to numeric variables
+ * and array elements, IF without jumps, nested FOR/NEXT and REM. Anything
+ * else (strings, I/O, GOTO/GOSUB, user functions, RND) keeps the loop in the
+ * interpreter.
+ *
+ * Arithmetic goes through the same Float40 helpers as both interpreters
+ * (applyNumericOperator, callMathFunction), so results are bit-identical.
+ *
+ * On Linux x86-64 each compiled loop is also translated to machine code
+ * (loop_tier_x64.cpp): stack traffic, constants, jumps and the loop
+ * control flow become native instructions and only arithmetic and
+ * variable access call back into C++. Elsewhere, or when the code buffer
+ * cannot be mapped, run() uses the portable dispatch loop.
+ *
+ * Bail-out: every statement commits its effect with its last instruction.
+ * When a statement fails (error, or a numeric variable that holds a string),
+ * the tier stops before that statement and reports its position together
+ * with the nested loops that were open. The interpreter recreates those FOR
+ * frames and re-executes the statement, so errors, ONERR handlers and the
+ * reported line are exactly what the interpreter alone would produce.
+ */
+
+#pragma once
+
+#include "variables.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class Program;
+class Statement;
+
+namespace looptier {
+
+/**
+ * @brief Statement position in the program image (line index, statement)
+ */
+struct Position {
+  size_t line;
+  size_t statement;
+
+  bool operator==(const Position &other) const {
+    return line == other.line && statement == other.statement;
+  }
+};
+
+/**
+ * @brief Instruction opcodes of the numeric loop program
+ */
+enum class OpCode : uint8_t {
+  Constant,     ///< Push constants[operand]
+  Load,         ///< Push the number in variable slot operand
+  LoadElement,  ///< Pop count subscripts, push element of array slot operand
+  Negate,       ///< Negate the top value
+  Not,          ///< Replace top with 1 if it is zero, else 0
+  Binary,       ///< Pop rhs, lhs; push applyNumericOperator(operand, ...)
+  Math,         ///< Replace top with callMathFunction(operand, top)
+  Store,        ///< Pop into variable slot operand
+  StoreElement, ///< Pop value, then count subscripts; store in array operand
+  Jump,         ///< Continue at instruction operand
+  JumpIfFalse,  ///< Pop condition; continue at operand when it is zero
+  ForEnter,     ///< Pop step (if flags), limit, start; open loops[operand]
+  ForNext,      ///< Step loops[operand]; repeat its body or fall through
+  Statement     ///< Statement boundary; positions[operand] is its position
+};
+
+/**
+ * @brief One fixed-size instruction (same layout as bytecode::Instruction)
+ */
+struct Instruction {
+  OpCode op;
+  uint8_t flags;
+  uint16_t count;
+  int32_t operand;
+};
+
+/**
+ * @brief A FOR loop inside a compiled program
+ *
+ * loops[0] is the hot loop the program was compiled for; its FOR ran in the
+ * interpreter, so only its NEXT appears in the code.
+ */
+struct Loop {
+  SymbolId var;
+  /** @brief Code offset of the first body instruction */
+  uint32_t bodyStart;
+  /** @brief Interpreter resume point of the body (statement after FOR) */
+  Position resume;
+};
+
+struct NativeCode;
+
+/**
+ * @brief Compiled form of one hot loop
+ */
+struct CompiledLoop {
+  std::vector<Instruction> code;
+  std::vector<double> constants;
+  std::vector<Position> positions;
+  std::vector<Loop> loops;
+  size_t maxStack = 0;
+  /** @brief Machine code of @ref code, or null to use the dispatch loop */
+  std::shared_ptr<NativeCode> native;
+};
+
+/**
+ * @class Builder
+ * @brief Emits loop instructions for AST nodes
+ *
+ * Expression::lowerNumeric() and Statement::lowerNumeric() overrides use the
+ * emit helpers and return false for anything the tier cannot run, which
+ * rejects the whole loop.
+ */
+class Builder {
+public:
+  explicit Builder(CompiledLoop &loop) : loop_(loop) {}
+
+  /** @brief Append an instruction and return its index */
+  size_t emit(OpCode op, int32_t operand = 0, uint16_t count = 0,
+              uint8_t flags = 0);
+
+  /** @brief Point the jump at @p at to the next instruction to be emitted */
+  void patchJump(size_t at);
+
+  /** @brief Add a constant to the pool and return its index */
+  int32_t addConstant(double value);
+
+  /** @brief Start a top-level statement at @p pos */
+  void beginStatement(const Position &pos);
+
+  /** @brief Lower the branch statements of an IF (no FOR/NEXT allowed) */
+  bool lowerBranch(const std::vector<Statement *> &stmts);
+
+  /**
+   * @brief Emit a nested FOR after its start/limit(/step) were lowered
+   * @return false if the FOR is not a top-level statement
+   */
+  bool openLoop(SymbolId var, bool hasStep);
+
+  /**
+   * @brief Emit the NEXT closing the innermost open loop
+   * @param var NEXT variable slot (kNoSymbol for bare NEXT)
+   * @return false if it does not close the innermost loop
+   */
+  bool closeLoop(SymbolId var);
+
+  /** @brief true once the NEXT of the hot loop has been emitted */
+  bool closed() const { return closed_; }
+
+private:
+  CompiledLoop &loop_;
+  Position current_{0, 0};
+  std::vector<size_t> open_; // indices into loop_.loops
+  size_t depth_ = 0;
+  size_t branchDepth_ = 0;
+  bool closed_ = false;
+};
+
+/**
+ * @brief Compile the body of a hot loop
+ *
+ * Lowers every statement from @p body (the FOR frame's resume point) up to
+ * and including the NEXT at @p next, following sequential flow.
+ *
+ * @param program Program image
+ * @param body First statement of the loop body
+ * @param next Position of the NEXT that closes the loop
+ * @param var Symbol slot of the loop variable
+ * @param native Also translate the loop to machine code where supported
+ * @return Compiled loop, or nullptr if the body is not purely numeric
+ */
+std::shared_ptr<CompiledLoop> compile(const Program &program, Position body,
+                                      Position next, SymbolId var,
+                                      bool native = true);
+
+/**
+ * @brief Nested loop that was open when a compiled loop bailed out
+ */
+struct OpenLoop {
+  size_t loop; ///< Index into CompiledLoop::loops
+  double limit;
+  double step;
+};
+
+/**
+ * @brief Outcome of running a compiled loop
+ */
+struct Exit {
+  /** @brief The hot loop ran to completion */
+  bool completed = false;
+  /** @brief Statement to re-execute in the interpreter (bail-out) */
+  Position position{0, 0};
+  /** @brief Nested loops open at the bail-out, outermost first */
+  std::vector<OpenLoop> open;
+};
+
+/**
+ * @brief Run a compiled loop from the start of its body
+ *
+ * @param loop Compiled loop
+ * @param vars Variables to operate on
+ * @param limit TO value of the hot loop's FOR frame
+ * @param step STEP value of the hot loop's FOR frame
+ * @return Completion or bail-out information
+ */
+Exit run(const CompiledLoop &loop, Variables &vars, double limit,
+         double step);
+
+/** @brief Runtime TO/STEP values of a loop */
+struct Frame {
+  double limit;
+  double step;
+};
+
+/**
+ * @brief Run-time state of a compiled loop, shared by both executors
+ */
+struct State {
+  State(const CompiledLoop &loop, Variables &vars, double limit, double step);
+
+  /** @brief Convert @p count stack values to integer subscripts */
+  const int *toSubscripts(const double *values, size_t count);
+
+  /**
+   * @brief Open nested loop @p index
+   * @param values Start, limit and (if @p hasStep) step
+   */
+  void enterLoop(size_t index, const double *values, bool hasStep);
+
+  /**
+   * @brief Step loop @p index (same update and test as NEXT)
+   * @return true if its body runs again
+   */
+  bool nextLoop(size_t index);
+
+  /** @brief Bail-out information for the statement being executed */
+  Exit bailOut() const;
+
+  const CompiledLoop &loop;
+  Variables &vars;
+  std::vector<double> stack;
+  std::vector<Frame> frames;
+  std::vector<size_t> active; ///< Open nested loops, outermost first
+  std::vector<int> subscripts;
+  size_t statement = 0; ///< Index into CompiledLoop::positions
+};
+
+/**
+ * @brief Translate a compiled loop to machine code
+ * @return The code, or nullptr where there is no native emitter or the
+ *         code buffer could not be mapped
+ */
+std::shared_ptr<NativeCode> emitNative(const CompiledLoop &loop);
+
+/**
+ * @brief Run the machine code of a compiled loop
+ * @return true if the hot loop completed, false on a bail-out (@p state
+ *         then holds the failing statement and the open loops)
+ */
+bool runNative(const NativeCode &code, State &state);
+
+} // namespace looptier
@@ -0,0 +1,444 @@
+/**
+ * @file loop_tier_x64.cpp
+ * @brief x86-64 code generator of the numeric loop tier (Linux only)
+ *
+ * Translates a CompiledLoop instruction by instruction into one machine
+ * code function. The code is written to an anonymous mmap() buffer that is
+ * made read-only and executable before it first runs.
+ *
+ * Registers of the generated function (all callee-saved, so they survive
+ * the helper calls):
+ * - rbx: value stack pointer, the next free slot (sp of the dispatch loop)
+ * - r12: State *
+ * - r13: constant pool
+ * - r14: &State::statement
+ *
+ * Stack traffic, constants, negation, NOT, jumps and the IF branch are
+ * inline. Float40 arithmetic, math functions, variable and array access
+ * and FOR/NEXT call the helpers below, which share their code with the
+ * dispatch loop. The generated frames have no unwind information, so the
+ * helpers catch every exception and return a status instead; the code
+ * then leaves through the bail-out exit.
+ *
+ * Other platforms get emitNative() returning nullptr, which keeps every
+ * loop in the portable executor.
+ */
+
+#include "loop_tier.h"
+
+#if defined(PLATFORM_LINUX) && defined(__x86_64__)
+
+#include "functions.h"
+#include <cstring>
+#include <exception>
+#include <initializer_list>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace looptier {
+
+/**
+ * @brief Executable code of one compiled loop, unmapped on destruction
+ */
+struct NativeCode {
+  /** @brief Generated function: 0 if the loop completed, 1 on a bail-out */
+  using Entry = int (*)(State *state, double *stack, const double *constants,
+                        size_t *statement);
+
+  NativeCode(void *memory, size_t size) : memory(memory), size(size) {}
+  ~NativeCode() { munmap(memory, size); }
+  NativeCode(const NativeCode &) = delete;
+  NativeCode &operator=(const NativeCode &) = delete;
+
+  Entry entry() const { return reinterpret_cast<Entry>(memory); }
+
+  void *memory;
+  size_t size;
+};
+
+namespace {
+/** @brief Helper result: carry on, or leave through the bail-out exit */
+enum Status : int { Ok = 0, Bail = 1 };
+
+/** @brief nextLoop() result, one branch of the generated code each */
+enum Next : int { Repeat = 0, FallThrough = 1, Completed = 2, Failed = 3 };
+
+int loadVariable(State *state, double *out, int32_t slot) {
+  try {
+    const Value &value =
+        state->vars.getVariable(static_cast<SymbolId>(slot));
+    if (!value.isNumber()) {
+      return Bail;
+    }
+    *out = value.getNumber();
+    return Ok;
+  } catch (const std::exception &) {
+    return Bail;
+  }
+}
+
+int loadElement(State *state, double *sp, int32_t slot, int32_t count) {
+  try {
+    Value value = state->vars.getArrayElement(
+        static_cast<SymbolId>(slot),
+        state->toSubscripts(sp, static_cast<size_t>(count)), count);
+    if (!value.isNumber()) {
+      return Bail;
+    }
+    *sp = value.getNumber();
+    return Ok;
+  } catch (const std::exception &) {
+    return Bail;
+  }
+}
+
+int binary(double *lhs, int32_t op) {
+  try {
+    lhs[0] = applyNumericOperator(static_cast<TokenType>(op), lhs[0], lhs[1]);
+    return Ok;
+  } catch (const std::exception &) {
+    return Bail;
+  }
+}
+
+int math(double *top, int32_t function) {
+  try {
+    *top = callMathFunction(static_cast<TokenType>(function), *top);
+    return Ok;
+  } catch (const std::exception &) {
+    return Bail;
+  }
+}
+
+int storeVariable(State *state, const double *value, int32_t slot) {
+  try {
+    state->vars.setNumber(static_cast<SymbolId>(slot), *value);
+    return Ok;
+  } catch (const std::exception &) {
+    return Bail;
+  }
+}
+
+int storeElement(State *state, const double *sp, int32_t slot,
+                 int32_t count) {
+  try {
+    state->vars.setArrayElement(
+        static_cast<SymbolId>(slot),
+        state->toSubscripts(sp, static_cast<size_t>(count)), count,
+        Value(sp[count]));
+    return Ok;
+  } catch (const std::exception &) {
+    return Bail;
+  }
+}
+
+int enterLoop(State *state, const double *values, int32_t index,
+              int32_t hasStep) {
+  try {
+    state->enterLoop(static_cast<size_t>(index), values, hasStep != 0);
+    return Ok;
+  } catch (const std::exception &) {
+    return Bail;
+  }
+}
+
+int nextLoop(State *state, int32_t index) {
+  try {
+    if (state->nextLoop(static_cast<size_t>(index))) {
+      return Repeat;
+    }
+    return index == 0 ? Completed : FallThrough;
+  } catch (const std::exception &) {
+    return Failed;
+  }
+}
+
+/**
+ * @brief Byte buffer with the few x86-64 instructions the tier needs
+ */
+class Assembler {
+public:
+  size_t size() const { return code_.size(); }
+  const std::vector<uint8_t> &code() const { return code_; }
+
+  void bytes(std::initializer_list<uint8_t> list) {
+    code_.insert(code_.end(), list);
+  }
+
+  void imm32(int32_t value) {
+    uint8_t raw[4];
+    std::memcpy(raw, &value, sizeof raw);
+    code_.insert(code_.end(), raw, raw + sizeof raw);
+  }
+
+  void imm64(uint64_t value) {
+    uint8_t raw[8];
+    std::memcpy(raw, &value, sizeof raw);
+    code_.insert(code_.end(), raw, raw + sizeof raw);
+  }
+
+  /** @brief Leave room for a rel32 and return its offset for patch() */
+  size_t rel32() {
+    imm32(0);
+    return code_.size() - 4;
+  }
+
+  /** @brief Point the rel32 at @p at to code offset @p target */
+  void patch(size_t at, size_t target) {
+    int32_t rel = static_cast<int32_t>(static_cast<std::ptrdiff_t>(target) -
+                                       static_cast<std::ptrdiff_t>(at + 4));
+    std::memcpy(&code_[at], &rel, sizeof rel);
+  }
+
+  /** @brief add rbx, delta (moves the value stack pointer) */
+  void moveStack(int32_t delta) {
+    if (delta == 8) {
+      bytes({0x48, 0x83, 0xC3, 0x08});
+    } else if (delta == -8) {
+      bytes({0x48, 0x83, 0xEB, 0x08});
+    } else if (delta != 0) {
+      bytes({0x48, 0x81, 0xC3});
+      imm32(delta);
+    }
+  }
+
+  /** @brief mov rdi, r12 (State * as first argument) */
+  void stateArgument() { bytes({0x4C, 0x89, 0xE7}); }
+
+  /** @brief mov rsi, rbx (stack pointer as second argument) */
+  void stackArgument() { bytes({0x48, 0x89, 0xDE}); }
+
+  /** @brief lea rdi, [rbx - 8] (top of stack as first argument) */
+  void topArgument() { bytes({0x48, 0x8D, 0x7B, 0xF8}); }
+
+  /** @brief mov esi, value */
+  void esi(int32_t value) {
+    bytes({0xBE});
+    imm32(value);
+  }
+
+  /** @brief mov edx, value */
+  void edx(int32_t value) {
+    bytes({0xBA});
+    imm32(value);
+  }
+
+  /** @brief mov ecx, value */
+  void ecx(int32_t value) {
+    bytes({0xB9});
+    imm32(value);
+  }
+
+  /** @brief mov rax, fn; call rax */
+  template <typename Fn> void call(Fn *fn) {
+    bytes({0x48, 0xB8});
+    imm64(reinterpret_cast<uint64_t>(fn));
+    bytes({0xFF, 0xD0});
+  }
+
+  /** @brief test eax, eax; jnz (rel32 to patch) */
+  size_t jumpIfFailed() {
+    bytes({0x85, 0xC0, 0x0F, 0x85});
+    return rel32();
+  }
+
+private:
+  std::vector<uint8_t> code_;
+};
+
+/** @brief Copy @p code into a fresh read-only, executable mapping */
+std::shared_ptr<NativeCode> map(const std::vector<uint8_t> &code) {
+  long page = sysconf(_SC_PAGESIZE);
+  size_t pageSize = page > 0 ? static_cast<size_t>(page) : 4096;
+  size_t size = (code.size() + pageSize - 1) / pageSize * pageSize;
+  void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    return nullptr;
+  }
+  std::memcpy(memory, code.data(), code.size());
+  if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+    munmap(memory, size);
+    return nullptr;
+  }
+  return std::make_shared<NativeCode>(memory, size);
+}
+} // namespace
+
+std::shared_ptr<NativeCode> emitNative(const CompiledLoop &loop) {
+  Assembler a;
+  // push rbp; mov rbp, rsp; push rbx; push r12; push r13; push r14
+  // (leaves rsp 16-byte aligned for the helper calls)
+  a.bytes({0x55, 0x48, 0x89, 0xE5, 0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56});
+  // mov r12, rdi; mov rbx, rsi; mov r13, rdx; mov r14, rcx
+  a.bytes({0x49, 0x89, 0xFC, 0x48, 0x89, 0xF3, 0x49, 0x89, 0xD5, 0x49, 0x89,
+           0xCE});
+
+  std::vector<size_t> offsets(loop.code.size() + 1);
+  std::vector<std::pair<size_t, size_t>> jumps; // rel32, target instruction
+  std::vector<size_t> bails;
+  std::vector<size_t> completions;
+
+  for (size_t pc = 0; pc < loop.code.size(); ++pc) {
+    offsets[pc] = a.size();
+    const Instruction &ins = loop.code[pc];
+    int32_t slots = static_cast<int32_t>(ins.count) * 8;
+    switch (ins.op) {
+    case OpCode::Constant:
+      // movsd xmm0, [r13 + disp32]; movsd [rbx], xmm0
+      a.bytes({0xF2, 0x41, 0x0F, 0x10, 0x85});
+      a.imm32(ins.operand * 8);
+      a.bytes({0xF2, 0x0F, 0x11, 0x03});
+      a.moveStack(8);
+      break;
+    case OpCode::Load:
+      a.stateArgument();
+      a.stackArgument();
+      a.edx(ins.operand);
+      a.call(loadVariable);
+      bails.push_back(a.jumpIfFailed());
+      a.moveStack(8);
+      break;
+    case OpCode::LoadElement:
+      a.moveStack(-slots);
+      a.stateArgument();
+      a.stackArgument();
+      a.edx(ins.operand);
+      a.ecx(ins.count);
+      a.call(loadElement);
+      bails.push_back(a.jumpIfFailed());
+      a.moveStack(8);
+      break;
+    case OpCode::Negate:
+      // mov rax, sign bit; xor [rbx - 8], rax
+      a.bytes({0x48, 0xB8});
+      a.imm64(0x8000000000000000ULL);
+      a.bytes({0x48, 0x31, 0x43, 0xF8});
+      break;
+    case OpCode::Not:
+      // movsd xmm0, [rbx - 8]; xorpd xmm1, xmm1; ucomisd xmm0, xmm1;
+      // sete al; setnp cl; and al, cl (equal and ordered: x == 0.0);
+      // movzx eax, al; cvtsi2sd xmm0, eax; movsd [rbx - 8], xmm0
+      a.bytes({0xF2, 0x0F, 0x10, 0x43, 0xF8, 0x66, 0x0F, 0x57, 0xC9, 0x66,
+               0x0F, 0x2E, 0xC1, 0x0F, 0x94, 0xC0, 0x0F, 0x9B, 0xC1, 0x20,
+               0xC8, 0x0F, 0xB6, 0xC0, 0xF2, 0x0F, 0x2A, 0xC0, 0xF2, 0x0F,
+               0x11, 0x43, 0xF8});
+      break;
+    case OpCode::Binary:
+      a.moveStack(-8);
+      a.topArgument();
+      a.esi(ins.operand);
+      a.call(binary);
+      bails.push_back(a.jumpIfFailed());
+      break;
+    case OpCode::Math:
+      a.topArgument();
+      a.esi(ins.operand);
+      a.call(math);
+      bails.push_back(a.jumpIfFailed());
+      break;
+    case OpCode::Store:
+      a.moveStack(-8);
+      a.stateArgument();
+      a.stackArgument();
+      a.edx(ins.operand);
+      a.call(storeVariable);
+      bails.push_back(a.jumpIfFailed());
+      break;
+    case OpCode::StoreElement:
+      a.moveStack(-slots - 8);
+      a.stateArgument();
+      a.stackArgument();
+      a.edx(ins.operand);
+      a.ecx(ins.count);
+      a.call(storeElement);
+      bails.push_back(a.jumpIfFailed());
+      break;
+    case OpCode::Jump:
+      a.bytes({0xE9});
+      jumps.emplace_back(a.rel32(), static_cast<size_t>(ins.operand));
+      break;
+    case OpCode::JumpIfFalse:
+      // sub rbx, 8; movsd xmm0, [rbx]; xorpd xmm1, xmm1;
+      // ucomisd xmm0, xmm1; jne +6; jnp target (NaN is not false)
+      a.moveStack(-8);
+      a.bytes({0xF2, 0x0F, 0x10, 0x03, 0x66, 0x0F, 0x57, 0xC9, 0x66, 0x0F,
+               0x2E, 0xC1, 0x75, 0x06, 0x0F, 0x8B});
+      jumps.emplace_back(a.rel32(), static_cast<size_t>(ins.operand));
+      break;
+    case OpCode::ForEnter:
+      a.moveStack(ins.flags ? -24 : -16);
+      a.stateArgument();
+      a.stackArgument();
+      a.edx(ins.operand);
+      a.ecx(ins.flags ? 1 : 0);
+      a.call(enterLoop);
+      bails.push_back(a.jumpIfFailed());
+      break;
+    case OpCode::ForNext: {
+      size_t index = static_cast<size_t>(ins.operand);
+      a.stateArgument();
+      a.esi(ins.operand);
+      a.call(nextLoop);
+      // test eax, eax; je body
+      a.bytes({0x85, 0xC0, 0x0F, 0x84});
+      jumps.emplace_back(a.rel32(), loop.loops[index].bodyStart);
+      // cmp eax, Completed; je done
+      a.bytes({0x83, 0xF8, Completed, 0x0F, 0x84});
+      completions.push_back(a.rel32());
+      // cmp eax, Failed; je bail
+      a.bytes({0x83, 0xF8, Failed, 0x0F, 0x84});
+      bails.push_back(a.rel32());
+      break;
+    }
+    case OpCode::Statement:
+      // mov qword [r14], operand
+      a.bytes({0x49, 0xC7, 0x06});
+      a.imm32(ins.operand);
+      break;
+    }
+  }
+  offsets[loop.code.size()] = a.size();
+
+  // done: xor eax, eax; jmp epilogue; bail: mov eax, 1
+  size_t done = a.size();
+  a.bytes({0x31, 0xC0, 0xEB, 0x05});
+  size_t bail = a.size();
+  a.bytes({0xB8, 0x01, 0x00, 0x00, 0x00});
+  // pop r14; pop r13; pop r12; pop rbx; pop rbp; ret
+  a.bytes({0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5B, 0x5D, 0xC3});
+
+  for (const auto &[at, target] : jumps) {
+    a.patch(at, offsets[target]);
+  }
+  for (size_t at : bails) {
+    a.patch(at, bail);
+  }
+  for (size_t at : completions) {
+    a.patch(at, done);
+  }
+  return map(a.code());
+}
+
+bool runNative(const NativeCode &code, State &state) {
+  return code.entry()(&state, state.stack.data(), state.loop.constants.data(),
+                      &state.statement) == 0;
+}
+
+} // namespace looptier
+
+#else
+
+namespace looptier {
+
+struct NativeCode {};
+
+std::shared_ptr<NativeCode> emitNative(const CompiledLoop &) {
+  return nullptr;
+}
+
+bool runNative(const NativeCode &, State &) { return false; }
+
+} // namespace looptier
+
+#endif
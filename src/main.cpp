@@ -12,20 +12,40 @@
  * - --scale N: Set window scale factor (1-10, default 2)
  * - --tape FILE: Set default tape file for STORE/RECALL/SHLOAD
  * - --tape-hotkey KEY: Set tape change hotkey (default: ESC-T)
+ * - --engine tree|vm: Select tree-walking or bytecode execution
+ * - --no-fold: Disable constant folding after parsing
+ * - --fold-stats: Report how many AST nodes constant folding removed
+ * - --no-fuse: Disable superinstruction fusion of hot statement shapes
+ * - --fuse-stats: Report how often each superinstruction executed
+ * - --no-loop-tier: Keep hot numeric FOR loops in the interpreter
+ * - --no-native-tier: Run the loop tier in its portable dispatch loop
+ * - --loop-tier-check: Run hot loops in both tiers and compare the results
+ * - --stack-depth N: Maximum GOSUB/FOR/WHILE nesting (default 4096)
+ * - --load-stats: Report program load time and AST arena size
+ * - --lazy-parse: Parse loaded lines on first use instead of at LOAD
+ * - --load-threads N: Threads that parse a loaded program (0 = automatic)
+ * - --no-cache: Do not read or write the tokenized program cache
+ * - --drop-tokens: Free each program line's tokens once it is parsed
+ * - --save-format text|applesoft: File format written by SAVE
  * - --version: Display version information
  * - --help: Display usage information
  * 
  * If a filename is provided, the interpreter runs in script mode, loading and
- * executing the specified BASIC program. Otherwise, it enters interactive mode
- * with the classic Applesoft "]" prompt.
+ * executing the specified BASIC program ("-" reads it from standard input).
+ * Otherwise, it enters interactive mode with the classic Applesoft "]"
+ * prompt.
  */
 
 #include "interpreter.h"
 #include "interactive.h"
+#include "parser.h"
 #include "graphics_config.h"
 #include "graphics.h"
 #include "version.h"
+#include <cctype>
+#include <chrono>
 #include <iostream>
+#include <optional>
 #include <string>
 #include <cstring>
 
@@ -34,17 +54,80 @@
  * @param progName Program name from argv[0]
  */
 void printUsage(const char* progName) {
-    std::cerr << "Usage: " << progName << " [options] [program.bas]\n"
+    std::cerr << "Usage: " << progName << " [options] [program.bas | -]\n"
+              << "  -                Read the program from standard input\n"
               << "Options:\n"
               << "  --no-graphics    Terminal-only mode (errors on graphics commands)\n"
               << "  --graphics       Enable graphics mode (default)\n"
               << "  --scale N        Window scale factor (default: 2)\n"
               << "  --tape FILE      Set default tape file\n"
               << "  --tape-hotkey KEY  Set tape change hotkey (default: ESC-T)\n"
+              << "  --engine tree|vm Execution engine: AST tree walker (default)\n"
+              << "                   or bytecode VM\n"
+              << "  --no-fold        Disable constant folding after parsing\n"
+              << "  --fold-stats     Report AST nodes removed by constant folding\n"
+              << "  --no-fuse        Disable superinstruction fusion\n"
+              << "  --fuse-stats     Report how often each superinstruction ran\n"
+              << "  --no-loop-tier   Keep hot numeric FOR loops in the interpreter\n"
+              << "  --no-native-tier Run the loop tier without machine code\n"
+              << "  --loop-tier-check  Run hot loops in both tiers and compare\n"
+              << "                   variables (exit status 1 on a mismatch)\n"
+              << "  --stack-depth N  Maximum GOSUB/FOR/WHILE nesting before\n"
+              << "                   OUT OF MEMORY ERROR (default: 4096)\n"
+              << "  --load-stats     Report load time and AST memory\n"
+              << "  --lazy-parse     Parse loaded lines when they first run\n"
+              << "  --load-threads N Threads that parse a loaded program\n"
+              << "                   (default: 0 = by program size, 1 = serial)\n"
+              << "  --no-cache       Do not use the tokenized program cache\n"
+              << "  --drop-tokens    Free program line tokens after parsing\n"
+              << "  --save-format text|applesoft\n"
+              << "                   File format written by SAVE (default: the\n"
+              << "                   format the program was loaded from)\n"
               << "  --version        Show version information\n"
               << "  --help           Show this help message\n";
 }
 
+/**
+ * @brief Print how often each superinstruction executed (to stderr)
+ */
+void printSuperinstructionStats() {
+    const auto& stats = superinstructionStats();
+    for (size_t i = 0; i < SuperinstructionStats::kKinds; ++i) {
+        auto kind = static_cast<Superinstruction>(i);
+        std::cerr << "superinstruction " << SuperinstructionStats::name(kind)
+                  << ": " << stats.count(kind) << "\n";
+    }
+}
+
+/**
+ * @brief Print program load time, AST arena and token usage (to stderr)
+ */
+void printLoadStats(const Program& program,
+                    std::chrono::steady_clock::duration elapsed) {
+    size_t nodes = 0, used = 0, reserved = 0, blocks = 0;
+    for (const auto& arena : program.arenas()) {
+        nodes += arena->nodeCount();
+        used += arena->bytesUsed();
+        reserved += arena->bytesReserved();
+        blocks += arena->blockCount();
+    }
+    size_t tokens = 0, constants = 0, tokenBytes = 0;
+    for (const auto& line : program) {
+        tokens += line.tokens.size();
+        constants += line.constants.size();
+        tokenBytes += line.tokens.capacity() * sizeof(Token) +
+                      line.constants.capacity() * sizeof(Value);
+    }
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed);
+    std::cerr << "loaded " << program.size() << " lines in "
+              << us.count() / 1000.0 << " ms\n"
+              << "AST arena: " << nodes << " nodes, " << used
+              << " bytes used, " << reserved << " bytes in " << blocks
+              << " blocks\n"
+              << "tokens: " << tokens << " tokens, " << constants
+              << " constants, " << tokenBytes << " bytes\n";
+}
+
 /**
  * @brief Main entry point for MSBasic interpreter
  * 
@@ -62,6 +145,21 @@ int main(int argc, char* argv[]) {
     std::string filename;
     std::string tapeFile;
     std::string tapeHotkey = "\x1B" "T";  // ESC-T by default
+    ExecutionEngine engine = ExecutionEngine::TreeWalker;
+    bool foldConstants = true;
+    bool foldStats = false;
+    bool superinstructions = true;
+    bool fuseStats = false;
+    bool loopTier = true;
+    bool loopTierNative = true;
+    bool loopTierCheck = false;
+    size_t stackDepth = kDefaultControlStackDepth;
+    bool loadStats = false;
+    bool lazyParse = false;
+    size_t loadThreads = 0;
+    bool programCache = true;
+    bool dropTokens = false;
+    std::optional<ProgramFormat> saveFormat;
     bool hasFilename = false;
     
     // Parse command-line arguments
@@ -98,13 +196,74 @@ int main(int argc, char* argv[]) {
                 printUsage(argv[0]);
                 return 1;
             }
+        } else if (strcmp(argv[i], "--engine") == 0) {
+            if (i + 1 < argc && strcmp(argv[i + 1], "tree") == 0) {
+                engine = ExecutionEngine::TreeWalker;
+            } else if (i + 1 < argc && strcmp(argv[i + 1], "vm") == 0) {
+                engine = ExecutionEngine::Bytecode;
+            } else {
+                std::cerr << "Error: --engine requires 'tree' or 'vm'\n";
+                printUsage(argv[0]);
+                return 1;
+            }
+            ++i;
+        } else if (strcmp(argv[i], "--no-fold") == 0) {
+            foldConstants = false;
+        } else if (strcmp(argv[i], "--fold-stats") == 0) {
+            foldStats = true;
+        } else if (strcmp(argv[i], "--no-fuse") == 0) {
+            superinstructions = false;
+        } else if (strcmp(argv[i], "--fuse-stats") == 0) {
+            fuseStats = true;
+        } else if (strcmp(argv[i], "--no-loop-tier") == 0) {
+            loopTier = false;
+        } else if (strcmp(argv[i], "--no-native-tier") == 0) {
+            loopTierNative = false;
+        } else if (strcmp(argv[i], "--loop-tier-check") == 0) {
+            loopTierCheck = true;
+        } else if (strcmp(argv[i], "--stack-depth") == 0) {
+            if (i + 1 < argc && std::atoi(argv[i + 1]) > 0) {
+                stackDepth = static_cast<size_t>(std::atoi(argv[++i]));
+            } else {
+                std::cerr << "Error: --stack-depth requires a positive number\n";
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--load-stats") == 0) {
+            loadStats = true;
+        } else if (strcmp(argv[i], "--lazy-parse") == 0) {
+            lazyParse = true;
+        } else if (strcmp(argv[i], "--no-cache") == 0) {
+            programCache = false;
+        } else if (strcmp(argv[i], "--drop-tokens") == 0) {
+            dropTokens = true;
+        } else if (strcmp(argv[i], "--save-format") == 0) {
+            if (i + 1 < argc && strcmp(argv[i + 1], "text") == 0) {
+                saveFormat = ProgramFormat::Text;
+            } else if (i + 1 < argc && strcmp(argv[i + 1], "applesoft") == 0) {
+                saveFormat = ProgramFormat::Applesoft;
+            } else {
+                std::cerr << "Error: --save-format requires 'text' or 'applesoft'\n";
+                printUsage(argv[0]);
+                return 1;
+            }
+            ++i;
+        } else if (strcmp(argv[i], "--load-threads") == 0) {
+            if (i + 1 < argc &&
+                std::isdigit(static_cast<unsigned char>(*argv[i + 1]))) {
+                loadThreads = static_cast<size_t>(std::atoi(argv[++i]));
+            } else {
+                std::cerr << "Error: --load-threads requires a number\n";
+                printUsage(argv[0]);
+                return 1;
+            }
         } else if (strcmp(argv[i], "--version") == 0) {
             std::cout << "MSBasic " << msbasic::kVersion << "\n";
             return 0;
         } else if (strcmp(argv[i], "--help") == 0) {
             printUsage(argv[0]);
             return 0;
-        } else if (argv[i][0] == '-') {
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
             std::cerr << "Error: Unknown option: " << argv[i] << "\n";
             printUsage(argv[0]);
             return 1;
@@ -134,13 +293,52 @@ int main(int argc, char* argv[]) {
                 interp.setTapeFile(tapeFile);
             }
             interp.setTapeHotkey(tapeHotkey);
+            interp.setExecutionEngine(engine);
+            interp.setConstantFolding(foldConstants);
+            interp.setSuperinstructions(superinstructions);
+            interp.setLoopTier(loopTier);
+            interp.setLoopTierNative(loopTierNative);
+            interp.setLoopTierCheck(loopTierCheck);
+            interp.setControlStackDepth(stackDepth);
+            interp.setLazyParsing(lazyParse);
+            interp.setLoadThreads(loadThreads);
+            interp.setProgramCache(programCache);
+            interp.setDropTokens(dropTokens);
+            if (saveFormat) {
+                interp.setSaveFormat(*saveFormat);
+            }
             
+            auto loadStart = std::chrono::steady_clock::now();
             interp.loadProgram(filename);
+            if (loadStats) {
+                printLoadStats(interp.program(),
+                               std::chrono::steady_clock::now() - loadStart);
+            }
             interp.run();
-            return 0;
+            if (foldStats) {
+                std::cerr << "constant folding removed " << interp.foldedNodes()
+                          << " nodes\n";
+            }
+            if (fuseStats) {
+                printSuperinstructionStats();
+            }
+            return interp.loopTierMismatches() > 0 ? 1 : 0;
         } else {
             // Interactive mode
             InteractiveMode interactive(config);
+            interactive.setExecutionEngine(engine);
+            interactive.setConstantFolding(foldConstants);
+            interactive.setSuperinstructions(superinstructions);
+            interactive.setLoopTier(loopTier);
+            interactive.setLoopTierNative(loopTierNative);
+            interactive.setControlStackDepth(stackDepth);
+            interactive.setLazyParsing(lazyParse);
+            interactive.setLoadThreads(loadThreads);
+            interactive.setProgramCache(programCache);
+            interactive.setDropTokens(dropTokens);
+            if (saveFormat) {
+                interactive.setSaveFormat(*saveFormat);
+            }
             interactive.run();
             return 0;
         }
@@ -31,13 +31,16 @@
  */
 
 #include "parser.h"
+#include "bytecode.h"
 #include "float40.h"
 #include "functions.h"
 #include "graphics.h"
 #include "interpreter.h"
+#include "loop_tier.h"
 #include <algorithm>
 #include <cctype>
 #include <chrono>
+#include <cmath>
 #include <iostream>
 #include <memory>
 #include <thread>
@@ -83,124 +86,136 @@ public:
 
 class PlotStmt : public Statement {
 public:
-  PlotStmt(std::shared_ptr<Expression> x, std::shared_ptr<Expression> y)
-      : x_(std::move(x)), y_(std::move(y)) {}
+  PlotStmt(Expression *x, Expression *y) : x_(x), y_(y) {}
   void execute(Interpreter *interp) override {
     interp->requireGraphicsMode();
-    graphics().plot(x_->evaluate(interp).getNumber(),
-                    y_->evaluate(interp).getNumber());
+    graphics().plot(x_->evaluateNumber(interp), y_->evaluateNumber(interp));
+  }
+
+  void foldConstants(ConstantFolder &folder) override {
+    folder.fold(x_);
+    folder.fold(y_);
   }
 
 private:
-  std::shared_ptr<Expression> x_;
-  std::shared_ptr<Expression> y_;
+  Expression *x_;
+  Expression *y_;
 };
 
 class HlinStmt : public Statement {
 public:
-  HlinStmt(std::shared_ptr<Expression> x1, std::shared_ptr<Expression> x2,
-           std::shared_ptr<Expression> y)
-      : x1_(std::move(x1)), x2_(std::move(x2)), y_(std::move(y)) {}
+  HlinStmt(Expression *x1, Expression *x2, Expression *y)
+      : x1_(x1), x2_(x2), y_(y) {}
   void execute(Interpreter *interp) override {
     interp->requireGraphicsMode();
-    graphics().hlin(x1_->evaluate(interp).getNumber(),
-                    x2_->evaluate(interp).getNumber(),
-                    y_->evaluate(interp).getNumber());
+    graphics().hlin(x1_->evaluateNumber(interp), x2_->evaluateNumber(interp),
+                    y_->evaluateNumber(interp));
+  }
+
+  void foldConstants(ConstantFolder &folder) override {
+    folder.fold(x1_);
+    folder.fold(x2_);
+    folder.fold(y_);
   }
 
 private:
-  std::shared_ptr<Expression> x1_;
-  std::shared_ptr<Expression> x2_;
-  std::shared_ptr<Expression> y_;
+  Expression *x1_;
+  Expression *x2_;
+  Expression *y_;
 };
 
 class VlinStmt : public Statement {
 public:
-  VlinStmt(std::shared_ptr<Expression> y1, std::shared_ptr<Expression> y2,
-           std::shared_ptr<Expression> x)
-      : y1_(std::move(y1)), y2_(std::move(y2)), x_(std::move(x)) {}
+  VlinStmt(Expression *y1, Expression *y2, Expression *x)
+      : y1_(y1), y2_(y2), x_(x) {}
   void execute(Interpreter *interp) override {
     interp->requireGraphicsMode();
-    graphics().vlin(y1_->evaluate(interp).getNumber(),
-                    y2_->evaluate(interp).getNumber(),
-                    x_->evaluate(interp).getNumber());
+    graphics().vlin(y1_->evaluateNumber(interp), y2_->evaluateNumber(interp),
+                    x_->evaluateNumber(interp));
+  }
+
+  void foldConstants(ConstantFolder &folder) override {
+    folder.fold(y1_);
+    folder.fold(y2_);
+    folder.fold(x_);
   }
 
 private:
-  std::shared_ptr<Expression> y1_;
-  std::shared_ptr<Expression> y2_;
-  std::shared_ptr<Expression> x_;
+  Expression *y1_;
+  Expression *y2_;
+  Expression *x_;
 };
 
 class HplotStmt : public Statement {
 public:
-  HplotStmt(std::vector<
-            std::pair<std::shared_ptr<Expression>, std::shared_ptr<Expression>>>
-                coords)
+  HplotStmt(std::vector< std::pair<Expression *, Expression *>> coords)
       : coords_(std::move(coords)) {}
   void execute(Interpreter *interp) override {
     interp->requireGraphicsMode();
     // HPLOT plots points in high-resolution graphics mode
     if (!coords_.empty()) {
-      double x = coords_[0].first->evaluate(interp).getNumber();
-      double y = coords_[0].second->evaluate(interp).getNumber();
+      double x = coords_[0].first->evaluateNumber(interp);
+      double y = coords_[0].second->evaluateNumber(interp);
       graphics().hplot(x, y);
 
       for (size_t i = 1; i < coords_.size(); ++i) {
-        x = coords_[i].first->evaluate(interp).getNumber();
-        y = coords_[i].second->evaluate(interp).getNumber();
+        x = coords_[i].first->evaluateNumber(interp);
+        y = coords_[i].second->evaluateNumber(interp);
         graphics().hplot_to(x, y);
       }
     }
   }
 
+  void foldConstants(ConstantFolder &folder) override {
+    for (auto &coord : coords_) {
+      folder.fold(coord.first);
+      folder.fold(coord.second);
+    }
+  }
+
 private:
   std::vector<
-      std::pair<std::shared_ptr<Expression>, std::shared_ptr<Expression>>>
+      std::pair<Expression *, Expression *>>
       coords_;
 };
 
 class MoveStmt : public Statement {
 public:
-  MoveStmt(std::shared_ptr<Expression> x, std::shared_ptr<Expression> y)
-      : x_(std::move(x)), y_(std::move(y)) {}
+  MoveStmt(Expression *x, Expression *y) : x_(x), y_(y) {}
   void execute(Interpreter *interp) override {
     interp->requireGraphicsMode();
-    graphics().move(x_->evaluate(interp).getNumber(),
-                    y_->evaluate(interp).getNumber());
+    graphics().move(x_->evaluateNumber(interp), y_->evaluateNumber(interp));
   }
 
 private:
-  std::shared_ptr<Expression> x_;
-  std::shared_ptr<Expression> y_;
+  Expression *x_;
+  Expression *y_;
 };
 
 class RotateStmt : public Statement {
 public:
-  explicit RotateStmt(std::shared_ptr<Expression> angle)
-      : angle_(std::move(angle)) {}
+  explicit RotateStmt(Expression *angle) : angle_(angle) {}
   void execute(Interpreter *interp) override {
     interp->requireGraphicsMode();
-    int angle = static_cast<int>(angle_->evaluate(interp).getNumber());
+    int angle = static_cast<int>(angle_->evaluateNumber(interp));
     graphics().setRotate(angle);
   }
 
 private:
-  std::shared_ptr<Expression> angle_;
+  Expression *angle_;
 };
 
 class ScaleStmt : public Statement {
 public:
-  explicit ScaleStmt(std::shared_ptr<Expression> scale)
-      : scale_(std::move(scale)) {}
+  explicit ScaleStmt(Expression *scale) : scale_(scale) {}
   void execute(Interpreter *interp) override {
     interp->requireGraphicsMode();
-    int s = static_cast<int>(scale_->evaluate(interp).getNumber());
+    int s = static_cast<int>(scale_->evaluateNumber(interp));
     graphics().setScale(s);
   }
 
 private:
-  std::shared_ptr<Expression> scale_;
+  Expression *scale_;
 };
 
 class ShloadStmt : public Statement {
@@ -215,20 +230,24 @@ public:
     } else {
       // Load from DATA statements (existing behavior)
       // Read shape number
-      Value shapeNumVal = interp->readData();
-      int shapeNum = static_cast<int>(shapeNumVal.getNumber());
-
-      // Read number of points
-      Value numPointsVal = interp->readData();
-      int numPoints = static_cast<int>(numPointsVal.getNumber());
+      const Value *shapeNumVal = interp->readData();
+      const Value *numPointsVal = shapeNumVal ? interp->readData() : nullptr;
+      if (!numPointsVal) {
+        return;
+      }
+      int shapeNum = static_cast<int>(shapeNumVal->getNumber());
+      int numPoints = static_cast<int>(numPointsVal->getNumber());
 
       // Read point pairs
       std::vector<std::pair<double, double>> points;
       points.reserve(static_cast<size_t>(numPoints));
       for (int i = 0; i < numPoints; ++i) {
-        Value xVal = interp->readData();
-        Value yVal = interp->readData();
-        points.push_back({xVal.getNumber(), yVal.getNumber()});
+        const Value *xVal = interp->readData();
+        const Value *yVal = xVal ? interp->readData() : nullptr;
+        if (!yVal) {
+          return;
+        }
+        points.push_back({xVal->getNumber(), yVal->getNumber()});
       }
 
       // Load shape into graphics
@@ -242,16 +261,14 @@ private:
 
 class DrawStmt : public Statement {
 public:
-  DrawStmt(std::shared_ptr<Expression> shape,
-           std::shared_ptr<Expression> x = nullptr,
-           std::shared_ptr<Expression> y = nullptr)
-      : shape_(std::move(shape)), x_(std::move(x)), y_(std::move(y)) {}
+  DrawStmt(Expression *shape, Expression *x = nullptr, Expression *y = nullptr)
+      : shape_(shape), x_(x), y_(y) {}
   void execute(Interpreter *interp) override {
     interp->requireGraphicsMode();
-    int shapeNum = static_cast<int>(shape_->evaluate(interp).getNumber());
+    int shapeNum = static_cast<int>(shape_->evaluateNumber(interp));
     if (x_ && y_) {
-      double xVal = x_->evaluate(interp).getNumber();
-      double yVal = y_->evaluate(interp).getNumber();
+      double xVal = x_->evaluateNumber(interp);
+      double yVal = y_->evaluateNumber(interp);
       graphics().draw(shapeNum, xVal, yVal);
     } else {
       graphics().draw(shapeNum);
@@ -259,23 +276,21 @@ public:
   }
 
 private:
-  std::shared_ptr<Expression> shape_;
-  std::shared_ptr<Expression> x_;
-  std::shared_ptr<Expression> y_;
+  Expression *shape_;
+  Expression *x_;
+  Expression *y_;
 };
 
 class XdrawStmt : public Statement {
 public:
-  XdrawStmt(std::shared_ptr<Expression> shape,
-            std::shared_ptr<Expression> x = nullptr,
-            std::shared_ptr<Expression> y = nullptr)
-      : shape_(std::move(shape)), x_(std::move(x)), y_(std::move(y)) {}
+  XdrawStmt(Expression *shape, Expression *x = nullptr, Expression *y = nullptr)
+      : shape_(shape), x_(x), y_(y) {}
   void execute(Interpreter *interp) override {
     interp->requireGraphicsMode();
-    int shapeNum = static_cast<int>(shape_->evaluate(interp).getNumber());
+    int shapeNum = static_cast<int>(shape_->evaluateNumber(interp));
     if (x_ && y_) {
-      double xVal = x_->evaluate(interp).getNumber();
-      double yVal = y_->evaluate(interp).getNumber();
+      double xVal = x_->evaluateNumber(interp);
+      double yVal = y_->evaluateNumber(interp);
       graphics().xdraw(shapeNum, xVal, yVal);
     } else {
       graphics().xdraw(shapeNum);
@@ -283,58 +298,74 @@ public:
   }
 
 private:
-  std::shared_ptr<Expression> shape_;
-  std::shared_ptr<Expression> x_;
-  std::shared_ptr<Expression> y_;
+  Expression *shape_;
+  Expression *x_;
+  Expression *y_;
 };
 
 class OnTransferStmt : public Statement {
 public:
   enum Kind { Goto, Gosub };
-  OnTransferStmt(std::shared_ptr<Expression> index, Kind kind,
-                 std::vector<int> lines)
-      : index_(std::move(index)), kind_(kind), lines_(std::move(lines)) {}
+  OnTransferStmt(Expression *index, Kind kind, const std::vector<int> &lines)
+      : index_(index), kind_(kind), lines_(lines.begin(), lines.end()) {}
   void execute(Interpreter *interp) override {
-    int n = static_cast<int>(index_->evaluate(interp).getNumber());
+    int n = static_cast<int>(index_->evaluateNumber(interp));
     if (n < 1 || n > static_cast<int>(lines_.size())) {
       return; // Do nothing if out of range (Applesoft behavior)
     }
-    int line = lines_[static_cast<size_t>(n - 1)];
+    LineRef &target = lines_[static_cast<size_t>(n - 1)];
     if (kind_ == Goto) {
-      interp->gotoLine(line);
+      interp->gotoLine(target);
     } else {
-      interp->gosub(line);
+      interp->gosub(target);
     }
   }
+  void linkTargets(const Program &program) override {
+    for (auto &target : lines_) {
+      program.resolve(target);
+    }
+  }
+
+  void foldConstants(ConstantFolder &folder) override {
+    folder.fold(index_);
+  }
 
 private:
-  std::shared_ptr<Expression> index_;
+  Expression *index_;
   Kind kind_;
-  std::vector<int> lines_;
+  std::vector<LineRef> lines_;
 };
 
 class HtabStmt : public Statement {
 public:
-  explicit HtabStmt(std::shared_ptr<Expression> col) : col_(std::move(col)) {}
+  explicit HtabStmt(Expression *col) : col_(col) {}
   void execute(Interpreter *interp) override {
-    int target = static_cast<int>(col_->evaluate(interp).getNumber());
+    int target = static_cast<int>(col_->evaluateNumber(interp));
     interp->htab(target);
   }
 
+  void foldConstants(ConstantFolder &folder) override {
+    folder.fold(col_);
+  }
+
 private:
-  std::shared_ptr<Expression> col_;
+  Expression *col_;
 };
 
 class VtabStmt : public Statement {
 public:
-  explicit VtabStmt(std::shared_ptr<Expression> row) : row_(std::move(row)) {}
+  explicit VtabStmt(Expression *row) : row_(row) {}
   void execute(Interpreter *interp) override {
-    int target = static_cast<int>(row_->evaluate(interp).getNumber());
+    int target = static_cast<int>(row_->evaluateNumber(interp));
     interp->vtab(target);
   }
 
+  void foldConstants(ConstantFolder &folder) override {
+    folder.fold(row_);
+  }
+
 private:
-  std::shared_ptr<Expression> row_;
+  Expression *row_;
 };
 
 class InverseStmt : public Statement {
@@ -362,199 +393,480 @@ public:
 
 class HcolorStmt : public Statement {
 public:
-  explicit HcolorStmt(std::shared_ptr<Expression> color)
-      : color_(std::move(color)) {}
+  explicit HcolorStmt(Expression *color) : color_(color) {}
   void execute(Interpreter *interp) override {
     interp->requireGraphicsMode();
-    int c = static_cast<int>(color_->evaluate(interp).getNumber());
+    int c = static_cast<int>(color_->evaluateNumber(interp));
     graphics().setColor(c);
   }
 
+  void foldConstants(ConstantFolder &folder) override {
+    folder.fold(color_);
+  }
+
 private:
-  std::shared_ptr<Expression> color_;
+  Expression *color_;
 };
 
 class ColorStmt : public Statement {
 public:
-  explicit ColorStmt(std::shared_ptr<Expression> color)
-      : color_(std::move(color)) {}
+  explicit ColorStmt(Expression *color) : color_(color) {}
   void execute(Interpreter *interp) override {
     interp->requireGraphicsMode();
-    int c = static_cast<int>(color_->evaluate(interp).getNumber());
+    int c = static_cast<int>(color_->evaluateNumber(interp));
     graphics().setColor(c);
   }
 
+  void foldConstants(ConstantFolder &folder) override {
+    folder.fold(color_);
+  }
+
 private:
-  std::shared_ptr<Expression> color_;
+  Expression *color_;
 };
 
 // Expression classes
 class LiteralExpr : public Expression {
 public:
-  explicit LiteralExpr(const Value &val) : value_(val) {}
+  explicit LiteralExpr(const Value &val)
+      : value_(val), number_(val.getNumber()) {}
   Value evaluate(Interpreter *) override { return value_; }
+  double evaluateNumber(Interpreter *) override { return number_; }
+  bool isNumeric() const override { return value_.isNumber(); }
+  bool isConstant() const override { return true; }
+  bool isFloat40Exact() const override {
+    return value_.isNumber() && Float40(number_).toDouble() == number_ &&
+           !std::signbit(number_);
+  }
+  void compile(bytecode::Compiler &compiler) override {
+    compiler.emit(bytecode::OpCode::PushConstant,
+                  compiler.addConstant(value_));
+  }
+  bool lowerNumeric(looptier::Builder &builder) override {
+    if (!value_.isNumber()) {
+      return false;
+    }
+    builder.emit(looptier::OpCode::Constant, builder.addConstant(number_));
+    return true;
+  }
 
 private:
   Value value_;
+  double number_;
 };
 
 class VariableExpr : public Expression {
 public:
-  explicit VariableExpr(const std::string &name) : name_(name) {}
+  explicit VariableExpr(const std::string &name)
+      : slot_(symbols().intern(name)) {}
   Value evaluate(Interpreter *interp) override {
-    return interp->getVariables().getVariable(name_);
+    return interp->getVariables().getVariable(slot_);
+  }
+  double evaluateNumber(Interpreter *interp) override {
+    return interp->getVariables().getVariable(slot_).getNumber();
+  }
+  bool isNumeric() const override {
+    return symbols().kind(slot_) != SymbolTable::Kind::String;
+  }
+  // Integer variables only ever hold small whole numbers
+  bool isFloat40Exact() const override {
+    return symbols().kind(slot_) == SymbolTable::Kind::Integer;
+  }
+  void compile(bytecode::Compiler &compiler) override {
+    compiler.emit(bytecode::OpCode::LoadVariable,
+                  static_cast<int32_t>(slot_));
+  }
+  bool lowerNumeric(looptier::Builder &builder) override {
+    if (!isNumeric()) {
+      return false;
+    }
+    builder.emit(looptier::OpCode::Load, static_cast<int32_t>(slot_));
+    return true;
   }
 
+  SymbolId slot() const { return slot_; }
+
 private:
-  std::string name_;
+  SymbolId slot_;
+};
+
+/**
+ * @brief Evaluated array subscripts
+ *
+ * Holds up to four subscripts inline so element access does not allocate;
+ * longer subscript lists spill to the heap.
+ */
+class Subscripts {
+public:
+  Subscripts(const std::vector<Expression *> &exprs, Interpreter *interp)
+      : count_(exprs.size()) {
+    if (count_ > kInline) {
+      heap_.resize(count_);
+    }
+    int *out = data();
+    for (size_t i = 0; i < count_; ++i) {
+      out[i] = static_cast<int>(exprs[i]->evaluateNumber(interp));
+    }
+  }
+
+  int *data() { return count_ > kInline ? heap_.data() : inline_; }
+  size_t size() const { return count_; }
+
+private:
+  static constexpr size_t kInline = 4;
+  int inline_[kInline];
+  std::vector<int> heap_;
+  size_t count_;
 };
 
 class ArrayAccessExpr : public Expression {
 public:
-  ArrayAccessExpr(const std::string &name,
-                  std::vector<std::shared_ptr<Expression>> indices)
-      : name_(name), indices_(std::move(indices)) {}
+  ArrayAccessExpr(const std::string &name, std::vector<Expression *> indices)
+      : slot_(symbols().intern(name)), indices_(std::move(indices)) {}
 
   Value evaluate(Interpreter *interp) override {
-    std::vector<int> idx;
-    idx.reserve(indices_.size());
+    Subscripts idx(indices_, interp);
+    return interp->getVariables().getArrayElement(slot_, idx.data(),
+                                                  idx.size());
+  }
+
+  double evaluateNumber(Interpreter *interp) override {
+    Subscripts idx(indices_, interp);
+    return interp->getVariables().getArrayNumber(slot_, idx.data(),
+                                                 idx.size());
+  }
+
+  bool isNumeric() const override {
+    return symbols().kind(slot_) != SymbolTable::Kind::String;
+  }
+
+  bool isFloat40Exact() const override {
+    return symbols().kind(slot_) == SymbolTable::Kind::Integer;
+  }
+
+  Expression *fold(ConstantFolder &folder) override {
+    folder.fold(indices_);
+    return nullptr;
+  }
+
+  void compile(bytecode::Compiler &compiler) override {
     for (auto &expr : indices_) {
-      idx.push_back(static_cast<int>(expr->evaluate(interp).getNumber()));
+      compiler.compileExpression(*expr);
     }
-    return interp->getVariables().getArrayElement(name_, idx);
+    compiler.emit(bytecode::OpCode::LoadArray, static_cast<int32_t>(slot_),
+                  static_cast<uint16_t>(indices_.size()));
+  }
+
+  bool lowerNumeric(looptier::Builder &builder) override {
+    if (!isNumeric()) {
+      return false;
+    }
+    for (auto &expr : indices_) {
+      if (!expr->lowerNumeric(builder)) {
+        return false;
+      }
+    }
+    builder.emit(looptier::OpCode::LoadElement, static_cast<int32_t>(slot_),
+                 static_cast<uint16_t>(indices_.size()));
+    return true;
+  }
+
+  SymbolId slot() const { return slot_; }
+  const std::vector<Expression *> &indices() const {
+    return indices_;
   }
 
 private:
-  std::string name_;
-  std::vector<std::shared_ptr<Expression>> indices_;
+  SymbolId slot_;
+  std::vector<Expression *> indices_;
 };
 
 class UnaryExpr : public Expression {
 public:
-  UnaryExpr(TokenType op, std::shared_ptr<Expression> operand)
-      : op_(op), operand_(std::move(operand)) {}
+  UnaryExpr(TokenType op, Expression *operand) : op_(op), operand_(operand) {}
 
   Value evaluate(Interpreter *interp) override {
-    Value v = operand_->evaluate(interp);
     if (op_ == TokenType::MINUS) {
-      return Value(-v.getNumber());
+      return Value(-operand_->evaluateNumber(interp));
     }
     // Unary plus is no-op
-    return v;
+    return operand_->evaluate(interp);
+  }
+
+  double evaluateNumber(Interpreter *interp) override {
+    double v = operand_->evaluateNumber(interp);
+    return op_ == TokenType::MINUS ? -v : v;
+  }
+
+  bool isNumeric() const override {
+    return op_ == TokenType::MINUS || operand_->isNumeric();
+  }
+
+  Expression *fold(ConstantFolder &folder) override {
+    folder.fold(operand_);
+    if (operand_->isConstant()) {
+      return folder.evaluateConstant(*this, 1);
+    }
+    if (op_ == TokenType::PLUS) {
+      return folder.replaceWith(operand_, 1);
+    }
+    return nullptr;
+  }
+
+  void compile(bytecode::Compiler &compiler) override {
+    compiler.compileExpression(*operand_);
+    if (op_ == TokenType::MINUS) {
+      compiler.emit(bytecode::OpCode::Negate);
+    }
+  }
+
+  bool lowerNumeric(looptier::Builder &builder) override {
+    if (!isNumeric() || !operand_->lowerNumeric(builder)) {
+      return false;
+    }
+    if (op_ == TokenType::MINUS) {
+      builder.emit(looptier::OpCode::Negate);
+    }
+    return true;
   }
 
 private:
   TokenType op_;
-  std::shared_ptr<Expression> operand_;
+  Expression *operand_;
 };
 
 class NotExpr : public Expression {
 public:
-  explicit NotExpr(std::shared_ptr<Expression> operand)
-      : operand_(std::move(operand)) {}
+  explicit NotExpr(Expression *operand) : operand_(operand) {}
 
   Value evaluate(Interpreter *interp) override {
-    double v = operand_->evaluate(interp).getNumber();
-    return Value(v == 0.0 ? 1.0 : 0.0);
+    return Value(evaluateNumber(interp));
+  }
+
+  double evaluateNumber(Interpreter *interp) override {
+    return operand_->evaluateNumber(interp) == 0.0 ? 1.0 : 0.0;
+  }
+
+  bool isNumeric() const override { return true; }
+  bool isFloat40Exact() const override { return true; }
+
+  Expression *fold(ConstantFolder &folder) override {
+    folder.fold(operand_);
+    if (operand_->isConstant()) {
+      return folder.evaluateConstant(*this, 1);
+    }
+    return nullptr;
+  }
+
+  void compile(bytecode::Compiler &compiler) override {
+    compiler.compileExpression(*operand_);
+    compiler.emit(bytecode::OpCode::LogicalNot);
+  }
+
+  bool lowerNumeric(looptier::Builder &builder) override {
+    if (!operand_->lowerNumeric(builder)) {
+      return false;
+    }
+    builder.emit(looptier::OpCode::Not);
+    return true;
   }
 
 private:
-  std::shared_ptr<Expression> operand_;
+  Expression *operand_;
 };
 
 class BinaryExpr : public Expression {
 public:
-  BinaryExpr(std::shared_ptr<Expression> left, TokenType op,
-             std::shared_ptr<Expression> right)
-      : left_(left), op_(op), right_(right) {}
+  BinaryExpr(Expression *left, TokenType op, Expression *right)
+      : left_(left), op_(op), right_(right),
+        numericOperands_(left_->isNumeric() && right_->isNumeric()) {}
 
   Value evaluate(Interpreter *interp) override {
+    if (numericOperands_) {
+      return Value(evaluateNumber(interp));
+    }
     Value lval = left_->evaluate(interp);
     Value rval = right_->evaluate(interp);
+    return applyBinaryOperator(op_, lval, rval);
+  }
+
+  double evaluateNumber(Interpreter *interp) override {
+    if (!numericOperands_) {
+      return evaluate(interp).getNumber();
+    }
+    double lhs = left_->evaluateNumber(interp);
+    double rhs = right_->evaluateNumber(interp);
+    return applyNumericOperator(op_, lhs, rhs);
+  }
 
+  // Only + can produce a string (concatenation)
+  bool isNumeric() const override {
+    return op_ != TokenType::PLUS || numericOperands_;
+  }
+
+  // Numeric results come out of Float40 arithmetic or are 0/1
+  bool isFloat40Exact() const override { return isNumeric(); }
+
+  Expression *fold(ConstantFolder &folder) override {
+    folder.fold(left_);
+    folder.fold(right_);
+    numericOperands_ = left_->isNumeric() && right_->isNumeric();
+    if (left_->isConstant() && right_->isConstant()) {
+      return folder.evaluateConstant(*this, 2);
+    }
+
+    // X+0, X-0, X*1 and X/1 only re-round X, a no-op when X is exact
+    double identity = 0.0;
     switch (op_) {
     case TokenType::PLUS:
-      return lval + rval;
     case TokenType::MINUS:
-      return lval - rval;
+      identity = 0.0;
+      break;
     case TokenType::MULTIPLY:
-      return lval * rval;
     case TokenType::DIVIDE:
-      return lval / rval;
-    case TokenType::POWER: {
-      Float40 a(lval.getNumber());
-      Float40 b(rval.getNumber());
-      return Value(a.power(b).toDouble());
-    }
-    case TokenType::MOD: {
-      Float40 a(lval.getNumber());
-      Float40 b(rval.getNumber());
-      return Value(a.mod(b).toDouble());
-    }
-    case TokenType::EQUAL:
-      return Value(lval == rval ? 1.0 : 0.0);
-    case TokenType::NOT_EQUAL:
-      return Value(lval != rval ? 1.0 : 0.0);
-    case TokenType::LESS:
-      return Value(lval < rval ? 1.0 : 0.0);
-    case TokenType::GREATER:
-      return Value(lval > rval ? 1.0 : 0.0);
-    case TokenType::LESS_EQUAL:
-      return Value(lval <= rval ? 1.0 : 0.0);
-    case TokenType::GREATER_EQUAL:
-      return Value(lval >= rval ? 1.0 : 0.0);
-    case TokenType::AND:
-      return Value((lval.getNumber() != 0 && rval.getNumber() != 0) ? 1.0
-                                                                    : 0.0);
-    case TokenType::OR:
-      return Value((lval.getNumber() != 0 || rval.getNumber() != 0) ? 1.0
-                                                                    : 0.0);
+      identity = 1.0;
+      break;
     default:
-      return Value(0.0);
+      return nullptr;
+    }
+    if (isConstantNumber(right_, identity) && left_->isFloat40Exact()) {
+      return folder.replaceWith(left_, 2);
+    }
+    bool commutative = op_ == TokenType::PLUS || op_ == TokenType::MULTIPLY;
+    if (commutative && isConstantNumber(left_, identity) &&
+        right_->isFloat40Exact()) {
+      return folder.replaceWith(right_, 2);
+    }
+    return nullptr;
+  }
+
+  void compile(bytecode::Compiler &compiler) override {
+    compiler.compileExpression(*left_);
+    compiler.compileExpression(*right_);
+    compiler.emit(bytecode::OpCode::BinaryOp, static_cast<int32_t>(op_));
+  }
+
+  bool lowerNumeric(looptier::Builder &builder) override {
+    if (!numericOperands_ || !left_->lowerNumeric(builder) ||
+        !right_->lowerNumeric(builder)) {
+      return false;
     }
+    builder.emit(looptier::OpCode::Binary, static_cast<int32_t>(op_));
+    return true;
   }
 
+  TokenType op() const { return op_; }
+  Expression *left() const { return left_; }
+  Expression *right() const { return right_; }
+
 private:
-  std::shared_ptr<Expression> left_;
+  static bool isConstantNumber(Expression *expr, double value) {
+    return expr->isConstant() && expr->isNumeric() &&
+           expr->evaluateNumber(nullptr) == value;
+  }
+
+  Expression *left_;
   TokenType op_;
-  std::shared_ptr<Expression> right_;
+  Expression *right_;
+  bool numericOperands_;
 };
 
-class UserFunctionCallExpr : public Expression {
+/**
+ * @brief The parameter of a DEF FN body
+ *
+ * References to the parameter inside the body are bound at parse time and
+ * read the innermost parameter frame instead of the variable table.
+ */
+class ParameterExpr : public Expression {
 public:
-  UserFunctionCallExpr(std::string name, std::shared_ptr<Expression> arg)
-      : name_(std::move(name)), arg_(std::move(arg)) {}
-
+  explicit ParameterExpr(SymbolId slot) : slot_(slot) {}
   Value evaluate(Interpreter *interp) override {
-    auto &vars = interp->getVariables();
-    const auto &fn = vars.getFunction(name_);
-
-    Value argValue = arg_->evaluate(interp);
-
-    bool hadExisting = vars.hasVariable(fn.parameter);
-    Value oldValue = vars.getVariable(fn.parameter);
+    return interp->getVariables().parameter();
+  }
+  double evaluateNumber(Interpreter *interp) override {
+    return interp->getVariables().parameter().getNumber();
+  }
+  bool isNumeric() const override {
+    return symbols().kind(slot_) != SymbolTable::Kind::String;
+  }
+  bool isFloat40Exact() const override {
+    return symbols().kind(slot_) == SymbolTable::Kind::Integer;
+  }
 
-    vars.setVariable(fn.parameter, argValue);
-    Value result = fn.body->evaluate(interp);
+private:
+  SymbolId slot_;
+};
 
-    if (hadExisting) {
-      vars.setVariable(fn.parameter, oldValue);
-    } else {
-      vars.unsetVariable(fn.parameter);
+/**
+ * @brief Binds a DEF FN argument for the duration of one call
+ *
+ * Pushes the parameter frame read by ParameterExpr. For functions that
+ * bind their parameter variable (FunctionInfo::bindsVariable) it also
+ * assigns the variable and restores its previous state afterwards. Both
+ * are undone when the body throws.
+ */
+class ParameterFrame {
+public:
+  ParameterFrame(Variables &vars, const Variables::FunctionInfo &fn,
+                 const Value &arg)
+      : vars_(vars), slot_(fn.parameter), bindsVariable_(fn.bindsVariable) {
+    vars_.pushParameter(slot_, arg);
+    if (bindsVariable_) {
+      hadValue_ = vars_.isDefined(slot_);
+      saved_ = vars_.getVariable(slot_);
+      vars_.setVariable(slot_, arg);
+    }
+  }
+  ~ParameterFrame() {
+    vars_.popParameter();
+    if (bindsVariable_) {
+      if (hadValue_) {
+        vars_.setVariable(slot_, saved_);
+      } else {
+        vars_.unsetVariable(slot_);
+      }
     }
+  }
+  ParameterFrame(const ParameterFrame &) = delete;
+  ParameterFrame &operator=(const ParameterFrame &) = delete;
 
-    return result;
+private:
+  Variables &vars_;
+  SymbolId slot_;
+  bool bindsVariable_;
+  bool hadValue_ = false;
+  Value saved_;
+};
+
+class UserFunctionCallExpr : public Expression {
+public:
+  UserFunctionCallExpr(const std::string &name, Expression *arg)
+      : slot_(symbols().intern(name)), arg_(arg) {}
+  Value evaluate(Interpreter *interp) override {
+    auto &vars = interp->getVariables();
+    const auto &fn = vars.getFunction(slot_);
+    ParameterFrame frame(vars, fn, arg_->evaluate(interp));
+    return fn.body->evaluate(interp);
+  }
+  double evaluateNumber(Interpreter *interp) override {
+    auto &vars = interp->getVariables();
+    const auto &fn = vars.getFunction(slot_);
+    ParameterFrame frame(vars, fn, arg_->evaluate(interp));
+    return fn.body->evaluateNumber(interp);
+  }
+  Expression *fold(ConstantFolder &folder) override {
+    folder.fold(arg_);
+    return nullptr;
   }
 
 private:
-  std::string name_;
-  std::shared_ptr<Expression> arg_;
+  SymbolId slot_;
+  Expression *arg_;
 };
 
 class FunctionCallExpr : public Expression {
 public:
-  FunctionCallExpr(TokenType func,
-                   std::vector<std::shared_ptr<Expression>> args)
+  FunctionCallExpr(TokenType func, std::vector<Expression *> args)
       : func_(func), args_(args) {}
 
   Value evaluate(Interpreter *interp) override {
@@ -562,75 +874,143 @@ public:
     for (auto &arg : args_) {
       argValues.push_back(arg->evaluate(interp));
     }
+    return callBuiltinFunction(func_, argValues.data());
+  }
 
-    switch (func_) {
-    case TokenType::SIN:
-      return funcSin(argValues[0]);
-    case TokenType::COS:
-      return funcCos(argValues[0]);
-    case TokenType::TAN:
-      return funcTan(argValues[0]);
-    case TokenType::ATN:
-      return funcAtn(argValues[0]);
-    case TokenType::EXP:
-      return funcExp(argValues[0]);
-    case TokenType::LOG:
-      return funcLog(argValues[0]);
-    case TokenType::SQR:
-      return funcSqr(argValues[0]);
-    case TokenType::ABS:
-      return funcAbs(argValues[0]);
-    case TokenType::INT:
-      return funcInt(argValues[0]);
-    case TokenType::SGN:
-      return funcSgn(argValues[0]);
-    case TokenType::RND:
-      return funcRnd(argValues[0]);
-    case TokenType::LEN:
-      return funcLen(argValues[0]);
-    case TokenType::VAL:
-      return funcVal(argValues[0]);
-    case TokenType::ASC:
-      return funcAsc(argValues[0]);
-    case TokenType::CHR:
-      return funcChr(argValues[0]);
-    case TokenType::LEFT:
-      return funcLeft(argValues[0], argValues[1]);
-    case TokenType::RIGHT:
-      return funcRight(argValues[0], argValues[1]);
-    case TokenType::MID:
-      return funcMid(argValues[0], argValues[1], argValues[2]);
-    case TokenType::STR:
-      return funcStr(argValues[0]);
-    case TokenType::SCRN:
-      return funcScrn(argValues[0], argValues[1]);
-    case TokenType::USR:
-      return funcUsr(argValues[0]);
-    case TokenType::PEEK:
-      return funcPeek(argValues[0]);
-    case TokenType::FRE:
-      return funcFre(argValues[0]);
-    case TokenType::PDL:
-      return funcPdl(argValues[0]);
-    case TokenType::POS:
-      return funcPos(argValues[0]);
-    default:
-      return Value(0.0);
+  double evaluateNumber(Interpreter *interp) override {
+    if (args_.size() == 1 && isMathFunction(func_)) {
+      return callMathFunction(func_, args_[0]->evaluateNumber(interp));
+    }
+    return evaluate(interp).getNumber();
+  }
+
+  bool isNumeric() const override { return isNumericBuiltin(func_); }
+  bool isFloat40Exact() const override { return isMathFunction(func_); }
+
+  Expression *fold(ConstantFolder &folder) override {
+    folder.fold(args_);
+    if (!isPureBuiltin(func_)) {
+      return nullptr;
+    }
+    for (auto &arg : args_) {
+      if (!arg->isConstant()) {
+        return nullptr;
+      }
+    }
+    return folder.evaluateConstant(*this, args_.size());
+  }
+
+  void compile(bytecode::Compiler &compiler) override {
+    for (auto &arg : args_) {
+      compiler.compileExpression(*arg);
+    }
+    compiler.emit(bytecode::OpCode::CallBuiltin, static_cast<int32_t>(func_),
+                  static_cast<uint16_t>(args_.size()));
+  }
+
+  // RND is excluded: a bail-out re-runs the statement, which must not
+  // advance the generator twice
+  bool lowerNumeric(looptier::Builder &builder) override {
+    if (args_.size() != 1 || !isMathFunction(func_) || !isPureBuiltin(func_) ||
+        !args_[0]->lowerNumeric(builder)) {
+      return false;
     }
+    builder.emit(looptier::OpCode::Math, static_cast<int32_t>(func_));
+    return true;
   }
 
 private:
   TokenType func_;
-  std::vector<std::shared_ptr<Expression>> args_;
+  std::vector<Expression *> args_;
 };
 
+void ConstantFolder::fold(Expression *&expr) {
+  if (!expr) {
+    return;
+  }
+  if (auto replacement = expr->fold(*this)) {
+    expr = replacement;
+  }
+}
+
+void ConstantFolder::fold(std::vector<Expression *> &exprs) {
+  for (auto &expr : exprs) {
+    fold(expr);
+  }
+}
+
+void ConstantFolder::fold(std::vector<Statement *> &statements) {
+  for (auto &stmt : statements) {
+    stmt->foldConstants(*this);
+  }
+}
+
+Expression *ConstantFolder::evaluateConstant(Expression &expr, size_t removed) {
+  try {
+    // Constant subtrees never touch the interpreter
+    Value value = expr.evaluate(nullptr);
+    removed_ += removed;
+    return arena_.make<LiteralExpr>(value);
+  } catch (const std::exception &) {
+    // Leave it for run time so the error is reported where it happens
+    return nullptr;
+  }
+}
+
+Expression *ConstantFolder::replaceWith(Expression *operand, size_t removed) {
+  removed_ += removed;
+  return operand;
+}
+
+const char *SuperinstructionStats::name(Superinstruction kind) {
+  switch (kind) {
+  case Superinstruction::Increment:
+    return "increment";
+  case Superinstruction::IfGoto:
+    return "if-goto";
+  case Superinstruction::IfArrayCompare:
+    return "if-array-compare";
+  case Superinstruction::PrintVariable:
+    return "print-variable";
+  case Superinstruction::PokeConstant:
+    return "poke-constant";
+  case Superinstruction::Count:
+    break;
+  }
+  return "?";
+}
+
+SuperinstructionStats &superinstructionStats() {
+  static SuperinstructionStats stats;
+  return stats;
+}
+
+/**
+ * @brief Replace statements by their fused superinstructions in place
+ */
+static void fuseStatements(std::vector<Statement *> &stmts, AstArena &arena) {
+  for (auto &stmt : stmts) {
+    if (auto fused = stmt->fuse(arena)) {
+      stmt = fused;
+    }
+  }
+}
+
+/**
+ * @brief Check that @p expr is a numeric simple variable
+ * @return The variable node, or nullptr
+ */
+static VariableExpr *numericVariable(Expression *expr) {
+  auto var = dynamic_cast<VariableExpr *>(expr);
+  return var && var->isNumeric() ? var : nullptr;
+}
+
 // Statement classes
 class PrintStmt : public Statement {
 public:
   enum class Separator { None, Semicolon, Comma };
 
-  PrintStmt(std::vector<std::shared_ptr<Expression>> exprs,
-            std::vector<Separator> separators)
+  PrintStmt(std::vector<Expression *> exprs, std::vector<Separator> separators)
       : exprs_(std::move(exprs)), separators_(std::move(separators)) {}
 
   void execute(Interpreter *interp) override {
@@ -641,148 +1021,546 @@ public:
 
     for (size_t i = 0; i < exprs_.size(); ++i) {
       Value val = exprs_[i]->evaluate(interp);
-      interp->printText(val.getString());
+      interp->printValue(val);
 
       Separator sep = i < separators_.size() ? separators_[i] : Separator::None;
-      switch (sep) {
-      case Separator::Comma:
-        interp->printToNextZone();
-        break;
-      case Separator::Semicolon:
-        break;
-      case Separator::None:
-        interp->printNewline();
-        break;
+      printSeparator(interp, sep);
+    }
+  }
+
+  /** @brief Output what follows a printed item */
+  static void printSeparator(Interpreter *interp, Separator sep) {
+    switch (sep) {
+    case Separator::Comma:
+      interp->printToNextZone();
+      break;
+    case Separator::Semicolon:
+      break;
+    case Separator::None:
+      interp->printNewline();
+      break;
+    }
+  }
+
+  void compile(bytecode::Compiler &compiler) override {
+    if (exprs_.empty()) {
+      compiler.emit(bytecode::OpCode::PrintNewline);
+      return;
+    }
+
+    for (size_t i = 0; i < exprs_.size(); ++i) {
+      compiler.compileExpression(*exprs_[i]);
+      compiler.emit(bytecode::OpCode::PrintValue);
+
+      Separator sep = i < separators_.size() ? separators_[i] : Separator::None;
+      if (sep == Separator::Comma) {
+        compiler.emit(bytecode::OpCode::PrintZone);
+      } else if (sep == Separator::None) {
+        compiler.emit(bytecode::OpCode::PrintNewline);
       }
     }
   }
 
+  void foldConstants(ConstantFolder &folder) override {
+    folder.fold(exprs_);
+  }
+
+  Statement *fuse(AstArena &arena) override;
+
 private:
-  std::vector<std::shared_ptr<Expression>> exprs_;
+  std::vector<Expression *> exprs_;
   std::vector<Separator> separators_;
 };
 
+/**
+ * @brief Superinstruction: PRINT of one simple variable
+ *
+ * Prints the variable's stored value in place, without copying it.
+ */
+class PrintVariableStmt : public Statement {
+public:
+  PrintVariableStmt(SymbolId slot, PrintStmt::Separator sep)
+      : slot_(slot), sep_(sep) {}
+
+  void execute(Interpreter *interp) override {
+    superinstructionStats().fired(Superinstruction::PrintVariable);
+    interp->printValue(interp->getVariables().getVariable(slot_));
+    PrintStmt::printSeparator(interp, sep_);
+  }
+
+private:
+  SymbolId slot_;
+  PrintStmt::Separator sep_;
+};
+
+Statement *PrintStmt::fuse(AstArena &arena) {
+  if (exprs_.size() != 1 || separators_.size() > 1) {
+    return nullptr;
+  }
+  auto var = dynamic_cast<VariableExpr *>(exprs_[0]);
+  if (!var) {
+    return nullptr;
+  }
+  Separator sep = separators_.empty() ? Separator::None : separators_[0];
+  return arena.make<PrintVariableStmt>(var->slot(), sep);
+}
+
 class LetStmt : public Statement {
 public:
-  LetStmt(const std::string &var, std::shared_ptr<Expression> expr)
-      : var_(var), expr_(expr) {}
+  LetStmt(const std::string &var, Expression *expr)
+      : slot_(symbols().intern(var)), expr_(expr) {}
 
   void execute(Interpreter *interp) override {
     Value val = expr_->evaluate(interp);
-    interp->getVariables().setVariable(var_, val);
+    interp->getVariables().setVariable(slot_, val);
+  }
+
+  void compile(bytecode::Compiler &compiler) override {
+    compiler.compileExpression(*expr_);
+    compiler.emit(bytecode::OpCode::StoreVariable,
+                  static_cast<int32_t>(slot_));
+  }
+
+  bool lowerNumeric(looptier::Builder &builder) override {
+    if (symbols().kind(slot_) == SymbolTable::Kind::String ||
+        !expr_->lowerNumeric(builder)) {
+      return false;
+    }
+    builder.emit(looptier::OpCode::Store, static_cast<int32_t>(slot_));
+    return true;
+  }
+
+  void foldConstants(ConstantFolder &folder) override {
+    folder.fold(expr_);
+  }
+
+  Statement *fuse(AstArena &arena) override;
+
+private:
+  SymbolId slot_;
+  Expression *expr_;
+};
+
+/**
+ * @brief Superinstruction: V = V + c / V = V - c
+ *
+ * Reads, adjusts and stores the variable's number in its slot with the same
+ * Float40 operator (and integer clamping) as the generic assignment.
+ */
+class IncrementStmt : public Statement {
+public:
+  IncrementStmt(SymbolId slot, TokenType op, double step)
+      : slot_(slot), op_(op), step_(step) {}
+
+  void execute(Interpreter *interp) override {
+    superinstructionStats().fired(Superinstruction::Increment);
+    auto &vars = interp->getVariables();
+    double value = vars.getVariable(slot_).getNumber();
+    vars.setNumber(slot_, applyNumericOperator(op_, value, step_));
+  }
+
+  bool lowerNumeric(looptier::Builder &builder) override {
+    builder.emit(looptier::OpCode::Load, static_cast<int32_t>(slot_));
+    builder.emit(looptier::OpCode::Constant, builder.addConstant(step_));
+    builder.emit(looptier::OpCode::Binary, static_cast<int32_t>(op_));
+    builder.emit(looptier::OpCode::Store, static_cast<int32_t>(slot_));
+    return true;
   }
 
 private:
-  std::string var_;
-  std::shared_ptr<Expression> expr_;
+  SymbolId slot_;
+  TokenType op_;
+  double step_;
 };
 
+Statement *LetStmt::fuse(AstArena &arena) {
+  auto sum = dynamic_cast<BinaryExpr *>(expr_);
+  if (!sum ||
+      (sum->op() != TokenType::PLUS && sum->op() != TokenType::MINUS)) {
+    return nullptr;
+  }
+  auto var = numericVariable(sum->left());
+  Expression *step = sum->right();
+  if (!var && sum->op() == TokenType::PLUS) {
+    // c + V: addition is commutative, including its rounding
+    var = numericVariable(sum->right());
+    step = sum->left();
+  }
+  if (!var || var->slot() != slot_ || !step->isConstant() ||
+      !step->isNumeric()) {
+    return nullptr;
+  }
+  return arena.make<IncrementStmt>(slot_, sum->op(),
+                                   step->evaluateNumber(nullptr));
+}
+
 class ArrayLetStmt : public Statement {
 public:
-  ArrayLetStmt(const std::string &var,
-               std::vector<std::shared_ptr<Expression>> indices,
-               std::shared_ptr<Expression> expr)
-      : var_(var), indices_(std::move(indices)), expr_(std::move(expr)) {}
+  ArrayLetStmt(const std::string &var, std::vector<Expression *> indices,
+               Expression *expr)
+      : slot_(symbols().intern(var)), indices_(std::move(indices)),
+        expr_(expr) {}
 
   void execute(Interpreter *interp) override {
-    std::vector<int> idx;
-    idx.reserve(indices_.size());
+    Subscripts idx(indices_, interp);
+    Value val = expr_->evaluate(interp);
+    if (!interp->getVariables().writeArrayElement(slot_, idx.data(),
+                                                  idx.size(), val)) {
+      interp->raise(ErrorKind::BadSubscript);
+    }
+  }
+
+  void compile(bytecode::Compiler &compiler) override {
     for (auto &e : indices_) {
-      idx.push_back(static_cast<int>(e->evaluate(interp).getNumber()));
+      compiler.compileExpression(*e);
     }
-    Value val = expr_->evaluate(interp);
-    interp->getVariables().setArrayElement(var_, idx, val);
+    compiler.compileExpression(*expr_);
+    compiler.emit(bytecode::OpCode::StoreArray, static_cast<int32_t>(slot_),
+                  static_cast<uint16_t>(indices_.size()));
+  }
+
+  bool lowerNumeric(looptier::Builder &builder) override {
+    if (symbols().kind(slot_) == SymbolTable::Kind::String) {
+      return false;
+    }
+    for (auto &e : indices_) {
+      if (!e->lowerNumeric(builder)) {
+        return false;
+      }
+    }
+    if (!expr_->lowerNumeric(builder)) {
+      return false;
+    }
+    builder.emit(looptier::OpCode::StoreElement, static_cast<int32_t>(slot_),
+                 static_cast<uint16_t>(indices_.size()));
+    return true;
+  }
+
+  void foldConstants(ConstantFolder &folder) override {
+    folder.fold(indices_);
+    folder.fold(expr_);
   }
 
 private:
-  std::string var_;
-  std::vector<std::shared_ptr<Expression>> indices_;
-  std::shared_ptr<Expression> expr_;
+  SymbolId slot_;
+  std::vector<Expression *> indices_;
+  Expression *expr_;
 };
 
 class EndStmt : public Statement {
 public:
   void execute(Interpreter *interp) override { interp->endProgram(); }
+  void compile(bytecode::Compiler &compiler) override {
+    compiler.emit(bytecode::OpCode::End);
+  }
 };
 
 class GotoStmt : public Statement {
 public:
-  explicit GotoStmt(int lineNum) : lineNum_(lineNum) {}
-  void execute(Interpreter *interp) override { interp->gotoLine(lineNum_); }
+  explicit GotoStmt(int lineNum) : target_(lineNum) {}
+  void execute(Interpreter *interp) override { interp->gotoLine(target_); }
+  void linkTargets(const Program &program) override {
+    program.resolve(target_);
+  }
+  void compile(bytecode::Compiler &compiler) override {
+    compiler.emit(bytecode::OpCode::Goto, compiler.addLineRef(target_));
+  }
+
+  LineNumber target() const { return target_.line; }
 
 private:
-  int lineNum_;
+  LineRef target_;
 };
 
 class GosubStmt : public Statement {
 public:
-  explicit GosubStmt(int lineNum) : lineNum_(lineNum) {}
-  void execute(Interpreter *interp) override { interp->gosub(lineNum_); }
+  explicit GosubStmt(int lineNum) : target_(lineNum) {}
+  void execute(Interpreter *interp) override { interp->gosub(target_); }
+  void linkTargets(const Program &program) override {
+    program.resolve(target_);
+  }
+  void compile(bytecode::Compiler &compiler) override {
+    compiler.emit(bytecode::OpCode::Gosub, compiler.addLineRef(target_));
+  }
 
 private:
-  int lineNum_;
+  LineRef target_;
+};
+
+class ReturnStmt : public Statement {
+public:
+  void execute(Interpreter *interp) override { interp->returnFromGosub(); }
+  void compile(bytecode::Compiler &compiler) override {
+    compiler.emit(bytecode::OpCode::Return);
+  }
+};
+
+class IfStmt : public Statement {
+public:
+  IfStmt(Expression *condition, std::vector<Statement *> thenStmts,
+         std::vector<Statement *> elseStmts = {})
+      : condition_(condition), thenStmts_(thenStmts), elseStmts_(elseStmts) {}
+
+  void execute(Interpreter *interp) override {
+    executeBranch(interp, condition_->evaluateNumber(interp) != 0);
+  }
+
+  void linkTargets(const Program &program) override {
+    for (auto &stmt : thenStmts_) {
+      stmt->linkTargets(program);
+    }
+    for (auto &stmt : elseStmts_) {
+      stmt->linkTargets(program);
+    }
+  }
+
+  void compile(bytecode::Compiler &compiler) override {
+    compiler.compileExpression(*condition_);
+    size_t toElse = compiler.emit(bytecode::OpCode::JumpIfFalse);
+    for (auto &stmt : thenStmts_) {
+      compiler.compileStatement(*stmt);
+    }
+    size_t toEnd = compiler.emit(bytecode::OpCode::Jump);
+    compiler.patchJump(toElse);
+    for (auto &stmt : elseStmts_) {
+      compiler.compileStatement(*stmt);
+    }
+    compiler.patchJump(toEnd);
+  }
+
+  bool lowerNumeric(looptier::Builder &builder) override {
+    if (!condition_->lowerNumeric(builder)) {
+      return false;
+    }
+    size_t toElse = builder.emit(looptier::OpCode::JumpIfFalse);
+    if (!builder.lowerBranch(thenStmts_)) {
+      return false;
+    }
+    size_t toEnd = builder.emit(looptier::OpCode::Jump);
+    builder.patchJump(toElse);
+    if (!builder.lowerBranch(elseStmts_)) {
+      return false;
+    }
+    builder.patchJump(toEnd);
+    return true;
+  }
+
+  void foldConstants(ConstantFolder &folder) override {
+    folder.fold(condition_);
+    folder.fold(thenStmts_);
+    folder.fold(elseStmts_);
+  }
+
+  Statement *fuse(AstArena &arena) override;
+
+protected:
+  /** @brief Run the THEN statements if @p taken, else the ELSE statements */
+  void executeBranch(Interpreter *interp, bool taken) {
+    for (auto &stmt : taken ? thenStmts_ : elseStmts_) {
+      stmt->execute(interp);
+      if (interp->errorPending()) {
+        return;
+      }
+    }
+  }
+
+  Expression *condition_;
+  std::vector<Statement *> thenStmts_;
+  std::vector<Statement *> elseStmts_;
+};
+
+/**
+ * @brief Superinstruction: IF cond THEN n (no ELSE)
+ */
+class IfGotoStmt : public Statement {
+public:
+  IfGotoStmt(Expression *condition, LineNumber target)
+      : condition_(condition), target_(target) {}
+
+  void execute(Interpreter *interp) override {
+    superinstructionStats().fired(Superinstruction::IfGoto);
+    if (condition_->evaluateNumber(interp) != 0) {
+      interp->gotoLine(target_);
+    }
+  }
+
+  void linkTargets(const Program &program) override {
+    program.resolve(target_);
+  }
+
+private:
+  Expression *condition_;
+  LineRef target_;
 };
 
-class ReturnStmt : public Statement {
-public:
-  void execute(Interpreter *interp) override { interp->returnFromGosub(); }
+/**
+ * @brief Superinstruction: IF A(I) op B(J) THEN ...
+ *
+ * Both sides are one-dimensional numeric arrays subscripted by simple
+ * variables. The elements are read straight from the array storage and
+ * compared as numbers; the branches are the IF's own statements.
+ */
+class IfArrayCompareStmt : public IfStmt {
+public:
+  IfArrayCompareStmt(IfStmt &&source, const ArrayAccessExpr &lhs,
+                     TokenType op, const ArrayAccessExpr &rhs)
+      : IfStmt(std::move(source)), op_(op), leftArray_(lhs.slot()),
+        rightArray_(rhs.slot()),
+        leftIndex_(indexSlot(lhs)), rightIndex_(indexSlot(rhs)) {}
+
+  void execute(Interpreter *interp) override {
+    superinstructionStats().fired(Superinstruction::IfArrayCompare);
+    auto &vars = interp->getVariables();
+    int i = static_cast<int>(vars.getVariable(leftIndex_).getNumber());
+    int j = static_cast<int>(vars.getVariable(rightIndex_).getNumber());
+    double lhs = vars.getArrayNumber(leftArray_, &i, 1);
+    double rhs = vars.getArrayNumber(rightArray_, &j, 1);
+    executeBranch(interp, applyNumericOperator(op_, lhs, rhs) != 0);
+  }
+
+  void compile(bytecode::Compiler &compiler) override {
+    compiler.emitStatementFallback(this);
+  }
+
+  /** @brief Check that @p expr is a numeric A(I) this node can read */
+  static bool matches(ArrayAccessExpr *expr) {
+    return expr && expr->isNumeric() && expr->indices().size() == 1 &&
+           numericVariable(expr->indices()[0]);
+  }
+
+private:
+  static SymbolId indexSlot(const ArrayAccessExpr &expr) {
+    return numericVariable(expr.indices()[0])->slot();
+  }
+
+  TokenType op_;
+  SymbolId leftArray_;
+  SymbolId rightArray_;
+  SymbolId leftIndex_;
+  SymbolId rightIndex_;
 };
 
-class IfStmt : public Statement {
-public:
-  IfStmt(std::shared_ptr<Expression> condition,
-         std::vector<std::shared_ptr<Statement>> thenStmts,
-         std::vector<std::shared_ptr<Statement>> elseStmts = {})
-      : condition_(condition), thenStmts_(thenStmts), elseStmts_(elseStmts) {}
+Statement *IfStmt::fuse(AstArena &arena) {
+  fuseStatements(thenStmts_, arena);
+  fuseStatements(elseStmts_, arena);
 
-  void execute(Interpreter *interp) override {
-    Value val = condition_->evaluate(interp);
-    if (val.getNumber() != 0) {
-      for (auto &stmt : thenStmts_) {
-        stmt->execute(interp);
-      }
-    } else if (!elseStmts_.empty()) {
-      for (auto &stmt : elseStmts_) {
-        stmt->execute(interp);
-      }
+  if (elseStmts_.empty() && thenStmts_.size() == 1) {
+    if (auto jump = dynamic_cast<GotoStmt *>(thenStmts_[0])) {
+      return arena.make<IfGotoStmt>(condition_, jump->target());
     }
   }
 
-private:
-  std::shared_ptr<Expression> condition_;
-  std::vector<std::shared_ptr<Statement>> thenStmts_;
-  std::vector<std::shared_ptr<Statement>> elseStmts_;
-};
+  auto compare = dynamic_cast<BinaryExpr *>(condition_);
+  if (!compare) {
+    return nullptr;
+  }
+  switch (compare->op()) {
+  case TokenType::EQUAL:
+  case TokenType::NOT_EQUAL:
+  case TokenType::LESS:
+  case TokenType::GREATER:
+  case TokenType::LESS_EQUAL:
+  case TokenType::GREATER_EQUAL:
+    break;
+  default:
+    return nullptr;
+  }
+  auto lhs = dynamic_cast<ArrayAccessExpr *>(compare->left());
+  auto rhs = dynamic_cast<ArrayAccessExpr *>(compare->right());
+  if (!IfArrayCompareStmt::matches(lhs) || !IfArrayCompareStmt::matches(rhs)) {
+    return nullptr;
+  }
+  return arena.make<IfArrayCompareStmt>(std::move(*this), *lhs, compare->op(),
+                                        *rhs);
+}
 
 class ForStmt : public Statement {
 public:
-  ForStmt(const std::string &var, std::shared_ptr<Expression> start,
-          std::shared_ptr<Expression> end, std::shared_ptr<Expression> step)
-      : var_(var), start_(start), end_(end), step_(step) {}
+  ForStmt(const std::string &var, Expression *start, Expression *end,
+          Expression *step)
+      : slot_(symbols().intern(var)), start_(start), end_(end), step_(step) {}
 
   void execute(Interpreter *interp) override {
-    double startVal = start_->evaluate(interp).getNumber();
-    double endVal = end_->evaluate(interp).getNumber();
-    double stepVal = step_ ? step_->evaluate(interp).getNumber() : 1.0;
+    double startVal = start_->evaluateNumber(interp);
+    double endVal = end_->evaluateNumber(interp);
+    double stepVal = step_ ? step_->evaluateNumber(interp) : 1.0;
+
+    interp->getVariables().setVariable(slot_, Value(startVal));
+    interp->pushForLoop(slot_, endVal, stepVal);
+  }
+
+  void compile(bytecode::Compiler &compiler) override {
+    compiler.compileExpression(*start_);
+    compiler.compileExpression(*end_);
+    if (step_) {
+      compiler.compileExpression(*step_);
+    }
+    compiler.emit(bytecode::OpCode::ForLoop, static_cast<int32_t>(slot_), 0,
+                  step_ ? 1 : 0);
+  }
+
+  bool lowerNumeric(looptier::Builder &builder) override {
+    if (symbols().kind(slot_) == SymbolTable::Kind::String ||
+        !start_->lowerNumeric(builder) || !end_->lowerNumeric(builder) ||
+        (step_ && !step_->lowerNumeric(builder))) {
+      return false;
+    }
+    return builder.openLoop(slot_, step_ != nullptr);
+  }
 
-    interp->getVariables().setVariable(var_, Value(startVal));
-    interp->pushForLoop(var_, endVal, stepVal, interp->getCurrentLine());
+  void foldConstants(ConstantFolder &folder) override {
+    folder.fold(start_);
+    folder.fold(end_);
+    folder.fold(step_);
   }
 
 private:
-  std::string var_;
-  std::shared_ptr<Expression> start_;
-  std::shared_ptr<Expression> end_;
-  std::shared_ptr<Expression> step_;
+  SymbolId slot_;
+  Expression *start_;
+  Expression *end_;
+  Expression *step_;
 };
 
+/**
+ * @brief NEXT [var[,var...]]
+ *
+ * Holds the symbol slots of its variables (a bare NEXT holds kNoSymbol).
+ * NEXT J,I runs NEXT J and, once that loop has finished, NEXT I.
+ */
 class NextStmt : public Statement {
 public:
-  explicit NextStmt(const std::string &var) : var_(var) {}
-  void execute(Interpreter *interp) override { interp->nextForLoop(var_); }
+  explicit NextStmt(std::vector<SymbolId> vars) : vars_(std::move(vars)) {}
+
+  void execute(Interpreter *interp) override {
+    for (SymbolId var : vars_) {
+      if (!interp->nextForLoop(var)) {
+        return;
+      }
+    }
+  }
+
+  void compile(bytecode::Compiler &compiler) override {
+    for (SymbolId var : vars_) {
+      compiler.emit(bytecode::OpCode::NextLoop, static_cast<int32_t>(var));
+    }
+  }
+
+  bool lowerNumeric(looptier::Builder &builder) override {
+    for (SymbolId var : vars_) {
+      if (!builder.closeLoop(var)) {
+        return false;
+      }
+      // Variables after the hot loop's own are left to the interpreter,
+      // which runs them when the compiled loop completes
+      if (builder.closed()) {
+        break;
+      }
+    }
+    return true;
+  }
 
 private:
-  std::string var_;
+  std::vector<SymbolId> vars_;
 };
 
 class InputStmt : public Statement {
@@ -825,7 +1603,7 @@ class DimStmt : public Statement {
 public:
   struct Entry {
     std::string name;
-    std::vector<std::shared_ptr<Expression>> dimensions;
+    std::vector<Expression *> dimensions;
   };
 
   explicit DimStmt(std::vector<Entry> entries) : entries_(std::move(entries)) {}
@@ -835,7 +1613,7 @@ public:
       std::vector<int> dims;
       dims.reserve(entry.dimensions.size());
       for (auto &expr : entry.dimensions) {
-        dims.push_back(static_cast<int>(expr->evaluate(interp).getNumber()));
+        dims.push_back(static_cast<int>(expr->evaluateNumber(interp)));
       }
       interp->getVariables().dimArray(entry.name, dims);
     }
@@ -868,8 +1646,8 @@ private:
 class ReadStmt : public Statement {
 public:
   struct Target {
-    std::string name;
-    std::vector<std::shared_ptr<Expression>> indices;
+    SymbolId slot;
+    std::vector<Expression *> indices;
   };
 
   explicit ReadStmt(std::vector<Target> targets)
@@ -877,16 +1655,19 @@ public:
 
   void execute(Interpreter *interp) override {
     for (auto &target : targets_) {
-      Value v = interp->readData();
+      const Value *v = interp->readData();
+      if (!v) {
+        return;
+      }
       if (target.indices.empty()) {
-        interp->getVariables().setVariable(target.name, v);
+        interp->getVariables().setVariable(target.slot, *v);
       } else {
-        std::vector<int> idx;
-        idx.reserve(target.indices.size());
-        for (auto &expr : target.indices) {
-          idx.push_back(static_cast<int>(expr->evaluate(interp).getNumber()));
+        Subscripts idx(target.indices, interp);
+        if (!interp->getVariables().writeArrayElement(target.slot, idx.data(),
+                                                      idx.size(), *v)) {
+          interp->raise(ErrorKind::BadSubscript);
+          return;
         }
-        interp->getVariables().setArrayElement(target.name, idx, v);
       }
     }
   }
@@ -897,49 +1678,78 @@ private:
 
 class RestoreStmt : public Statement {
 public:
-  explicit RestoreStmt(std::shared_ptr<Expression> target)
-      : target_(std::move(target)) {}
+  explicit RestoreStmt(Expression *target) : target_(target) {}
 
   void execute(Interpreter *interp) override {
     int line = -1;
     if (target_) {
-      line = static_cast<int>(target_->evaluate(interp).getNumber());
+      line = static_cast<int>(target_->evaluateNumber(interp));
     }
     interp->restoreData(line);
   }
 
 private:
-  std::shared_ptr<Expression> target_;
+  Expression *target_;
 };
 
 class PokeStmt : public Statement {
 public:
-  PokeStmt(std::shared_ptr<Expression> addr, std::shared_ptr<Expression> val)
-      : addr_(std::move(addr)), val_(std::move(val)) {}
+  PokeStmt(Expression *addr, Expression *val) : addr_(addr), val_(val) {}
 
   void execute(Interpreter *interp) override {
-    int a = static_cast<int>(addr_->evaluate(interp).getNumber());
-    int v = static_cast<int>(val_->evaluate(interp).getNumber());
+    int a = static_cast<int>(addr_->evaluateNumber(interp));
+    int v = static_cast<int>(val_->evaluateNumber(interp));
     pokeMemory(a, v);
   }
 
+  void foldConstants(ConstantFolder &folder) override {
+    folder.fold(addr_);
+    folder.fold(val_);
+  }
+
+  Statement *fuse(AstArena &arena) override;
+
+private:
+  Expression *addr_;
+  Expression *val_;
+};
+
+/**
+ * @brief Superinstruction: POKE with a constant address
+ */
+class PokeConstantStmt : public Statement {
+public:
+  PokeConstantStmt(int addr, Expression *val) : addr_(addr), val_(val) {}
+
+  void execute(Interpreter *interp) override {
+    superinstructionStats().fired(Superinstruction::PokeConstant);
+    pokeMemory(addr_, static_cast<int>(val_->evaluateNumber(interp)));
+  }
+
 private:
-  std::shared_ptr<Expression> addr_;
-  std::shared_ptr<Expression> val_;
+  int addr_;
+  Expression *val_;
 };
 
+Statement *PokeStmt::fuse(AstArena &arena) {
+  if (!addr_->isConstant() || !addr_->isNumeric()) {
+    return nullptr;
+  }
+  return arena.make<PokeConstantStmt>(
+      static_cast<int>(addr_->evaluateNumber(nullptr)), val_);
+}
+
 class CallStmt : public Statement {
 public:
-  explicit CallStmt(std::shared_ptr<Expression> addr)
-      : addr_(std::move(addr)) {}
+  explicit CallStmt(Expression *addr) : addr_(addr) {}
 
   void execute(Interpreter *interp) override {
-    int address = static_cast<int>(addr_->evaluate(interp).getNumber());
+    int address = static_cast<int>(addr_->evaluateNumber(interp));
     interp->callAddress(address);
   }
 
 private:
-  std::shared_ptr<Expression> addr_;
+  Expression *addr_;
 };
 
 class HomeStmt : public Statement {
@@ -1017,18 +1827,25 @@ public:
 
 class DefStmt : public Statement {
 public:
-  DefStmt(std::string name, std::string param, std::shared_ptr<Expression> expr)
-      : name_(std::move(name)), param_(std::move(param)),
-        expr_(std::move(expr)) {}
+  DefStmt(std::string name, SymbolId param, Expression *expr,
+          bool bindsVariable, AstArena &arena)
+      : name_(std::move(name)), param_(param), expr_(expr),
+        bindsVariable_(bindsVariable), arena_(&arena) {}
 
   void execute(Interpreter *interp) override {
-    interp->getVariables().defineFunction(name_, param_, expr_);
+    // The definition may outlive this line (CHAIN, immediate mode), so it
+    // keeps the arena holding the body alive
+    interp->getVariables().defineFunction(name_, param_, expr_,
+                                          bindsVariable_,
+                                          arena_->shared_from_this());
   }
 
 private:
   std::string name_;
-  std::string param_;
-  std::shared_ptr<Expression> expr_;
+  SymbolId param_;
+  Expression *expr_;
+  bool bindsVariable_;
+  AstArena *arena_;
 };
 
 class RemStmt : public Statement {
@@ -1036,6 +1853,8 @@ public:
   void execute(Interpreter *) override {
     // REM does nothing - it's a comment
   }
+  void compile(bytecode::Compiler &) override {}
+  bool lowerNumeric(looptier::Builder &) override { return true; }
 };
 
 class TraceStmt : public Statement {
@@ -1050,23 +1869,21 @@ public:
 
 class RandomizeStmt : public Statement {
 public:
-  explicit RandomizeStmt(std::shared_ptr<Expression> seed)
-      : seed_(std::move(seed)) {}
+  explicit RandomizeStmt(Expression *seed) : seed_(seed) {}
   void execute(Interpreter *interp) override {
-    double s = seed_ ? seed_->evaluate(interp).getNumber() : 1.0;
+    double s = seed_ ? seed_->evaluateNumber(interp) : 1.0;
     interp->randomize(s);
   }
 
 private:
-  std::shared_ptr<Expression> seed_;
+  Expression *seed_;
 };
 
 class SpeedStmt : public Statement {
 public:
-  explicit SpeedStmt(std::shared_ptr<Expression> delay)
-      : delay_(std::move(delay)) {}
+  explicit SpeedStmt(Expression *delay) : delay_(delay) {}
   void execute(Interpreter *interp) override {
-    int raw = static_cast<int>(delay_->evaluate(interp).getNumber());
+    int raw = static_cast<int>(delay_->evaluateNumber(interp));
     if (raw < 0)
       raw = 0;
     if (raw > 255)
@@ -1075,45 +1892,50 @@ public:
   }
 
 private:
-  std::shared_ptr<Expression> delay_;
+  Expression *delay_;
 };
 
 class PrStmt : public Statement {
 public:
-  explicit PrStmt(std::shared_ptr<Expression> slot) : slot_(std::move(slot)) {}
+  explicit PrStmt(Expression *slot) : slot_(slot) {}
   void execute(Interpreter *interp) override {
-    int device = static_cast<int>(slot_->evaluate(interp).getNumber());
+    int device = static_cast<int>(slot_->evaluateNumber(interp));
     if (device < 0)
       device = 0;
     interp->setOutputDevice(device);
   }
 
 private:
-  std::shared_ptr<Expression> slot_;
+  Expression *slot_;
 };
 
 class InStmt : public Statement {
 public:
-  explicit InStmt(std::shared_ptr<Expression> slot) : slot_(std::move(slot)) {}
+  explicit InStmt(Expression *slot) : slot_(slot) {}
   void execute(Interpreter *interp) override {
-    int device = static_cast<int>(slot_->evaluate(interp).getNumber());
+    int device = static_cast<int>(slot_->evaluateNumber(interp));
     if (device < 0)
       device = 0;
     interp->setInputDevice(device);
   }
 
 private:
-  std::shared_ptr<Expression> slot_;
+  Expression *slot_;
 };
 
 class WhileStmt : public Statement {
 public:
-  explicit WhileStmt(std::shared_ptr<Expression> condition)
-      : condition_(std::move(condition)) {}
+  WhileStmt(Expression *condition, AstArena &arena)
+      : condition_(condition), arena_(&arena) {}
   void execute(Interpreter *interp) override;
 
+  void foldConstants(ConstantFolder &folder) override {
+    folder.fold(condition_);
+  }
+
 private:
-  std::shared_ptr<Expression> condition_;
+  Expression *condition_;
+  AstArena *arena_;
 };
 
 class WendStmt : public Statement {
@@ -1128,17 +1950,16 @@ public:
 
 class WaitStmt : public Statement {
 public:
-  WaitStmt(std::shared_ptr<Expression> addr, std::shared_ptr<Expression> mask,
-           std::shared_ptr<Expression> timeout = nullptr)
-      : addr_(std::move(addr)), mask_(std::move(mask)),
-        timeout_(std::move(timeout)) {}
+  WaitStmt(Expression *addr, Expression *mask, Expression *timeout = nullptr)
+      : addr_(addr), mask_(mask),
+        timeout_(timeout) {}
   void execute(Interpreter *interp) override {
-    int a = static_cast<int>(addr_->evaluate(interp).getNumber());
-    int m = static_cast<int>(mask_->evaluate(interp).getNumber());
+    int a = static_cast<int>(addr_->evaluateNumber(interp));
+    int m = static_cast<int>(mask_->evaluateNumber(interp));
     // Optional timeout in milliseconds; <=0 means no timeout
     int timeoutMs = 0;
     if (timeout_) {
-      timeoutMs = static_cast<int>(timeout_->evaluate(interp).getNumber());
+      timeoutMs = static_cast<int>(timeout_->evaluateNumber(interp));
       if (timeoutMs < 0)
         timeoutMs = 0;
     }
@@ -1163,35 +1984,33 @@ public:
   }
 
 private:
-  std::shared_ptr<Expression> addr_;
-  std::shared_ptr<Expression> mask_;
-  std::shared_ptr<Expression> timeout_;
+  Expression *addr_;
+  Expression *mask_;
+  Expression *timeout_;
 };
 
 class HimemStmt : public Statement {
 public:
-  explicit HimemStmt(std::shared_ptr<Expression> addr)
-      : addr_(std::move(addr)) {}
+  explicit HimemStmt(Expression *addr) : addr_(addr) {}
   void execute(Interpreter *interp) override {
-    int val = static_cast<int>(addr_->evaluate(interp).getNumber());
+    int val = static_cast<int>(addr_->evaluateNumber(interp));
     interp->setHimem(val);
   }
 
 private:
-  std::shared_ptr<Expression> addr_;
+  Expression *addr_;
 };
 
 class LomemStmt : public Statement {
 public:
-  explicit LomemStmt(std::shared_ptr<Expression> addr)
-      : addr_(std::move(addr)) {}
+  explicit LomemStmt(Expression *addr) : addr_(addr) {}
   void execute(Interpreter *interp) override {
-    int val = static_cast<int>(addr_->evaluate(interp).getNumber());
+    int val = static_cast<int>(addr_->evaluateNumber(interp));
     interp->setLomem(val);
   }
 
 private:
-  std::shared_ptr<Expression> addr_;
+  Expression *addr_;
 };
 
 class RecallStmt : public Statement {
@@ -1539,7 +2358,7 @@ private:
  * @param interp Interpreter instance
  */
 void WhileStmt::execute(Interpreter *interp) {
-  interp->pushWhileLoop(condition_, interp->getCurrentLine());
+  interp->pushWhileLoop(condition_, *arena_);
 }
 
 /**
@@ -1576,10 +2395,11 @@ void PopStmt::execute(Interpreter *interp) { interp->popGosub(); }
 /**
  * @brief Construct a new Parser object
  * 
- * Initializes an empty parser. The parser is stateless and can be reused
- * for parsing multiple token sequences.
+ * Initializes an empty parser. The parser keeps no state between lines and
+ * can be reused for parsing multiple token sequences; all nodes it creates
+ * are allocated in @p arena.
  */
-Parser::Parser() {}
+Parser::Parser(AstArena &arena) : arena_(arena), folder_(arena) {}
 
 /**
  * @brief Parse a token sequence into statement AST nodes
@@ -1606,13 +2426,19 @@ Parser::Parser() {}
  * - Position tracking ensures error messages can identify problem location
  * 
  * @param tokens Token sequence from tokenizer
+ * @param source Text the tokens were made from
+ * @param constants Constant pool of the tokens
  * @return Vector of parsed Statement objects ready for execution
  * @throws std::runtime_error on syntax errors
  */
-std::vector<std::shared_ptr<Statement>>
-Parser::parse(const std::vector<Token> &tokens) {
-  std::vector<std::shared_ptr<Statement>> statements;
+std::vector<Statement *> Parser::parse(const std::vector<Token> &tokens,
+                                      std::string_view source,
+                                      const std::vector<Value> &constants) {
+  std::vector<Statement *> statements;
   size_t pos = 0;
+  source_ = source;
+  constants_ = &constants;
+  parameter_.reset(); // a DEF body may have thrown mid-parse
 
   while (pos < tokens.size()) {
     // Skip newlines
@@ -1635,6 +2461,12 @@ Parser::parse(const std::vector<Token> &tokens) {
     }
   }
 
+  if (foldConstants_) {
+    folder_.fold(statements);
+  }
+  if (superinstructions_) {
+    fuseStatements(statements, arena_);
+  }
   return statements;
 }
 
@@ -1666,8 +2498,8 @@ Parser::parse(const std::vector<Token> &tokens) {
  * @return Parsed Statement object, or nullptr if no statement found
  * @throws std::runtime_error on syntax errors
  */
-std::shared_ptr<Statement>
-Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
+Statement *Parser::parseStatement(const std::vector<Token> &tokens,
+                                  size_t &pos) {
   if (pos >= tokens.size())
     return nullptr;
 
@@ -1681,7 +2513,7 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
     return parseLetOrAssignment(tokens, pos);
   case TokenType::END:
     pos++;
-    return std::make_shared<EndStmt>();
+    return arena_.make<EndStmt>();
   case TokenType::IF:
     return parseIf(tokens, pos);
   case TokenType::GOTO:
@@ -1690,29 +2522,29 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
     return parseGosub(tokens, pos);
   case TokenType::RETURN:
     pos++;
-    return std::make_shared<ReturnStmt>();
+    return arena_.make<ReturnStmt>();
   case TokenType::STOP:
     pos++;
-    return std::make_shared<StopStmt>();
+    return arena_.make<StopStmt>();
   case TokenType::HTAB: {
     pos++; // Skip HTAB
     auto col = parseExpression(tokens, pos);
-    return std::make_shared<HtabStmt>(col);
+    return arena_.make<HtabStmt>(col);
   }
   case TokenType::VTAB: {
     pos++; // Skip VTAB
     auto row = parseExpression(tokens, pos);
-    return std::make_shared<VtabStmt>(row);
+    return arena_.make<VtabStmt>(row);
   }
   case TokenType::INVERSE:
     pos++;
-    return std::make_shared<InverseStmt>();
+    return arena_.make<InverseStmt>();
   case TokenType::NORMAL:
     pos++;
-    return std::make_shared<NormalStmt>();
+    return arena_.make<NormalStmt>();
   case TokenType::FLASH:
     pos++;
-    return std::make_shared<FlashStmt>();
+    return arena_.make<FlashStmt>();
   case TokenType::FOR:
     return parseFor(tokens, pos);
   case TokenType::NEXT:
@@ -1730,18 +2562,18 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
     // Check if it's ProDOS RESTORE (followed by string filename) or DATA RESTORE
     if (pos < tokens.size() && tokens[pos].type == TokenType::STRING) {
       // ProDOS RESTORE pn
-      std::string filename = tokens[pos].value.getString();
+      std::string filename = value(tokens[pos]).getString();
       pos++;
       // TODO: Parse optional S# and D# parameters (slot and drive)
-      return std::make_shared<ProdosRestoreStmt>(filename);
+      return arena_.make<ProdosRestoreStmt>(filename);
     } else {
       // DATA RESTORE [line_number]
-      std::shared_ptr<Expression> target;
+      Expression *target = nullptr;
       if (pos < tokens.size() && tokens[pos].type != TokenType::COLON &&
           tokens[pos].type != TokenType::NEWLINE) {
         target = parseExpression(tokens, pos);
       }
-      return std::make_shared<RestoreStmt>(target);
+      return arena_.make<RestoreStmt>(target);
     }
   }
   case TokenType::DEF:
@@ -1756,43 +2588,43 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
     }
     pos++;
     auto val = parseExpression(tokens, pos);
-    return std::make_shared<PokeStmt>(addr, val);
+    return arena_.make<PokeStmt>(addr, val);
   }
   case TokenType::CALL: {
     pos++; // Skip CALL
     auto addr = parseExpression(tokens, pos);
-    return std::make_shared<CallStmt>(addr);
+    return arena_.make<CallStmt>(addr);
   }
   case TokenType::HOME:
     pos++;
-    return std::make_shared<HomeStmt>();
+    return arena_.make<HomeStmt>();
   case TokenType::TEXT:
     pos++;
-    return std::make_shared<TextStmt>();
+    return arena_.make<TextStmt>();
   case TokenType::CLR:
     pos++;
-    return std::make_shared<ClrStmt>();
+    return arena_.make<ClrStmt>();
   case TokenType::GR:
     pos++;
-    return std::make_shared<GrStmt>();
+    return arena_.make<GrStmt>();
   case TokenType::HIRES:
     pos++;
-    return std::make_shared<HiresStmt>();
+    return arena_.make<HiresStmt>();
   case TokenType::HGR:
     pos++;
-    return std::make_shared<HgrStmt>();
+    return arena_.make<HgrStmt>();
   case TokenType::HGR2:
     pos++;
-    return std::make_shared<HgrStmt>();
+    return arena_.make<HgrStmt>();
   case TokenType::HCOLOR: {
     pos++; // Skip HCOLOR=
     auto color = parseExpression(tokens, pos);
-    return std::make_shared<HcolorStmt>(color);
+    return arena_.make<HcolorStmt>(color);
   }
   case TokenType::COLOR: {
     pos++; // Skip COLOR=
     auto color = parseExpression(tokens, pos);
-    return std::make_shared<ColorStmt>(color);
+    return arena_.make<ColorStmt>(color);
   }
   case TokenType::PLOT: {
     pos++; // Skip PLOT
@@ -1802,7 +2634,7 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
     }
     pos++;
     auto y = parseExpression(tokens, pos);
-    return std::make_shared<PlotStmt>(x, y);
+    return arena_.make<PlotStmt>(x, y);
   }
   case TokenType::HLIN: {
     pos++; // Skip HLIN
@@ -1817,7 +2649,7 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
     }
     pos++;
     auto y = parseExpression(tokens, pos);
-    return std::make_shared<HlinStmt>(x1, x2, y);
+    return arena_.make<HlinStmt>(x1, x2, y);
   }
   case TokenType::VLIN: {
     pos++; // Skip VLIN
@@ -1832,12 +2664,12 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
     }
     pos++;
     auto x = parseExpression(tokens, pos);
-    return std::make_shared<VlinStmt>(y1, y2, x);
+    return arena_.make<VlinStmt>(y1, y2, x);
   }
   case TokenType::HPLOT: {
     pos++; // Skip HPLOT
     std::vector<
-        std::pair<std::shared_ptr<Expression>, std::shared_ptr<Expression>>>
+        std::pair<Expression *, Expression *>>
         coords;
     auto x = parseExpression(tokens, pos);
     if (pos >= tokens.size() || tokens[pos].type != TokenType::COMMA) {
@@ -1862,7 +2694,7 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
       y = parseExpression(tokens, pos);
       coords.push_back({x, y});
     }
-    return std::make_shared<HplotStmt>(coords);
+    return arena_.make<HplotStmt>(coords);
   }
   case TokenType::MOVE: {
     pos++; // Skip MOVE
@@ -1872,25 +2704,25 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
     }
     pos++;
     auto y = parseExpression(tokens, pos);
-    return std::make_shared<MoveStmt>(x, y);
+    return arena_.make<MoveStmt>(x, y);
   }
   case TokenType::ROTATE: {
     pos++; // Skip ROTATE
     auto angle = parseExpression(tokens, pos);
-    return std::make_shared<RotateStmt>(angle);
+    return arena_.make<RotateStmt>(angle);
   }
   case TokenType::SCALE: {
     pos++; // Skip SCALE
     auto scale = parseExpression(tokens, pos);
-    return std::make_shared<ScaleStmt>(scale);
+    return arena_.make<ScaleStmt>(scale);
   }
   case TokenType::SHLOAD:
     return parseShload(tokens, pos);
   case TokenType::DRAW: {
     pos++; // Skip DRAW
     auto shapeNum = parseExpression(tokens, pos);
-    std::shared_ptr<Expression> x = nullptr;
-    std::shared_ptr<Expression> y = nullptr;
+    Expression *x = nullptr;
+    Expression *y = nullptr;
 
     // Check for AT clause
     if (pos < tokens.size() && tokens[pos].type == TokenType::AT) {
@@ -1903,13 +2735,13 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
       y = parseExpression(tokens, pos);
     }
 
-    return std::make_shared<DrawStmt>(shapeNum, x, y);
+    return arena_.make<DrawStmt>(shapeNum, x, y);
   }
   case TokenType::XDRAW: {
     pos++; // Skip XDRAW
     auto shapeNum = parseExpression(tokens, pos);
-    std::shared_ptr<Expression> x = nullptr;
-    std::shared_ptr<Expression> y = nullptr;
+    Expression *x = nullptr;
+    Expression *y = nullptr;
 
     // Check for AT clause
     if (pos < tokens.size() && tokens[pos].type == TokenType::AT) {
@@ -1922,16 +2754,16 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
       y = parseExpression(tokens, pos);
     }
 
-    return std::make_shared<XdrawStmt>(shapeNum, x, y);
+    return arena_.make<XdrawStmt>(shapeNum, x, y);
   }
   case TokenType::GET: {
     pos++; // Skip GET
     if (pos >= tokens.size() || tokens[pos].type != TokenType::IDENTIFIER) {
       throw std::runtime_error("SYNTAX ERROR: EXPECTED VARIABLE");
     }
-    std::string varName = tokens[pos].text;
+    std::string varName(text(tokens[pos]));
     pos++;
-    return std::make_shared<GetStmt>(varName);
+    return arena_.make<GetStmt>(varName);
   }
   case TokenType::REM:
     // REM consumes rest of line
@@ -1940,18 +2772,18 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
            tokens[pos].type != TokenType::COLON) {
       pos++;
     }
-    return std::make_shared<RemStmt>();
+    return arena_.make<RemStmt>();
   case TokenType::ONERR:
     return parseOnErr(tokens, pos);
   case TokenType::RESUME:
     pos++;
-    return std::make_shared<ResumeStmt>();
+    return arena_.make<ResumeStmt>();
   case TokenType::TRACE:
     pos++;
-    return std::make_shared<TraceStmt>();
+    return arena_.make<TraceStmt>();
   case TokenType::NOTRACE:
     pos++;
-    return std::make_shared<NoTraceStmt>();
+    return arena_.make<NoTraceStmt>();
   case TokenType::RANDOMIZE:
     return parseRandomize(tokens, pos);
   case TokenType::SPEED:
@@ -1964,10 +2796,10 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
     return parseWhile(tokens, pos);
   case TokenType::WEND:
     pos++;
-    return std::make_shared<WendStmt>();
+    return arena_.make<WendStmt>();
   case TokenType::POP:
     pos++;
-    return std::make_shared<PopStmt>();
+    return arena_.make<PopStmt>();
   case TokenType::WAIT:
     return parseWait(tokens, pos);
   case TokenType::HIMEM:
@@ -1979,114 +2811,114 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
     if (pos >= tokens.size() || tokens[pos].type != TokenType::IDENTIFIER) {
       throw std::runtime_error("SYNTAX ERROR: EXPECTED ARRAY NAME");
     }
-    std::string arrayName = tokens[pos].text;
+    std::string arrayName(text(tokens[pos]));
     pos++;
-    return std::make_shared<RecallStmt>(arrayName);
+    return arena_.make<RecallStmt>(arrayName);
   }
   case TokenType::STORE: {
     pos++; // Skip STORE
     // Check if it's ProDOS STORE (followed by string filename) or array STORE
     if (pos < tokens.size() && tokens[pos].type == TokenType::STRING) {
       // ProDOS STORE pn
-      std::string filename = tokens[pos].value.getString();
+      std::string filename = value(tokens[pos]).getString();
       pos++;
       // TODO: Parse optional S# and D# parameters (slot and drive)
-      return std::make_shared<ProdosStoreStmt>(filename);
+      return arena_.make<ProdosStoreStmt>(filename);
     } else {
       // Array STORE arrayname
       if (pos >= tokens.size() || tokens[pos].type != TokenType::IDENTIFIER) {
         throw std::runtime_error("SYNTAX ERROR: EXPECTED ARRAY NAME OR FILENAME");
       }
-      std::string arrayName = tokens[pos].text;
+      std::string arrayName(text(tokens[pos]));
       pos++;
-      return std::make_shared<StoreStmt>(arrayName);
+      return arena_.make<StoreStmt>(arrayName);
     }
   }
   case TokenType::TAPE: {
     pos++; // Skip TAPE
     if (pos >= tokens.size()) {
       // TAPE with no arguments - show current tape
-      return std::make_shared<TapeStmt>("");
+      return arena_.make<TapeStmt>("");
     }
     if (tokens[pos].type == TokenType::STRING) {
       // TAPE "filename" - set tape file
-      std::string filename = tokens[pos].value.getString();
+      std::string filename = value(tokens[pos]).getString();
       pos++;
-      return std::make_shared<TapeStmt>(filename);
+      return arena_.make<TapeStmt>(filename);
     }
     // TAPE with no arguments - show current tape
-    return std::make_shared<TapeStmt>("");
+    return arena_.make<TapeStmt>("");
   }
   case TokenType::OPEN: {
     pos++; // Skip OPEN
     if (pos >= tokens.size() || tokens[pos].type != TokenType::STRING) {
       throw std::runtime_error("SYNTAX ERROR: EXPECTED FILENAME");
     }
-    std::string filename = tokens[pos].value.getString();
+    std::string filename = value(tokens[pos]).getString();
     pos++;
     // Parse optional options (not fully implemented yet)
-    return std::make_shared<OpenFileStmt>(filename, "");
+    return arena_.make<OpenFileStmt>(filename, "");
   }
   case TokenType::CLOSE: {
     pos++; // Skip CLOSE
     std::string filename = "";
     if (pos < tokens.size() && tokens[pos].type == TokenType::STRING) {
-      filename = tokens[pos].value.getString();
+      filename = value(tokens[pos]).getString();
       pos++;
     }
-    return std::make_shared<CloseFileStmt>(filename);
+    return arena_.make<CloseFileStmt>(filename);
   }
   case TokenType::APPEND: {
     pos++; // Skip APPEND
     if (pos >= tokens.size() || tokens[pos].type != TokenType::STRING) {
       throw std::runtime_error("SYNTAX ERROR: EXPECTED FILENAME");
     }
-    std::string filename = tokens[pos].value.getString();
+    std::string filename = value(tokens[pos]).getString();
     pos++;
-    return std::make_shared<AppendFileStmt>(filename);
+    return arena_.make<AppendFileStmt>(filename);
   }
   case TokenType::FLUSH: {
     pos++; // Skip FLUSH
     if (pos >= tokens.size() || tokens[pos].type != TokenType::STRING) {
       throw std::runtime_error("SYNTAX ERROR: EXPECTED FILENAME");
     }
-    std::string filename = tokens[pos].value.getString();
+    std::string filename = value(tokens[pos]).getString();
     pos++;
-    return std::make_shared<FlushFileStmt>(filename);
+    return arena_.make<FlushFileStmt>(filename);
   }
   case TokenType::CREATE: {
     pos++; // Skip CREATE
     if (pos >= tokens.size() || tokens[pos].type != TokenType::STRING) {
       throw std::runtime_error("SYNTAX ERROR: EXPECTED FILENAME");
     }
-    std::string filename = tokens[pos].value.getString();
+    std::string filename = value(tokens[pos]).getString();
     pos++;
-    return std::make_shared<CreateFileStmt>(filename, "");
+    return arena_.make<CreateFileStmt>(filename, "");
   }
   case TokenType::LOCK: {
     pos++; // Skip LOCK
     if (pos >= tokens.size() || tokens[pos].type != TokenType::STRING) {
       throw std::runtime_error("SYNTAX ERROR: EXPECTED FILENAME");
     }
-    std::string filename = tokens[pos].value.getString();
+    std::string filename = value(tokens[pos]).getString();
     pos++;
-    return std::make_shared<LockFileStmt>(filename);
+    return arena_.make<LockFileStmt>(filename);
   }
   case TokenType::UNLOCK: {
     pos++; // Skip UNLOCK
     if (pos >= tokens.size() || tokens[pos].type != TokenType::STRING) {
       throw std::runtime_error("SYNTAX ERROR: EXPECTED FILENAME");
     }
-    std::string filename = tokens[pos].value.getString();
+    std::string filename = value(tokens[pos]).getString();
     pos++;
-    return std::make_shared<UnlockFileStmt>(filename);
+    return arena_.make<UnlockFileStmt>(filename);
   }
   case TokenType::BLOAD: {
     pos++; // Skip BLOAD
     if (pos >= tokens.size() || tokens[pos].type != TokenType::STRING) {
       throw std::runtime_error("SYNTAX ERROR: EXPECTED FILENAME");
     }
-    std::string filename = tokens[pos].value.getString();
+    std::string filename = value(tokens[pos]).getString();
     pos++;
     
     int address = -1;
@@ -2095,24 +2927,24 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
       pos++; // Skip comma
       if (pos < tokens.size()) {
         // Could be A# or just a number
-        if (tokens[pos].type == TokenType::IDENTIFIER && tokens[pos].text[0] == 'A') {
-          std::string addrStr = tokens[pos].text.substr(1);
+        if (tokens[pos].type == TokenType::IDENTIFIER && text(tokens[pos])[0] == 'A') {
+          std::string addrStr(text(tokens[pos]).substr(1));
           address = std::stoi(addrStr);
           pos++;
         } else if (tokens[pos].type == TokenType::NUMBER) {
-          address = static_cast<int>(tokens[pos].value.getNumber());
+          address = static_cast<int>(value(tokens[pos]).getNumber());
           pos++;
         }
       }
     }
-    return std::make_shared<BloadFileStmt>(filename, address);
+    return arena_.make<BloadFileStmt>(filename, address);
   }
   case TokenType::BSAVE: {
     pos++; // Skip BSAVE
     if (pos >= tokens.size() || tokens[pos].type != TokenType::STRING) {
       throw std::runtime_error("SYNTAX ERROR: EXPECTED FILENAME");
     }
-    std::string filename = tokens[pos].value.getString();
+    std::string filename = value(tokens[pos]).getString();
     pos++;
     
     int address = 0, length = 0;
@@ -2121,12 +2953,12 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
       pos++; // Skip first comma
       if (pos < tokens.size()) {
         // Parse A# or just a number
-        if (tokens[pos].type == TokenType::IDENTIFIER && tokens[pos].text[0] == 'A') {
-          std::string addrStr = tokens[pos].text.substr(1);
+        if (tokens[pos].type == TokenType::IDENTIFIER && text(tokens[pos])[0] == 'A') {
+          std::string addrStr(text(tokens[pos]).substr(1));
           address = std::stoi(addrStr);
           pos++;
         } else if (tokens[pos].type == TokenType::NUMBER) {
-          address = static_cast<int>(tokens[pos].value.getNumber());
+          address = static_cast<int>(value(tokens[pos]).getNumber());
           pos++;
         }
         
@@ -2134,26 +2966,26 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
         if (pos < tokens.size() && tokens[pos].type == TokenType::COMMA) {
           pos++; // Skip second comma
           if (pos < tokens.size()) {
-            if (tokens[pos].type == TokenType::IDENTIFIER && tokens[pos].text[0] == 'L') {
-              std::string lenStr = tokens[pos].text.substr(1);
+            if (tokens[pos].type == TokenType::IDENTIFIER && text(tokens[pos])[0] == 'L') {
+              std::string lenStr(text(tokens[pos]).substr(1));
               length = std::stoi(lenStr);
               pos++;
             } else if (tokens[pos].type == TokenType::NUMBER) {
-              length = static_cast<int>(tokens[pos].value.getNumber());
+              length = static_cast<int>(value(tokens[pos]).getNumber());
               pos++;
             }
           }
         }
       }
     }
-    return std::make_shared<BsaveFileStmt>(filename, address, length);
+    return arena_.make<BsaveFileStmt>(filename, address, length);
   }
   case TokenType::BRUN: {
     pos++; // Skip BRUN
     if (pos >= tokens.size() || tokens[pos].type != TokenType::STRING) {
       throw std::runtime_error("SYNTAX ERROR: EXPECTED FILENAME");
     }
-    std::string filename = tokens[pos].value.getString();
+    std::string filename = value(tokens[pos]).getString();
     pos++;
     
     int address = -1;
@@ -2161,34 +2993,34 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
     if (pos < tokens.size() && tokens[pos].type == TokenType::COMMA) {
       pos++; // Skip comma
       if (pos < tokens.size()) {
-        if (tokens[pos].type == TokenType::IDENTIFIER && tokens[pos].text[0] == 'A') {
-          std::string addrStr = tokens[pos].text.substr(1);
+        if (tokens[pos].type == TokenType::IDENTIFIER && text(tokens[pos])[0] == 'A') {
+          std::string addrStr(text(tokens[pos]).substr(1));
           address = std::stoi(addrStr);
           pos++;
         } else if (tokens[pos].type == TokenType::NUMBER) {
-          address = static_cast<int>(tokens[pos].value.getNumber());
+          address = static_cast<int>(value(tokens[pos]).getNumber());
           pos++;
         }
       }
     }
-    return std::make_shared<BrunFileStmt>(filename, address);
+    return arena_.make<BrunFileStmt>(filename, address);
   }
   case TokenType::DELETE: {
     pos++; // Skip DELETE
     if (pos >= tokens.size() || tokens[pos].type != TokenType::STRING) {
       throw std::runtime_error("SYNTAX ERROR: EXPECTED FILENAME");
     }
-    std::string filename = tokens[pos].value.getString();
+    std::string filename = value(tokens[pos]).getString();
     pos++;
     // TODO: Parse optional S# and D# parameters
-    return std::make_shared<DeleteFileStmt>(filename);
+    return arena_.make<DeleteFileStmt>(filename);
   }
   case TokenType::RENAME: {
     pos++; // Skip RENAME
     if (pos >= tokens.size() || tokens[pos].type != TokenType::STRING) {
       throw std::runtime_error("SYNTAX ERROR: EXPECTED FILENAME");
     }
-    std::string oldName = tokens[pos].value.getString();
+    std::string oldName = value(tokens[pos]).getString();
     pos++;
     if (pos >= tokens.size() || tokens[pos].type != TokenType::COMMA) {
       throw std::runtime_error("SYNTAX ERROR: EXPECTED COMMA");
@@ -2197,27 +3029,27 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
     if (pos >= tokens.size() || tokens[pos].type != TokenType::STRING) {
       throw std::runtime_error("SYNTAX ERROR: EXPECTED NEW FILENAME");
     }
-    std::string newName = tokens[pos].value.getString();
+    std::string newName = value(tokens[pos]).getString();
     pos++;
     // TODO: Parse optional S# and D# parameters
-    return std::make_shared<RenameFileStmt>(oldName, newName);
+    return arena_.make<RenameFileStmt>(oldName, newName);
   }
   case TokenType::PREFIX: {
     pos++; // Skip PREFIX
     std::string path = "";
     if (pos < tokens.size() && tokens[pos].type == TokenType::STRING) {
-      path = tokens[pos].value.getString();
+      path = value(tokens[pos]).getString();
       pos++;
     }
     // TODO: Parse optional S# and D# parameters
-    return std::make_shared<PrefixStmt>(path);
+    return arena_.make<PrefixStmt>(path);
   }
   case TokenType::POSITION: {
     pos++; // Skip POSITION
     if (pos >= tokens.size() || tokens[pos].type != TokenType::STRING) {
       throw std::runtime_error("SYNTAX ERROR: EXPECTED FILENAME");
     }
-    std::string filename = tokens[pos].value.getString();
+    std::string filename = value(tokens[pos]).getString();
     pos++;
     
     int record = 0, byte = 0;
@@ -2225,16 +3057,16 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
     if (pos < tokens.size() && tokens[pos].type == TokenType::COMMA) {
       pos++; // Skip comma
       if (pos < tokens.size()) {
-        if (tokens[pos].type == TokenType::IDENTIFIER && tokens[pos].text[0] == 'R') {
+        if (tokens[pos].type == TokenType::IDENTIFIER && text(tokens[pos])[0] == 'R') {
           try {
-            std::string recStr = tokens[pos].text.substr(1);
+            std::string recStr(text(tokens[pos]).substr(1));
             record = std::stoi(recStr);
             pos++;
           } catch (...) {
             throw std::runtime_error("SYNTAX ERROR: INVALID RECORD NUMBER");
           }
         } else if (tokens[pos].type == TokenType::NUMBER) {
-          record = static_cast<int>(tokens[pos].value.getNumber());
+          record = static_cast<int>(value(tokens[pos]).getNumber());
           pos++;
         }
       }
@@ -2242,29 +3074,29 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
       if (pos < tokens.size() && tokens[pos].type == TokenType::COMMA) {
         pos++; // Skip comma
         if (pos < tokens.size()) {
-          if (tokens[pos].type == TokenType::IDENTIFIER && tokens[pos].text[0] == 'B') {
+          if (tokens[pos].type == TokenType::IDENTIFIER && text(tokens[pos])[0] == 'B') {
             try {
-              std::string byteStr = tokens[pos].text.substr(1);
+              std::string byteStr(text(tokens[pos]).substr(1));
               byte = std::stoi(byteStr);
               pos++;
             } catch (...) {
               throw std::runtime_error("SYNTAX ERROR: INVALID BYTE NUMBER");
             }
           } else if (tokens[pos].type == TokenType::NUMBER) {
-            byte = static_cast<int>(tokens[pos].value.getNumber());
+            byte = static_cast<int>(value(tokens[pos]).getNumber());
             pos++;
           }
         }
       }
     }
-    return std::make_shared<PositionFileStmt>(filename, record, byte);
+    return arena_.make<PositionFileStmt>(filename, record, byte);
   }
   case TokenType::CHAIN: {
     pos++; // Skip CHAIN
     if (pos >= tokens.size() || tokens[pos].type != TokenType::STRING) {
       throw std::runtime_error("SYNTAX ERROR: EXPECTED FILENAME");
     }
-    std::string filename = tokens[pos].value.getString();
+    std::string filename = value(tokens[pos]).getString();
     pos++;
     
     int startLine = -1;
@@ -2272,59 +3104,59 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
     if (pos < tokens.size() && tokens[pos].type == TokenType::COMMA) {
       pos++; // Skip comma
       if (pos < tokens.size()) {
-        if (tokens[pos].type == TokenType::IDENTIFIER && tokens[pos].text[0] == '@') {
+        if (tokens[pos].type == TokenType::IDENTIFIER && text(tokens[pos])[0] == '@') {
           try {
-            std::string lineStr = tokens[pos].text.substr(1);
+            std::string lineStr(text(tokens[pos]).substr(1));
             startLine = std::stoi(lineStr);
             pos++;
           } catch (...) {
             throw std::runtime_error("SYNTAX ERROR: INVALID LINE NUMBER");
           }
         } else if (tokens[pos].type == TokenType::NUMBER) {
-          startLine = static_cast<int>(tokens[pos].value.getNumber());
+          startLine = static_cast<int>(value(tokens[pos]).getNumber());
           pos++;
         }
       }
     }
     // TODO: Parse optional S# and D# parameters
-    return std::make_shared<ChainStmt>(filename, startLine);
+    return arena_.make<ChainStmt>(filename, startLine);
   }
   case TokenType::EXEC: {
     pos++; // Skip EXEC
     if (pos >= tokens.size() || tokens[pos].type != TokenType::STRING) {
       throw std::runtime_error("SYNTAX ERROR: EXPECTED FILENAME");
     }
-    std::string filename = tokens[pos].value.getString();
+    std::string filename = value(tokens[pos]).getString();
     pos++;
     // TODO: Parse optional S# and D# parameters
-    return std::make_shared<ExecStmt>(filename);
+    return arena_.make<ExecStmt>(filename);
   }
   case TokenType::DASH: {
     pos++; // Skip -
     if (pos >= tokens.size() || tokens[pos].type != TokenType::STRING) {
       throw std::runtime_error("SYNTAX ERROR: EXPECTED FILENAME");
     }
-    std::string filename = tokens[pos].value.getString();
+    std::string filename = value(tokens[pos]).getString();
     pos++;
     // TODO: Parse optional S# and D# parameters
-    return std::make_shared<DashStmt>(filename);
+    return arena_.make<DashStmt>(filename);
   }
   case TokenType::CAT: {
     pos++; // Skip CAT
     std::string path = ".";
     if (pos < tokens.size() && tokens[pos].type == TokenType::STRING) {
-      path = tokens[pos].value.getString();
+      path = value(tokens[pos]).getString();
       pos++;
     }
     // TODO: Parse optional S# and D# parameters
-    return std::make_shared<CatStmt>(path);
+    return arena_.make<CatStmt>(path);
   }
   case TokenType::PRODOSREAD: {
     pos++; // Skip READ
     if (pos >= tokens.size() || tokens[pos].type != TokenType::STRING) {
       throw std::runtime_error("SYNTAX ERROR: EXPECTED FILENAME");
     }
-    std::string filename = tokens[pos].value.getString();
+    std::string filename = value(tokens[pos]).getString();
     pos++;
     
     int record = 0, byte = 0;
@@ -2332,16 +3164,16 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
     if (pos < tokens.size() && tokens[pos].type == TokenType::COMMA) {
       pos++; // Skip comma
       if (pos < tokens.size()) {
-        if (tokens[pos].type == TokenType::IDENTIFIER && tokens[pos].text[0] == 'R') {
+        if (tokens[pos].type == TokenType::IDENTIFIER && text(tokens[pos])[0] == 'R') {
           try {
-            std::string recStr = tokens[pos].text.substr(1);
+            std::string recStr(text(tokens[pos]).substr(1));
             record = std::stoi(recStr);
             pos++;
           } catch (...) {
             throw std::runtime_error("SYNTAX ERROR: INVALID RECORD NUMBER");
           }
         } else if (tokens[pos].type == TokenType::NUMBER) {
-          record = static_cast<int>(tokens[pos].value.getNumber());
+          record = static_cast<int>(value(tokens[pos]).getNumber());
           pos++;
         }
       }
@@ -2349,29 +3181,29 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
       if (pos < tokens.size() && tokens[pos].type == TokenType::COMMA) {
         pos++; // Skip comma
         if (pos < tokens.size()) {
-          if (tokens[pos].type == TokenType::IDENTIFIER && tokens[pos].text[0] == 'B') {
+          if (tokens[pos].type == TokenType::IDENTIFIER && text(tokens[pos])[0] == 'B') {
             try {
-              std::string byteStr = tokens[pos].text.substr(1);
+              std::string byteStr(text(tokens[pos]).substr(1));
               byte = std::stoi(byteStr);
               pos++;
             } catch (...) {
               throw std::runtime_error("SYNTAX ERROR: INVALID BYTE NUMBER");
             }
           } else if (tokens[pos].type == TokenType::NUMBER) {
-            byte = static_cast<int>(tokens[pos].value.getNumber());
+            byte = static_cast<int>(value(tokens[pos]).getNumber());
             pos++;
           }
         }
       }
     }
-    return std::make_shared<ProdosReadStmt>(filename, record, byte);
+    return arena_.make<ProdosReadStmt>(filename, record, byte);
   }
   case TokenType::PRODOSWRITE: {
     pos++; // Skip WRITE
     if (pos >= tokens.size() || tokens[pos].type != TokenType::STRING) {
       throw std::runtime_error("SYNTAX ERROR: EXPECTED FILENAME");
     }
-    std::string filename = tokens[pos].value.getString();
+    std::string filename = value(tokens[pos]).getString();
     pos++;
     
     int record = 0;
@@ -2379,21 +3211,21 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
     if (pos < tokens.size() && tokens[pos].type == TokenType::COMMA) {
       pos++; // Skip comma
       if (pos < tokens.size()) {
-        if (tokens[pos].type == TokenType::IDENTIFIER && tokens[pos].text[0] == 'R') {
+        if (tokens[pos].type == TokenType::IDENTIFIER && text(tokens[pos])[0] == 'R') {
           try {
-            std::string recStr = tokens[pos].text.substr(1);
+            std::string recStr(text(tokens[pos]).substr(1));
             record = std::stoi(recStr);
             pos++;
           } catch (...) {
             throw std::runtime_error("SYNTAX ERROR: INVALID RECORD NUMBER");
           }
         } else if (tokens[pos].type == TokenType::NUMBER) {
-          record = static_cast<int>(tokens[pos].value.getNumber());
+          record = static_cast<int>(value(tokens[pos]).getNumber());
           pos++;
         }
       }
     }
-    return std::make_shared<ProdosWriteStmt>(filename, record);
+    return arena_.make<ProdosWriteStmt>(filename, record);
   }
   case TokenType::IDENTIFIER:
     return parseLetOrAssignment(tokens, pos);
@@ -2436,11 +3268,10 @@ Parser::parseStatement(const std::vector<Token> &tokens, size_t &pos) {
  * @param pos Current position (updated after parsing)
  * @return PrintStmt with expression list and separator flags
  */
-std::shared_ptr<Statement> Parser::parsePrint(const std::vector<Token> &tokens,
-                                              size_t &pos) {
+Statement *Parser::parsePrint(const std::vector<Token> &tokens, size_t &pos) {
   pos++; // Skip PRINT
 
-  std::vector<std::shared_ptr<Expression>> exprs;
+  std::vector<Expression *> exprs;
   std::vector<PrintStmt::Separator> separators;
 
   while (pos < tokens.size() && tokens[pos].type != TokenType::COLON &&
@@ -2465,7 +3296,7 @@ std::shared_ptr<Statement> Parser::parsePrint(const std::vector<Token> &tokens,
     }
   }
 
-  return std::make_shared<PrintStmt>(exprs, separators);
+  return arena_.make<PrintStmt>(exprs, separators);
 }
 
 /**
@@ -2497,8 +3328,8 @@ std::shared_ptr<Statement> Parser::parsePrint(const std::vector<Token> &tokens,
  * @return LetStmt for variable or ArrayLetStmt for array assignment
  * @throws std::runtime_error on syntax errors
  */
-std::shared_ptr<Statement>
-Parser::parseLetOrAssignment(const std::vector<Token> &tokens, size_t &pos) {
+Statement *Parser::parseLetOrAssignment(const std::vector<Token> &tokens,
+                                        size_t &pos) {
   if (tokens[pos].type == TokenType::LET) {
     pos++; // Skip LET
   }
@@ -2507,10 +3338,10 @@ Parser::parseLetOrAssignment(const std::vector<Token> &tokens, size_t &pos) {
     throw std::runtime_error("SYNTAX ERROR");
   }
 
-  std::string varName = tokens[pos].text;
+  std::string varName(text(tokens[pos]));
   pos++;
 
-  std::vector<std::shared_ptr<Expression>> indices;
+  std::vector<Expression *> indices;
   if (pos < tokens.size() && tokens[pos].type == TokenType::LPAREN) {
     pos++;
     while (pos < tokens.size() && tokens[pos].type != TokenType::RPAREN) {
@@ -2534,27 +3365,28 @@ Parser::parseLetOrAssignment(const std::vector<Token> &tokens, size_t &pos) {
 
   auto expr = parseExpression(tokens, pos);
   if (indices.empty()) {
-    return std::make_shared<LetStmt>(varName, expr);
+    return arena_.make<LetStmt>(varName, expr);
   }
-  return std::make_shared<ArrayLetStmt>(varName, indices, expr);
+  return arena_.make<ArrayLetStmt>(varName, indices, expr);
 }
 
 // ============================================================================
 // Expression Parsing with Operator Precedence
 // ============================================================================
-// The following functions implement recursive descent parsing for expressions
-// with proper operator precedence. Each level of precedence has its own
-// parse function that calls the next higher precedence level.
+// Expressions are parsed by precedence climbing over one operator table:
+// parseSubexpression() reads an operand (a prefix operator with its
+// operand, or a primary expression) and then every binary operator that
+// binds at least as tightly as the level it was called for.
 //
 // Precedence hierarchy (lowest to highest):
 // 1. OR (logical or)
 // 2. AND (logical and)
-// 3. NOT (logical not)
-// 4. Relational (=, <>, <, >, <=, >=)
+// 3. NOT (logical not, prefix)
+// 4. Relational (=, <>, <, >, <=, >=), not chained
 // 5. Additive (+, -)
 // 6. Multiplicative (*, /, MOD)
-// 7. Unary (+, -)
-// 8. Power (^)
+// 7. Unary (+, -, prefix)
+// 8. Power (^), right-associative
 // 9. Primary (literals, variables, functions, parentheses)
 //
 // This structure ensures that operations bind correctly:
@@ -2562,292 +3394,169 @@ Parser::parseLetOrAssignment(const std::vector<Token> &tokens, size_t &pos) {
 //   X = 5 OR Y = 3  evaluates comparisons before OR
 // ============================================================================
 
-/**
- * @brief Parse an expression with full operator precedence
- * 
- * Entry point for expression parsing. Dispatches to the lowest precedence
- * level (OR expressions) which then recursively calls higher precedence
- * levels to build the correct AST structure.
- * 
- * @param tokens Token sequence
- * @param pos Current position (updated by parsing)
- * @return Expression AST node
- */
-std::shared_ptr<Expression>
-Parser::parseExpression(const std::vector<Token> &tokens, size_t &pos) {
-  return parseOrExpression(tokens, pos);
-}
-
-/**
- * @brief Parse logical OR expressions (lowest precedence)
- * 
- * Handles OR operator which has lowest precedence. Parses left-associative
- * chains of OR operations:
- *   A OR B OR C = (A OR B) OR C
- * 
- * In Applesoft BASIC, OR performs bitwise OR on integer values:
- *   0 OR 0 = 0 (false OR false = false)
- *   0 OR 1 = 1 (false OR true = true)
- *   Any non-zero value is considered true
- * 
- * @param tokens Token sequence
- * @param pos Current position
- * @return Expression representing OR chain or single AND expression
- */
-std::shared_ptr<Expression>
-Parser::parseOrExpression(const std::vector<Token> &tokens, size_t &pos) {
-  auto left = parseAndExpression(tokens, pos);
-
-  // Handle left-associative chain: A OR B OR C
-  while (pos < tokens.size() && tokens[pos].type == TokenType::OR) {
-    pos++;
-    auto right = parseAndExpression(tokens, pos);
-    left = std::make_shared<BinaryExpr>(left, TokenType::OR, right);
-  }
-
-  return left;
-}
+namespace {
+/** @brief How a binary operator groups with others of its level */
+enum class Associativity : uint8_t {
+  None,  ///< A = B = C stops after A = B
+  Left,  ///< A - B - C = (A - B) - C
+  Right, ///< A ^ B ^ C = A ^ (B ^ C)
+};
 
 /**
- * @brief Parse logical AND expressions
- * 
- * Handles AND operator with higher precedence than OR but lower than NOT.
- * Parses left-associative chains:
- *   A AND B AND C = (A AND B) AND C
- * 
- * In Applesoft BASIC, AND performs bitwise AND on integer values:
- *   0 AND 0 = 0 (false AND false = false)
- *   0 AND 1 = 0 (false AND true = false)
- *   1 AND 1 = 1 (true AND true = true)
- * 
- * @param tokens Token sequence
- * @param pos Current position
- * @return Expression representing AND chain or single NOT expression
+ * @brief What a token does in an expression
+ *
+ * Precedence levels are 0 where the token is no such operator.
  */
-std::shared_ptr<Expression>
-Parser::parseAndExpression(const std::vector<Token> &tokens, size_t &pos) {
-  auto left = parseNotExpression(tokens, pos);
-
-  // Handle left-associative chain: A AND B AND C
-  while (pos < tokens.size() && tokens[pos].type == TokenType::AND) {
-    pos++;
-    auto right = parseNotExpression(tokens, pos);
-    left = std::make_shared<BinaryExpr>(left, TokenType::AND, right);
-  }
+struct OperatorInfo {
+  uint8_t binary = 0; ///< level as a binary operator
+  Associativity associativity = Associativity::Left;
+  uint8_t prefix = 0;    ///< level as a prefix operator
+  uint8_t arguments = 0; ///< argument count of a built-in function
+};
 
-  return left;
+constexpr uint8_t kOrLevel = 1;
+constexpr uint8_t kAndLevel = 2;
+constexpr uint8_t kNotLevel = 3;
+constexpr uint8_t kRelationalLevel = 4;
+constexpr uint8_t kAdditiveLevel = 5;
+constexpr uint8_t kMultiplicativeLevel = 6;
+constexpr uint8_t kUnaryLevel = 7;
+constexpr uint8_t kPowerLevel = 8;
+/** @brief Above every operator: nothing stops an operand's operators */
+constexpr uint8_t kNoLimit = kPowerLevel + 1;
+
+constexpr size_t kTokenTypes = static_cast<size_t>(TokenType::PDL) + 1;
+
+constexpr std::array<OperatorInfo, kTokenTypes> buildOperatorTable() {
+  std::array<OperatorInfo, kTokenTypes> table{};
+  auto binary = [&table](TokenType type, uint8_t level,
+                         Associativity associativity) {
+    table[static_cast<size_t>(type)].binary = level;
+    table[static_cast<size_t>(type)].associativity = associativity;
+  };
+  binary(TokenType::OR, kOrLevel, Associativity::Left);
+  binary(TokenType::AND, kAndLevel, Associativity::Left);
+  for (TokenType type :
+       {TokenType::EQUAL, TokenType::NOT_EQUAL, TokenType::LESS,
+        TokenType::GREATER, TokenType::LESS_EQUAL, TokenType::GREATER_EQUAL}) {
+    binary(type, kRelationalLevel, Associativity::None);
+  }
+  binary(TokenType::PLUS, kAdditiveLevel, Associativity::Left);
+  binary(TokenType::MINUS, kAdditiveLevel, Associativity::Left);
+  binary(TokenType::MULTIPLY, kMultiplicativeLevel, Associativity::Left);
+  binary(TokenType::DIVIDE, kMultiplicativeLevel, Associativity::Left);
+  binary(TokenType::MOD, kMultiplicativeLevel, Associativity::Left);
+  binary(TokenType::POWER, kPowerLevel, Associativity::Right);
+  table[static_cast<size_t>(TokenType::NOT)].prefix = kNotLevel;
+  table[static_cast<size_t>(TokenType::PLUS)].prefix = kUnaryLevel;
+  table[static_cast<size_t>(TokenType::MINUS)].prefix = kUnaryLevel;
+  for (TokenType type :
+       {TokenType::SIN, TokenType::COS, TokenType::TAN, TokenType::ATN,
+        TokenType::EXP, TokenType::LOG, TokenType::SQR, TokenType::ABS,
+        TokenType::INT, TokenType::SGN, TokenType::RND, TokenType::LEN,
+        TokenType::VAL, TokenType::ASC, TokenType::CHR, TokenType::STR,
+        TokenType::TAB, TokenType::SPC, TokenType::POS, TokenType::FRE,
+        TokenType::PDL, TokenType::PEEK, TokenType::USR}) {
+    table[static_cast<size_t>(type)].arguments = 1;
+  }
+  for (TokenType type : {TokenType::LEFT, TokenType::RIGHT, TokenType::SCRN}) {
+    table[static_cast<size_t>(type)].arguments = 2;
+  }
+  table[static_cast<size_t>(TokenType::MID)].arguments = 3;
+  return table;
 }
 
-/**
- * @brief Parse logical NOT expressions (prefix unary)
- * 
- * Handles NOT operator which has higher precedence than AND/OR.
- * Can be chained: NOT NOT X = X
- * 
- * In Applesoft BASIC, NOT performs bitwise NOT (complement):
- *   NOT 0 = -1 (all bits set)
- *   NOT -1 = 0
- *   NOT X = -(X + 1)
- * 
- * @param tokens Token sequence
- * @param pos Current position
- * @return Expression representing NOT operation or relational expression
- */
-std::shared_ptr<Expression>
-Parser::parseNotExpression(const std::vector<Token> &tokens, size_t &pos) {
-  if (pos < tokens.size() && tokens[pos].type == TokenType::NOT) {
-    pos++;
-    // Recursively handle NOT chains
-    auto operand = parseNotExpression(tokens, pos);
-    return std::make_shared<NotExpr>(operand);
-  }
+constexpr std::array<OperatorInfo, kTokenTypes> kOperators =
+    buildOperatorTable();
 
-  return parseRelationalExpression(tokens, pos);
+const OperatorInfo &operatorInfo(TokenType type) {
+  return kOperators[static_cast<size_t>(type)];
 }
+} // namespace
 
 /**
- * @brief Parse relational (comparison) expressions
- * 
- * Handles comparison operators: =, <>, <, >, <=, >=
- * Unlike arithmetic operators, comparisons are not chained in BASIC:
- *   A = B = C is parsed as A = (B = C), not (A = B) = C
- * 
- * Comparison results:
- *   True: -1 (all bits set, Applesoft convention)
- *   False: 0
+ * @brief Parse an expression with full operator precedence
  * 
- * String comparisons use lexicographic ordering.
+ * Entry point for expression parsing: a subexpression at the lowest
+ * level (OR), so every operator is taken.
  * 
  * @param tokens Token sequence
- * @param pos Current position
- * @return Expression representing comparison or additive expression
+ * @param pos Current position (updated by parsing)
+ * @return Expression AST node
  */
-std::shared_ptr<Expression>
-Parser::parseRelationalExpression(const std::vector<Token> &tokens,
-                                  size_t &pos) {
-  auto left = parseAdditiveExpression(tokens, pos);
-
-  // Check for comparison operator (not chained)
-  if (pos < tokens.size()) {
-    TokenType op = tokens[pos].type;
-    if (op == TokenType::EQUAL || op == TokenType::NOT_EQUAL ||
-        op == TokenType::LESS || op == TokenType::GREATER ||
-        op == TokenType::LESS_EQUAL || op == TokenType::GREATER_EQUAL) {
-      pos++;
-      auto right = parseAdditiveExpression(tokens, pos);
-      return std::make_shared<BinaryExpr>(left, op, right);
-    }
-  }
-
-  return left;
+Expression *Parser::parseExpression(const std::vector<Token> &tokens,
+                                    size_t &pos) {
+  return parseSubexpression(tokens, pos, kOrLevel);
 }
 
 /**
- * @brief Parse additive expressions (+ and -)
- * 
- * Handles addition and subtraction with left-to-right associativity:
- *   A + B - C + D = ((A + B) - C) + D
- * 
- * String concatenation:
- *   "HELLO" + "WORLD" = "HELLOWORLD"
- * 
- * Type coercion:
- *   Numeric + Numeric = Numeric
- *   String + String = String
- *   String + Numeric or Numeric + String raises TYPE MISMATCH ERROR
- * 
+ * @brief Parse the operators of one precedence level and above
+ *
+ * The operand is a prefix operator applied to a subexpression of its own
+ * level (NOT, unary + and -, which chain: NOT NOT X, --X), or else a
+ * primary expression. A prefix operator is only taken where its level is
+ * allowed, so 2 ^ -1 and A * NOT B are syntax errors, as is -X^2 read
+ * as anything but -(X^2).
+ *
+ * Binary operators of at least @p level are then applied left to right.
+ * The right operand of a left-associative or non-associative operator is
+ * a subexpression one level up, that of ^ one of its own level. Each
+ * step also lowers the limit on what may follow, because the grammar
+ * returns to an outer level there:
+ * - after a prefix operator of level L, only operators below L
+ *   (NOT A = B AND C is (NOT (A = B)) AND C)
+ * - after a relational operator, only operators below it (A = B = C
+ *   leaves "= C" to the caller, which reports it)
+ * - after a left-associative operator, only its level and below
+ *
+ * Comparison results are -1 (true, Applesoft convention) or 0; AND, OR
+ * and NOT work bitwise on integers; + also concatenates strings.
+ *
  * @param tokens Token sequence
  * @param pos Current position
- * @return Expression representing addition/subtraction or multiplicative expression
+ * @param level Lowest precedence level taken (kOrLevel: all)
+ * @return Expression AST node
  */
-std::shared_ptr<Expression>
-Parser::parseAdditiveExpression(const std::vector<Token> &tokens, size_t &pos) {
-  auto left = parseMultiplicativeExpression(tokens, pos);
-
-  // Handle left-associative chain: A + B - C
-  while (pos < tokens.size()) {
+Expression *Parser::parseSubexpression(const std::vector<Token> &tokens,
+                                       size_t &pos, uint8_t level) {
+  Expression *left;
+  uint8_t limit = kNoLimit;
+  uint8_t prefix =
+      pos < tokens.size() ? operatorInfo(tokens[pos].type).prefix : 0;
+  if (prefix >= level) {
     TokenType op = tokens[pos].type;
-    if (op == TokenType::PLUS || op == TokenType::MINUS) {
-      pos++;
-      auto right = parseMultiplicativeExpression(tokens, pos);
-      left = std::make_shared<BinaryExpr>(left, op, right);
+    pos++;
+    auto operand = parseSubexpression(tokens, pos, prefix);
+    if (op == TokenType::NOT) {
+      left = arena_.make<NotExpr>(operand);
     } else {
-      break;
+      left = arena_.make<UnaryExpr>(op, operand);
     }
+    limit = prefix;
+  } else {
+    left = parsePrimaryExpression(tokens, pos);
   }
 
-  return left;
-}
-
-/**
- * @brief Parse multiplicative expressions (*, /, MOD)
- * 
- * Handles multiplication, division, and modulo with left-to-right associativity:
- *   A * B / C MOD D = ((A * B) / C) MOD D
- * 
- * Operator semantics:
- *   * : Standard multiplication
- *   / : Floating-point division (5 / 2 = 2.5)
- *   MOD : Integer modulo (5 MOD 2 = 1)
- * 
- * Division by zero raises DIVISION BY ZERO ERROR.
- * MOD 0 raises ILLEGAL QUANTITY ERROR.
- * 
- * @param tokens Token sequence
- * @param pos Current position
- * @return Expression representing multiplication/division or unary expression
- */
-std::shared_ptr<Expression>
-Parser::parseMultiplicativeExpression(const std::vector<Token> &tokens,
-                                      size_t &pos) {
-  auto left = parseUnaryExpression(tokens, pos);
-
-  // Handle left-associative chain: A * B / C
   while (pos < tokens.size()) {
     TokenType op = tokens[pos].type;
-    if (op == TokenType::MULTIPLY || op == TokenType::DIVIDE ||
-        op == TokenType::MOD) {
-      pos++;
-      auto right = parseUnaryExpression(tokens, pos);
-      left = std::make_shared<BinaryExpr>(left, op, right);
-    } else {
+    const OperatorInfo &info = operatorInfo(op);
+    if (info.binary < level || info.binary >= limit) {
       break;
     }
-  }
-
-  return left;
-}
-
-/**
- * @brief Parse unary expressions (prefix + and -)
- * 
- * Handles unary plus and minus operators which have higher precedence than
- * binary operators but lower than power (^).
- * 
- * Can be chained:
- *   --X = X (double negation)
- *   -+X = -X
- * 
- * Examples:
- *   -5 = negative five
- *   -X^2 = -(X^2), not (-X)^2
- *   +5 = positive five (usually redundant)
- * 
- * @param tokens Token sequence
- * @param pos Current position
- * @return Expression representing unary operation or power expression
- */
-std::shared_ptr<Expression>
-Parser::parseUnaryExpression(const std::vector<Token> &tokens, size_t &pos) {
-  if (pos < tokens.size() && (tokens[pos].type == TokenType::PLUS ||
-                              tokens[pos].type == TokenType::MINUS)) {
-    TokenType op = tokens[pos].type;
-    pos++;
-    // Recursively handle unary chains: --X
-    auto operand = parseUnaryExpression(tokens, pos);
-    return std::make_shared<UnaryExpr>(op, operand);
-  }
-
-  return parsePowerExpression(tokens, pos);
-}
-
-/**
- * @brief Parse power (exponentiation) expressions
- * 
- * Handles the exponentiation operator (^) which has highest precedence
- * among binary operators.
- * 
- * Right-associative:
- *   2 ^ 3 ^ 2 = 2 ^ (3 ^ 2) = 2 ^ 9 = 512
- *   (not (2 ^ 3) ^ 2 = 8 ^ 2 = 64)
- * 
- * This is the standard mathematical convention for exponentiation.
- * 
- * Examples:
- *   2 ^ 3 = 8
- *   -2 ^ 2 = -(2 ^ 2) = -4 (unary minus has lower precedence)
- *   (-2) ^ 2 = 4
- *   X ^ 0.5 = square root of X
- * 
- * @param tokens Token sequence
- * @param pos Current position
- * @return Expression representing power operation or primary expression
- */
-std::shared_ptr<Expression>
-Parser::parsePowerExpression(const std::vector<Token> &tokens, size_t &pos) {
-  auto left = parsePrimaryExpression(tokens, pos);
-
-  if (pos < tokens.size() && tokens[pos].type == TokenType::POWER) {
     pos++;
-    auto right = parsePowerExpression(tokens, pos);
-    left = std::make_shared<BinaryExpr>(left, TokenType::POWER, right);
+    bool right = info.associativity == Associativity::Right;
+    auto operand = parseSubexpression(
+        tokens, pos, right ? info.binary : info.binary + 1);
+    left = arena_.make<BinaryExpr>(left, op, operand);
+    limit = info.associativity == Associativity::Left ? info.binary + 1
+                                                      : info.binary;
   }
 
   return left;
 }
 
-std::shared_ptr<Expression>
-Parser::parsePrimaryExpression(const std::vector<Token> &tokens, size_t &pos) {
+Expression *Parser::parsePrimaryExpression(const std::vector<Token> &tokens,
+                                           size_t &pos) {
   if (pos >= tokens.size()) {
     throw std::runtime_error("SYNTAX ERROR");
   }
@@ -2856,26 +3565,27 @@ Parser::parsePrimaryExpression(const std::vector<Token> &tokens, size_t &pos) {
 
   if (token.type == TokenType::NUMBER) {
     pos++;
-    return std::make_shared<LiteralExpr>(token.value);
+    return arena_.make<LiteralExpr>(value(token));
   }
 
   if (token.type == TokenType::STRING) {
     pos++;
-    return std::make_shared<LiteralExpr>(token.value);
+    return arena_.make<LiteralExpr>(value(token));
   }
 
   if (token.type == TokenType::IDENTIFIER) {
-    std::string name = token.text;
-    std::string upperName = toUpper(name);
+    std::string name(text(token));
     pos++;
 
     bool hasParen =
         pos < tokens.size() && tokens[pos].type == TokenType::LPAREN;
-    bool isUserFn = upperName.rfind("FN", 0) == 0;
+    bool isUserFn = name.size() >= 2 &&
+                    std::toupper(static_cast<unsigned char>(name[0])) == 'F' &&
+                    std::toupper(static_cast<unsigned char>(name[1])) == 'N';
 
     if (hasParen) {
       pos++; // Skip '('
-      std::vector<std::shared_ptr<Expression>> indices;
+      std::vector<Expression *> indices;
       while (pos < tokens.size() && tokens[pos].type != TokenType::RPAREN) {
         indices.push_back(parseExpression(tokens, pos));
         if (pos < tokens.size() && tokens[pos].type == TokenType::COMMA) {
@@ -2893,18 +3603,22 @@ Parser::parsePrimaryExpression(const std::vector<Token> &tokens, size_t &pos) {
         if (indices.size() != 1) {
           throw std::runtime_error("SYNTAX ERROR: FN EXPECTS 1 ARGUMENT");
         }
-        return std::make_shared<UserFunctionCallExpr>(upperName,
-                                                      indices.front());
+        ++userCalls_;
+        return arena_.make<UserFunctionCallExpr>(toUpper(name),
+                                                 indices.front());
       }
 
-      return std::make_shared<ArrayAccessExpr>(name, indices);
+      return arena_.make<ArrayAccessExpr>(name, indices);
     }
 
     if (isUserFn) {
       throw std::runtime_error("SYNTAX ERROR");
     }
 
-    return std::make_shared<VariableExpr>(name);
+    if (parameter_ && symbols().intern(name) == *parameter_) {
+      return arena_.make<ParameterExpr>(*parameter_);
+    }
+    return arena_.make<VariableExpr>(name);
   }
 
   if (token.type == TokenType::LPAREN) {
@@ -2917,69 +3631,8 @@ Parser::parsePrimaryExpression(const std::vector<Token> &tokens, size_t &pos) {
     return expr;
   }
 
-  // Built-in functions - single argument
-  if (token.type == TokenType::SIN || token.type == TokenType::COS ||
-      token.type == TokenType::TAN || token.type == TokenType::ATN ||
-      token.type == TokenType::EXP || token.type == TokenType::LOG ||
-      token.type == TokenType::SQR || token.type == TokenType::ABS ||
-      token.type == TokenType::INT || token.type == TokenType::SGN ||
-      token.type == TokenType::RND || token.type == TokenType::LEN ||
-      token.type == TokenType::VAL || token.type == TokenType::ASC ||
-      token.type == TokenType::CHR || token.type == TokenType::STR ||
-      token.type == TokenType::TAB || token.type == TokenType::SPC ||
-      token.type == TokenType::POS || token.type == TokenType::FRE ||
-      token.type == TokenType::PDL || token.type == TokenType::PEEK ||
-      token.type == TokenType::USR) {
-    TokenType func = token.type;
-    pos++;
-
-    if (pos >= tokens.size() || tokens[pos].type != TokenType::LPAREN) {
-      throw std::runtime_error("SYNTAX ERROR");
-    }
-    pos++;
-
-    std::vector<std::shared_ptr<Expression>> args;
-    args.push_back(parseExpression(tokens, pos));
-
-    if (pos >= tokens.size() || tokens[pos].type != TokenType::RPAREN) {
-      throw std::runtime_error("SYNTAX ERROR: MISSING )");
-    }
-    pos++;
-
-    return std::make_shared<FunctionCallExpr>(func, args);
-  }
-
-  // Built-in functions - two arguments
-  if (token.type == TokenType::LEFT || token.type == TokenType::RIGHT ||
-      token.type == TokenType::SCRN) {
-    TokenType func = token.type;
-    pos++;
-
-    if (pos >= tokens.size() || tokens[pos].type != TokenType::LPAREN) {
-      throw std::runtime_error("SYNTAX ERROR");
-    }
-    pos++;
-
-    std::vector<std::shared_ptr<Expression>> args;
-    args.push_back(parseExpression(tokens, pos));
-
-    if (pos >= tokens.size() || tokens[pos].type != TokenType::COMMA) {
-      throw std::runtime_error("SYNTAX ERROR: EXPECTED COMMA");
-    }
-    pos++;
-
-    args.push_back(parseExpression(tokens, pos));
-
-    if (pos >= tokens.size() || tokens[pos].type != TokenType::RPAREN) {
-      throw std::runtime_error("SYNTAX ERROR: MISSING )");
-    }
-    pos++;
-
-    return std::make_shared<FunctionCallExpr>(func, args);
-  }
-
-  // MID$ - three arguments
-  if (token.type == TokenType::MID) {
+  // Built-in functions: SIN(X), LEFT$(A$, N), MID$(A$, I, N), ...
+  if (uint8_t arguments = operatorInfo(token.type).arguments) {
     TokenType func = token.type;
     pos++;
 
@@ -2988,29 +3641,23 @@ Parser::parsePrimaryExpression(const std::vector<Token> &tokens, size_t &pos) {
     }
     pos++;
 
-    std::vector<std::shared_ptr<Expression>> args;
-    args.push_back(parseExpression(tokens, pos));
-
-    if (pos >= tokens.size() || tokens[pos].type != TokenType::COMMA) {
-      throw std::runtime_error("SYNTAX ERROR: EXPECTED COMMA");
-    }
-    pos++;
-
+    std::vector<Expression *> args;
+    args.reserve(arguments);
     args.push_back(parseExpression(tokens, pos));
-
-    if (pos >= tokens.size() || tokens[pos].type != TokenType::COMMA) {
-      throw std::runtime_error("SYNTAX ERROR: EXPECTED COMMA");
+    while (args.size() < arguments) {
+      if (pos >= tokens.size() || tokens[pos].type != TokenType::COMMA) {
+        throw std::runtime_error("SYNTAX ERROR: EXPECTED COMMA");
+      }
+      pos++;
+      args.push_back(parseExpression(tokens, pos));
     }
-    pos++;
-
-    args.push_back(parseExpression(tokens, pos));
 
     if (pos >= tokens.size() || tokens[pos].type != TokenType::RPAREN) {
       throw std::runtime_error("SYNTAX ERROR: MISSING )");
     }
     pos++;
 
-    return std::make_shared<FunctionCallExpr>(func, args);
+    return arena_.make<FunctionCallExpr>(func, args);
   }
 
   throw std::runtime_error("SYNTAX ERROR");
@@ -3042,8 +3689,7 @@ Parser::parsePrimaryExpression(const std::vector<Token> &tokens, size_t &pos) {
  * @return OnTransferStmt with index expression and line number list
  * @throws std::runtime_error if GOTO/GOSUB keyword missing or syntax error
  */
-std::shared_ptr<Statement> Parser::parseOn(const std::vector<Token> &tokens,
-                                           size_t &pos) {
+Statement *Parser::parseOn(const std::vector<Token> &tokens, size_t &pos) {
   pos++; // Skip ON
   auto index = parseExpression(tokens, pos);
   if (pos >= tokens.size() || (tokens[pos].type != TokenType::GOTO &&
@@ -3059,7 +3705,7 @@ std::shared_ptr<Statement> Parser::parseOn(const std::vector<Token> &tokens,
     if (tokens[pos].type != TokenType::NUMBER) {
       throw std::runtime_error("SYNTAX ERROR: EXPECTED LINE NUMBER");
     }
-    int line = static_cast<int>(tokens[pos].value.getNumber());
+    int line = static_cast<int>(value(tokens[pos]).getNumber());
     lines.push_back(line);
     pos++;
     if (pos < tokens.size() && tokens[pos].type == TokenType::COMMA) {
@@ -3072,7 +3718,7 @@ std::shared_ptr<Statement> Parser::parseOn(const std::vector<Token> &tokens,
   OnTransferStmt::Kind kind = (kindTok == TokenType::GOTO)
                                   ? OnTransferStmt::Goto
                                   : OnTransferStmt::Gosub;
-  return std::make_shared<OnTransferStmt>(index, kind, lines);
+  return arena_.make<OnTransferStmt>(index, kind, lines);
 }
 
 /**
@@ -3101,8 +3747,7 @@ std::shared_ptr<Statement> Parser::parseOn(const std::vector<Token> &tokens,
  * @return InputStmt with prompt and variable list
  * @throws std::runtime_error on syntax errors
  */
-std::shared_ptr<Statement> Parser::parseInput(const std::vector<Token> &tokens,
-                                              size_t &pos) {
+Statement *Parser::parseInput(const std::vector<Token> &tokens, size_t &pos) {
   pos++; // Skip INPUT
 
   std::string prompt;
@@ -3110,7 +3755,7 @@ std::shared_ptr<Statement> Parser::parseInput(const std::vector<Token> &tokens,
 
   // Check for prompt string
   if (pos < tokens.size() && tokens[pos].type == TokenType::STRING) {
-    prompt = tokens[pos].text;
+    prompt = value(tokens[pos]).getString();
     pos++;
 
     if (pos < tokens.size() && tokens[pos].type == TokenType::SEMICOLON) {
@@ -3122,7 +3767,7 @@ std::shared_ptr<Statement> Parser::parseInput(const std::vector<Token> &tokens,
   while (pos < tokens.size() && tokens[pos].type != TokenType::COLON &&
          tokens[pos].type != TokenType::NEWLINE) {
     if (tokens[pos].type == TokenType::IDENTIFIER) {
-      vars.push_back(tokens[pos].text);
+      vars.push_back(std::string(text(tokens[pos])));
       pos++;
 
       if (pos < tokens.size() && tokens[pos].type == TokenType::COMMA) {
@@ -3133,7 +3778,7 @@ std::shared_ptr<Statement> Parser::parseInput(const std::vector<Token> &tokens,
     }
   }
 
-  return std::make_shared<InputStmt>(prompt, vars);
+  return arena_.make<InputStmt>(prompt, vars);
 }
 
 /**
@@ -3170,8 +3815,7 @@ std::shared_ptr<Statement> Parser::parseInput(const std::vector<Token> &tokens,
  * @return IfStmt with condition, THEN statements, and optional ELSE statements
  * @throws std::runtime_error if THEN keyword missing or syntax error
  */
-std::shared_ptr<Statement> Parser::parseIf(const std::vector<Token> &tokens,
-                                           size_t &pos) {
+Statement *Parser::parseIf(const std::vector<Token> &tokens, size_t &pos) {
   pos++; // Skip IF
 
   auto condition = parseExpression(tokens, pos);
@@ -3181,14 +3825,14 @@ std::shared_ptr<Statement> Parser::parseIf(const std::vector<Token> &tokens,
   }
   pos++;
 
-  std::vector<std::shared_ptr<Statement>> thenStmts;
-  std::vector<std::shared_ptr<Statement>> elseStmts;
+  std::vector<Statement *> thenStmts;
+  std::vector<Statement *> elseStmts;
 
   // Check if THEN is followed by a line number (GOTO)
   if (pos < tokens.size() && tokens[pos].type == TokenType::NUMBER) {
-    int lineNum = static_cast<int>(tokens[pos].value.getNumber());
+    int lineNum = static_cast<int>(value(tokens[pos]).getNumber());
     pos++;
-    thenStmts.push_back(std::make_shared<GotoStmt>(lineNum));
+    thenStmts.push_back(arena_.make<GotoStmt>(lineNum));
   } else {
     // Parse statements until ELSE or end of line
     while (pos < tokens.size() && tokens[pos].type != TokenType::ELSE &&
@@ -3206,9 +3850,9 @@ std::shared_ptr<Statement> Parser::parseIf(const std::vector<Token> &tokens,
     pos++;
 
     if (pos < tokens.size() && tokens[pos].type == TokenType::NUMBER) {
-      int lineNum = static_cast<int>(tokens[pos].value.getNumber());
+      int lineNum = static_cast<int>(value(tokens[pos]).getNumber());
       pos++;
-      elseStmts.push_back(std::make_shared<GotoStmt>(lineNum));
+      elseStmts.push_back(arena_.make<GotoStmt>(lineNum));
     } else {
       while (pos < tokens.size() && tokens[pos].type != TokenType::COLON &&
              tokens[pos].type != TokenType::NEWLINE) {
@@ -3220,7 +3864,7 @@ std::shared_ptr<Statement> Parser::parseIf(const std::vector<Token> &tokens,
     }
   }
 
-  return std::make_shared<IfStmt>(condition, thenStmts, elseStmts);
+  return arena_.make<IfStmt>(condition, thenStmts, elseStmts);
 }
 
 /**
@@ -3252,18 +3896,17 @@ std::shared_ptr<Statement> Parser::parseIf(const std::vector<Token> &tokens,
  * @return GotoStmt with target line number
  * @throws std::runtime_error if line number missing
  */
-std::shared_ptr<Statement> Parser::parseGoto(const std::vector<Token> &tokens,
-                                             size_t &pos) {
+Statement *Parser::parseGoto(const std::vector<Token> &tokens, size_t &pos) {
   pos++; // Skip GOTO
 
   if (pos >= tokens.size() || tokens[pos].type != TokenType::NUMBER) {
     throw std::runtime_error("SYNTAX ERROR: EXPECTED LINE NUMBER");
   }
 
-  int lineNum = static_cast<int>(tokens[pos].value.getNumber());
+  int lineNum = static_cast<int>(value(tokens[pos]).getNumber());
   pos++;
 
-  return std::make_shared<GotoStmt>(lineNum);
+  return arena_.make<GotoStmt>(lineNum);
 }
 
 /**
@@ -3303,18 +3946,17 @@ std::shared_ptr<Statement> Parser::parseGoto(const std::vector<Token> &tokens,
  * @return GosubStmt with target subroutine line number
  * @throws std::runtime_error if line number missing
  */
-std::shared_ptr<Statement> Parser::parseGosub(const std::vector<Token> &tokens,
-                                              size_t &pos) {
+Statement *Parser::parseGosub(const std::vector<Token> &tokens, size_t &pos) {
   pos++; // Skip GOSUB
 
   if (pos >= tokens.size() || tokens[pos].type != TokenType::NUMBER) {
     throw std::runtime_error("SYNTAX ERROR: EXPECTED LINE NUMBER");
   }
 
-  int lineNum = static_cast<int>(tokens[pos].value.getNumber());
+  int lineNum = static_cast<int>(value(tokens[pos]).getNumber());
   pos++;
 
-  return std::make_shared<GosubStmt>(lineNum);
+  return arena_.make<GosubStmt>(lineNum);
 }
 
 /**
@@ -3356,15 +3998,14 @@ std::shared_ptr<Statement> Parser::parseGosub(const std::vector<Token> &tokens,
  * @return ForStmt with loop control parameters
  * @throws std::runtime_error on syntax errors (missing =, TO, invalid variable)
  */
-std::shared_ptr<Statement> Parser::parseFor(const std::vector<Token> &tokens,
-                                            size_t &pos) {
+Statement *Parser::parseFor(const std::vector<Token> &tokens, size_t &pos) {
   pos++; // Skip FOR
 
   if (pos >= tokens.size() || tokens[pos].type != TokenType::IDENTIFIER) {
     throw std::runtime_error("SYNTAX ERROR: EXPECTED VARIABLE");
   }
 
-  std::string varName = tokens[pos].text;
+  std::string varName(text(tokens[pos]));
   pos++;
 
   if (pos >= tokens.size() || tokens[pos].type != TokenType::EQUAL) {
@@ -3381,13 +4022,13 @@ std::shared_ptr<Statement> Parser::parseFor(const std::vector<Token> &tokens,
 
   auto end = parseExpression(tokens, pos);
 
-  std::shared_ptr<Expression> step;
+  Expression *step = nullptr;
   if (pos < tokens.size() && tokens[pos].type == TokenType::STEP) {
     pos++;
     step = parseExpression(tokens, pos);
   }
 
-  return std::make_shared<ForStmt>(varName, start, end, step);
+  return arena_.make<ForStmt>(varName, start, end, step);
 }
 
 /**
@@ -3423,7 +4064,8 @@ std::shared_ptr<Statement> Parser::parseFor(const std::vector<Token> &tokens,
  * - Missing NEXT leaves FOR on stack (can cause issues)
  * 
  * Implementation:
- * - Creates NextStmt with optional variable name
+ * - Creates NextStmt with the symbol slots of its variables (kNoSymbol
+ *   for a bare NEXT)
  * - Runtime interpreter pops FOR stack and evaluates loop condition
  * - If continuing, sets program counter back to FOR line
  * 
@@ -3431,17 +4073,26 @@ std::shared_ptr<Statement> Parser::parseFor(const std::vector<Token> &tokens,
  * @param pos Current position (updated after parsing)
  * @return NextStmt with optional control variable name
  */
-std::shared_ptr<Statement> Parser::parseNext(const std::vector<Token> &tokens,
-                                             size_t &pos) {
+Statement *Parser::parseNext(const std::vector<Token> &tokens, size_t &pos) {
   pos++; // Skip NEXT
 
-  std::string varName;
-  if (pos < tokens.size() && tokens[pos].type == TokenType::IDENTIFIER) {
-    varName = tokens[pos].text;
+  std::vector<SymbolId> vars;
+  while (pos < tokens.size() && tokens[pos].type == TokenType::IDENTIFIER) {
+    vars.push_back(symbols().intern(std::string(text(tokens[pos]))));
+    pos++;
+    if (pos >= tokens.size() || tokens[pos].type != TokenType::COMMA) {
+      break;
+    }
     pos++;
+    if (pos >= tokens.size() || tokens[pos].type != TokenType::IDENTIFIER) {
+      throw std::runtime_error("SYNTAX ERROR: EXPECTED VARIABLE");
+    }
+  }
+  if (vars.empty()) {
+    vars.push_back(kNoSymbol);
   }
 
-  return std::make_shared<NextStmt>(varName);
+  return arena_.make<NextStmt>(std::move(vars));
 }
 
 /**
@@ -3487,8 +4138,7 @@ std::shared_ptr<Statement> Parser::parseNext(const std::vector<Token> &tokens,
  * @return DimStmt with array declarations (name and dimension expressions)
  * @throws std::runtime_error on syntax errors (missing parentheses, invalid format)
  */
-std::shared_ptr<Statement> Parser::parseDim(const std::vector<Token> &tokens,
-                                            size_t &pos) {
+Statement *Parser::parseDim(const std::vector<Token> &tokens, size_t &pos) {
   pos++; // Skip DIM
 
   std::vector<DimStmt::Entry> entries;
@@ -3500,7 +4150,7 @@ std::shared_ptr<Statement> Parser::parseDim(const std::vector<Token> &tokens,
     }
 
     DimStmt::Entry entry;
-    entry.name = tokens[pos].text;
+    entry.name = std::string(text(tokens[pos]));
     pos++;
 
     if (pos >= tokens.size() || tokens[pos].type != TokenType::LPAREN) {
@@ -3531,7 +4181,7 @@ std::shared_ptr<Statement> Parser::parseDim(const std::vector<Token> &tokens,
     break;
   }
 
-  return std::make_shared<DimStmt>(entries);
+  return arena_.make<DimStmt>(entries);
 }
 
 /**
@@ -3582,8 +4232,7 @@ std::shared_ptr<Statement> Parser::parseDim(const std::vector<Token> &tokens,
  * @return DataStmt with vector of constant values
  * @throws std::runtime_error if non-literal value found
  */
-std::shared_ptr<Statement> Parser::parseData(const std::vector<Token> &tokens,
-                                             size_t &pos) {
+Statement *Parser::parseData(const std::vector<Token> &tokens, size_t &pos) {
   pos++; // Skip DATA
   std::vector<Value> values;
 
@@ -3591,7 +4240,7 @@ std::shared_ptr<Statement> Parser::parseData(const std::vector<Token> &tokens,
          tokens[pos].type != TokenType::COLON) {
     if (tokens[pos].type == TokenType::NUMBER ||
         tokens[pos].type == TokenType::STRING) {
-      values.push_back(tokens[pos].value);
+      values.push_back(value(tokens[pos]));
       pos++;
       if (pos < tokens.size() && tokens[pos].type == TokenType::COMMA) {
         pos++;
@@ -3601,7 +4250,7 @@ std::shared_ptr<Statement> Parser::parseData(const std::vector<Token> &tokens,
     throw std::runtime_error("SYNTAX ERROR IN DATA");
   }
 
-  return std::make_shared<DataStmt>(values);
+  return arena_.make<DataStmt>(values);
 }
 
 /**
@@ -3650,7 +4299,7 @@ std::shared_ptr<Statement> Parser::parseData(const std::vector<Token> &tokens,
  * Implementation:
  * - Parses comma-separated list of variables or array subscripts
  * - Creates ReadStmt with vector of targets (variable or array element)
- * - Runtime interpreter pulls values from dataValues_ array
+ * - Target names are interned here; READ stores straight into the slots
  * - Handles type coercion and bounds checking
  * 
  * @param tokens Token sequence to parse
@@ -3658,8 +4307,7 @@ std::shared_ptr<Statement> Parser::parseData(const std::vector<Token> &tokens,
  * @return ReadStmt with list of target variables/arrays
  * @throws std::runtime_error on syntax errors
  */
-std::shared_ptr<Statement> Parser::parseRead(const std::vector<Token> &tokens,
-                                             size_t &pos) {
+Statement *Parser::parseRead(const std::vector<Token> &tokens, size_t &pos) {
   pos++; // Skip READ
 
   std::vector<ReadStmt::Target> targets;
@@ -3671,7 +4319,7 @@ std::shared_ptr<Statement> Parser::parseRead(const std::vector<Token> &tokens,
     }
 
     ReadStmt::Target tgt;
-    tgt.name = tokens[pos].text;
+    tgt.slot = symbols().intern(std::string(text(tokens[pos])));
     pos++;
 
     if (pos < tokens.size() && tokens[pos].type == TokenType::LPAREN) {
@@ -3699,7 +4347,7 @@ std::shared_ptr<Statement> Parser::parseRead(const std::vector<Token> &tokens,
     break;
   }
 
-  return std::make_shared<ReadStmt>(targets);
+  return arena_.make<ReadStmt>(targets);
 }
 
 /**
@@ -3746,15 +4394,15 @@ std::shared_ptr<Statement> Parser::parseRead(const std::vector<Token> &tokens,
  * - Parses FN keyword + name, parenthesized parameter, equals, expression
  * - Creates DefStmt with function name, parameter, and expression AST
  * - Runtime interpreter stores function definition in Variables
- * - Function calls are parsed as FunctionCallExpr and evaluated by substituting parameter
+ * - References to the parameter in the body become ParameterExpr nodes that
+ *   read the call's parameter frame
  * 
  * @param tokens Token sequence to parse
  * @param pos Current position (updated after parsing)
  * @return DefStmt with function name, parameter, and expression
  * @throws std::runtime_error on syntax errors (missing FN prefix, invalid format)
  */
-std::shared_ptr<Statement> Parser::parseDef(const std::vector<Token> &tokens,
-                                            size_t &pos) {
+Statement *Parser::parseDef(const std::vector<Token> &tokens, size_t &pos) {
   pos++; // Skip DEF
 
   if (pos >= tokens.size()) {
@@ -3767,10 +4415,10 @@ std::shared_ptr<Statement> Parser::parseDef(const std::vector<Token> &tokens,
     if (pos >= tokens.size() || tokens[pos].type != TokenType::IDENTIFIER) {
       throw std::runtime_error("SYNTAX ERROR: EXPECTED FUNCTION NAME");
     }
-    fnName = "FN" + tokens[pos].text;
+    fnName = "FN" + std::string(text(tokens[pos]));
     pos++;
   } else if (tokens[pos].type == TokenType::IDENTIFIER) {
-    fnName = tokens[pos].text;
+    fnName = std::string(text(tokens[pos]));
     pos++;
   } else {
     throw std::runtime_error("SYNTAX ERROR: EXPECTED FUNCTION NAME");
@@ -3789,7 +4437,7 @@ std::shared_ptr<Statement> Parser::parseDef(const std::vector<Token> &tokens,
     throw std::runtime_error("SYNTAX ERROR: EXPECTED PARAMETER");
   }
 
-  std::string param = tokens[pos].text;
+  SymbolId param = symbols().intern(std::string(text(tokens[pos])));
   pos++;
 
   if (pos >= tokens.size() || tokens[pos].type != TokenType::RPAREN) {
@@ -3802,8 +4450,16 @@ std::shared_ptr<Statement> Parser::parseDef(const std::vector<Token> &tokens,
   }
   pos++;
 
+  // Bind references to the parameter in the body to the call frame, and
+  // note whether the body calls other functions (see
+  // FunctionInfo::bindsVariable)
+  size_t callsBefore = userCalls_;
+  parameter_ = param;
   auto expr = parseExpression(tokens, pos);
-  return std::make_shared<DefStmt>(toUpper(fnName), param, expr);
+  parameter_.reset();
+  bool bindsVariable = userCalls_ != callsBefore;
+  return arena_.make<DefStmt>(toUpper(fnName), param, expr, bindsVariable,
+                              arena_);
 }
 
 /**
@@ -3866,8 +4522,7 @@ std::shared_ptr<Statement> Parser::parseDef(const std::vector<Token> &tokens,
  * @return OnErrStmt with error handler line number
  * @throws std::runtime_error if GOTO keyword or line number missing
  */
-std::shared_ptr<Statement> Parser::parseOnErr(const std::vector<Token> &tokens,
-                                              size_t &pos) {
+Statement *Parser::parseOnErr(const std::vector<Token> &tokens, size_t &pos) {
   pos++; // Skip ONERR
 
   if (pos >= tokens.size() || tokens[pos].type != TokenType::GOTO) {
@@ -3879,10 +4534,10 @@ std::shared_ptr<Statement> Parser::parseOnErr(const std::vector<Token> &tokens,
     throw std::runtime_error("SYNTAX ERROR: EXPECTED LINE NUMBER");
   }
 
-  int lineNum = static_cast<int>(tokens[pos].value.getNumber());
+  int lineNum = static_cast<int>(value(tokens[pos]).getNumber());
   pos++;
 
-  return std::make_shared<OnErrStmt>(lineNum);
+  return arena_.make<OnErrStmt>(lineNum);
 }
 
 /**
@@ -3903,15 +4558,15 @@ std::shared_ptr<Statement> Parser::parseOnErr(const std::vector<Token> &tokens,
  * @param pos Current position (updated after parsing)
  * @return RandomizeStmt with optional seed expression
  */
-std::shared_ptr<Statement>
-Parser::parseRandomize(const std::vector<Token> &tokens, size_t &pos) {
+Statement *Parser::parseRandomize(const std::vector<Token> &tokens,
+                                  size_t &pos) {
   pos++; // Skip RANDOMIZE
-  std::shared_ptr<Expression> seed;
+  Expression *seed = nullptr;
   if (pos < tokens.size() && tokens[pos].type != TokenType::COLON &&
       tokens[pos].type != TokenType::NEWLINE) {
     seed = parseExpression(tokens, pos);
   }
-  return std::make_shared<RandomizeStmt>(seed);
+  return arena_.make<RandomizeStmt>(seed);
 }
 
 /**
@@ -3935,14 +4590,13 @@ Parser::parseRandomize(const std::vector<Token> &tokens, size_t &pos) {
  * @param pos Current position (updated after parsing)
  * @return SpeedStmt with delay expression
  */
-std::shared_ptr<Statement> Parser::parseSpeed(const std::vector<Token> &tokens,
-                                              size_t &pos) {
+Statement *Parser::parseSpeed(const std::vector<Token> &tokens, size_t &pos) {
   pos++; // Skip SPEED
   if (pos < tokens.size() && tokens[pos].type == TokenType::EQUAL) {
     pos++; // Optional '='
   }
   auto delay = parseExpression(tokens, pos);
-  return std::make_shared<SpeedStmt>(delay);
+  return arena_.make<SpeedStmt>(delay);
 }
 
 /**
@@ -3970,18 +4624,17 @@ std::shared_ptr<Statement> Parser::parseSpeed(const std::vector<Token> &tokens,
  * @param isOutput true for PR# (output), false for IN# (input)
  * @return DeviceRedirectStmt with slot expression
  */
-std::shared_ptr<Statement>
-Parser::parseDeviceRedirect(const std::vector<Token> &tokens, size_t &pos,
-                            bool isOutput) {
+Statement *Parser::parseDeviceRedirect(const std::vector<Token> &tokens,
+                                       size_t &pos, bool isOutput) {
   pos++; // Skip PR or IN
   if (pos < tokens.size() && tokens[pos].type == TokenType::HASH) {
     pos++; // Optional '#'
   }
   auto slot = parseExpression(tokens, pos);
   if (isOutput) {
-    return std::make_shared<PrStmt>(slot);
+    return arena_.make<PrStmt>(slot);
   }
-  return std::make_shared<InStmt>(slot);
+  return arena_.make<InStmt>(slot);
 }
 
 /**
@@ -4045,11 +4698,10 @@ Parser::parseDeviceRedirect(const std::vector<Token> &tokens, size_t &pos,
  * @param pos Current position (updated after parsing)
  * @return WhileStmt with condition expression
  */
-std::shared_ptr<Statement> Parser::parseWhile(const std::vector<Token> &tokens,
-                                              size_t &pos) {
+Statement *Parser::parseWhile(const std::vector<Token> &tokens, size_t &pos) {
   pos++; // Skip WHILE
   auto condition = parseExpression(tokens, pos);
-  return std::make_shared<WhileStmt>(condition);
+  return arena_.make<WhileStmt>(condition, arena_);
 }
 
 /**
@@ -4078,8 +4730,7 @@ std::shared_ptr<Statement> Parser::parseWhile(const std::vector<Token> &tokens,
  * @return WaitStmt with address, mask, and optional timeout
  * @throws std::runtime_error on syntax errors
  */
-std::shared_ptr<Statement> Parser::parseWait(const std::vector<Token> &tokens,
-                                             size_t &pos) {
+Statement *Parser::parseWait(const std::vector<Token> &tokens, size_t &pos) {
   pos++; // Skip WAIT
   auto addr = parseExpression(tokens, pos);
   if (pos >= tokens.size() || tokens[pos].type != TokenType::COMMA) {
@@ -4088,12 +4739,12 @@ std::shared_ptr<Statement> Parser::parseWait(const std::vector<Token> &tokens,
   pos++;
   auto mask = parseExpression(tokens, pos);
   // Optional third argument: timeout in milliseconds
-  std::shared_ptr<Expression> timeout;
+  Expression *timeout = nullptr;
   if (pos < tokens.size() && tokens[pos].type == TokenType::COMMA) {
     pos++;
     timeout = parseExpression(tokens, pos);
   }
-  return std::make_shared<WaitStmt>(addr, mask, timeout);
+  return arena_.make<WaitStmt>(addr, mask, timeout);
 }
 
 /**
@@ -4119,15 +4770,14 @@ std::shared_ptr<Statement> Parser::parseWait(const std::vector<Token> &tokens,
  * @return HimemStmt with address expression
  * @throws std::runtime_error if equals sign missing
  */
-std::shared_ptr<Statement> Parser::parseHimem(const std::vector<Token> &tokens,
-                                              size_t &pos) {
+Statement *Parser::parseHimem(const std::vector<Token> &tokens, size_t &pos) {
   pos++; // Skip HIMEM
   if (pos >= tokens.size() || tokens[pos].type != TokenType::EQUAL) {
     throw std::runtime_error("SYNTAX ERROR: EXPECTED =");
   }
   pos++;
   auto addr = parseExpression(tokens, pos);
-  return std::make_shared<HimemStmt>(addr);
+  return arena_.make<HimemStmt>(addr);
 }
 
 /**
@@ -4154,15 +4804,14 @@ std::shared_ptr<Statement> Parser::parseHimem(const std::vector<Token> &tokens,
  * @return LomemStmt with address expression
  * @throws std::runtime_error if equals sign missing
  */
-std::shared_ptr<Statement> Parser::parseLomem(const std::vector<Token> &tokens,
-                                              size_t &pos) {
+Statement *Parser::parseLomem(const std::vector<Token> &tokens, size_t &pos) {
   pos++; // Skip LOMEM
   if (pos >= tokens.size() || tokens[pos].type != TokenType::EQUAL) {
     throw std::runtime_error("SYNTAX ERROR: EXPECTED =");
   }
   pos++;
   auto addr = parseExpression(tokens, pos);
-  return std::make_shared<LomemStmt>(addr);
+  return arena_.make<LomemStmt>(addr);
 }
 
 /**
@@ -4188,19 +4837,18 @@ std::shared_ptr<Statement> Parser::parseLomem(const std::vector<Token> &tokens,
  * @param pos Current position (updated after parsing)
  * @return ShloadStmt with optional filename
  */
-std::shared_ptr<Statement> Parser::parseShload(const std::vector<Token> &tokens,
-                                               size_t &pos) {
+Statement *Parser::parseShload(const std::vector<Token> &tokens, size_t &pos) {
   pos++; // Skip SHLOAD
   
   // Check if there's a filename parameter
   if (pos < tokens.size() && tokens[pos].type == TokenType::STRING) {
-    std::string filename = tokens[pos].value.getString();
+    std::string filename = value(tokens[pos]).getString();
     pos++;
-    return std::make_shared<ShloadStmt>(filename);
+    return arena_.make<ShloadStmt>(filename);
   }
   
   // No filename, use DATA statements
-  return std::make_shared<ShloadStmt>();
+  return arena_.make<ShloadStmt>();
 }
 
 /**
@@ -8,7 +8,8 @@
  * the interpreter.
  *
  * Parser features:
- * - Recursive descent parsing with proper operator precedence
+ * - Recursive descent parsing of statements; expressions by precedence
+ *   climbing over one operator table
  * - Expression parsing (arithmetic, logical, relational, string)
  * - Statement parsing (all BASIC statements)
  * - Multi-statement line support (colon separator)
@@ -18,23 +19,38 @@
  * 1. OR
  * 2. AND
  * 3. NOT
- * 4. Relational (=, <>, <, >, <=, >=)
+ * 4. Relational (=, <>, <, >, <=, >=), not chained
  * 5. Additive (+, -)
  * 6. Multiplicative (*, /, MOD)
- * 7. Unary (+, -, NOT)
- * 8. Power (^)
+ * 7. Unary (+, -)
+ * 8. Power (^), right-associative
  * 9. Primary (literals, variables, functions, parentheses)
  */
 
 #pragma once
 
+#include "ast_arena.h"
 #include "tokenizer.h"
 #include "types.h"
 #include "variables.h"
+#include <array>
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
+namespace bytecode {
+class Compiler;
+}
+
+namespace looptier {
+class Builder;
+}
+
+class ConstantFolder;
+
 /**
  * @class Expression
  * @brief Base class for all expression AST nodes
@@ -58,6 +74,72 @@ public:
    * @throws std::runtime_error On evaluation errors (type mismatch, etc.)
    */
   virtual Value evaluate(class Interpreter *interp) = 0;
+
+  /**
+   * @brief Evaluate this expression as a number
+   *
+   * Numeric nodes (literals, numeric variables and array elements,
+   * arithmetic, comparisons, math builtins) override this to compute a plain
+   * double without building Value temporaries. The default evaluates the
+   * expression and converts the result with Value::getNumber().
+   *
+   * @param interp Pointer to the interpreter
+   * @return double The expression's numeric value
+   * @throws std::runtime_error On evaluation errors
+   */
+  virtual double evaluateNumber(class Interpreter *interp) {
+    return evaluate(interp).getNumber();
+  }
+
+  /**
+   * @brief Check whether the parser can prove this expression is numeric
+   *
+   * Used when building the tree to decide whether a parent node may
+   * evaluate its operands through evaluateNumber().
+   *
+   * @return true if the expression always yields a number
+   */
+  virtual bool isNumeric() const { return false; }
+
+  /**
+   * @brief Check whether this expression is a compile-time constant
+   * @return true only for literals (folded subtrees become literals)
+   */
+  virtual bool isConstant() const { return false; }
+
+  /**
+   * @brief Check whether every value this yields is already Float40-rounded
+   *
+   * Such values are unchanged by another pass through Float40 arithmetic,
+   * which is what lets the folder drop X+0 and X*1.
+   */
+  virtual bool isFloat40Exact() const { return false; }
+
+  /**
+   * @brief Constant-fold this node's children, then the node itself
+   *
+   * @param folder Folding pass (records removed nodes)
+   * @return Replacement node, or nullptr to keep this node
+   */
+  virtual Expression *fold(ConstantFolder & /*folder*/) { return nullptr; }
+
+  /**
+   * @brief Emit bytecode that leaves this expression's value on the VM stack
+   *
+   * The default implementation emits a fallback instruction that calls
+   * evaluate(), so every expression can run under the bytecode engine.
+   *
+   * @param compiler Bytecode compiler for the current line
+   */
+  virtual void compile(bytecode::Compiler &compiler);
+
+  /**
+   * @brief Emit loop-tier code that pushes this expression's number
+   *
+   * @param builder Loop tier builder
+   * @return false if the expression is not purely numeric (default)
+   */
+  virtual bool lowerNumeric(looptier::Builder & /*builder*/) { return false; }
 };
 
 /**
@@ -93,8 +175,162 @@ public:
    * @param dataValues Vector to append data values to
    */
   virtual void collectData(std::vector<Value> & /*dataValues*/) const {}
+
+  /**
+   * @brief Resolve jump targets against the program image
+   *
+   * Called by the interpreter's link pass before a run. GOTO, GOSUB and
+   * ON...GOTO/GOSUB cache the index of their target lines; IF forwards to
+   * its nested statements. Default implementation does nothing.
+   *
+   * @param program Program image to resolve line numbers in
+   */
+  virtual void linkTargets(const Program & /*program*/) {}
+
+  /**
+   * @brief Run the constant folder over this statement's expressions
+   *
+   * Default implementation does nothing; statements that evaluate
+   * expressions on hot paths override it.
+   *
+   * @param folder Folding pass
+   */
+  virtual void foldConstants(ConstantFolder & /*folder*/) {}
+
+  /**
+   * @brief Replace this statement by a fused superinstruction
+   *
+   * Called once per statement after constant folding. Statements matching
+   * one of the hot shapes listed in Superinstruction return the fused node
+   * that takes their place; IF also fuses its THEN/ELSE statements. The
+   * default implementation keeps the statement.
+   *
+   * @param arena Arena that owns the line's nodes (for the fused node)
+   * @return Replacement node, or nullptr to keep this statement
+   */
+  virtual Statement *fuse(AstArena & /*arena*/) { return nullptr; }
+
+  /**
+   * @brief Emit bytecode that performs this statement
+   *
+   * The default implementation emits a fallback instruction that calls
+   * execute(), so statements without a dedicated lowering still run under
+   * the bytecode engine.
+   *
+   * @param compiler Bytecode compiler for the current line
+   */
+  virtual void compile(bytecode::Compiler &compiler);
+
+  /**
+   * @brief Emit loop-tier code that performs this statement
+   *
+   * Numeric assignments, IF without jumps, FOR, NEXT and REM override this
+   * so hot loops built from them can run in the loop tier.
+   *
+   * @param builder Loop tier builder
+   * @return false if the statement cannot run in the tier (default)
+   */
+  virtual bool lowerNumeric(looptier::Builder & /*builder*/) { return false; }
+};
+
+/**
+ * @class ConstantFolder
+ * @brief Simplification pass run over each line after parsing
+ *
+ * Replaces subtrees whose operands are all constants (arithmetic, relational
+ * and logical operators, NOT, unary minus, and pure builtins such as SIN,
+ * INT, LEN, CHR$ and STR$) with a single literal. The value is computed by
+ * the node's own evaluate(), so it is bit-identical to what the line would
+ * compute at run time. Subtrees whose evaluation raises an error (1/0,
+ * CHR$(300), ...) are kept so the error still happens when the line runs.
+ *
+ * It also drops unary plus and the identities X+0, 0+X, X-0, X*1, 1*X and
+ * X/1 when X is already Float40-rounded (so removing the operation cannot
+ * change a bit).
+ */
+class ConstantFolder {
+public:
+  /** @param arena Arena that receives the literals built by the pass */
+  explicit ConstantFolder(AstArena &arena) : arena_(arena) {}
+
+  /** @brief Fold an expression in place (null pointers are ignored) */
+  void fold(Expression *&expr);
+
+  /** @brief Fold each expression of a list in place */
+  void fold(std::vector<Expression *> &exprs);
+
+  /** @brief Fold the expressions of each statement */
+  void fold(std::vector<Statement *> &statements);
+
+  /**
+   * @brief Evaluate a constant node into a literal
+   * @param expr Node whose operands are all constants
+   * @param removed Nodes saved if the replacement succeeds
+   * @return The literal, or nullptr if evaluation raised an error
+   */
+  Expression *evaluateConstant(Expression &expr, size_t removed);
+
+  /**
+   * @brief Replace a node by one of its operands
+   * @param operand Node that takes the folded node's place
+   * @param removed Nodes saved by the replacement
+   * @return @p operand
+   */
+  Expression *replaceWith(Expression *operand, size_t removed);
+
+  /** @brief Total number of AST nodes removed so far */
+  size_t removedNodes() const { return removed_; }
+
+private:
+  AstArena &arena_;
+  size_t removed_ = 0;
+};
+
+/**
+ * @brief Statement shapes the parser fuses into single nodes
+ *
+ * Each fused node performs the whole statement in one execute() call,
+ * reading and writing symbol slots directly instead of evaluating a tree of
+ * expression nodes.
+ */
+enum class Superinstruction : uint8_t {
+  Increment,      ///< V = V + c, V = V - c or V = c + V (numeric V)
+  IfGoto,         ///< IF cond THEN n / IF cond THEN GOTO n without ELSE
+  IfArrayCompare, ///< IF A(I) op B(J) THEN ... (relational op)
+  PrintVariable,  ///< PRINT V with at most one trailing separator
+  PokeConstant,   ///< POKE c, expr with a constant address
+  Count
 };
 
+/**
+ * @class SuperinstructionStats
+ * @brief Per-shape counters of how often fused statements executed
+ */
+class SuperinstructionStats {
+public:
+  static constexpr size_t kKinds =
+      static_cast<size_t>(Superinstruction::Count);
+
+  /** @brief Record one execution of a fused statement */
+  void fired(Superinstruction kind) {
+    ++counts_[static_cast<size_t>(kind)];
+  }
+
+  /** @brief Executions recorded for @p kind */
+  uint64_t count(Superinstruction kind) const {
+    return counts_[static_cast<size_t>(kind)];
+  }
+
+  /** @brief Display name of @p kind (for statistics output) */
+  static const char *name(Superinstruction kind);
+
+private:
+  std::array<uint64_t, kKinds> counts_{};
+};
+
+/** @brief Process-wide superinstruction counters */
+SuperinstructionStats &superinstructionStats();
+
 /**
  * @class Parser
  * @brief Recursive descent parser for BASIC syntax
@@ -106,9 +342,11 @@ public:
  *
  * Usage:
  * @code
- * Parser parser;
- * std::vector<Token> tokens = tokenizer.tokenize(line);
- * auto statements = parser.parse(tokens);
+ * AstArena arena;
+ * Parser parser(arena);
+ * std::vector<Value> constants;
+ * std::vector<Token> tokens = tokenizer.tokenize(line, constants);
+ * auto statements = parser.parse(tokens, line, constants);
  * for (auto& stmt : statements) {
  *     stmt->execute(interpreter);
  * }
@@ -121,8 +359,9 @@ class Parser {
 public:
   /**
    * @brief Construct a new Parser
+   * @param arena Arena that owns every node the parser creates
    */
-  Parser();
+  explicit Parser(AstArena &arena);
 
   /**
    * @brief Parse a line of tokens into statements
@@ -131,160 +370,134 @@ public:
    * Supports multiple statements per line (colon-separated).
    *
    * @param tokens The token sequence to parse
-   * @return std::vector<std::shared_ptr<Statement>> The parsed statements
+   * @param source The text @p tokens were made from (names are read from
+   * it)
+   * @param constants The constant pool of @p tokens (literal values)
+   * @return std::vector<Statement*> The parsed statements (owned by the
+   * parser's arena)
    * @throws std::runtime_error On syntax errors
    */
-  std::vector<std::shared_ptr<Statement>>
-  parse(const std::vector<Token> &tokens);
+  std::vector<Statement *> parse(const std::vector<Token> &tokens,
+                                 std::string_view source,
+                                 const std::vector<Value> &constants);
 
   /**
    * @brief Parse an expression from tokens
    *
    * Entry point for expression parsing. Parses a complete expression
-   * starting at the given position.
+   * starting at the given position. Only valid during parse(), which
+   * provides the tokens' source text and constants.
    *
    * @param tokens The token sequence
    * @param pos Current position in tokens (updated on return)
-   * @return std::shared_ptr<Expression> The parsed expression AST
+   * @return Expression* The parsed expression AST
    * @throws std::runtime_error On syntax errors
    */
-  std::shared_ptr<Expression> parseExpression(const std::vector<Token> &tokens,
-                                              size_t &pos);
-
-private:
-  // Expression parsing methods (in order of precedence, lowest to highest)
-
-  /** @brief Parse OR expression (lowest precedence) */
-  std::shared_ptr<Expression>
-  parseOrExpression(const std::vector<Token> &tokens, size_t &pos);
+  Expression *parseExpression(const std::vector<Token> &tokens, size_t &pos);
 
-  /** @brief Parse AND expression */
-  std::shared_ptr<Expression>
-  parseAndExpression(const std::vector<Token> &tokens, size_t &pos);
-
-  /** @brief Parse NOT expression */
-  std::shared_ptr<Expression>
-  parseNotExpression(const std::vector<Token> &tokens, size_t &pos);
-
-  /** @brief Parse relational expression (=, <>, <, >, <=, >=) */
-  std::shared_ptr<Expression>
-  parseRelationalExpression(const std::vector<Token> &tokens, size_t &pos);
+  /**
+   * @brief Enable or disable the constant-folding pass (on by default)
+   *
+   * Disabling it leaves the AST exactly as parsed, for differential testing.
+   */
+  void setConstantFolding(bool enabled) { foldConstants_ = enabled; }
 
-  /** @brief Parse additive expression (+, -) */
-  std::shared_ptr<Expression>
-  parseAdditiveExpression(const std::vector<Token> &tokens, size_t &pos);
+  /** @brief Number of AST nodes removed by constant folding so far */
+  size_t foldedNodes() const { return folder_.removedNodes(); }
 
-  /** @brief Parse multiplicative expression (*, /, MOD) */
-  std::shared_ptr<Expression>
-  parseMultiplicativeExpression(const std::vector<Token> &tokens, size_t &pos);
+  /**
+   * @brief Enable or disable superinstruction fusion (on by default)
+   *
+   * Disabling it leaves hot statement shapes as generic nodes, for
+   * differential testing.
+   */
+  void setSuperinstructions(bool enabled) { superinstructions_ = enabled; }
 
-  /** @brief Parse unary expression (+, -, NOT) */
-  std::shared_ptr<Expression>
-  parseUnaryExpression(const std::vector<Token> &tokens, size_t &pos);
+private:
+  // Expression parsing methods
 
-  /** @brief Parse power expression (^) */
-  std::shared_ptr<Expression>
-  parsePowerExpression(const std::vector<Token> &tokens, size_t &pos);
+  /** @brief Parse operators of precedence @p level and above (see the
+   * table in parser.cpp) */
+  Expression *parseSubexpression(const std::vector<Token> &tokens,
+                                 size_t &pos, uint8_t level);
 
   /** @brief Parse primary expression (literals, variables, functions,
    * parentheses) */
-  std::shared_ptr<Expression>
-  parsePrimaryExpression(const std::vector<Token> &tokens, size_t &pos);
+  Expression *parsePrimaryExpression(const std::vector<Token> &tokens,
+                                     size_t &pos);
 
   // Statement parsing methods
 
   /** @brief Parse any statement based on leading keyword */
-  std::shared_ptr<Statement> parseStatement(const std::vector<Token> &tokens,
-                                            size_t &pos);
+  Statement *parseStatement(const std::vector<Token> &tokens, size_t &pos);
 
   /** @brief Parse PRINT statement */
-  std::shared_ptr<Statement> parsePrint(const std::vector<Token> &tokens,
-                                        size_t &pos);
+  Statement *parsePrint(const std::vector<Token> &tokens, size_t &pos);
 
   /** @brief Parse INPUT statement */
-  std::shared_ptr<Statement> parseInput(const std::vector<Token> &tokens,
-                                        size_t &pos);
+  Statement *parseInput(const std::vector<Token> &tokens, size_t &pos);
 
   /** @brief Parse LET or implicit assignment statement */
-  std::shared_ptr<Statement>
-  parseLetOrAssignment(const std::vector<Token> &tokens, size_t &pos);
+  Statement *parseLetOrAssignment(const std::vector<Token> &tokens,
+                                  size_t &pos);
 
   /** @brief Parse IF...THEN...ELSE statement */
-  std::shared_ptr<Statement> parseIf(const std::vector<Token> &tokens,
-                                     size_t &pos);
+  Statement *parseIf(const std::vector<Token> &tokens, size_t &pos);
 
   /** @brief Parse GOTO statement */
-  std::shared_ptr<Statement> parseGoto(const std::vector<Token> &tokens,
-                                       size_t &pos);
+  Statement *parseGoto(const std::vector<Token> &tokens, size_t &pos);
 
   /** @brief Parse GOSUB statement */
-  std::shared_ptr<Statement> parseGosub(const std::vector<Token> &tokens,
-                                        size_t &pos);
+  Statement *parseGosub(const std::vector<Token> &tokens, size_t &pos);
 
   /** @brief Parse FOR statement */
-  std::shared_ptr<Statement> parseFor(const std::vector<Token> &tokens,
-                                      size_t &pos);
+  Statement *parseFor(const std::vector<Token> &tokens, size_t &pos);
 
   /** @brief Parse NEXT statement */
-  std::shared_ptr<Statement> parseNext(const std::vector<Token> &tokens,
-                                       size_t &pos);
+  Statement *parseNext(const std::vector<Token> &tokens, size_t &pos);
 
   /** @brief Parse DIM statement */
-  std::shared_ptr<Statement> parseDim(const std::vector<Token> &tokens,
-                                      size_t &pos);
+  Statement *parseDim(const std::vector<Token> &tokens, size_t &pos);
 
   /** @brief Parse DATA statement */
-  std::shared_ptr<Statement> parseData(const std::vector<Token> &tokens,
-                                       size_t &pos);
+  Statement *parseData(const std::vector<Token> &tokens, size_t &pos);
 
   /** @brief Parse READ statement */
-  std::shared_ptr<Statement> parseRead(const std::vector<Token> &tokens,
-                                       size_t &pos);
+  Statement *parseRead(const std::vector<Token> &tokens, size_t &pos);
 
   /** @brief Parse DEF FN statement */
-  std::shared_ptr<Statement> parseDef(const std::vector<Token> &tokens,
-                                      size_t &pos);
+  Statement *parseDef(const std::vector<Token> &tokens, size_t &pos);
 
   /** @brief Parse ONERR GOTO statement */
-  std::shared_ptr<Statement> parseOnErr(const std::vector<Token> &tokens,
-                                        size_t &pos);
+  Statement *parseOnErr(const std::vector<Token> &tokens, size_t &pos);
 
   /** @brief Parse ON...GOTO/GOSUB statement */
-  std::shared_ptr<Statement> parseOn(const std::vector<Token> &tokens,
-                                     size_t &pos);
+  Statement *parseOn(const std::vector<Token> &tokens, size_t &pos);
 
   /** @brief Parse RANDOMIZE statement */
-  std::shared_ptr<Statement> parseRandomize(const std::vector<Token> &tokens,
-                                            size_t &pos);
+  Statement *parseRandomize(const std::vector<Token> &tokens, size_t &pos);
 
   /** @brief Parse SPEED statement */
-  std::shared_ptr<Statement> parseSpeed(const std::vector<Token> &tokens,
-                                        size_t &pos);
+  Statement *parseSpeed(const std::vector<Token> &tokens, size_t &pos);
 
   /** @brief Parse PR# or IN# device redirection statement */
-  std::shared_ptr<Statement>
-  parseDeviceRedirect(const std::vector<Token> &tokens, size_t &pos,
-                      bool isOutput);
+  Statement *parseDeviceRedirect(const std::vector<Token> &tokens, size_t &pos,
+                                 bool isOutput);
 
   /** @brief Parse WHILE statement */
-  std::shared_ptr<Statement> parseWhile(const std::vector<Token> &tokens,
-                                        size_t &pos);
+  Statement *parseWhile(const std::vector<Token> &tokens, size_t &pos);
 
   /** @brief Parse WAIT statement */
-  std::shared_ptr<Statement> parseWait(const std::vector<Token> &tokens,
-                                       size_t &pos);
+  Statement *parseWait(const std::vector<Token> &tokens, size_t &pos);
 
   /** @brief Parse HIMEM statement */
-  std::shared_ptr<Statement> parseHimem(const std::vector<Token> &tokens,
-                                        size_t &pos);
+  Statement *parseHimem(const std::vector<Token> &tokens, size_t &pos);
 
   /** @brief Parse LOMEM statement */
-  std::shared_ptr<Statement> parseLomem(const std::vector<Token> &tokens,
-                                        size_t &pos);
+  Statement *parseLomem(const std::vector<Token> &tokens, size_t &pos);
 
   /** @brief Parse SHLOAD statement */
-  std::shared_ptr<Statement> parseShload(const std::vector<Token> &tokens,
-                                         size_t &pos);
+  Statement *parseShload(const std::vector<Token> &tokens, size_t &pos);
 
   // Helper methods
 
@@ -305,4 +518,31 @@ private:
    * @return true if at end, false otherwise
    */
   bool isAtEnd(const std::vector<Token> &tokens, size_t pos) const;
+
+  /** @brief Text of a token of the line being parsed */
+  std::string_view text(const Token &token) const {
+    return token.text(source_);
+  }
+
+  /** @brief Value of a literal token of the line being parsed */
+  const Value &value(const Token &token) const {
+    return token.value(*constants_);
+  }
+
+  /** @brief Owner of the parsed nodes */
+  AstArena &arena_;
+  /** @brief Run the constant folder over parsed lines */
+  bool foldConstants_ = true;
+  /** @brief Folding pass (accumulates the removed-node count) */
+  ConstantFolder folder_;
+  /** @brief Replace hot statement shapes by fused nodes */
+  bool superinstructions_ = true;
+  /** @brief Parameter of the DEF FN body being parsed */
+  std::optional<SymbolId> parameter_;
+  /** @brief User function calls parsed so far (see parseDef) */
+  size_t userCalls_ = 0;
+  /** @brief Text of the line being parsed */
+  std::string_view source_;
+  /** @brief Constant pool of the line being parsed */
+  const std::vector<Value> *constants_ = nullptr;
 };
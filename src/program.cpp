@@ -0,0 +1,116 @@
+/**
+ * @file program.cpp
+ * @brief Implementation of the contiguous program image
+ */
+
+#include "program.h"
+#include <algorithm>
+
+Program::Program()
+    : index_(kMaxDirectLine + 1, -1),
+      arenas_{std::make_shared<AstArena>()} {}
+
+/**
+ * @brief Add or replace a program line
+ *
+ * Replacing an existing line keeps every position unchanged. Appending past
+ * the last line only writes one table entry; inserting in the middle shifts
+ * the following lines and re-patches their entries.
+ */
+void Program::insert(ProgramLine line) {
+  LineNumber lineNum = line.lineNumber;
+  size_t existing = indexOf(lineNum);
+  ++epoch_;
+  if (existing != npos) {
+    lines_[existing] = std::move(line);
+    return;
+  }
+
+  size_t pos = lines_.empty() || lines_.back().lineNumber < lineNum
+                   ? lines_.size()
+                   : lowerBound(lineNum);
+  lines_.insert(lines_.begin() + static_cast<std::ptrdiff_t>(pos),
+                std::move(line));
+  reindexFrom(pos);
+}
+
+/**
+ * @brief Delete a program line
+ *
+ * Clears the line's table entry and re-patches the entries of the lines that
+ * moved down.
+ */
+bool Program::erase(LineNumber lineNum) {
+  size_t pos = indexOf(lineNum);
+  if (pos == npos) {
+    return false;
+  }
+  ++epoch_;
+  if (isDirect(lineNum)) {
+    index_[static_cast<size_t>(lineNum)] = -1;
+  }
+  lines_.erase(lines_.begin() + static_cast<std::ptrdiff_t>(pos));
+  reindexFrom(pos);
+  return true;
+}
+
+void Program::clear() {
+  ++epoch_;
+  for (const auto &line : lines_) {
+    if (isDirect(line.lineNumber)) {
+      index_[static_cast<size_t>(line.lineNumber)] = -1;
+    }
+  }
+  lines_.clear();
+  arenas_.assign(1, std::make_shared<AstArena>());
+}
+
+void Program::adoptArena(std::shared_ptr<AstArena> arena) {
+  arenas_.push_back(std::move(arena));
+}
+
+bool Program::ownsArena(const AstArena *arena) const {
+  for (const auto &owned : arenas_) {
+    if (owned.get() == arena) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t Program::indexOf(LineNumber lineNum) const {
+  if (isDirect(lineNum)) {
+    int32_t pos = index_[static_cast<size_t>(lineNum)];
+    return pos < 0 ? npos : static_cast<size_t>(pos);
+  }
+  size_t pos = lowerBound(lineNum);
+  if (pos < lines_.size() && lines_[pos].lineNumber == lineNum) {
+    return pos;
+  }
+  return npos;
+}
+
+size_t Program::resolve(LineRef &ref) const {
+  if (ref.epoch != epoch_) {
+    ref.index = indexOf(ref.line);
+    ref.epoch = epoch_;
+  }
+  return ref.index;
+}
+
+size_t Program::lowerBound(LineNumber lineNum) const {
+  auto it = std::lower_bound(lines_.begin(), lines_.end(), lineNum,
+                             [](const ProgramLine &line, LineNumber n) {
+                               return line.lineNumber < n;
+                             });
+  return static_cast<size_t>(it - lines_.begin());
+}
+
+void Program::reindexFrom(size_t from) {
+  for (size_t i = from; i < lines_.size(); ++i) {
+    if (isDirect(lines_[i].lineNumber)) {
+      index_[static_cast<size_t>(lines_[i].lineNumber)] =
+          static_cast<int32_t>(i);
+    }
+  }
+}
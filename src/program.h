@@ -0,0 +1,157 @@
+/**
+ * @file program.h
+ * @brief Contiguous program image with constant-time line-number lookup
+ *
+ * The Program class stores the lines of a BASIC program in a single vector
+ * sorted by line number, plus a dense table that maps every valid line number
+ * (0-32767) to its position in that vector. The interpreter's program counter
+ * is a plain index into the vector, so sequential execution walks memory in
+ * order and every GOTO/GOSUB/RETURN/NEXT target resolves with one array read.
+ *
+ * Edits keep both structures consistent:
+ * - Appending a line past the end (the LOAD case) is O(1)
+ * - Inserting or deleting in the middle shifts the following lines and
+ *   patches their table entries
+ *
+ * Line numbers outside the table range are still accepted and are located by
+ * binary search, preserving the behavior of the former std::map storage.
+ *
+ * GOTO/GOSUB/ON targets are held as LineRef values that cache the resolved
+ * index together with the program's edit epoch. Every edit bumps the epoch,
+ * so a reference is re-resolved (one table read) only the first time it is
+ * used after the program changed.
+ *
+ * The statements of loaded lines are allocated in AstArenas owned by the
+ * program: the main arena, plus one per worker of a parallel LOAD that the
+ * program adopts. clear() releases them as a whole; the nodes of replaced or
+ * deleted loaded lines stay in their arena until then. A line entered in
+ * the editor carries its own arena (ProgramLine::arena), which goes away
+ * with the line.
+ */
+
+#pragma once
+
+#include "ast_arena.h"
+#include "types.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct LineRef;
+
+/**
+ * @class Program
+ * @brief Program lines in line-number order with O(1) lookup by number
+ */
+class Program {
+public:
+  /** @brief Returned by indexOf() when a line does not exist */
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  /** @brief Number of line numbers covered by the direct lookup table */
+  static constexpr LineNumber kMaxDirectLine = 32767;
+
+  Program();
+
+  /**
+   * @brief Add a line, replacing any existing line with the same number
+   * @param line Parsed program line (moved into the image)
+   */
+  void insert(ProgramLine line);
+
+  /**
+   * @brief Remove a line if present
+   * @param lineNum Line number to delete
+   * @return true if a line was removed
+   */
+  bool erase(LineNumber lineNum);
+
+  /** @brief Remove all lines and start a new arena */
+  void clear();
+
+  /**
+   * @brief Main arena, where lines parsed by the interpreter are allocated
+   *
+   * Shared so that code which must outlive the program (a DEF FN body kept
+   * across CHAIN) can keep the nodes alive.
+   */
+  const std::shared_ptr<AstArena> &arena() const { return arenas_.front(); }
+
+  /**
+   * @brief Keep an arena alive until the next clear()
+   * @param arena Arena holding the statements of lines inserted from it
+   */
+  void adoptArena(std::shared_ptr<AstArena> arena);
+
+  /** @brief true if @p arena is the main arena or an adopted one */
+  bool ownsArena(const AstArena *arena) const;
+
+  /** @brief All arenas of the program, main arena first */
+  const std::vector<std::shared_ptr<AstArena>> &arenas() const {
+    return arenas_;
+  }
+
+  bool empty() const { return lines_.empty(); }
+  size_t size() const { return lines_.size(); }
+
+  /**
+   * @brief Find the position of a line
+   * @param lineNum Line number to look up
+   * @return Index into the image, or npos if the line does not exist
+   */
+  size_t indexOf(LineNumber lineNum) const;
+
+  /**
+   * @brief Resolve a jump target, reusing its cached index when still valid
+   * @param ref Target reference (its cache is refreshed if stale)
+   * @return Index into the image, or npos if the line does not exist
+   */
+  size_t resolve(LineRef &ref) const;
+
+  /** @brief Edit counter, incremented by every insert/erase/clear */
+  uint64_t epoch() const { return epoch_; }
+
+  ProgramLine &operator[](size_t index) { return lines_[index]; }
+  const ProgramLine &operator[](size_t index) const { return lines_[index]; }
+
+  std::vector<ProgramLine>::iterator begin() { return lines_.begin(); }
+  std::vector<ProgramLine>::iterator end() { return lines_.end(); }
+  std::vector<ProgramLine>::const_iterator begin() const {
+    return lines_.begin();
+  }
+  std::vector<ProgramLine>::const_iterator end() const { return lines_.end(); }
+
+private:
+  /** @brief Binary search for the first line numbered >= lineNum */
+  size_t lowerBound(LineNumber lineNum) const;
+
+  /** @brief Refresh table entries for lines at positions >= from */
+  void reindexFrom(size_t from);
+
+  static bool isDirect(LineNumber lineNum) {
+    return lineNum >= 0 && lineNum <= kMaxDirectLine;
+  }
+
+  std::vector<ProgramLine> lines_;
+  std::vector<int32_t> index_; // line number -> position, -1 when absent
+  uint64_t epoch_ = 1;         // 0 is never current, so new refs are stale
+  std::vector<std::shared_ptr<AstArena>> arenas_;
+};
+
+/**
+ * @struct LineRef
+ * @brief Linked reference to a target line (GOTO, GOSUB, ON...GOTO/GOSUB)
+ *
+ * Holds the target line number from the source plus the image index it
+ * resolved to at a given program epoch. A missing target resolves to
+ * Program::npos, so UNDEF'D STATEMENT ERROR is still raised when the jump
+ * executes, not when it is linked.
+ */
+struct LineRef {
+  explicit LineRef(LineNumber target) : line(target) {}
+
+  LineNumber line;
+  size_t index = Program::npos;
+  uint64_t epoch = 0;
+};
@@ -0,0 +1,338 @@
+/**
+ * @file program_cache.cpp
+ * @brief Implementation of the tokenized program cache
+ *
+ * File layout (native byte order, checked through a marker word):
+ *
+ *   header:  "MSBC", byte-order marker, format version, token type count,
+ *            interpreter version string, source length, source hash,
+ *            line count, payload length, payload checksum
+ *   payload: per line: line number, text, constant count, the constants
+ *            (kind, then number or string), token count, the tokens
+ *            (type, flags, offset, length, constant index)
+ *
+ * Strings are stored as a 32-bit length followed by their bytes.
+ */
+
+#include "program_cache.h"
+#include "filesystem.h"
+#include "program.h"
+#include "tokenizer.h"
+#include "version.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <random>
+#include <type_traits>
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr char kMagic[4] = {'M', 'S', 'B', 'C'};
+constexpr uint32_t kByteOrderMarker = 0x01020304;
+
+/** @brief Bump when the payload layout changes */
+constexpr uint32_t kFormatVersion = 3;
+
+/** @brief Number of TokenType values (PDL is the last enumerator) */
+constexpr uint32_t kTokenTypeCount =
+    static_cast<uint32_t>(TokenType::PDL) + 1;
+
+/** @brief How a constant is stored (Default: the 0 of Value()) */
+enum class CachedValue : uint8_t { Default, Number, String };
+
+/** @brief Appends fixed-size fields and strings to a byte buffer */
+class CacheWriter {
+public:
+  template <typename T> void put(T value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out_.append(bytes, sizeof(T));
+  }
+
+  void putString(std::string_view text) {
+    put(static_cast<uint32_t>(text.size()));
+    out_.append(text);
+  }
+
+  std::string &buffer() { return out_; }
+
+private:
+  std::string out_;
+};
+
+/**
+ * @brief Reads fields back; any read past the end marks the reader failed
+ */
+class CacheReader {
+public:
+  explicit CacheReader(std::string_view data) : data_(data) {}
+
+  template <typename T> T get() {
+    T value{};
+    if (!ok_ || data_.size() - pos_ < sizeof(T)) {
+      ok_ = false;
+      return value;
+    }
+    std::memcpy(&value, data_.data() + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return value;
+  }
+
+  std::string_view getBytes(size_t size) {
+    if (!ok_ || data_.size() - pos_ < size) {
+      ok_ = false;
+      return {};
+    }
+    std::string_view bytes = data_.substr(pos_, size);
+    pos_ += size;
+    return bytes;
+  }
+
+  std::string_view getString() { return getBytes(get<uint32_t>()); }
+
+  bool ok() const { return ok_; }
+  bool atEnd() const { return pos_ == data_.size(); }
+
+private:
+  std::string_view data_;
+  size_t pos_ = 0;
+  bool ok_ = true;
+};
+
+/** @brief Directory holding the cache files, empty if none is configured */
+fs::path cacheDirectory() {
+  if (const char *dir = std::getenv("MSBASIC_CACHE_DIR"); dir && *dir) {
+    return fs::path(dir);
+  }
+#ifdef PLATFORM_WINDOWS
+  if (const char *local = std::getenv("LOCALAPPDATA"); local && *local) {
+    return fs::path(local) / "msbasic";
+  }
+#else
+  if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+    return fs::path(xdg) / "msbasic";
+  }
+  if (const char *home = std::getenv("HOME"); home && *home) {
+    return fs::path(home) / ".cache" / "msbasic";
+  }
+#endif
+  return {};
+}
+
+/** @brief Header fields that must match the current source and build */
+void putStamp(CacheWriter &out, std::string_view source) {
+  out.buffer().append(kMagic, sizeof(kMagic));
+  out.put(kByteOrderMarker);
+  out.put(kFormatVersion);
+  out.put(kTokenTypeCount);
+  out.putString(msbasic::kVersion);
+  out.put(static_cast<uint64_t>(source.size()));
+  out.put(hashProgramSource(source));
+}
+
+bool stampMatches(CacheReader &in, std::string_view source) {
+  std::string_view magic = in.getBytes(sizeof(kMagic));
+  return in.ok() && magic == std::string_view(kMagic, sizeof(kMagic)) &&
+         in.get<uint32_t>() == kByteOrderMarker &&
+         in.get<uint32_t>() == kFormatVersion &&
+         in.get<uint32_t>() == kTokenTypeCount &&
+         in.getString() == msbasic::kVersion &&
+         in.get<uint64_t>() == source.size() &&
+         in.get<uint64_t>() == hashProgramSource(source) && in.ok();
+}
+} // namespace
+
+uint64_t hashProgramSource(std::string_view source) {
+  // FNV-1a, eight bytes per step: hashing the source and checking the
+  // payload stay a small fraction of a cached load
+  constexpr uint64_t kPrime = 0x100000001b3ULL;
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  size_t pos = 0;
+  for (; pos + sizeof(uint64_t) <= source.size(); pos += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, source.data() + pos, sizeof(word));
+    hash = (hash ^ word) * kPrime;
+    hash ^= hash >> 32;
+  }
+  for (; pos < source.size(); ++pos) {
+    hash = (hash ^ static_cast<unsigned char>(source[pos])) * kPrime;
+  }
+  return hash;
+}
+
+std::string programCachePath(const std::string &sourceFile) {
+  fs::path dir = cacheDirectory();
+  if (dir.empty()) {
+    return {};
+  }
+  std::error_code ec;
+  fs::path source = fs::weakly_canonical(fs::absolute(sourceFile, ec), ec);
+  if (ec) {
+    return {};
+  }
+  char name[24];
+  std::snprintf(name, sizeof(name), "%016llx.msbc",
+                static_cast<unsigned long long>(
+                    hashProgramSource(source.string())));
+  return (dir / name).string();
+}
+
+bool readProgramCache(const std::string &cacheFile, std::string_view source,
+                      std::vector<ProgramLine> &lines) {
+  std::error_code ec;
+  if (!fs::is_regular_file(cacheFile, ec)) {
+    return false;
+  }
+  std::optional<MappedFile> file;
+  try {
+    file.emplace(cacheFile);
+  } catch (const std::exception &) {
+    return false;
+  }
+  CacheReader in(file->data());
+  if (!stampMatches(in, source)) {
+    return false;
+  }
+  uint32_t lineCount = in.get<uint32_t>();
+  uint64_t payloadSize = in.get<uint64_t>();
+  uint64_t payloadHash = in.get<uint64_t>();
+  std::string_view payload = in.getBytes(payloadSize);
+  if (!in.ok() || !in.atEnd() || hashProgramSource(payload) != payloadHash ||
+      lineCount > payload.size()) {
+    return false;
+  }
+
+  CacheReader body(payload);
+  std::vector<ProgramLine> result;
+  result.reserve(lineCount);
+  for (uint32_t i = 0; i < lineCount && body.ok(); ++i) {
+    ProgramLine line;
+    line.lineNumber = body.get<LineNumber>();
+    line.text = body.getString();
+    uint32_t constantCount = body.get<uint32_t>();
+    if (constantCount > payload.size()) {
+      return false;
+    }
+    line.constants.reserve(constantCount);
+    for (uint32_t c = 0; c < constantCount && body.ok(); ++c) {
+      auto kind = static_cast<CachedValue>(body.get<uint8_t>());
+      if (kind == CachedValue::Default) {
+        line.constants.emplace_back();
+      } else if (kind == CachedValue::Number) {
+        line.constants.emplace_back(body.get<double>());
+      } else if (kind == CachedValue::String) {
+        line.constants.emplace_back(body.getString());
+      } else {
+        return false;
+      }
+    }
+    uint32_t tokenCount = body.get<uint32_t>();
+    if (tokenCount > payload.size()) {
+      return false;
+    }
+    line.tokens.reserve(tokenCount);
+    for (uint32_t t = 0; t < tokenCount && body.ok(); ++t) {
+      Token token;
+      uint8_t type = body.get<uint8_t>();
+      if (type >= kTokenTypeCount) {
+        return false;
+      }
+      token.type = static_cast<TokenType>(type);
+      token.flags = body.get<uint8_t>();
+      token.offset = body.get<uint32_t>();
+      token.length = body.get<uint32_t>();
+      token.constant = body.get<uint32_t>();
+      if (token.offset > line.text.size() ||
+          token.length > line.text.size() - token.offset ||
+          ((token.flags & Token::kConstant) &&
+           token.constant >= line.constants.size())) {
+        return false;
+      }
+      line.tokens.push_back(token);
+    }
+    result.push_back(std::move(line));
+  }
+  if (!body.ok() || !body.atEnd()) {
+    return false;
+  }
+  lines = std::move(result);
+  return true;
+}
+
+void writeProgramCache(const std::string &cacheFile, std::string_view source,
+                       const Program &program) {
+  static_assert(kTokenTypeCount <= 256, "token types must fit in a byte");
+  CacheWriter body;
+  Tokenizer tokenizer;
+  std::vector<Token> retokenized;
+  std::vector<Value> reconstants;
+  for (const auto &line : program) {
+    const std::vector<Token> *tokens = &line.tokens;
+    const std::vector<Value> *constants = &line.constants;
+    if (tokens->empty()) {
+      // Dropped after parsing (see Interpreter::setDropTokens())
+      reconstants.clear();
+      retokenized = tokenizer.tokenize(line.text, reconstants);
+      tokens = &retokenized;
+      constants = &reconstants;
+    }
+    body.put(static_cast<LineNumber>(line.lineNumber));
+    body.putString(line.text);
+    body.put(static_cast<uint32_t>(constants->size()));
+    for (const auto &value : *constants) {
+      if (value.isNumber() && value.getNumber() == 0.0 &&
+          !std::signbit(value.getNumber())) {
+        body.put(CachedValue::Default);
+      } else if (value.isNumber()) {
+        body.put(CachedValue::Number);
+        body.put(value.getNumber());
+      } else {
+        body.put(CachedValue::String);
+        body.putString(value.stringView());
+      }
+    }
+    body.put(static_cast<uint32_t>(tokens->size()));
+    for (const auto &token : *tokens) {
+      body.put(static_cast<uint8_t>(token.type));
+      body.put(token.flags);
+      body.put(token.offset);
+      body.put(token.length);
+      body.put(token.constant);
+    }
+  }
+
+  CacheWriter out;
+  putStamp(out, source);
+  out.put(static_cast<uint32_t>(program.size()));
+  out.put(static_cast<uint64_t>(body.buffer().size()));
+  out.put(hashProgramSource(body.buffer()));
+  out.buffer().append(body.buffer());
+
+  std::error_code ec;
+  fs::path target(cacheFile);
+  fs::create_directories(target.parent_path(), ec);
+  char suffix[24];
+  std::snprintf(suffix, sizeof(suffix), ".%08x.tmp",
+                static_cast<unsigned>(std::random_device{}()));
+  fs::path temp = target;
+  temp += suffix;
+  {
+    std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+    if (!file.write(out.buffer().data(),
+                    static_cast<std::streamsize>(out.buffer().size()))) {
+      file.close();
+      fs::remove(temp, ec);
+      return;
+    }
+  }
+  fs::rename(temp, target, ec);
+  if (ec) {
+    fs::remove(temp, ec);
+  }
+}
@@ -0,0 +1,77 @@
+/**
+ * @file program_cache.h
+ * @brief On-disk cache of tokenized programs
+ *
+ * LOAD, CHAIN and "-" store the tokenized form of every program they load
+ * in a cache directory, one file per source path. The next load of the
+ * same, unchanged source maps the cache file into memory and rebuilds the
+ * program lines from it instead of tokenizing the text again.
+ *
+ * The cache holds each line's number, text, tokens and constants, the
+ * parser's input. Parsed statements are not stored: AST nodes point into
+ * arenas and are specialized by the current folding and fusion settings,
+ * so they are rebuilt from the cached tokens.
+ *
+ * A cache file is used only if all of these match:
+ * - the magic number and the cache format version
+ * - the interpreter version and the size of the token table
+ * - the length and the 64-bit hash of the current source text
+ * - the checksum of the payload (catches truncated or damaged files)
+ * Anything else is treated as a miss: the source is loaded normally and
+ * the cache file is written again.
+ *
+ * The cache directory is $MSBASIC_CACHE_DIR if set, else
+ * $XDG_CACHE_HOME/msbasic or ~/.cache/msbasic (%LOCALAPPDATA%\\msbasic on
+ * Windows). Files are written to a temporary name and renamed into place,
+ * so concurrent runs of the same program never see a partial file.
+ */
+
+#pragma once
+
+#include "types.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Program;
+
+/**
+ * @brief 64-bit FNV-1a hash of a source text
+ */
+uint64_t hashProgramSource(std::string_view source);
+
+/**
+ * @brief Cache file for a program source file
+ * @param sourceFile Path of the program as given to LOAD/CHAIN
+ * @return Path of its cache file, or an empty string when no cache
+ *         directory is available
+ */
+std::string programCachePath(const std::string &sourceFile);
+
+/**
+ * @brief Read the tokenized lines of a program from its cache file
+ *
+ * The returned lines have their number, text and tokens set; they still
+ * have to be parsed.
+ *
+ * @param cacheFile Path returned by programCachePath()
+ * @param source Current text of the program source
+ * @param lines Receives the lines in program order
+ * @return false if the file is missing, stale or damaged
+ */
+bool readProgramCache(const std::string &cacheFile, std::string_view source,
+                      std::vector<ProgramLine> &lines);
+
+/**
+ * @brief Write the cache file of a freshly loaded program
+ *
+ * All lines of @p program must be tokenized. Errors (no cache directory,
+ * disk full, ...) are ignored: the cache is only an optimization.
+ *
+ * @param cacheFile Path returned by programCachePath()
+ * @param source Text the program was loaded from
+ * @param program Loaded program
+ */
+void writeProgramCache(const std::string &cacheFile, std::string_view source,
+                       const Program &program);
@@ -13,40 +13,294 @@
  * - Delimiters (parentheses, commas, colons, semicolons)
  *
  * Special features:
- * - Case-insensitive keyword matching
+ * - Case-insensitive keyword matching through a perfect hash table built
+ *   at compile time
  * - Support for ? as PRINT shorthand
  * - String literals with quote delimiters
  * - Multi-character operators (<=, >=, <>)
  * - Line continuation handling
+ *
+ * The tokenizer reads the line through a view and never copies it: tokens
+ * record where their text is, and only string literals copy their
+ * characters, into the line's constant pool. String literals and REM text are
+ * skipped with memchr rather than a character at a time.
  */
 
 #include "tokenizer.h"
-#include <algorithm>
+#include <array>
 #include <cctype>
-#include <map>
+#include <charconv>
+#include <cstring>
+#include <iterator>
+#include <string>
+
+namespace {
+/** @brief A keyword and the token it produces */
+struct Keyword {
+  std::string_view name;
+  TokenType type;
+};
+
+/**
+ * @brief All keywords, in upper case
+ *
+ * Commands (PRINT, INPUT, LIST, RUN, NEW), control flow (IF, THEN, ELSE,
+ * FOR, NEXT, GOTO, GOSUB), data keywords (DATA, READ, RESTORE, DIM),
+ * functions (FN, DEF), graphics (GR, HGR, HPLOT, DRAW, XDRAW) and ProDOS
+ * commands (OPEN, CLOSE, READ, WRITE). Special tokens like "?" (alias for
+ * PRINT) and "COLOR=" / "HCOLOR=" are included for isKeyword(), although
+ * identifiers never contain those characters.
+ */
+constexpr Keyword kKeywords[] = {
+    {"PRINT", TokenType::PRINT},
+    {"?", TokenType::PRINT},
+    {"INPUT", TokenType::INPUT},
+    {"LET", TokenType::LET},
+    {"IF", TokenType::IF},
+    {"THEN", TokenType::THEN},
+    {"ELSE", TokenType::ELSE},
+    {"GOTO", TokenType::GOTO},
+    {"GOSUB", TokenType::GOSUB},
+    {"RETURN", TokenType::RETURN},
+    {"FOR", TokenType::FOR},
+    {"TO", TokenType::TO},
+    {"STEP", TokenType::STEP},
+    {"NEXT", TokenType::NEXT},
+    {"DIM", TokenType::DIM},
+    {"DATA", TokenType::DATA},
+    {"READ", TokenType::READ},
+    {"RESTORE", TokenType::RESTORE},
+    {"REM", TokenType::REM},
+    {"END", TokenType::END},
+    {"NEW", TokenType::NEW},
+    {"RUN", TokenType::RUN},
+    {"LIST", TokenType::LIST},
+    {"LOAD", TokenType::LOAD},
+    {"SAVE", TokenType::SAVE},
+    {"CATALOG", TokenType::CATALOG},
+    {"CONT", TokenType::CONT},
+    {"DEL", TokenType::DEL},
+    {"DEF", TokenType::DEF},
+    {"FN", TokenType::FN},
+    {"ONERR", TokenType::ONERR},
+    {"RESUME", TokenType::RESUME},
+    {"ON", TokenType::ON},
+    {"AT", TokenType::AT},
+    {"CLR", TokenType::CLR},
+    {"CLEAR", TokenType::CLR},
+    {"HOME", TokenType::HOME},
+    {"TEXT", TokenType::TEXT},
+    {"GR", TokenType::GR},
+    {"HIRES", TokenType::HIRES},
+    {"COLOR=", TokenType::COLOR},
+    {"HGR", TokenType::HGR},
+    {"HGR2", TokenType::HGR2},
+    {"HCOLOR=", TokenType::HCOLOR},
+    {"CALL", TokenType::CALL},
+    {"PEEK", TokenType::PEEK},
+    {"POKE", TokenType::POKE},
+    {"GET", TokenType::GET},
+    {"HTAB", TokenType::HTAB},
+    {"VTAB", TokenType::VTAB},
+    {"INVERSE", TokenType::INVERSE},
+    {"NORMAL", TokenType::NORMAL},
+    {"FLASH", TokenType::FLASH},
+    {"STOP", TokenType::STOP},
+    {"PLOT", TokenType::PLOT},
+    {"HLIN", TokenType::HLIN},
+    {"VLIN", TokenType::VLIN},
+    {"HPLOT", TokenType::HPLOT},
+    {"XDRAW", TokenType::XDRAW},
+    {"DRAW", TokenType::DRAW},
+    {"MOVE", TokenType::MOVE},
+    {"ROTATE", TokenType::ROTATE},
+    {"SCALE", TokenType::SCALE},
+    {"SHLOAD", TokenType::SHLOAD},
+    {"SIN", TokenType::SIN},
+    {"COS", TokenType::COS},
+    {"TAN", TokenType::TAN},
+    {"ATN", TokenType::ATN},
+    {"EXP", TokenType::EXP},
+    {"LOG", TokenType::LOG},
+    {"SQR", TokenType::SQR},
+    {"ABS", TokenType::ABS},
+    {"INT", TokenType::INT},
+    {"SGN", TokenType::SGN},
+    {"RND", TokenType::RND},
+    {"LEN", TokenType::LEN},
+    {"VAL", TokenType::VAL},
+    {"ASC", TokenType::ASC},
+    {"CHR$", TokenType::CHR},
+    {"LEFT$", TokenType::LEFT},
+    {"RIGHT$", TokenType::RIGHT},
+    {"MID$", TokenType::MID},
+    {"STR$", TokenType::STR},
+    {"TAB", TokenType::TAB},
+    {"SPC", TokenType::SPC},
+    {"POS", TokenType::POS},
+    {"FRE", TokenType::FRE},
+    {"PDL", TokenType::PDL},
+    {"AND", TokenType::AND},
+    {"OR", TokenType::OR},
+    {"NOT", TokenType::NOT},
+    {"MOD", TokenType::MOD},
+    {"TRACE", TokenType::TRACE},
+    {"NOTRACE", TokenType::NOTRACE},
+    {"RANDOMIZE", TokenType::RANDOMIZE},
+    {"SPEED", TokenType::SPEED},
+    {"PR", TokenType::PR},
+    {"IN", TokenType::IN},
+    {"WHILE", TokenType::WHILE},
+    {"WEND", TokenType::WEND},
+    {"POP", TokenType::POP},
+    {"WAIT", TokenType::WAIT},
+    {"HIMEM", TokenType::HIMEM},
+    {"LOMEM", TokenType::LOMEM},
+    {"SCRN", TokenType::SCRN},
+    {"RECALL", TokenType::RECALL},
+    {"STORE", TokenType::STORE},
+    {"TAPE", TokenType::TAPE},
+    {"DELETE", TokenType::DELETE},
+    {"RENAME", TokenType::RENAME},
+    {"PREFIX", TokenType::PREFIX},
+    {"OPEN", TokenType::OPEN},
+    {"CLOSE", TokenType::CLOSE},
+    {"APPEND", TokenType::APPEND},
+    {"BLOAD", TokenType::BLOAD},
+    {"BRUN", TokenType::BRUN},
+    {"BSAVE", TokenType::BSAVE},
+    {"CREATE", TokenType::CREATE},
+    {"FLUSH", TokenType::FLUSH},
+    {"LOCK", TokenType::LOCK},
+    {"UNLOCK", TokenType::UNLOCK},
+    {"POSITION", TokenType::POSITION},
+    {"CHAIN", TokenType::CHAIN},
+    {"EXEC", TokenType::EXEC},
+    {"CAT", TokenType::CAT},
+    {"WRITE", TokenType::PRODOSWRITE},
+    {"-", TokenType::DASH},
+    {"USR", TokenType::USR},
+};
+
+constexpr size_t kKeywordCount = std::size(kKeywords);
+static_assert(kKeywordCount < 256, "keyword indices must fit in a byte");
+
+constexpr char upperAscii(char c) {
+  return c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c;
+}
+
+/** @brief One step of the keyword hash (32-bit FNV-1a over upper case) */
+constexpr uint32_t hashStep(uint32_t hash, char c) {
+  return (hash ^ static_cast<unsigned char>(upperAscii(c))) * 16777619u;
+}
+
+constexpr uint32_t keywordHash(std::string_view word, uint32_t seed) {
+  for (char c : word) {
+    seed = hashStep(seed, c);
+  }
+  return seed;
+}
+
+/** @brief log2 of the slot count: 4096 one-byte slots for ~130 keywords */
+constexpr unsigned kSlotBits = 12;
+
+constexpr size_t slotOf(uint32_t hash) { return hash >> (32 - kSlotBits); }
+
+/**
+ * @brief Perfect hash table of the keywords
+ *
+ * slots[slotOf(keywordHash(name, seed))] is 1 + the keyword's index in
+ * kKeywords, and 0 for slots no keyword hashes to.
+ */
+struct KeywordTable {
+  uint32_t seed = 0;
+  std::array<uint8_t, size_t{1} << kSlotBits> slots{};
+};
+
+/**
+ * @brief Find a seed under which no two keywords share a slot
+ *
+ * Runs at compile time; with ~130 keywords in 4096 slots about one seed
+ * in ten works.
+ */
+constexpr KeywordTable buildKeywordTable() {
+  for (uint32_t seed = 2166136261u;; ++seed) {
+    KeywordTable table;
+    table.seed = seed;
+    bool collision = false;
+    for (size_t i = 0; i < kKeywordCount && !collision; ++i) {
+      uint8_t &slot = table.slots[slotOf(keywordHash(kKeywords[i].name, seed))];
+      collision = slot != 0;
+      slot = static_cast<uint8_t>(i + 1);
+    }
+    if (!collision) {
+      return table;
+    }
+  }
+}
+
+constexpr KeywordTable kKeywordTable = buildKeywordTable();
+
+/**
+ * @brief Keyword spelled by @p word (any case), given its hash
+ * @return The keyword, or nullptr if @p word is not one
+ */
+const Keyword *findKeyword(std::string_view word, uint32_t hash) {
+  uint8_t slot = kKeywordTable.slots[slotOf(hash)];
+  if (slot == 0) {
+    return nullptr;
+  }
+  const Keyword &keyword = kKeywords[slot - 1];
+  if (keyword.name.size() != word.size()) {
+    return nullptr;
+  }
+  for (size_t i = 0; i < word.size(); ++i) {
+    if (upperAscii(word[i]) != keyword.name[i]) {
+      return nullptr;
+    }
+  }
+  return &keyword;
+}
+
+const Keyword *findKeyword(std::string_view word) {
+  return findKeyword(word, keywordHash(word, kKeywordTable.seed));
+}
+
+/** @brief Position of @p c in text[from, to), or @p to if absent */
+size_t find(std::string_view text, char c, size_t from, size_t to) {
+  const void *found = std::memchr(text.data() + from, c, to - from);
+  return found ? static_cast<size_t>(static_cast<const char *>(found) -
+                                     text.data())
+               : to;
+}
+} // namespace
 
 /**
  * @brief Construct a new Tokenizer
  *
  * Initializes tokenizer state with position at start of input.
  */
-Tokenizer::Tokenizer() : pos_(0), line_(1), column_(1) {}
+Tokenizer::Tokenizer() : pos_(0) {}
 
 /**
  * @brief Tokenize a line of BASIC code
  *
  * Converts the input string into a vector of tokens. Handles whitespace
- * skipping and ensures no duplicate NEWLINE tokens are emitted.
+ * skipping and ensures no duplicate NEWLINE tokens are emitted. The
+ * tokens refer to @p line by offset; @p line is not kept.
  *
  * @param line Input BASIC source code line
+ * @param constants Constant pool the values of literals are appended to
  * @return Vector of Token objects representing the tokenized input
  */
-std::vector<Token> Tokenizer::tokenize(const std::string &line) {
+std::vector<Token> Tokenizer::tokenize(std::string_view line,
+                                       std::vector<Value> &constants) {
   input_ = line;
   pos_ = 0;
-  column_ = 1;
+  constants_ = &constants;
 
   std::vector<Token> tokens;
+  tokens.reserve(line.size() / 2 + 1);
 
   while (!isAtEnd()) {
     skipWhitespace();
@@ -56,315 +310,44 @@ std::vector<Token> Tokenizer::tokenize(const std::string &line) {
     Token token = nextToken();
     if (token.type != TokenType::NEWLINE || tokens.empty() ||
         tokens.back().type != TokenType::NEWLINE) {
-      tokens.push_back(token);
+      tokens.push_back(std::move(token));
     }
   }
 
+  input_ = {};
+  constants_ = nullptr;
   return tokens;
 }
 
 /**
  * @brief Check if a word is a BASIC keyword
  *
- * Performs case-insensitive lookup in the keyword table. This static map
- * contains all Applesoft BASIC keywords including commands, statements,
- * functions, and special symbols (like ? for PRINT).
+ * Performs a case-insensitive lookup in the keyword table, which contains
+ * all Applesoft BASIC keywords including commands, statements, functions,
+ * and special symbols (like ? for PRINT).
  *
  * @param word Word to check (case-insensitive)
  * @return true if word is a keyword, false otherwise
  */
-bool Tokenizer::isKeyword(const std::string &word) const {
-  static const std::map<std::string, TokenType> keywords = {
-      {"PRINT", TokenType::PRINT},
-      {"?", TokenType::PRINT},
-      {"INPUT", TokenType::INPUT},
-      {"LET", TokenType::LET},
-      {"IF", TokenType::IF},
-      {"THEN", TokenType::THEN},
-      {"ELSE", TokenType::ELSE},
-      {"GOTO", TokenType::GOTO},
-      {"GOSUB", TokenType::GOSUB},
-      {"RETURN", TokenType::RETURN},
-      {"FOR", TokenType::FOR},
-      {"TO", TokenType::TO},
-      {"STEP", TokenType::STEP},
-      {"NEXT", TokenType::NEXT},
-      {"DIM", TokenType::DIM},
-      {"DATA", TokenType::DATA},
-      {"READ", TokenType::READ},
-      {"RESTORE", TokenType::RESTORE},
-      {"REM", TokenType::REM},
-      {"END", TokenType::END},
-      {"NEW", TokenType::NEW},
-      {"RUN", TokenType::RUN},
-      {"LIST", TokenType::LIST},
-      {"LOAD", TokenType::LOAD},
-      {"SAVE", TokenType::SAVE},
-      {"CATALOG", TokenType::CATALOG},
-      {"CONT", TokenType::CONT},
-      {"DEL", TokenType::DEL},
-      {"DEF", TokenType::DEF},
-      {"FN", TokenType::FN},
-      {"ONERR", TokenType::ONERR},
-      {"RESUME", TokenType::RESUME},
-      {"ON", TokenType::ON},
-      {"AT", TokenType::AT},
-      {"CLR", TokenType::CLR},
-      {"CLEAR", TokenType::CLR},
-      {"HOME", TokenType::HOME},
-      {"TEXT", TokenType::TEXT},
-      {"GR", TokenType::GR},
-      {"HIRES", TokenType::HIRES},
-      {"COLOR=", TokenType::COLOR},
-      {"HGR", TokenType::HGR},
-      {"HGR2", TokenType::HGR2},
-      {"HCOLOR=", TokenType::HCOLOR},
-      {"CALL", TokenType::CALL},
-      {"PEEK", TokenType::PEEK},
-      {"POKE", TokenType::POKE},
-      {"GET", TokenType::GET},
-      {"HTAB", TokenType::HTAB},
-      {"VTAB", TokenType::VTAB},
-      {"INVERSE", TokenType::INVERSE},
-      {"NORMAL", TokenType::NORMAL},
-      {"FLASH", TokenType::FLASH},
-      {"STOP", TokenType::STOP},
-      {"PLOT", TokenType::PLOT},
-      {"HLIN", TokenType::HLIN},
-      {"VLIN", TokenType::VLIN},
-      {"HPLOT", TokenType::HPLOT},
-      {"XDRAW", TokenType::XDRAW},
-      {"DRAW", TokenType::DRAW},
-      {"MOVE", TokenType::MOVE},
-      {"ROTATE", TokenType::ROTATE},
-      {"SCALE", TokenType::SCALE},
-      {"SHLOAD", TokenType::SHLOAD},
-      {"SIN", TokenType::SIN},
-      {"COS", TokenType::COS},
-      {"TAN", TokenType::TAN},
-      {"ATN", TokenType::ATN},
-      {"EXP", TokenType::EXP},
-      {"LOG", TokenType::LOG},
-      {"SQR", TokenType::SQR},
-      {"ABS", TokenType::ABS},
-      {"INT", TokenType::INT},
-      {"SGN", TokenType::SGN},
-      {"RND", TokenType::RND},
-      {"LEN", TokenType::LEN},
-      {"VAL", TokenType::VAL},
-      {"ASC", TokenType::ASC},
-      {"CHR$", TokenType::CHR},
-      {"LEFT$", TokenType::LEFT},
-      {"RIGHT$", TokenType::RIGHT},
-      {"MID$", TokenType::MID},
-      {"STR$", TokenType::STR},
-      {"TAB", TokenType::TAB},
-      {"SPC", TokenType::SPC},
-      {"POS", TokenType::POS},
-      {"FRE", TokenType::FRE},
-      {"PDL", TokenType::PDL},
-      {"AND", TokenType::AND},
-      {"OR", TokenType::OR},
-      {"NOT", TokenType::NOT},
-      {"MOD", TokenType::MOD},
-      {"TRACE", TokenType::TRACE},
-      {"NOTRACE", TokenType::NOTRACE},
-      {"RANDOMIZE", TokenType::RANDOMIZE},
-      {"SPEED", TokenType::SPEED},
-      {"PR", TokenType::PR},
-      {"IN", TokenType::IN},
-      {"WHILE", TokenType::WHILE},
-      {"WEND", TokenType::WEND},
-      {"POP", TokenType::POP},
-      {"WAIT", TokenType::WAIT},
-      {"HIMEM", TokenType::HIMEM},
-      {"LOMEM", TokenType::LOMEM},
-      {"SCRN", TokenType::SCRN},
-      {"RECALL", TokenType::RECALL},
-      {"STORE", TokenType::STORE},
-      {"TAPE", TokenType::TAPE},
-      {"DELETE", TokenType::DELETE},
-      {"RENAME", TokenType::RENAME},
-      {"PREFIX", TokenType::PREFIX},
-      {"OPEN", TokenType::OPEN},
-      {"CLOSE", TokenType::CLOSE},
-      {"APPEND", TokenType::APPEND},
-      {"BLOAD", TokenType::BLOAD},
-      {"BRUN", TokenType::BRUN},
-      {"BSAVE", TokenType::BSAVE},
-      {"CREATE", TokenType::CREATE},
-      {"FLUSH", TokenType::FLUSH},
-      {"LOCK", TokenType::LOCK},
-      {"UNLOCK", TokenType::UNLOCK},
-      {"POSITION", TokenType::POSITION},
-      {"CHAIN", TokenType::CHAIN},
-      {"EXEC", TokenType::EXEC},
-      {"CAT", TokenType::CAT},
-      {"WRITE", TokenType::PRODOSWRITE},
-      {"-", TokenType::DASH},
-      {"USR", TokenType::USR}};
-
-  std::string upper = word;
-  std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
-  return keywords.find(upper) != keywords.end();
+bool Tokenizer::isKeyword(std::string_view word) const {
+  return findKeyword(word) != nullptr;
 }
 
 /**
  * @brief Resolve a keyword string to its TokenType
  *
- * Performs case-insensitive lookup in the tokenizer's keyword table and
+ * Performs a case-insensitive lookup in the tokenizer's keyword table and
  * returns the corresponding TokenType.
  *
- * Details:
- * - The keyword map includes commands (PRINT, INPUT, LIST, RUN, NEW),
- *   control flow (IF, THEN, ELSE, FOR, NEXT, GOTO, GOSUB), data keywords
- *   (DATA, READ, RESTORE, DIM), functions (FN, DEF), graphics (GR, HGR,
- *   HPLOT, DRAW, XDRAW), and ProDOS commands (OPEN, CLOSE, READ, WRITE).
- * - Special tokens like "?" (alias for PRINT) and multi-character tokens
- *   such as "COLOR=" and "HCOLOR=" are included.
- * - Keywords are matched case-insensitively; input is converted to uppercase.
- *
  * Notes:
  * - If the word is not recognized as a keyword, returns TokenType::IDENTIFIER.
  *
  * @param word Input word to classify (case-insensitive)
  * @return TokenType for the keyword, or TokenType::IDENTIFIER if not found
  */
-TokenType Tokenizer::getKeywordType(const std::string &word) const {
-  static const std::map<std::string, TokenType> keywords = {
-      {"PRINT", TokenType::PRINT},
-      {"?", TokenType::PRINT},
-      {"INPUT", TokenType::INPUT},
-      {"LET", TokenType::LET},
-      {"IF", TokenType::IF},
-      {"THEN", TokenType::THEN},
-      {"ELSE", TokenType::ELSE},
-      {"GOTO", TokenType::GOTO},
-      {"GOSUB", TokenType::GOSUB},
-      {"RETURN", TokenType::RETURN},
-      {"FOR", TokenType::FOR},
-      {"TO", TokenType::TO},
-      {"STEP", TokenType::STEP},
-      {"NEXT", TokenType::NEXT},
-      {"DIM", TokenType::DIM},
-      {"DATA", TokenType::DATA},
-      {"READ", TokenType::READ},
-      {"RESTORE", TokenType::RESTORE},
-      {"REM", TokenType::REM},
-      {"END", TokenType::END},
-      {"NEW", TokenType::NEW},
-      {"RUN", TokenType::RUN},
-      {"LIST", TokenType::LIST},
-      {"LOAD", TokenType::LOAD},
-      {"SAVE", TokenType::SAVE},
-      {"CATALOG", TokenType::CATALOG},
-      {"CONT", TokenType::CONT},
-      {"DEL", TokenType::DEL},
-      {"DEF", TokenType::DEF},
-      {"FN", TokenType::FN},
-      {"ONERR", TokenType::ONERR},
-      {"RESUME", TokenType::RESUME},
-      {"ON", TokenType::ON},
-      {"AT", TokenType::AT},
-      {"CLR", TokenType::CLR},
-      {"CLEAR", TokenType::CLR},
-      {"HOME", TokenType::HOME},
-      {"TEXT", TokenType::TEXT},
-      {"GR", TokenType::GR},
-      {"HIRES", TokenType::HIRES},
-      {"COLOR=", TokenType::COLOR},
-      {"HGR", TokenType::HGR},
-      {"HGR2", TokenType::HGR2},
-      {"HCOLOR=", TokenType::HCOLOR},
-      {"CALL", TokenType::CALL},
-      {"PEEK", TokenType::PEEK},
-      {"POKE", TokenType::POKE},
-      {"GET", TokenType::GET},
-      {"HTAB", TokenType::HTAB},
-      {"VTAB", TokenType::VTAB},
-      {"INVERSE", TokenType::INVERSE},
-      {"NORMAL", TokenType::NORMAL},
-      {"FLASH", TokenType::FLASH},
-      {"STOP", TokenType::STOP},
-      {"PLOT", TokenType::PLOT},
-      {"HLIN", TokenType::HLIN},
-      {"VLIN", TokenType::VLIN},
-      {"HPLOT", TokenType::HPLOT},
-      {"XDRAW", TokenType::XDRAW},
-      {"DRAW", TokenType::DRAW},
-      {"MOVE", TokenType::MOVE},
-      {"ROTATE", TokenType::ROTATE},
-      {"SCALE", TokenType::SCALE},
-      {"SHLOAD", TokenType::SHLOAD},
-      {"SIN", TokenType::SIN},
-      {"COS", TokenType::COS},
-      {"TAN", TokenType::TAN},
-      {"ATN", TokenType::ATN},
-      {"EXP", TokenType::EXP},
-      {"LOG", TokenType::LOG},
-      {"SQR", TokenType::SQR},
-      {"ABS", TokenType::ABS},
-      {"INT", TokenType::INT},
-      {"SGN", TokenType::SGN},
-      {"RND", TokenType::RND},
-      {"LEN", TokenType::LEN},
-      {"VAL", TokenType::VAL},
-      {"ASC", TokenType::ASC},
-      {"CHR$", TokenType::CHR},
-      {"LEFT$", TokenType::LEFT},
-      {"RIGHT$", TokenType::RIGHT},
-      {"MID$", TokenType::MID},
-      {"STR$", TokenType::STR},
-      {"TAB", TokenType::TAB},
-      {"SPC", TokenType::SPC},
-      {"POS", TokenType::POS},
-      {"FRE", TokenType::FRE},
-      {"PDL", TokenType::PDL},
-      {"AND", TokenType::AND},
-      {"OR", TokenType::OR},
-      {"NOT", TokenType::NOT},
-      {"MOD", TokenType::MOD},
-      {"TRACE", TokenType::TRACE},
-      {"NOTRACE", TokenType::NOTRACE},
-      {"RANDOMIZE", TokenType::RANDOMIZE},
-      {"SPEED", TokenType::SPEED},
-      {"PR", TokenType::PR},
-      {"IN", TokenType::IN},
-      {"WHILE", TokenType::WHILE},
-      {"WEND", TokenType::WEND},
-      {"POP", TokenType::POP},
-      {"WAIT", TokenType::WAIT},
-      {"HIMEM", TokenType::HIMEM},
-      {"LOMEM", TokenType::LOMEM},
-      {"SCRN", TokenType::SCRN},
-      {"RECALL", TokenType::RECALL},
-      {"STORE", TokenType::STORE},
-      {"TAPE", TokenType::TAPE},
-      {"DELETE", TokenType::DELETE},
-      {"RENAME", TokenType::RENAME},
-      {"PREFIX", TokenType::PREFIX},
-      {"OPEN", TokenType::OPEN},
-      {"CLOSE", TokenType::CLOSE},
-      {"APPEND", TokenType::APPEND},
-      {"BLOAD", TokenType::BLOAD},
-      {"BRUN", TokenType::BRUN},
-      {"BSAVE", TokenType::BSAVE},
-      {"CREATE", TokenType::CREATE},
-      {"FLUSH", TokenType::FLUSH},
-      {"LOCK", TokenType::LOCK},
-      {"UNLOCK", TokenType::UNLOCK},
-      {"POSITION", TokenType::POSITION},
-      {"CHAIN", TokenType::CHAIN},
-      {"EXEC", TokenType::EXEC},
-      {"CAT", TokenType::CAT},
-      {"WRITE", TokenType::PRODOSWRITE},
-      {"-", TokenType::DASH},
-      {"USR", TokenType::USR}};
-
-  std::string upper = word;
-  std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
-  auto it = keywords.find(upper);
-  return it != keywords.end() ? it->second : TokenType::IDENTIFIER;
+TokenType Tokenizer::getKeywordType(std::string_view word) const {
+  const Keyword *keyword = findKeyword(word);
+  return keyword ? keyword->type : TokenType::IDENTIFIER;
 }
 
 /**
@@ -374,11 +357,36 @@ TokenType Tokenizer::getKeywordType(const std::string &word) const {
  * This preserves newline tokens which are significant in BASIC syntax.
  */
 void Tokenizer::skipWhitespace() {
-  while (!isAtEnd() && std::isspace(peek()) && peek() != '\n') {
+  while (!isAtEnd() && std::isspace(static_cast<unsigned char>(peek())) &&
+         peek() != '\n') {
     advance();
   }
 }
 
+/**
+ * @brief Token of the given type spanning from @p start to the current
+ *        position
+ */
+Token Tokenizer::makeToken(TokenType type, size_t start) const {
+  Token token;
+  token.type = type;
+  token.offset = static_cast<uint32_t>(start);
+  token.length = static_cast<uint32_t>(pos_ - start);
+  return token;
+}
+
+/**
+ * @brief Literal token spanning from @p start to the current position
+ * @param value The literal's value, added to the constant pool
+ */
+Token Tokenizer::makeLiteral(TokenType type, size_t start, Value value) {
+  Token token = makeToken(type, start);
+  token.flags |= Token::kConstant;
+  token.constant = static_cast<uint32_t>(constants_->size());
+  constants_->push_back(std::move(value));
+  return token;
+}
+
 /**
  * @brief Read next token from input
  *
@@ -391,11 +399,12 @@ void Tokenizer::skipWhitespace() {
  * @return Next token from input stream
  */
 Token Tokenizer::nextToken() {
-  char ch = peek();
+  auto ch = static_cast<unsigned char>(peek());
 
   // Numbers
-  if (std::isdigit(ch) || (ch == '.' && pos_ + 1 < input_.length() &&
-                           std::isdigit(input_[pos_ + 1]))) {
+  if (std::isdigit(ch) ||
+      (ch == '.' && pos_ + 1 < input_.length() &&
+       std::isdigit(static_cast<unsigned char>(input_[pos_ + 1])))) {
     return readNumber();
   }
 
@@ -429,37 +438,37 @@ Token Tokenizer::nextToken() {
  * @return NUMBER token with parsed value
  */
 Token Tokenizer::readNumber() {
-  Token token;
-  token.type = TokenType::NUMBER;
-  token.line = line_;
-  token.column = column_;
-
-  std::string numStr;
+  size_t start = pos_;
   bool hasDecimal = false;
   bool hasExponent = false;
 
   while (!isAtEnd()) {
     char ch = peek();
 
-    if (std::isdigit(ch)) {
-      numStr += advance();
+    if (std::isdigit(static_cast<unsigned char>(ch))) {
+      advance();
     } else if (ch == '.' && !hasDecimal && !hasExponent) {
       hasDecimal = true;
-      numStr += advance();
+      advance();
     } else if ((ch == 'E' || ch == 'e') && !hasExponent) {
       hasExponent = true;
-      numStr += advance();
+      advance();
       if (!isAtEnd() && (peek() == '+' || peek() == '-')) {
-        numStr += advance();
+        advance();
       }
     } else {
       break;
     }
   }
 
-  token.text = numStr;
-  token.value = Value(std::stod(numStr));
-  return token;
+  const char *first = input_.data() + start;
+  const char *last = input_.data() + pos_;
+  double number = 0.0;
+  if (std::from_chars(first, last, number).ec != std::errc()) {
+    // Out of range: std::stod reports it as before
+    number = std::stod(std::string(first, last));
+  }
+  return makeLiteral(TokenType::NUMBER, start, Value(number));
 }
 
 /**
@@ -475,28 +484,43 @@ Token Tokenizer::readNumber() {
  *   "Hello, World!"
  *   ""  (empty string)
  *
- * @return STRING token with the string content (quotes not included)
+ * @return STRING token with the string content (quotes not included) as
+ *         its value; the token spans the quotes
  */
 Token Tokenizer::readString() {
-  Token token;
-  token.type = TokenType::STRING;
-  token.line = line_;
-  token.column = column_;
-
-  advance(); // Skip opening quote
-
-  std::string str;
-  while (!isAtEnd() && peek() != '"' && peek() != '\n') {
-    str += advance();
-  }
+  size_t start = pos_;
+  size_t contentStart = start + 1; // Skip opening quote
+  size_t end = find(input_, '\n', contentStart, input_.size());
+  end = find(input_, '"', contentStart, end);
+  std::string_view content = input_.substr(contentStart, end - contentStart);
 
+  pos_ = end;
   if (!isAtEnd() && peek() == '"') {
     advance(); // Skip closing quote
   }
 
-  token.text = str;
-  token.value = Value(str);
-  return token;
+  return makeLiteral(TokenType::STRING, start, Value(content));
+}
+
+/**
+ * @brief Skip the text of a REM statement
+ *
+ * A remark ends at the first colon outside double quotes, or at the end
+ * of the line, so the parser sees the next statement (if any). The text
+ * itself produces no tokens.
+ */
+void Tokenizer::skipRemark() {
+  size_t end = find(input_, '\n', pos_, input_.size());
+  while (pos_ < end) {
+    size_t colon = find(input_, ':', pos_, end);
+    size_t quote = find(input_, '"', pos_, colon);
+    if (quote == colon) {
+      pos_ = colon;
+      return;
+    }
+    size_t close = find(input_, '"', quote + 1, end);
+    pos_ = close == end ? end : close + 1;
+  }
 }
 
 /**
@@ -510,9 +534,12 @@ Token Tokenizer::readString() {
  * - % suffix for integer variables
  *
  * Special handling:
- * - Keywords are case-insensitive and converted to uppercase
- * - Built-in string functions (CHR$, LEFT$, etc.) are recognized as keywords
+ * - Keywords are case-insensitive; the word is hashed while it is read
+ *   and looked up once in the perfect hash table
+ * - Built-in string functions (CHR$, LEFT$, etc.) are keywords including
+ *   their $
  * - FN prefix indicates user-defined function call
+ * - REM skips the rest of its statement (see skipRemark())
  *
  * Examples:
  *   PRINT → PRINT keyword
@@ -524,38 +551,21 @@ Token Tokenizer::readString() {
  * @return Keyword token or IDENTIFIER token
  */
 Token Tokenizer::readIdentifier() {
-  Token token;
-  token.line = line_;
-  token.column = column_;
-
-  std::string ident;
+  size_t start = pos_;
+  uint32_t hash = kKeywordTable.seed;
   while (!isAtEnd() &&
-         (std::isalnum(peek()) || peek() == '$' || peek() == '%')) {
-    ident += advance();
+         (std::isalnum(static_cast<unsigned char>(peek())) ||
+          peek() == '$' || peek() == '%')) {
+    hash = hashStep(hash, advance());
   }
 
-  // Check for function names with $
-  if (!ident.empty() && ident.back() == '$') {
-    std::string funcName = ident;
-    std::transform(funcName.begin(), funcName.end(), funcName.begin(),
-                   ::toupper);
-
-    if (funcName == "CHR$" || funcName == "LEFT$" || funcName == "RIGHT$" ||
-        funcName == "MID$" || funcName == "STR$") {
-      token.type = getKeywordType(funcName);
-      token.text = funcName;
-      return token;
-    }
-  }
-
-  token.text = ident;
-
-  if (isKeyword(ident)) {
-    token.type = getKeywordType(ident);
-  } else {
-    token.type = TokenType::IDENTIFIER;
+  const Keyword *keyword =
+      findKeyword(input_.substr(start, pos_ - start), hash);
+  Token token =
+      makeToken(keyword ? keyword->type : TokenType::IDENTIFIER, start);
+  if (token.type == TokenType::REM) {
+    skipRemark();
   }
-
   return token;
 }
 
@@ -580,131 +590,85 @@ Token Tokenizer::readIdentifier() {
  * @return Operator or delimiter token
  */
 Token Tokenizer::readOperator() {
-  Token token;
-  token.line = line_;
-  token.column = column_;
+  size_t start = pos_;
+  TokenType type;
 
-  char ch = peek();
-
-  switch (ch) {
+  switch (advance()) {
   case '+':
-    token.type = TokenType::PLUS;
-    token.text = "+";
-    advance();
+    type = TokenType::PLUS;
     break;
   case '-':
-    token.type = TokenType::MINUS;
-    token.text = "-";
-    advance();
+    type = TokenType::MINUS;
     break;
   case '*':
-    token.type = TokenType::MULTIPLY;
-    token.text = "*";
-    advance();
+    type = TokenType::MULTIPLY;
     break;
   case '/':
-    token.type = TokenType::DIVIDE;
-    token.text = "/";
-    advance();
+    type = TokenType::DIVIDE;
     break;
   case '^':
-    token.type = TokenType::POWER;
-    token.text = "^";
-    advance();
+    type = TokenType::POWER;
     break;
   case '(':
-    token.type = TokenType::LPAREN;
-    token.text = "(";
-    advance();
+    type = TokenType::LPAREN;
     break;
   case ')':
-    token.type = TokenType::RPAREN;
-    token.text = ")";
-    advance();
+    type = TokenType::RPAREN;
     break;
   case ',':
-    token.type = TokenType::COMMA;
-    token.text = ",";
-    advance();
+    type = TokenType::COMMA;
     break;
   case ';':
-    token.type = TokenType::SEMICOLON;
-    token.text = ";";
-    advance();
+    type = TokenType::SEMICOLON;
     break;
   case ':':
-    token.type = TokenType::COLON;
-    token.text = ":";
-    advance();
+    type = TokenType::COLON;
     break;
   case '#':
-    token.type = TokenType::HASH;
-    token.text = "#";
-    advance();
+    type = TokenType::HASH;
     break;
   case '$':
-    token.type = TokenType::DOLLAR;
-    token.text = "$";
-    advance();
+    type = TokenType::DOLLAR;
     break;
   case '%':
-    token.type = TokenType::PERCENT;
-    token.text = "%";
-    advance();
+    type = TokenType::PERCENT;
     break;
   case '\n':
-    token.type = TokenType::NEWLINE;
-    token.text = "\\n";
-    advance();
+    type = TokenType::NEWLINE;
     break;
 
   case '=':
-    token.text = "=";
-    advance();
-    token.type = TokenType::EQUAL;
+    type = TokenType::EQUAL;
     break;
 
   case '<':
-    token.text = "<";
-    advance();
-    if (!isAtEnd()) {
-      if (peek() == '=') {
-        token.text += "=";
-        token.type = TokenType::LESS_EQUAL;
-        advance();
-      } else if (peek() == '>') {
-        token.text += ">";
-        token.type = TokenType::NOT_EQUAL;
-        advance();
-      } else {
-        token.type = TokenType::LESS;
-      }
+    if (peek() == '=') {
+      type = TokenType::LESS_EQUAL;
+      advance();
+    } else if (peek() == '>') {
+      type = TokenType::NOT_EQUAL;
+      advance();
     } else {
-      token.type = TokenType::LESS;
+      type = TokenType::LESS;
     }
     break;
 
   case '>':
-    token.text = ">";
-    advance();
-    if (!isAtEnd() && peek() == '=') {
-      token.text += "=";
-      token.type = TokenType::GREATER_EQUAL;
+    if (peek() == '=') {
+      type = TokenType::GREATER_EQUAL;
       advance();
     } else {
-      token.type = TokenType::GREATER;
+      type = TokenType::GREATER;
     }
     break;
 
   default:
     // Unknown character, skip it
-    token.type = TokenType::NEWLINE;
-    token.text = std::string(1, ch);
-    advance();
+    type = TokenType::NEWLINE;
     break;
   }
 
-  return token;
+  return makeToken(type, start);
 }
 
 /**
@@ -724,7 +688,7 @@ char Tokenizer::peek() const {
 /**
  * @brief Consume and return current character
  *
- * Advances the position and column counters, returning the character
+ * Advances the position, returning the character
  * that was consumed. This is the primary method for consuming input
  * during tokenization.
  *
@@ -733,9 +697,7 @@ char Tokenizer::peek() const {
 char Tokenizer::advance() {
   if (isAtEnd())
     return '\0';
-  char ch = input_[pos_++];
-  column_++;
-  return ch;
+  return input_[pos_++];
 }
 
 /**
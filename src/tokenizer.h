@@ -12,15 +12,14 @@
  * - String literal parsing (with escape sequences)
  * - Identifier recognition (variables, FN names, etc.)
  * - Operator and delimiter recognition
- * - Position tracking for error reporting
+ * - Source offsets of every token, which refer back to the input text
  */
 
 #pragma once
 
 #include "types.h"
-#include <string>
+#include <string_view>
 #include <vector>
-#include <memory>
 
 /**
  * @class Tokenizer
@@ -34,11 +33,15 @@
  * Usage:
  * @code
  * Tokenizer tokenizer;
- * std::vector<Token> tokens = tokenizer.tokenize("PRINT \"HELLO\"");
+ * std::vector<Value> constants;
+ * std::vector<Token> tokens =
+ *     tokenizer.tokenize("PRINT \"HELLO\"", constants);
  * @endcode
  * 
- * The tokenizer maintains position information (line and column) for
- * error reporting and supports both immediate commands and program lines.
+ * Tokens record the offset and length of their text in the input rather
+ * than a copy of it, so the input must outlive them for anyone who needs
+ * a token's text. The tokenizer supports both immediate commands and
+ * program lines.
  */
 class Tokenizer {
 public:
@@ -55,10 +58,14 @@ public:
      * multi-statement lines (separated by colons).
      * 
      * @param line The source code line to tokenize
-     * @return std::vector<Token> The sequence of tokens
-     * @throws std::runtime_error On lexical errors (unterminated strings, etc.)
+     * @param constants Receives the values of number and string literals,
+     *        appended; tokens hold their indices
+     * @return std::vector<Token> The sequence of tokens, with offsets into
+     *         @p line
+     * @throws std::out_of_range On a number too large for a double
      */
-    std::vector<Token> tokenize(const std::string& line);
+    std::vector<Token> tokenize(std::string_view line,
+                                std::vector<Value>& constants);
     
     /**
      * @brief Check if a string is a BASIC keyword
@@ -67,16 +74,16 @@ public:
      * @return true if the word is a recognized BASIC keyword
      * @return false otherwise
      */
-    bool isKeyword(const std::string& word) const;
+    bool isKeyword(std::string_view word) const;
     
     /**
      * @brief Get the token type for a keyword
      * 
      * @param word The keyword string
-     * @return TokenType The corresponding token type
-     * @throws std::runtime_error if word is not a keyword
+     * @return TokenType The corresponding token type, or
+     *         TokenType::IDENTIFIER if word is not a keyword
      */
-    TokenType getKeywordType(const std::string& word) const;
+    TokenType getKeywordType(std::string_view word) const;
     
 private:
     /** @brief Skip whitespace characters in the input */
@@ -97,17 +104,23 @@ private:
     /** @brief Read an operator token */
     Token readOperator();
     
-    /** @brief The input string being tokenized */
-    std::string input_;
+    /** @brief Skip the comment after a REM keyword */
+    void skipRemark();
+    
+    /** @brief Token of a type spanning from start to the current position */
+    Token makeToken(TokenType type, size_t start) const;
+    
+    /** @brief Like makeToken(), with a value for the constant pool */
+    Token makeLiteral(TokenType type, size_t start, Value value);
+    
+    /** @brief The input being tokenized (during tokenize() only) */
+    std::string_view input_;
     
     /** @brief Current position in the input string */
     size_t pos_;
     
-    /** @brief Current line number (for error reporting) */
-    int line_;
-    
-    /** @brief Current column number (for error reporting) */
-    int column_;
+    /** @brief Constant pool of the line (during tokenize() only) */
+    std::vector<Value>* constants_ = nullptr;
     
     /**
      * @brief Peek at the current character without consuming it
@@ -4,7 +4,7 @@
  * 
  * This file implements the Value class which represents runtime values in
  * MSBasic. A Value can hold either a numeric value (double) or a string,
- * using std::variant for type-safe storage.
+ * packed into 16 bytes with short strings inline and long strings shared.
  * 
  * Key features:
  * - Automatic type coercion (string to number, number to string)
@@ -18,50 +18,143 @@
 
 #include "types.h"
 #include "float40.h"
+#include <atomic>
+#include <cstring>
 #include <stdexcept>
 #include <sstream>
 
+/**
+ * @brief Heap block shared by copies of a long string Value
+ *
+ * The text is never modified after construction, so copies can share it.
+ * The count is atomic so values may be copied across threads.
+ */
+struct Value::LongString {
+    explicit LongString(std::string_view str) : text(str) {}
+
+    std::atomic<uint32_t> refs{1};
+    const std::string text;
+};
+
 // Constructors
 
 /**
  * @brief Construct a default Value (numeric 0.0)
  */
-Value::Value() : data(0.0) {}
+Value::Value() : Value(0.0) {}
 
 /**
  * @brief Construct a numeric Value
  * @param num Numeric value to store
  */
-Value::Value(double num) : data(num) {}
+Value::Value(double num) {
+    std::memcpy(storage_, &num, sizeof num);
+}
 
 /**
  * @brief Construct a string Value
  * @param str String value to store
  */
-Value::Value(const std::string& str) : data(str) {}
+Value::Value(const std::string& str) { assignString(str); }
+
+/**
+ * @brief Construct a string Value from a view
+ * @param str Characters to copy
+ */
+Value::Value(std::string_view str) { assignString(str); }
+
+/**
+ * @brief Construct a string Value from a C string
+ * @param str Null-terminated characters to copy
+ */
+Value::Value(const char* str) { assignString(str); }
 
 /**
  * @brief Construct a Value from Float40
  * @param f40 Float40 value (converted to double)
  */
-Value::Value(const Float40& f40) : data(f40.toDouble()) {}
+Value::Value(const Float40& f40) : Value(f40.toDouble()) {}
 
-// Type checking
+Value::Value(const Value& other) { copyFrom(other); }
 
 /**
- * @brief Check if this Value holds a number
- * @return true if value is numeric, false otherwise
+ * @brief Move constructor
+ *
+ * Takes over the representation (including a heap block reference) and
+ * leaves @p other as numeric 0; never allocates.
  */
-bool Value::isNumber() const {
-    return std::holds_alternative<double>(data);
+Value::Value(Value&& other) noexcept {
+    std::memcpy(storage_, other.storage_, sizeof storage_);
+    length_ = other.length_;
+    kind_ = other.kind_;
+    other.kind_ = Kind::Number;
+    double zero = 0.0;
+    std::memcpy(other.storage_, &zero, sizeof zero);
 }
 
-/**
- * @brief Check if this Value holds a string
- * @return true if value is a string, false otherwise
- */
-bool Value::isString() const {
-    return std::holds_alternative<std::string>(data);
+Value& Value::operator=(const Value& other) {
+    if (this != &other) {
+        if (kind_ == Kind::LongString) {
+            release();
+        }
+        copyFrom(other);
+    }
+    return *this;
+}
+
+Value& Value::operator=(Value&& other) noexcept {
+    if (this != &other) {
+        if (kind_ == Kind::LongString) {
+            release();
+        }
+        std::memcpy(storage_, other.storage_, sizeof storage_);
+        length_ = other.length_;
+        kind_ = other.kind_;
+        other.kind_ = Kind::Number;
+        double zero = 0.0;
+        std::memcpy(other.storage_, &zero, sizeof zero);
+    }
+    return *this;
+}
+
+void Value::assignString(std::string_view str) {
+    if (str.size() <= kInlineCapacity) {
+        kind_ = Kind::ShortString;
+        length_ = static_cast<uint8_t>(str.size());
+        std::memcpy(storage_, str.data(), str.size());
+        return;
+    }
+    kind_ = Kind::LongString;
+    LongString* block = new LongString(str);
+    std::memcpy(storage_, &block, sizeof block);
+}
+
+void Value::copyFrom(const Value& other) {
+    std::memcpy(storage_, other.storage_, sizeof storage_);
+    length_ = other.length_;
+    kind_ = other.kind_;
+    if (kind_ == Kind::LongString) {
+        longString()->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Value::release() {
+    LongString* block = longString();
+    if (block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete block;
+    }
+}
+
+double Value::number() const {
+    double num;
+    std::memcpy(&num, storage_, sizeof num);
+    return num;
+}
+
+Value::LongString* Value::longString() const {
+    LongString* block;
+    std::memcpy(&block, storage_, sizeof block);
+    return block;
 }
 
 // Type conversion
@@ -77,24 +170,20 @@ bool Value::isString() const {
  */
 double Value::getNumber() const {
     if (isNumber()) {
-        return std::get<double>(data);
+        return number();
     }
-    if (isString()) {
-        // Try to convert string to number
-        const std::string& str = std::get<std::string>(data);
-        try {
-            return std::stod(str);
-        } catch (...) {
-            return 0.0;
-        }
+    // Try to convert string to number
+    try {
+        return std::stod(std::string(stringView()));
+    } catch (...) {
+        return 0.0;
     }
-    return 0.0;
 }
 
 /**
  * @brief Get value as a string
  * 
- * If the value is already a string, returns it directly.
+ * If the value is already a string, returns a copy of it.
  * If the value is numeric, converts it using Float40::toString() to
  * maintain Applesoft formatting conventions.
  * 
@@ -102,14 +191,28 @@ double Value::getNumber() const {
  */
 std::string Value::getString() const {
     if (isString()) {
-        return std::get<std::string>(data);
+        return std::string(stringView());
     }
-    if (isNumber()) {
-        // Convert number to string
-        Float40 f(std::get<double>(data));
-        return f.toString();
+    // Convert number to string
+    Float40 f(number());
+    return f.toString();
+}
+
+/**
+ * @brief View the string payload without copying
+ * @return Inline or shared characters; empty for numbers
+ */
+std::string_view Value::stringView() const {
+    switch (kind_) {
+    case Kind::ShortString:
+        return std::string_view(reinterpret_cast<const char*>(storage_),
+                                length_);
+    case Kind::LongString:
+        return longString()->text;
+    case Kind::Number:
+        break;
     }
-    return "";
+    return std::string_view();
 }
 
 // Arithmetic operators
@@ -124,8 +227,16 @@ std::string Value::getString() const {
  * @return Result of addition or concatenation
  */
 Value Value::operator+(const Value& other) const {
-    if (isString() || other.isString()) {
+    if (isString() && other.isString()) {
         // String concatenation
+        std::string_view lhs = stringView();
+        std::string_view rhs = other.stringView();
+        std::string joined;
+        joined.reserve(lhs.size() + rhs.size());
+        joined.append(lhs).append(rhs);
+        return Value(joined);
+    }
+    if (isString() || other.isString()) {
         return Value(getString() + other.getString());
     }
     // Numeric addition
@@ -194,7 +305,7 @@ Value Value::operator/(const Value& other) const {
  */
 bool Value::operator==(const Value& other) const {
     if (isString() && other.isString()) {
-        return getString() == other.getString();
+        return stringView() == other.stringView();
     }
     Float40 a(getNumber());
     Float40 b(other.getNumber());
@@ -222,7 +333,7 @@ bool Value::operator!=(const Value& other) const {
  */
 bool Value::operator<(const Value& other) const {
     if (isString() && other.isString()) {
-        return getString() < other.getString();
+        return stringView() < other.stringView();
     }
     Float40 a(getNumber());
     Float40 b(other.getNumber());
@@ -241,7 +352,7 @@ bool Value::operator<(const Value& other) const {
  */
 bool Value::operator>(const Value& other) const {
     if (isString() && other.isString()) {
-        return getString() > other.getString();
+        return stringView() > other.stringView();
     }
     Float40 a(getNumber());
     Float40 b(other.getNumber());
@@ -9,10 +9,12 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <string>
-#include <variant>
+#include <string_view>
 #include <vector>
 
 // Forward declarations
@@ -23,6 +25,10 @@ class Statement;
 class Program;
 class Variables;
 class Interpreter;
+class AstArena;
+namespace bytecode {
+struct Chunk;
+}
 
 /**
  * @brief Type alias for BASIC line numbers
@@ -38,7 +44,7 @@ using LineNumber = int;
  * including literals, keywords, operators, built-in functions, and delimiters.
  * The tokenizer converts raw text into a stream of these typed tokens.
  */
-enum class TokenType {
+enum class TokenType : uint8_t {
   // Literals
   NUMBER,
   STRING,
@@ -218,9 +224,16 @@ enum class TokenType {
  * @brief Runtime value that can hold either a number or a string
  * 
  * Value is the fundamental data type for all runtime computations in MSBasic.
- * It uses std::variant to store either a double (for numeric values) or
- * std::string (for string values). The class provides type-safe access
- * and automatic type checking for operations.
+ * It holds either a double (for numeric values) or a string (for string
+ * values). The class provides type-safe access and automatic type checking
+ * for operations.
+ *
+ * Representation (16 bytes):
+ * - Numbers are stored inline as a double
+ * - Strings of up to kInlineCapacity characters are stored inline
+ * - Longer strings live in a shared, reference-counted, immutable heap
+ *   block; copying such a Value only bumps the count
+ * Moves never allocate. Use stringView() to read a string without copying.
  * 
  * Type coercion rules:
  * - Numeric operations on strings attempt conversion via VAL()
@@ -243,6 +256,22 @@ public:
    * @param str The string value to store
    */
   explicit Value(const std::string &str);
+
+  /** @brief Construct a string value from a view (the text is copied) */
+  explicit Value(std::string_view str);
+
+  /** @brief Construct a string value from a C string */
+  explicit Value(const char *str);
+
+  Value(const Value &other);
+  Value(Value &&other) noexcept;
+  Value &operator=(const Value &other);
+  Value &operator=(Value &&other) noexcept;
+  ~Value() {
+    if (kind_ == Kind::LongString) {
+      release();
+    }
+  }
   
   /**
    * @brief Construct from a 40-bit floating-point value
@@ -254,13 +283,13 @@ public:
    * @brief Check if this value is a number
    * @return true if the value holds a number, false if it holds a string
    */
-  bool isNumber() const;
+  bool isNumber() const { return kind_ == Kind::Number; }
   
   /**
    * @brief Check if this value is a string
    * @return true if the value holds a string, false if it holds a number
    */
-  bool isString() const;
+  bool isString() const { return kind_ != Kind::Number; }
 
   /**
    * @brief Get the numeric value
@@ -276,6 +305,15 @@ public:
    */
   std::string getString() const;
 
+  /**
+   * @brief View the string payload without copying
+   *
+   * The view stays valid while this Value is alive and unmodified.
+   *
+   * @return The string characters, or an empty view for numbers
+   */
+  std::string_view stringView() const;
+
   /**
    * @brief Add two values (or concatenate strings)
    * @param other The value to add
@@ -354,46 +392,123 @@ public:
    */
   bool operator>=(const Value &other) const;
 
+  /** @brief Longest string stored without a heap block */
+  static constexpr size_t kInlineCapacity = 14;
+
 private:
-  /** @brief Internal storage for either double or string */
-  std::variant<double, std::string> data;
+  enum class Kind : uint8_t { Number, ShortString, LongString };
+  struct LongString;
+
+  /** @brief Store a string payload (inline or in a new heap block) */
+  void assignString(std::string_view str);
+  /** @brief Copy representation from @p other, sharing its heap block */
+  void copyFrom(const Value &other);
+  /** @brief Drop this value's reference to its heap block */
+  void release();
+
+  double number() const;
+  LongString *longString() const;
+
+  /**
+   * @brief Payload: a double, up to kInlineCapacity characters, or a
+   *        LongString pointer (accessed through memcpy)
+   */
+  alignas(8) unsigned char storage_[kInlineCapacity];
+  uint8_t length_ = 0; ///< Inline string length
+  Kind kind_ = Kind::Number;
 };
 
+static_assert(sizeof(Value) == 16, "Value must stay 16 bytes");
+
 /**
  * @struct Token
  * @brief Represents a single lexical token from the source code
  * 
  * Tokens are the output of the tokenizer and input to the parser.
- * Each token has a type, original text, optional value (for literals),
- * and position information for error reporting.
+ * Each token has a type, the place of its text in the tokenized line and,
+ * for literals, the index of its value in the line's constant pool. The
+ * text is not copied: the line the tokens came from (ProgramLine::text
+ * for program lines) must be at hand to read it, and so must the pool
+ * (ProgramLine::constants).
+ *
+ * Tokens are packed into 16 bytes: they are kept for every line of a
+ * loaded program unless --drop-tokens discards them after parsing.
  */
 struct Token {
+  /** @brief flags bit: constant indexes the line's constant pool */
+  static constexpr uint8_t kConstant = 1;
+
   /** @brief The type of this token */
-  TokenType type;
-  /** @brief Original text from source code */
-  std::string text;
-  /** @brief The value associated with this token (for literals) */
-  Value value;
-  /** @brief Source line number where this token appears */
-  int line;
-  /** @brief Column position in the source line */
-  int column;
+  TokenType type = TokenType::NEWLINE;
+  /** @brief Combination of the k... flag bits */
+  uint8_t flags = 0;
+  /** @brief Offset of the token's text in the tokenized line */
+  uint32_t offset = 0;
+  /** @brief Length of the token's text (a string literal's includes the
+   *         quotes) */
+  uint32_t length = 0;
+  /** @brief Index of the literal's value in the constant pool */
+  uint32_t constant = 0;
+
+  /** @brief Original text of the token in @p source, its line */
+  std::string_view text(std::string_view source) const {
+    return source.substr(offset, length);
+  }
+
+  /**
+   * @brief Value of a literal token
+   * @param constants The constant pool of the token's line
+   * @return The literal's value; 0 for tokens other than literals
+   */
+  const Value &value(const std::vector<Value> &constants) const {
+    static const Value kNone;
+    return flags & kConstant ? constants[constant] : kNone;
+  }
 };
 
+static_assert(sizeof(Token) == 16, "Token must stay 16 bytes");
+
+/**
+ * @brief Strategy used to execute stored program lines
+ *
+ * TreeWalker calls execute() on each parsed statement. Bytecode compiles each
+ * line once into a compact instruction array (see bytecode.h) and runs it
+ * from a single dispatch loop. Both engines share all runtime state and
+ * produce identical results.
+ */
+enum class ExecutionEngine { TreeWalker, Bytecode };
+
+/**
+ * @brief Default number of GOSUB/FOR/WHILE frames before OUT OF MEMORY ERROR
+ */
+inline constexpr size_t kDefaultControlStackDepth = 4096;
+
 /**
  * @struct ProgramLine
  * @brief Represents a single numbered line in a BASIC program
  * 
  * Each program line contains its line number, original source text,
  * tokenized representation, and parsed statement ASTs ready for execution.
+ * A line stored by a lazy LOAD holds only its number and text until it is
+ * first needed (see Interpreter::setLazyParsing()).
  */
 struct ProgramLine {
   /** @brief The line number (0-32767) */
   LineNumber lineNumber;
   /** @brief Original source text of the line */
   std::string text;
-  /** @brief Tokenized representation of the line */
+  /** @brief Tokenized representation of the line (empty once parsed if
+   *         tokens are dropped, see Interpreter::setDropTokens()) */
   std::vector<Token> tokens;
-  /** @brief Parsed statements ready for execution */
-  std::vector<std::shared_ptr<Statement>> statements;
+  /** @brief Values of the literals among the tokens */
+  std::vector<Value> constants;
+  /** @brief Parsed statements ready for execution (owned by an AstArena) */
+  std::vector<Statement *> statements;
+  /** @brief Arena of a line entered in the editor, freed with the line;
+   *         null when the statements live in an arena of the Program */
+  std::shared_ptr<AstArena> arena;
+  /** @brief Compiled bytecode (built on first run under the VM engine) */
+  std::shared_ptr<bytecode::Chunk> bytecode;
+  /** @brief false while tokens and statements have not been built yet */
+  bool parsed = true;
 };
@@ -9,10 +9,13 @@
  * 
  * Key implementation details:
  * - Variable names normalized to uppercase, 2-char significance
+ * - Simple variables live in a flat vector indexed by symbol-table slot
  * - FN functions preserve FN prefix + 2 chars (4 chars total)
  * - Integer variables (%) clamped to 16-bit signed range (-32768 to 32767)
  * - Arrays auto-dimension to size 10 per dimension if not explicitly DIM'd
- * - Sparse array storage using std::map keyed by dimension indices
+ * - Arrays stored densely in row-major order (double / int16_t / string),
+ *   demoted to a std::map keyed by dimension indices when huge or when used
+ *   with a mismatched subscript count or value type
  */
 
 #include "variables.h"
@@ -31,6 +34,15 @@ constexpr size_t FN_FUNCTION_NAME_LENGTH = 4; // FN prefix + 2 chars
  */
 Variables::Variables() {}
 
+Variables::Variables(const Variables &other)
+    : values_(other.values_), defined_(other.defined_),
+      functions_(other.functions_) {
+  arrays_.reserve(other.arrays_.size());
+  for (const auto &arr : other.arrays_) {
+    arrays_.push_back(arr ? std::make_unique<ArrayInfo>(*arr) : nullptr);
+  }
+}
+
 /**
  * @brief Normalize a variable name according to Applesoft conventions
  * 
@@ -49,7 +61,7 @@ Variables::Variables() {}
  * @param name Variable name to normalize
  * @return Normalized name
  */
-std::string Variables::normalizeName(const std::string &name) const {
+std::string SymbolTable::normalize(const std::string &name) {
   // In Applesoft BASIC, only first 2 characters are significant
   std::string normalized = name;
   std::transform(normalized.begin(), normalized.end(), normalized.begin(),
@@ -69,6 +81,51 @@ std::string Variables::normalizeName(const std::string &name) const {
   return normalized;
 }
 
+/**
+ * @brief Intern a variable name
+ *
+ * Normalizes the name and returns its slot, allocating a new slot the first
+ * time a normalized name is seen. The storage class is taken from the
+ * normalized name's suffix. Safe to call from several loader threads.
+ *
+ * @param name Variable name as written in the source
+ * @return Slot number for the normalized name
+ */
+SymbolId SymbolTable::intern(const std::string &name) {
+  std::string normalized = normalize(name);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = ids_.find(normalized);
+  if (it != ids_.end()) {
+    return it->second;
+  }
+  SymbolId id = size_.load(std::memory_order_relaxed);
+  if ((id >> kChunkBits) >= kMaxChunks) {
+    throw RuntimeError(ErrorKind::OutOfMemory);
+  }
+  auto &chunk = chunks_[id >> kChunkBits];
+  if (!chunk) {
+    chunk = std::make_unique<Entry[]>(kChunkSize);
+  }
+  Entry &entry = chunk[id & (kChunkSize - 1)];
+  if (!normalized.empty() && normalized.back() == '$') {
+    entry.kind = Kind::String;
+  } else if (!normalized.empty() && normalized.back() == '%') {
+    entry.kind = Kind::Integer;
+  }
+  entry.name = normalized;
+  ids_.emplace(std::move(normalized), id);
+  size_.store(id + 1, std::memory_order_release);
+  return id;
+}
+
+/**
+ * @brief Access the process-wide symbol table
+ */
+SymbolTable &symbols() {
+  static SymbolTable table;
+  return table;
+}
+
 namespace {
 /**
  * @brief Coerce a value to integer range
@@ -80,15 +137,34 @@ namespace {
  * @param value Value to coerce
  * @return Clamped integer value
  */
-Value coerceInteger(const Value &value) {
-  double n = value.getNumber();
+double clampInteger(double n) {
   // Applesoft integer variables are 16-bit signed; clamp to range.
   double clamped = std::llround(n);
   if (clamped > 32767.0)
     clamped = 32767.0;
   if (clamped < -32768.0)
     clamped = -32768.0;
-  return Value(clamped);
+  return clamped;
+}
+
+Value coerceInteger(const Value &value) {
+  return Value(clampInteger(value.getNumber()));
+}
+
+/**
+ * @brief Bounds-check the subscripts an array and an access have in common
+ *
+ * Only the leading min(count, dimensions) subscripts are checked, which is
+ * how mismatched subscript counts have always been treated.
+ */
+bool inBounds(const std::vector<int> &dimensions, const int *indices,
+              size_t count) {
+  for (size_t i = 0; i < count && i < dimensions.size(); ++i) {
+    if (indices[i] < 0 || indices[i] > dimensions[i]) {
+      return false;
+    }
+  }
+  return true;
 }
 } // namespace
 
@@ -112,11 +188,41 @@ Value coerceInteger(const Value &value) {
  * @param value Value to store (type coercion applied for %)
  */
 void Variables::setVariable(const std::string &name, const Value &value) {
-  if (!name.empty() && name.back() == '%') {
-    variables_[normalizeName(name)] = coerceInteger(value);
-    return;
+  setVariable(symbols().intern(name), value);
+}
+
+/**
+ * @brief Set a variable value by slot
+ *
+ * Same semantics as setVariable(name, value) without normalizing or looking
+ * up the name. Storage grows on demand as new slots are interned.
+ *
+ * @param slot Symbol slot of the variable
+ * @param value Value to store (type coercion applied for %)
+ */
+void Variables::setVariable(SymbolId slot, const Value &value) {
+  if (slot >= values_.size()) {
+    values_.resize(symbols().size());
+    defined_.resize(symbols().size(), 0);
+  }
+  if (symbols().kind(slot) == SymbolTable::Kind::Integer) {
+    values_[slot] = coerceInteger(value);
+  } else {
+    values_[slot] = value;
+  }
+  defined_[slot] = 1;
+}
+
+void Variables::setNumber(SymbolId slot, double value) {
+  if (slot >= values_.size()) {
+    values_.resize(symbols().size());
+    defined_.resize(symbols().size(), 0);
+  }
+  if (symbols().kind(slot) == SymbolTable::Kind::Integer) {
+    value = clampInteger(value);
   }
-  variables_[normalizeName(name)] = value;
+  values_[slot] = Value(value);
+  defined_[slot] = 1;
 }
 
 /**
@@ -128,7 +234,14 @@ void Variables::setVariable(const std::string &name, const Value &value) {
  * @param name Variable name to remove
  */
 void Variables::unsetVariable(const std::string &name) {
-  variables_.erase(normalizeName(name));
+  unsetVariable(symbols().intern(name));
+}
+
+void Variables::unsetVariable(SymbolId slot) {
+  if (slot < defined_.size()) {
+    defined_[slot] = 0;
+    values_[slot] = Value(0.0);
+  }
 }
 
 /**
@@ -148,17 +261,30 @@ void Variables::unsetVariable(const std::string &name) {
  * @return Variable value, or default if uninitialized
  */
 Value Variables::getVariable(const std::string &name) {
-  std::string normalized = normalizeName(name);
-  auto it = variables_.find(normalized);
-  if (it != variables_.end()) {
-    return it->second;
+  return getVariable(symbols().intern(name));
+}
+
+/**
+ * @brief Get a variable value by slot
+ *
+ * Same semantics as getVariable(name) without normalizing or looking up the
+ * name. Unassigned variables yield a shared default (0 or "").
+ *
+ * @param slot Symbol slot of the variable
+ * @return Reference to the stored value or to the default for its type
+ */
+const Value &Variables::getVariable(SymbolId slot) const {
+  if (slot < defined_.size() && defined_[slot]) {
+    return values_[slot];
   }
 
   // Uninitialized variables default to 0 or empty string
-  if (!name.empty() && name.back() == '$') {
-    return Value("");
+  static const Value emptyString{std::string()};
+  static const Value zero{0.0};
+  if (symbols().kind(slot) == SymbolTable::Kind::String) {
+    return emptyString;
   }
-  return Value(0.0);
+  return zero;
 }
 
 /**
@@ -171,7 +297,8 @@ Value Variables::getVariable(const std::string &name) {
  * @return true if variable has been set, false otherwise
  */
 bool Variables::hasVariable(const std::string &name) const {
-  return variables_.find(normalizeName(name)) != variables_.end();
+  SymbolId slot = symbols().intern(name);
+  return slot < defined_.size() && defined_[slot];
 }
 
 /**
@@ -184,7 +311,8 @@ bool Variables::hasVariable(const std::string &name) const {
  * This is called by the CLR and NEW commands.
  */
 void Variables::clear() {
-  variables_.clear();
+  values_.clear();
+  defined_.clear();
   arrays_.clear();
   // Don't clear functions - they persist
 }
@@ -206,8 +334,9 @@ void Variables::clear() {
  * - Explicit DIM overrides auto-dimension (if array not yet used)
  * 
  * Memory management:
- * - Uses sparse storage (only stores non-default values)
- * - Clearing array data frees all element storage
+ * - Arrays of up to kMaxDenseElements elements are allocated contiguously:
+ *   8 bytes per real element, 2 per integer (%) element
+ * - Larger arrays use sparse storage (only stores set values)
  * - Redimensioning clears existing array data
  * 
  * Error conditions:
@@ -219,10 +348,135 @@ void Variables::clear() {
  */
 void Variables::dimArray(const std::string &name,
                          const std::vector<int> &dimensions) {
-  std::string normalized = normalizeName(name);
-  ArrayInfo &arr = arrays_[normalized];
+  createArray(symbols().intern(name), dimensions);
+}
+
+Variables::ArrayInfo &
+Variables::createArray(SymbolId slot, const std::vector<int> &dimensions) {
+  if (slot >= arrays_.size()) {
+    arrays_.resize(symbols().size());
+  }
+  arrays_[slot] = std::make_unique<ArrayInfo>();
+  ArrayInfo &arr = *arrays_[slot];
   arr.dimensions = dimensions;
-  arr.data.clear();
+  arr.strides.assign(dimensions.size(), 0);
+
+  // Row-major: the last subscript varies fastest
+  size_t elements = 1;
+  for (size_t i = dimensions.size(); i-- > 0;) {
+    arr.strides[i] = elements;
+    size_t extent =
+        dimensions[i] < 0 ? 0 : static_cast<size_t>(dimensions[i]) + 1;
+    if (extent != 0 && elements > kMaxDenseElements / extent) {
+      elements = kMaxDenseElements + 1;
+      break;
+    }
+    elements *= extent;
+  }
+
+  if (elements > kMaxDenseElements) {
+    arr.storage = ArrayInfo::Storage::Sparse;
+    return arr;
+  }
+  switch (symbols().kind(slot)) {
+  case SymbolTable::Kind::String:
+    arr.storage = ArrayInfo::Storage::String;
+    arr.strings.resize(elements);
+    break;
+  case SymbolTable::Kind::Integer:
+    arr.storage = ArrayInfo::Storage::Integer;
+    arr.integers.resize(elements, 0);
+    break;
+  case SymbolTable::Kind::Numeric:
+    arr.storage = ArrayInfo::Storage::Real;
+    arr.reals.resize(elements, 0.0);
+    break;
+  }
+  return arr;
+}
+
+Variables::ArrayInfo &Variables::arrayFor(SymbolId slot, size_t count) {
+  if (slot < arrays_.size() && arrays_[slot]) {
+    return *arrays_[slot];
+  }
+  // Auto-dimension to 10 if not explicitly dimensioned (Applesoft behavior)
+  return createArray(slot, std::vector<int>(count, 10));
+}
+
+const Variables::ArrayInfo &
+Variables::findArray(const std::string &name) const {
+  SymbolId slot = symbols().intern(name);
+  if (slot >= arrays_.size() || !arrays_[slot]) {
+    throw RuntimeError(ErrorKind::UndefinedArray);
+  }
+  return *arrays_[slot];
+}
+
+Variables::Lookup Variables::denseOffset(const ArrayInfo &arr,
+                                         const int *indices, size_t count,
+                                         size_t &offset) {
+  if (arr.storage == ArrayInfo::Storage::Sparse ||
+      count != arr.dimensions.size()) {
+    return Lookup::Sparse;
+  }
+  size_t off = 0;
+  for (size_t i = 0; i < count; ++i) {
+    if (indices[i] < 0 || indices[i] > arr.dimensions[i]) {
+      return Lookup::OutOfBounds;
+    }
+    off += static_cast<size_t>(indices[i]) * arr.strides[i];
+  }
+  offset = off;
+  return Lookup::Dense;
+}
+
+void Variables::collectElements(const ArrayInfo &arr,
+                                std::map<std::vector<int>, Value> &out) {
+  size_t elements =
+      arr.reals.size() + arr.integers.size() + arr.strings.size();
+  std::vector<int> key(arr.dimensions.size(), 0);
+  for (size_t offset = 0; offset < elements; ++offset) {
+    if (offset > 0) {
+      // Advance the subscripts odometer-style, last subscript fastest
+      for (size_t i = key.size(); i-- > 0;) {
+        if (key[i] < arr.dimensions[i]) {
+          ++key[i];
+          break;
+        }
+        key[i] = 0;
+      }
+    }
+    switch (arr.storage) {
+    case ArrayInfo::Storage::Real:
+      if (arr.reals[offset] != 0.0) {
+        out[key] = Value(arr.reals[offset]);
+      }
+      break;
+    case ArrayInfo::Storage::Integer:
+      if (arr.integers[offset] != 0) {
+        out[key] = Value(static_cast<double>(arr.integers[offset]));
+      }
+      break;
+    case ArrayInfo::Storage::String:
+      if (!arr.strings[offset].empty()) {
+        out[key] = Value(arr.strings[offset]);
+      }
+      break;
+    case ArrayInfo::Storage::Sparse:
+      break;
+    }
+  }
+}
+
+void Variables::makeSparse(ArrayInfo &arr) {
+  if (arr.storage == ArrayInfo::Storage::Sparse) {
+    return;
+  }
+  collectElements(arr, arr.data);
+  arr.reals = {};
+  arr.integers = {};
+  arr.strings = {};
+  arr.storage = ArrayInfo::Storage::Sparse;
 }
 
 /**
@@ -242,10 +496,11 @@ void Variables::dimArray(const std::string &name,
  * - Values are clamped to 16-bit signed range (-32768 to 32767)
  * - Matches Applesoft BASIC integer variable behavior
  * 
- * Sparse storage:
- * - Only explicitly set elements are stored in memory
- * - Unset elements return default values (0 or "")
- * - Efficient for large arrays with few used elements
+ * Storage:
+ * - Dense arrays write the element in place at its stride offset
+ * - Storing a string in a numeric array (or a number in a string array), or
+ *   using a different subscript count than the array was dimensioned with,
+ *   moves the array to sparse storage so those uses keep working
  * 
  * Examples:
  *   A(5) = 100              (1D array access)
@@ -256,33 +511,75 @@ void Variables::dimArray(const std::string &name,
  * @param name Array name
  * @param indices Vector of indices (one per dimension)
  * @param value Value to store
- * @throws std::runtime_error if any index out of bounds ("BAD SUBSCRIPT ERROR")
+ * @throws RuntimeError if any index out of bounds (BAD SUBSCRIPT ERROR)
  */
 void Variables::setArrayElement(const std::string &name,
                                 const std::vector<int> &indices,
                                 const Value &value) {
-  std::string normalized = normalizeName(name);
+  setArrayElement(symbols().intern(name), indices.data(), indices.size(),
+                  value);
+}
 
-  if (arrays_.find(normalized) == arrays_.end()) {
-    // Auto-dimension to 10 if not explicitly dimensioned (Applesoft behavior)
-    std::vector<int> defaultDims(indices.size(), 10);
-    dimArray(name, defaultDims);
+void Variables::setArrayElement(SymbolId slot, const int *indices,
+                                size_t count, const Value &value) {
+  if (!writeArrayElement(slot, indices, count, value)) {
+    throw RuntimeError(ErrorKind::BadSubscript);
   }
+}
 
-  ArrayInfo &arr = arrays_[normalized];
-
-  // Check bounds
-  for (size_t i = 0; i < indices.size() && i < arr.dimensions.size(); ++i) {
-    if (indices[i] < 0 || indices[i] > arr.dimensions[i]) {
-      throw std::runtime_error("BAD SUBSCRIPT ERROR");
+/**
+ * @brief Set an array element, reporting a bad subscript by return value
+ *
+ * Same as setArrayElement(slot, ...) but does not throw, so statements can
+ * raise BAD SUBSCRIPT through the interpreter's error channel.
+ *
+ * @return false (and nothing stored) if a subscript is out of bounds
+ */
+bool Variables::writeArrayElement(SymbolId slot, const int *indices,
+                                  size_t count, const Value &value) {
+  ArrayInfo &arr = arrayFor(slot, count);
+
+  size_t offset;
+  switch (denseOffset(arr, indices, count, offset)) {
+  case Lookup::OutOfBounds:
+    return false;
+  case Lookup::Dense:
+    switch (arr.storage) {
+    case ArrayInfo::Storage::Real:
+      if (!value.isString()) {
+        arr.reals[offset] = value.getNumber();
+        return true;
+      }
+      break;
+    case ArrayInfo::Storage::Integer:
+      arr.integers[offset] =
+          static_cast<int16_t>(clampInteger(value.getNumber()));
+      return true;
+    case ArrayInfo::Storage::String:
+      if (value.isString()) {
+        arr.strings[offset] = value.getString();
+        return true;
+      }
+      break;
+    case ArrayInfo::Storage::Sparse:
+      break;
     }
+    break;
+  case Lookup::Sparse:
+    break;
   }
 
-  if (!name.empty() && name.back() == '%') {
-    arr.data[indices] = coerceInteger(value);
+  if (!inBounds(arr.dimensions, indices, count)) {
+    return false;
+  }
+  makeSparse(arr);
+  std::vector<int> key(indices, indices + count);
+  if (symbols().kind(slot) == SymbolTable::Kind::Integer) {
+    arr.data[key] = coerceInteger(value);
   } else {
-    arr.data[indices] = value;
+    arr.data[key] = value;
   }
+  return true;
 }
 
 /**
@@ -300,7 +597,6 @@ void Variables::setArrayElement(const std::string &name,
  * Default values:
  * - Uninitialized numeric array elements return 0.0
  * - Uninitialized string array elements return ""
- * - Sparse storage: only explicitly set elements consume memory
  * 
  * Bounds checking:
  * - Each index must be >= 0 and <= dimension size
@@ -321,37 +617,87 @@ void Variables::setArrayElement(const std::string &name,
  * @param name Array name
  * @param indices Vector of indices (one per dimension)
  * @return Array element value, or default (0 or "") if uninitialized
- * @throws std::runtime_error if any index out of bounds ("BAD SUBSCRIPT ERROR")
+ * @throws RuntimeError if any index out of bounds (BAD SUBSCRIPT ERROR)
  */
 Value Variables::getArrayElement(const std::string &name,
                                  const std::vector<int> &indices) {
-  std::string normalized = normalizeName(name);
+  return getArrayElement(symbols().intern(name), indices.data(),
+                         indices.size());
+}
 
-  if (arrays_.find(normalized) == arrays_.end()) {
-    // Auto-dimension to 10 if not explicitly dimensioned
-    std::vector<int> defaultDims(indices.size(), 10);
-    dimArray(name, defaultDims);
+Value Variables::getArrayElement(SymbolId slot, const int *indices,
+                                 size_t count) {
+  Value value;
+  if (!readArrayElement(slot, indices, count, value)) {
+    throw RuntimeError(ErrorKind::BadSubscript);
   }
+  return value;
+}
 
-  ArrayInfo &arr = arrays_[normalized];
-
-  // Check bounds
-  for (size_t i = 0; i < indices.size() && i < arr.dimensions.size(); ++i) {
-    if (indices[i] < 0 || indices[i] > arr.dimensions[i]) {
-      throw std::runtime_error("BAD SUBSCRIPT ERROR");
+/**
+ * @brief Read an array element, reporting a bad subscript by return value
+ *
+ * Same as getArrayElement(slot, ...) but does not throw, so the bytecode VM
+ * can raise BAD SUBSCRIPT through the interpreter's error channel.
+ *
+ * @return false (and @p value untouched) if a subscript is out of bounds
+ */
+bool Variables::readArrayElement(SymbolId slot, const int *indices,
+                                 size_t count, Value &value) {
+  ArrayInfo &arr = arrayFor(slot, count);
+
+  size_t offset;
+  switch (denseOffset(arr, indices, count, offset)) {
+  case Lookup::OutOfBounds:
+    return false;
+  case Lookup::Dense:
+    switch (arr.storage) {
+    case ArrayInfo::Storage::Real:
+      value = Value(arr.reals[offset]);
+      return true;
+    case ArrayInfo::Storage::Integer:
+      value = Value(static_cast<double>(arr.integers[offset]));
+      return true;
+    case ArrayInfo::Storage::String:
+      value = Value(arr.strings[offset]);
+      return true;
+    case ArrayInfo::Storage::Sparse:
+      break;
     }
+    break;
+  case Lookup::Sparse:
+    break;
   }
 
-  auto it = arr.data.find(indices);
+  if (!inBounds(arr.dimensions, indices, count)) {
+    return false;
+  }
+  auto it = arr.data.find(std::vector<int>(indices, indices + count));
   if (it != arr.data.end()) {
-    return it->second;
+    value = it->second;
+  } else if (symbols().kind(slot) == SymbolTable::Kind::String) {
+    // Uninitialized array elements default to 0 or empty string
+    value = Value("");
+  } else {
+    value = Value(0.0);
   }
+  return true;
+}
+
+double Variables::getArrayNumber(SymbolId slot, const int *indices,
+                                 size_t count) {
+  ArrayInfo &arr = arrayFor(slot, count);
 
-  // Uninitialized array elements default to 0 or empty string
-  if (!name.empty() && name.back() == '$') {
-    return Value("");
+  size_t offset;
+  if (denseOffset(arr, indices, count, offset) == Lookup::Dense) {
+    if (arr.storage == ArrayInfo::Storage::Real) {
+      return arr.reals[offset];
+    }
+    if (arr.storage == ArrayInfo::Storage::Integer) {
+      return arr.integers[offset];
+    }
   }
-  return Value(0.0);
+  return getArrayElement(slot, indices, count).getNumber();
 }
 
 /**
@@ -377,8 +723,8 @@ Value Variables::getArrayElement(const std::string &name,
  * - Redefining a function replaces the previous definition
  * 
  * Function evaluation:
- * - Function call FNxy(10) substitutes parameter with value 10
- * - Expression evaluated in context with parameter substituted
+ * - Function call FNxy(10) pushes 10 as a parameter frame; the body reads
+ *   its parameter from that frame, not from the variable table
  * - Can reference and modify global variables
  * - Recursive calls supported but uncommon
  * 
@@ -388,16 +734,23 @@ Value Variables::getArrayElement(const std::string &name,
  *   DEF FNC(Z) = INT(Z + 0.5)
  * 
  * @param name Function name (e.g., "FNXY") - normalized internally
- * @param param Parameter variable name (e.g., "X")
+ * @param param Slot of the parameter variable (e.g., "X")
  * @param expr Function body expression AST
+ * @param bindsVariable The body calls other user functions
+ * @param owner Arena holding the body
  */
-void Variables::defineFunction(const std::string &name,
-                               const std::string &param,
-                               const std::shared_ptr<Expression> &expr) {
-  std::string normalized = normalizeName(name);
-  FunctionInfo &func = functions_[normalized];
+void Variables::defineFunction(const std::string &name, SymbolId param,
+                               Expression *expr, bool bindsVariable,
+                               std::shared_ptr<AstArena> owner) {
+  SymbolId slot = symbols().intern(name);
+  if (slot >= functions_.size()) {
+    functions_.resize(symbols().size());
+  }
+  FunctionInfo &func = functions_[slot];
   func.parameter = param;
   func.body = expr;
+  func.bindsVariable = bindsVariable;
+  func.owner = std::move(owner);
 }
 
 /**
@@ -409,7 +762,8 @@ void Variables::defineFunction(const std::string &name,
  * @return true if function is defined, false otherwise
  */
 bool Variables::hasFunction(const std::string &name) const {
-  return functions_.find(normalizeName(name)) != functions_.end();
+  SymbolId slot = symbols().intern(name);
+  return slot < functions_.size() && functions_[slot].body;
 }
 
 /**
@@ -419,16 +773,29 @@ bool Variables::hasFunction(const std::string &name) const {
  * substitute the parameter value and evaluate the function body expression.
  * 
  * @param name Function name (e.g., "FNXY")
- * @return Function information (parameter name and body expression)
+ * @return Function information (parameter slot and body expression)
  * @throws std::runtime_error if function is not defined
  */
 const Variables::FunctionInfo &Variables::getFunction(const std::string &name) {
-  std::string normalized = normalizeName(name);
-  auto it = functions_.find(normalized);
-  if (it == functions_.end()) {
-    throw std::runtime_error("UNDEFINED FUNCTION ERROR");
+  return getFunction(symbols().intern(name));
+}
+
+/**
+ * @brief Push the argument of a user function call
+ *
+ * The argument is stored the way setVariable() would store it in the
+ * parameter, so the body sees the same value it would read from the
+ * variable.
+ *
+ * @param slot Slot of the parameter variable
+ * @param value Argument value
+ */
+void Variables::pushParameter(SymbolId slot, const Value &value) {
+  if (symbols().kind(slot) == SymbolTable::Kind::Integer) {
+    parameters_.push_back(coerceInteger(value));
+  } else {
+    parameters_.push_back(value);
   }
-  return it->second;
 }
 
 /**
@@ -441,7 +808,8 @@ const Variables::FunctionInfo &Variables::getFunction(const std::string &name) {
  * @return true if array exists, false otherwise
  */
 bool Variables::hasArray(const std::string &name) const {
-  return arrays_.find(normalizeName(name)) != arrays_.end();
+  SymbolId slot = symbols().intern(name);
+  return slot < arrays_.size() && arrays_[slot];
 }
 
 /**
@@ -457,33 +825,26 @@ bool Variables::hasArray(const std::string &name) const {
  * @throws std::runtime_error if array not defined
  */
 const std::vector<int> &Variables::getArrayDimensions(const std::string &name) const {
-  std::string normalized = normalizeName(name);
-  auto it = arrays_.find(normalized);
-  if (it == arrays_.end()) {
-    throw std::runtime_error("UNDEFINED ARRAY ERROR");
-  }
-  return it->second.dimensions;
+  return findArray(name).dimensions;
 }
 
 /**
  * @brief Get array data storage
  * 
- * Returns the sparse array data map. Array elements are stored as
- * map entries keyed by dimension indices. Uninitialized elements
- * are not stored (sparse storage).
+ * Returns the array elements as map entries keyed by dimension indices.
+ * Elements holding the default value (0 or "") are omitted, so the map
+ * stays small for mostly empty arrays.
  * 
  * @param name Array name
  * @return Map of dimension indices to values
  * @throws std::runtime_error if array not defined
  */
-const std::map<std::vector<int>, Value> &
+std::map<std::vector<int>, Value>
 Variables::getArrayData(const std::string &name) const {
-  std::string normalized = normalizeName(name);
-  auto it = arrays_.find(normalized);
-  if (it == arrays_.end()) {
-    throw std::runtime_error("UNDEFINED ARRAY ERROR");
-  }
-  return it->second.data;
+  const ArrayInfo &arr = findArray(name);
+  std::map<std::vector<int>, Value> data = arr.data;
+  collectElements(arr, data);
+  return data;
 }
 
 /**
@@ -499,10 +860,12 @@ Variables::getArrayData(const std::string &name) const {
 void Variables::setArrayData(const std::string &name,
                              const std::vector<int> &dimensions,
                              const std::map<std::vector<int>, Value> &data) {
-  std::string normalized = normalizeName(name);
-  ArrayInfo &arr = arrays_[normalized];
-  arr.dimensions = dimensions;
-  arr.data = data;
+  SymbolId slot = symbols().intern(name);
+  createArray(slot, dimensions);
+  for (const auto &entry : data) {
+    setArrayElement(slot, entry.first.data(), entry.first.size(),
+                    entry.second);
+  }
 }
 
 /**
@@ -515,9 +878,10 @@ void Variables::setArrayData(const std::string &name,
  */
 std::map<std::string, double> Variables::getAllNumericVariables() const {
   std::map<std::string, double> numVars;
-  for (const auto &pair : variables_) {
-    if (!pair.second.isString()) {
-      numVars[pair.first] = pair.second.getNumber();
+  for (size_t slot = 0; slot < defined_.size(); ++slot) {
+    if (defined_[slot] && !values_[slot].isString()) {
+      numVars[symbols().name(static_cast<SymbolId>(slot))] =
+          values_[slot].getNumber();
     }
   }
   return numVars;
@@ -533,10 +897,61 @@ std::map<std::string, double> Variables::getAllNumericVariables() const {
  */
 std::map<std::string, std::string> Variables::getAllStringVariables() const {
   std::map<std::string, std::string> strVars;
-  for (const auto &pair : variables_) {
-    if (pair.second.isString()) {
-      strVars[pair.first] = pair.second.getString();
+  for (size_t slot = 0; slot < defined_.size(); ++slot) {
+    if (defined_[slot] && values_[slot].isString()) {
+      strVars[symbols().name(static_cast<SymbolId>(slot))] =
+          values_[slot].getString();
     }
   }
   return strVars;
 }
+
+namespace {
+/** @brief Exact equality (Value::operator== allows Float40 tolerance) */
+bool sameValue(const Value &a, const Value &b) {
+  if (a.isNumber() != b.isNumber()) {
+    return false;
+  }
+  return a.isNumber() ? a.getNumber() == b.getNumber()
+                      : a.stringView() == b.stringView();
+}
+} // namespace
+
+std::string Variables::firstDifference(const Variables &other) const {
+  size_t slots = std::max(defined_.size(), other.defined_.size());
+  for (size_t slot = 0; slot < slots; ++slot) {
+    bool mine = slot < defined_.size() && defined_[slot];
+    bool theirs = slot < other.defined_.size() && other.defined_[slot];
+    if (mine != theirs ||
+        (mine && !sameValue(values_[slot], other.values_[slot]))) {
+      return symbols().name(static_cast<SymbolId>(slot));
+    }
+  }
+
+  slots = std::max(arrays_.size(), other.arrays_.size());
+  for (size_t slot = 0; slot < slots; ++slot) {
+    const ArrayInfo *mine =
+        slot < arrays_.size() ? arrays_[slot].get() : nullptr;
+    const ArrayInfo *theirs =
+        slot < other.arrays_.size() ? other.arrays_[slot].get() : nullptr;
+    if (!mine && !theirs) {
+      continue;
+    }
+    bool same = mine && theirs && mine->storage == theirs->storage &&
+                mine->dimensions == theirs->dimensions &&
+                mine->reals == theirs->reals &&
+                mine->integers == theirs->integers &&
+                mine->strings == theirs->strings &&
+                mine->data.size() == theirs->data.size() &&
+                std::equal(mine->data.begin(), mine->data.end(),
+                           theirs->data.begin(),
+                           [](const auto &a, const auto &b) {
+                             return a.first == b.first &&
+                                    sameValue(a.second, b.second);
+                           });
+    if (!same) {
+      return symbols().name(static_cast<SymbolId>(slot)) + "()";
+    }
+  }
+  return "";
+}
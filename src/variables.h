@@ -9,21 +9,118 @@
  * 
  * Key features:
  * - Applesoft-compatible variable name normalization (first 2 chars significant)
- * - Sparse array storage for memory efficiency
+ * - Program-wide symbol table: the parser interns each variable name once and
+ *   AST nodes access values by numeric slot instead of by name
+ * - Dense row-major array storage (double, int16_t or string per array),
+ *   with a sparse fallback for huge or irregularly used arrays
  * - Type-safe value storage with automatic coercion
  * - Function parameter substitution
  */
 
 #pragma once
 
+#include "errors.h"
 #include "types.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+class AstArena;
 class Expression;
 
+/** @brief Slot number of an interned variable name */
+using SymbolId = uint32_t;
+
+/** @brief SymbolId that names no variable (bare NEXT) */
+inline constexpr SymbolId kNoSymbol = UINT32_MAX;
+
+/**
+ * @class SymbolTable
+ * @brief Program-wide interning of normalized variable names
+ *
+ * Maps every normalized simple-variable name to a dense slot number. Names
+ * are normalized before interning, so spellings that Applesoft treats as the
+ * same variable (COUNT and CO) share one slot. Slots are never reused, so an
+ * id stays valid for the life of the process.
+ *
+ * The table is shared by the parallel program loader: intern() takes a lock,
+ * while name() and kind() read without one. Entries live in fixed-size
+ * chunks that are never moved, so a slot handed out by intern() can be read
+ * from any thread while other threads keep adding names.
+ */
+class SymbolTable {
+public:
+  /** @brief Storage class of a variable, derived from its suffix */
+  enum class Kind : uint8_t { Numeric, Integer, String };
+
+  /**
+   * @brief Get (or create) the slot for a variable name
+   * @param name Variable name as written in the source (any case)
+   * @return Slot shared by all names with the same normalized form
+   */
+  SymbolId intern(const std::string &name);
+
+  /** @brief Normalized name of a slot */
+  const std::string &name(SymbolId id) const { return entry(id).name; }
+
+  /** @brief Storage class of a slot */
+  Kind kind(SymbolId id) const { return entry(id).kind; }
+
+  /** @brief Number of interned names */
+  size_t size() const { return size_.load(std::memory_order_acquire); }
+
+  /**
+   * @brief Normalize a name according to Applesoft conventions
+   *
+   * Normalization rules:
+   * - Convert to uppercase
+   * - Extract first 2 characters (excluding type suffixes)
+   * - Preserve $ and % suffixes
+   * - Special handling for FN names (preserve FN + 2 chars)
+   *
+   * Examples:
+   * - "Hello" -> "HE"
+   * - "Name$" -> "NA$"
+   * - "Count%" -> "CO%"
+   * - "FNabc" -> "FNAB"
+   *
+   * @param name Original variable name
+   * @return std::string Normalized name
+   */
+  static std::string normalize(const std::string &name);
+
+private:
+  struct Entry {
+    std::string name;
+    Kind kind = Kind::Numeric;
+  };
+
+  static constexpr unsigned kChunkBits = 10;
+  static constexpr size_t kChunkSize = size_t{1} << kChunkBits;
+  static constexpr size_t kMaxChunks = 4096;
+
+  const Entry &entry(SymbolId id) const {
+    return chunks_[id >> kChunkBits][id & (kChunkSize - 1)];
+  }
+
+  std::mutex mutex_; // guards ids_ and the growth of chunks_
+  std::unordered_map<std::string, SymbolId> ids_;
+  std::array<std::unique_ptr<Entry[]>, kMaxChunks> chunks_;
+  std::atomic<SymbolId> size_{0};
+};
+
+/**
+ * @brief Process-wide symbol table shared by the parser and Variables
+ */
+SymbolTable &symbols();
+
 /**
  * @class Variables
  * @brief Storage and management for program variables, arrays, and functions
@@ -40,7 +137,7 @@ class Expression;
  * Arrays:
  * - Multi-dimensional with arbitrary dimension count
  * - Auto-dimension to size 10 per dimension if undeclared
- * - Sparse storage using std::map for memory efficiency
+ * - Contiguous typed storage indexed through precomputed strides
  * - Bounds checking with "BAD SUBSCRIPT" error
  * 
  * User-defined functions:
@@ -55,6 +152,14 @@ public:
    */
   Variables();
 
+  /**
+   * @brief Deep copy of all variables, arrays and function definitions
+   *
+   * Used by the loop tier's check mode to run a loop on a scratch copy.
+   */
+  Variables(const Variables &other);
+  Variables &operator=(const Variables &) = delete;
+
   // Variable operations
   
   /**
@@ -84,6 +189,35 @@ public:
    * @throws std::runtime_error if variable doesn't exist
    */
   Value getVariable(const std::string &name);
+
+  /**
+   * @brief Get a variable's value by symbol slot
+   *
+   * Fast path used by AST nodes that interned their variable at parse time.
+   *
+   * @param slot Slot from symbols().intern()
+   * @return Reference to the value (a shared default if never assigned);
+   *         valid until the next assignment or clear()
+   */
+  const Value &getVariable(SymbolId slot) const;
+
+  /**
+   * @brief Set a variable's value by symbol slot
+   *
+   * @param slot Slot from symbols().intern()
+   * @param value The value to store (clamped for integer variables)
+   */
+  void setVariable(SymbolId slot, const Value &value);
+
+  /**
+   * @brief Store a number in a variable by symbol slot
+   *
+   * Same as setVariable(slot, Value(value)) for numeric variables.
+   *
+   * @param slot Slot from symbols().intern()
+   * @param value The number to store (clamped for integer variables)
+   */
+  void setNumber(SymbolId slot, double value);
   
   /**
    * @brief Check if a variable exists
@@ -105,8 +239,9 @@ public:
   /**
    * @brief Dimension an array with specified sizes
    * 
-   * Creates a new array with the given dimensions. Arrays are stored
-   * sparsely - elements are created on demand.
+   * Creates a new array with the given dimensions. Arrays up to
+   * kMaxDenseElements elements get contiguous typed storage; larger ones
+   * are stored sparsely and elements are created on demand.
    * 
    * @param name Array name (normalized)
    * @param dimensions Vector of dimension sizes (each must be > 0)
@@ -123,7 +258,7 @@ public:
    * @param name Array name
    * @param indices Subscript values for each dimension
    * @param value The value to store
-   * @throws std::runtime_error on bad subscript (out of bounds)
+   * @throws RuntimeError on bad subscript (out of bounds)
    */
   void setArrayElement(const std::string &name, const std::vector<int> &indices,
                        const Value &value);
@@ -137,11 +272,62 @@ public:
    * @param name Array name
    * @param indices Subscript values for each dimension
    * @return Value The element's value
-   * @throws std::runtime_error on bad subscript (out of bounds)
+   * @throws RuntimeError on bad subscript (out of bounds)
    */
   Value getArrayElement(const std::string &name,
                         const std::vector<int> &indices);
 
+  /**
+   * @brief Get an array element by symbol slot
+   *
+   * Fast path used by AST nodes that interned their array name at parse
+   * time; subscripts are passed without building a vector.
+   *
+   * @param slot Slot from symbols().intern()
+   * @param indices Pointer to @p count subscripts
+   * @param count Number of subscripts
+   * @return Value The element's value
+   * @throws RuntimeError on bad subscript (out of bounds)
+   */
+  Value getArrayElement(SymbolId slot, const int *indices, size_t count);
+
+  /**
+   * @brief Get an array element as a number by symbol slot
+   *
+   * Same as getArrayElement(slot, ...).getNumber(), but reads dense real and
+   * integer arrays without constructing a Value.
+   */
+  double getArrayNumber(SymbolId slot, const int *indices, size_t count);
+
+  /**
+   * @brief Set an array element by symbol slot
+   *
+   * @param slot Slot from symbols().intern()
+   * @param indices Pointer to @p count subscripts
+   * @param count Number of subscripts
+   * @param value The value to store
+   * @throws RuntimeError on bad subscript (out of bounds)
+   */
+  void setArrayElement(SymbolId slot, const int *indices, size_t count,
+                       const Value &value);
+
+  /**
+   * @brief Non-throwing form of getArrayElement(slot, ...)
+   * @return false (@p value untouched) on a bad subscript
+   */
+  bool readArrayElement(SymbolId slot, const int *indices, size_t count,
+                        Value &value);
+
+  /**
+   * @brief Non-throwing form of setArrayElement(slot, ...)
+   * @return false (nothing stored) on a bad subscript
+   */
+  bool writeArrayElement(SymbolId slot, const int *indices, size_t count,
+                         const Value &value);
+
+  /** @brief Largest array (in elements) that gets contiguous storage */
+  static constexpr size_t kMaxDenseElements = size_t{1} << 22;
+
   // User-defined functions
   
   /**
@@ -151,11 +337,15 @@ public:
    * Function calls will substitute the parameter value and evaluate the body.
    * 
    * @param name Function name (e.g., "FNxy")
-   * @param param Parameter name (e.g., "x")
+   * @param param Slot of the parameter variable
    * @param expr Expression AST for the function body
+   * @param bindsVariable Also assign the argument to the parameter variable
+   *        during calls (see FunctionInfo::bindsVariable)
+   * @param owner Arena holding @p expr (kept alive with the definition)
    */
-  void defineFunction(const std::string &name, const std::string &param,
-                      const std::shared_ptr<Expression> &expr);
+  void defineFunction(const std::string &name, SymbolId param,
+                      Expression *expr, bool bindsVariable,
+                      std::shared_ptr<AstArena> owner);
   
   /**
    * @brief Check if a function is defined
@@ -170,10 +360,21 @@ public:
    * @brief Storage for user-defined function details
    */
   struct FunctionInfo {
-    /** @brief Parameter variable name */
-    std::string parameter;
-    /** @brief Function body expression AST */
-    std::shared_ptr<Expression> body;
+    /** @brief Slot of the parameter variable */
+    SymbolId parameter = 0;
+    /** @brief Function body expression AST (null when not defined) */
+    Expression *body = nullptr;
+    /**
+     * @brief The body calls other user functions
+     *
+     * Applesoft binds the parameter dynamically, so a function called from
+     * the body may read it by name. Such calls also assign the argument to
+     * the parameter variable and restore it afterwards; all other calls
+     * leave the variable table alone.
+     */
+    bool bindsVariable = false;
+    /** @brief Arena that owns body (it may outlive its program) */
+    std::shared_ptr<AstArena> owner;
   };
 
   /**
@@ -185,6 +386,48 @@ public:
    */
   const FunctionInfo &getFunction(const std::string &name);
 
+  /**
+   * @brief Get function definition by the slot of its normalized name
+   *
+   * @param slot Slot from symbols().intern() of the FN name
+   * @return const FunctionInfo& Function details
+   * @throws std::runtime_error if function not defined
+   */
+  const FunctionInfo &getFunction(SymbolId slot) const {
+    if (slot >= functions_.size() || !functions_[slot].body) {
+      throw RuntimeError(ErrorKind::UndefinedFunction);
+    }
+    return functions_[slot];
+  }
+
+  // Parameter frames of DEF FN calls in progress
+
+  /**
+   * @brief Push the argument of a user function call
+   *
+   * @param slot Slot of the parameter (integer parameters are clamped)
+   * @param value Argument value
+   */
+  void pushParameter(SymbolId slot, const Value &value);
+
+  /** @brief Argument of the innermost call in progress */
+  const Value &parameter() const { return parameters_.back(); }
+
+  /** @brief Pop the innermost parameter frame */
+  void popParameter() { parameters_.pop_back(); }
+
+  /**
+   * @brief Check if a variable has been assigned, by symbol slot
+   */
+  bool isDefined(SymbolId slot) const {
+    return slot < defined_.size() && defined_[slot];
+  }
+
+  /**
+   * @brief Remove a variable by symbol slot
+   */
+  void unsetVariable(SymbolId slot);
+
   // Array persistence helpers
   
   /**
@@ -207,13 +450,14 @@ public:
   /**
    * @brief Get array data (for persistence)
    * 
-   * Returns the sparse map of array elements for saving to disk.
+   * Returns the elements that hold a non-default value, keyed by their
+   * subscripts, for saving to disk.
    * 
    * @param name Array name
-   * @return const std::map<std::vector<int>, Value>& Array element map
+   * @return std::map<std::vector<int>, Value> Array element map
    * @throws std::runtime_error if array doesn't exist
    */
-  const std::map<std::vector<int>, Value> &getArrayData(const std::string &name) const;
+  std::map<std::vector<int>, Value> getArrayData(const std::string &name) const;
   
   /**
    * @brief Set array data (for restoration)
@@ -249,44 +493,93 @@ public:
    */
   std::map<std::string, std::string> getAllStringVariables() const;
 
+  /**
+   * @brief Find the first variable or array whose contents differ
+   *
+   * Numbers are compared exactly (no Float40 tolerance) and arrays must
+   * also use the same storage.
+   *
+   * @param other Variables to compare with
+   * @return Name of the first differing variable or array ("A()"), or an
+   *         empty string if both hold the same state
+   */
+  std::string firstDifference(const Variables &other) const;
+
 private:
-  /** @brief Map of simple variables (normalized name -> value) */
-  std::map<std::string, Value> variables_;
+  /** @brief Simple variable values indexed by symbol slot */
+  std::vector<Value> values_;
+  /** @brief Per-slot flag: variable has been assigned since the last clear */
+  std::vector<uint8_t> defined_;
 
   /**
    * @struct ArrayInfo
    * @brief Storage structure for array metadata and data
+   *
+   * Exactly one of the element containers is in use, selected by
+   * @c storage. Dense containers are row-major: the element at subscripts
+   * (i0, i1, ...) lives at offset i0*strides[0] + i1*strides[1] + ...
    */
   struct ArrayInfo {
-    /** @brief Size of each dimension */
+    /** @brief Element container in use */
+    enum class Storage : uint8_t { Real, Integer, String, Sparse };
+
+    /** @brief Size of each dimension (highest valid subscript) */
     std::vector<int> dimensions;
+    /** @brief Row-major stride of each dimension, in elements */
+    std::vector<size_t> strides;
+    Storage storage = Storage::Real;
+    /** @brief Dense elements of a real array */
+    std::vector<double> reals;
+    /** @brief Dense elements of an integer (%) array */
+    std::vector<int16_t> integers;
+    /** @brief Dense elements of a string ($) array */
+    std::vector<std::string> strings;
     /** @brief Sparse map of element indices to values */
     std::map<std::vector<int>, Value> data;
   };
   
-  /** @brief Map of arrays (normalized name -> array info) */
-  std::map<std::string, ArrayInfo> arrays_;
+  /** @brief Arrays indexed by symbol slot (null when not dimensioned) */
+  std::vector<std::unique_ptr<ArrayInfo>> arrays_;
+
+  /** @brief (Re)create an array, choosing dense or sparse storage */
+  ArrayInfo &createArray(SymbolId slot, const std::vector<int> &dimensions);
+
+  /** @brief Look up an array, auto-dimensioning it to 10 if undeclared */
+  ArrayInfo &arrayFor(SymbolId slot, size_t count);
+
+  /** @brief Const lookup by name; throws UNDEFINED ARRAY ERROR if absent */
+  const ArrayInfo &findArray(const std::string &name) const;
 
-  /** @brief Map of user-defined functions (normalized name -> function info) */
-  std::map<std::string, FunctionInfo> functions_;
+  /** @brief Outcome of denseOffset() */
+  enum class Lookup {
+    Dense,      ///< offset addresses the element in dense storage
+    Sparse,     ///< wrong dimension count or sparse array
+    OutOfBounds ///< a subscript is out of bounds
+  };
+
+  /** @brief Bounds-check subscripts and compute the dense element offset */
+  static Lookup denseOffset(const ArrayInfo &arr, const int *indices,
+                            size_t count, size_t &offset);
+
+  /** @brief Add a dense array's non-default elements to @p out */
+  static void collectElements(const ArrayInfo &arr,
+                              std::map<std::vector<int>, Value> &out);
+
+  /** @brief Move a dense array's non-default elements into sparse storage */
+  static void makeSparse(ArrayInfo &arr);
+
+  /** @brief User-defined functions indexed by the slot of their name */
+  std::vector<FunctionInfo> functions_;
 
   /**
-   * @brief Normalize variable name according to Applesoft conventions
-   * 
-   * Normalization rules:
-   * - Convert to uppercase
-   * - Extract first 2 characters (excluding type suffixes)
-   * - Preserve $ and % suffixes
-   * - Special handling for FN names (preserve FN + 2 chars)
-   * 
-   * Examples:
-   * - "Hello" -> "HE"
-   * - "Name$" -> "NA$"
-   * - "Count%" -> "CO%"
-   * - "FNabc" -> "FNAB"
-   * 
-   * @param name Original variable name
-   * @return std::string Normalized name
+   * @brief Arguments of the DEF FN calls in progress (innermost last)
+   *
+   * The capacity is kept between calls, so calls do not allocate.
    */
-  std::string normalizeName(const std::string &name) const;
+  std::vector<Value> parameters_;
+
+  /** @brief Normalize a name (see SymbolTable::normalize) */
+  std::string normalizeName(const std::string &name) const {
+    return SymbolTable::normalize(name);
+  }
 };
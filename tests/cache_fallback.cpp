@@ -0,0 +1,154 @@
+/**
+ * @file cache_fallback.cpp
+ * @brief Check that damaged program cache files fall back to the source
+ *
+ * Runs msbasic on a small program with MSBASIC_CACHE_DIR pointing at an
+ * empty directory, then damages the cache file it wrote in each way the
+ * loader must detect: a truncated file, a payload that fails its checksum,
+ * another format version and a source that changed since the file was
+ * written. Every run must print the program's output as loaded from the
+ * text source, and after each fallback the cache must be rewritten.
+ *
+ * Usage: msbasic_cache_fallback <msbasic> <work directory>
+ *
+ * The work directory is emptied first. The test sets MSBASIC_CACHE_DIR for
+ * the runs itself.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+using Bytes = std::vector<char>;
+
+/** @brief Offset of the format version: after the magic and byte order */
+constexpr size_t kFormatVersionOffset = 8;
+
+std::string msbasic;
+fs::path workDir;
+fs::path cacheDir;
+fs::path programFile;
+int failures = 0;
+
+void check(bool ok, const std::string &what) {
+  if (!ok) {
+    std::cerr << "FAILED: " << what << "\n";
+    ++failures;
+  }
+}
+
+Bytes readFile(const fs::path &file) {
+  std::ifstream in(file, std::ios::binary);
+  return Bytes(std::istreambuf_iterator<char>(in),
+               std::istreambuf_iterator<char>());
+}
+
+void writeFile(const fs::path &file, const Bytes &bytes) {
+  std::ofstream out(file, std::ios::binary | std::ios::trunc);
+  out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+void writeProgram(const std::string &text) {
+  std::ofstream(programFile, std::ios::binary) << text;
+}
+
+std::string quote(const std::string &text) { return "\"" + text + "\""; }
+
+/** @brief Output of one msbasic run of the program */
+std::string run() {
+  fs::path output = workDir / "output.txt";
+  std::string command = quote(msbasic) + " " + quote(programFile.string()) +
+                        " > " + quote(output.string()) + " 2>&1";
+#ifdef _WIN32
+  // cmd.exe strips the outer quotes of a command that starts with one
+  command = "\"" + command + "\"";
+#endif
+  if (std::system(command.c_str()) != 0) {
+    check(false, "msbasic exited with an error");
+  }
+  Bytes bytes = readFile(output);
+  return std::string(bytes.begin(), bytes.end());
+}
+
+/** @brief The single cache file, or an empty path */
+fs::path cacheFile() {
+  std::vector<fs::path> files;
+  for (const auto &entry : fs::directory_iterator(cacheDir)) {
+    files.push_back(entry.path());
+  }
+  return files.size() == 1 ? files.front() : fs::path();
+}
+
+/** @brief Damage the cache file, run and expect the source's output */
+void expectFallback(const std::string &what, const Bytes &damaged,
+                    const Bytes &pristine, const std::string &expected) {
+  writeFile(cacheFile(), damaged);
+  std::string output = run();
+  check(output.find(expected) != std::string::npos,
+        what + ": printed \"" + output + "\"");
+  check(readFile(cacheFile()) == pristine, what + ": cache not rewritten");
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <msbasic> <work directory>\n";
+    return 2;
+  }
+  msbasic = argv[1];
+  workDir = fs::absolute(argv[2]);
+  cacheDir = workDir / "cache";
+  programFile = workDir / "program.bas";
+  fs::remove_all(workDir);
+  fs::create_directories(cacheDir);
+#ifdef _WIN32
+  _putenv_s("MSBASIC_CACHE_DIR", cacheDir.string().c_str());
+#else
+  setenv("MSBASIC_CACHE_DIR", cacheDir.string().c_str(), 1);
+#endif
+
+  const std::string expected = "RESULT 42";
+  writeProgram("10 DIM A(3)\n20 FOR I=1 TO 3: A(I)=I*7: NEXT\n"
+               "30 PRINT \"RESULT \";A(1)+A(2)+A(3)\n");
+  check(run().find(expected) != std::string::npos, "first run");
+  check(!cacheFile().empty(), "no cache file written");
+  if (failures != 0) {
+    return 1;
+  }
+  const Bytes pristine = readFile(cacheFile());
+  check(run().find(expected) != std::string::npos, "cached run");
+  check(readFile(cacheFile()) == pristine, "cached run changed the cache");
+
+  Bytes truncated(pristine.begin(), pristine.begin() + pristine.size() / 2);
+  expectFallback("truncated file", truncated, pristine, expected);
+
+  Bytes corrupted = pristine;
+  corrupted.back() ^= 0x55;
+  expectFallback("checksum mismatch", corrupted, pristine, expected);
+
+  Bytes otherVersion = pristine;
+  ++otherVersion[kFormatVersionOffset];
+  expectFallback("format version", otherVersion, pristine, expected);
+
+  // The cache still holds the old program: the edited source must win
+  writeProgram("10 DIM A(3)\n20 FOR I=1 TO 3: A(I)=I*8: NEXT\n"
+               "30 PRINT \"RESULT \";A(1)+A(2)+A(3)\n");
+  std::string output = run();
+  check(output.find("RESULT 48") != std::string::npos,
+        "changed source: printed \"" + output + "\"");
+  check(readFile(cacheFile()) != pristine, "changed source: cache kept");
+
+  if (failures != 0) {
+    return 1;
+  }
+  std::cout << "CACHE FALLBACK OK\n";
+  return 0;
+}
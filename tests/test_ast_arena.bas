@@ -0,0 +1,13 @@
+10 REM AST ARENA - NODES SHARED BY DEF FN, WHILE AND FUSED STATEMENTS
+20 DEF FNA(X) = X * X + 1
+30 DEF FNB(X) = FNA(X) - FNA(X - 1)
+40 IF FNB(5) <> 9 THEN 1/0
+50 DEF FNA(X) = X + 1
+60 IF FNB(5) <> 1 THEN 1/0
+70 N = 0: S = 0
+80 WHILE N < 10: N = N + 1: S = S + FNA(N): WEND
+90 IF S <> 65 THEN 1/0
+100 GOSUB 200: IF R <> 42 THEN 1/0
+110 PRINT "AST ARENA OK"
+120 END
+200 DEF FNC(Y) = Y * 2: R = FNC(21): RETURN
@@ -0,0 +1,15 @@
+10 REM CONSTANT FOLDING - FOLDED VALUES MATCH RUN-TIME EVALUATION
+20 X = 2*3.14159/360: Y = 2: Y = Y*3.14159: Y = Y/360
+30 IF X<>Y THEN 1/0
+40 IF CHR$(65)+"B"<>"AB" THEN 1/0
+50 IF LEN("ABC")*2<>6 THEN 1/0
+60 N = 5: IF STR$(5)<>STR$(N) THEN 1/0
+70 I% = 7: IF I%+0<>7 OR 1*I%<>7 OR +I%<>7 THEN 1/0
+80 IF -(2^3)<>-8 OR NOT 0<>1 THEN 1/0
+90 IF 0 THEN 1/0
+100 Z = 0.1: IF Z+0<>Z THEN 1/0
+110 ONERR GOTO 150
+120 PRINT 1/0
+130 PRINT "MISSING DIVISION BY ZERO": GOTO 1
+150 PRINT "CONSTANT FOLDING OK"
+160 END
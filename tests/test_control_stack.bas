@@ -0,0 +1,33 @@
+10 REM CONTROL STACK - SHARED GOSUB FOR WHILE FRAMES AND OVERFLOW
+20 ONERR GOTO 900
+30 REM RUNAWAY RECURSION STOPS WITH OUT OF MEMORY AT THE DEPTH LIMIT
+40 D = 0: E = 0: R = 1: GOSUB 500
+50 IF E <> 1 OR D <> 4096 THEN 1/0
+60 POP: D = D - 1: IF D > 0 THEN 60
+70 E = 0: R = 2: POP
+80 IF E <> 1 THEN 1/0
+90 REM RETURN DROPS THE LOOPS OPENED INSIDE THE SUBROUTINE
+100 GOSUB 600
+110 E = 0: R = 3: NEXT I
+120 IF E <> 1 THEN 1/0
+130 REM NEXT AND WEND DO NOT SEE LOOPS BELOW THE INNERMOST GOSUB
+140 E = 0: FOR K = 1 TO 2: GOSUB 700: NEXT K
+150 IF E <> 4 OR K <> 3 THEN 1/0
+160 REM LOOPS LEFT WITH GOTO ARE DROPPED WHEN THEY ARE ENTERED AGAIN
+170 N = 0
+180 WHILE N < 10000
+190 N = N + 1: IF N < 10000 THEN 180
+200 WEND
+210 N = 0
+220 FOR I = 1 TO 2: N = N + 1: IF N < 10000 THEN 220
+230 REM THE OPEN FOR FRAME SHARES THE STACK WITH THE GOSUB FRAMES
+240 D = 0: E = 0: R = 4: GOSUB 500
+250 IF E <> 1 OR D <> 4095 THEN 1/0
+260 PRINT "CONTROL STACK OK"
+270 END
+500 D = D + 1: GOSUB 500
+600 FOR I = 1 TO 3: WHILE 1: RETURN
+700 R = 5: NEXT K
+900 E = E + 1: ON R GOTO 50, 80, 120, 250, 910, 920
+910 R = 6: WEND
+920 RETURN
@@ -0,0 +1,22 @@
+10 DIM V(3)
+20 READ A,B$,V(2)
+30 IF A<>1 OR B$<>"TWO" OR V(2)<>3 THEN 1/0
+40 RESTORE 215
+50 READ A
+60 IF A<>4 THEN 1/0
+70 RESTORE 230
+80 READ A
+90 IF A<>6 THEN 1/0
+100 CLR
+110 READ A
+120 IF A<>1 THEN 1/0
+130 ONERR GOTO 170
+140 RESTORE 1000
+150 READ A
+160 PRINT "READ PAST THE LAST DATA": END
+170 E=PEEK(218)+256*PEEK(219)
+180 IF E=150 AND PEEK(222)=42 THEN PRINT "DATA INDEX OK"
+190 END
+210 DATA 1,"TWO",3
+220 DATA 4,5
+230 DATA 6
@@ -0,0 +1,33 @@
+10 REM DEF FN PARAMETER FRAMES - ARGUMENTS NEVER LEAK INTO VARIABLES
+20 X = 7
+30 DEF FNA(X) = X * X
+40 IF FNA(3) <> 9 THEN 1/0
+50 IF X <> 7 THEN 1/0
+60 DEF FNB(Y) = Y + 1
+70 IF FNB(4) <> 5 THEN 1/0
+80 IF Y <> 0 THEN 1/0
+90 REM NESTED CALLS WITH THE SAME PARAMETER NAME
+100 DEF FNC(X) = FNA(X + 1) + X
+110 IF FNC(3) <> 19 THEN 1/0
+120 IF X <> 7 THEN 1/0
+130 REM A CALLEE SEES THE CALLER ARGUMENT THROUGH THE VARIABLE
+140 DEF FND(Y) = X * Y
+150 DEF FNE(X) = FND(2)
+160 IF FNE(5) <> 10 THEN 1/0
+170 IF FND(2) <> 14 THEN 1/0
+180 IF X <> 7 OR Y <> 0 THEN 1/0
+190 REM INTEGER PARAMETERS ARE CONVERTED LIKE ASSIGNMENTS
+200 DEF FNI(I%) = I% * 2
+210 IF FNI(2.7) <> 6 THEN 1/0
+220 REM LOOP VARIABLE AS ARGUMENT AND AS PARAMETER
+230 S = 0
+240 FOR X = 1 TO 100: S = S + FNA(X): NEXT X
+250 IF S <> 338350 OR X <> 101 THEN 1/0
+260 REM AN ERROR IN THE BODY DROPS THE FRAME
+270 X = 7: ONERR GOTO 300
+280 Z = FNA(1E30)
+290 GOTO 1
+300 IF X <> 7 THEN 1/0
+310 IF FNA(4) <> 16 THEN 1/0
+320 PRINT "DEF FN FRAMES OK"
+330 END
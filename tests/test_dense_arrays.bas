@@ -0,0 +1,23 @@
+10 REM DENSE ARRAYS - ROW-MAJOR CELLS, TYPED ELEMENTS, SPARSE FALLBACK
+20 DIM A(3,4)
+30 FOR I=0 TO 3: FOR J=0 TO 4: A(I,J)=I*10+J: NEXT J: NEXT I
+40 IF A(2,3)<>23 THEN 1/0
+50 IF A(3,0)<>30 THEN 1/0
+60 A(1,1)=A(1,1)+1: IF A(1,1)<>12 THEN 1/0
+70 DIM B%(5): B%(2)=3.7: B%(3)=-40000
+80 IF B%(2)<>4 THEN 1/0
+90 IF B%(3)<>-32768 THEN 1/0
+100 DIM C$(2): C$(1)="HELLO"
+110 IF C$(0)<>"" THEN 1/0
+120 IF C$(1)<>"HELLO" THEN 1/0
+130 REM AUTO-DIMENSIONED TO 10
+140 D(10)=5: IF D(10)<>5 THEN 1/0
+150 REM TOO LARGE FOR DENSE STORAGE
+160 DIM H(3000,3000): H(2999,17)=9
+170 IF H(2999,17)<>9 THEN 1/0
+180 IF H(0,0)<>0 THEN 1/0
+190 ONERR GOTO 250
+200 X=A(4,0)
+210 PRINT "MISSING BAD SUBSCRIPT": GOTO 1
+250 PRINT "DENSE ARRAYS OK"
+260 END
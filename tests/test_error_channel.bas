@@ -0,0 +1,20 @@
+10 REM ERROR CHANNEL - STATEMENT ERRORS ARE TRAPPED AT THE FAILING STATEMENT
+20 DIM A(5): N = 0: S = 0: I = 9
+30 ONERR GOTO 500
+40 A(I) = 1: S = S + 1
+50 READ X: S = S + 10
+60 GOTO 9999
+70 RETURN
+80 NEXT Q
+90 POP
+100 X = A(7) + 1: S = S + 10
+110 IF 1 THEN GOSUB 9999
+120 WEND
+130 IF N <> 9 OR S <> 1 OR A(2) <> 1 THEN 160
+140 PRINT "ERROR CHANNEL OK"
+150 END
+160 PRINT "ERROR CHANNEL FAILED"
+170 END
+500 N = N + 1: IF N = 1 THEN 600
+510 ON N - 1 GOTO 60, 70, 80, 90, 100, 110, 120, 130
+600 I = 2: RESUME
@@ -0,0 +1,31 @@
+10 REM FOR FRAMES - MULTI VARIABLE NEXT AND APPLESOFT FRAME DROPPING
+20 N = 0
+30 FOR I = 1 TO 3: FOR J = 1 TO 4: N = N + 1: NEXT J,I
+40 IF N <> 12 OR I <> 4 OR J <> 5 THEN 1/0
+50 REM NEXT OF AN OUTER LOOP DROPS THE LOOPS INSIDE IT
+60 ONERR GOTO 900
+70 N = 0: FOR I = 1 TO 3: FOR J = 1 TO 10: N = N + 1: NEXT I
+80 IF N <> 3 THEN 1/0
+90 E = 0: R = 1: NEXT J
+100 IF E <> 1 THEN 1/0
+110 REM A NEW FOR ON AN ACTIVE VARIABLE DROPS THAT LOOP AND INNER ONES
+120 N = 0: FOR I = 1 TO 2: FOR J = 1 TO 2: FOR I = 1 TO 3: N = N + 1: NEXT I
+130 IF N <> 3 THEN 1/0
+140 E = 0: R = 2: NEXT J
+150 IF E <> 1 THEN 1/0
+160 FOR I = 1 TO 5: IF I = 2 THEN 180
+170 NEXT I
+180 FOR I = 1 TO 2: NEXT
+190 E = 0: R = 3: NEXT
+200 IF E <> 1 THEN 1/0
+210 REM NEXT MATCHES THE LOOP VARIABLE BY ITS TWO SIGNIFICANT CHARACTERS
+220 N = 0: FOR COUNT = 1 TO 3: N = N + 1: NEXT CO
+230 IF N <> 3 THEN 1/0
+240 REM HOT LOOPS CLOSED BY ONE NEXT
+250 S = 0: FOR I = 1 TO 50: FOR J = 1 TO 40: S = S + J: NEXT J,I
+260 IF S <> 41000 THEN 1/0
+270 S = 0: FOR I = 1 TO 30: FOR J = 1 TO 3: FOR K = 1 TO 20: S = S + 1: NEXT K,J,I
+280 IF S <> 1800 THEN 1/0
+290 PRINT "FOR FRAMES OK"
+300 END
+900 E = E + 1: ON R GOTO 100, 150, 200
@@ -0,0 +1,12 @@
+10 REM READ REACHING A DATA LINE THAT DOES NOT PARSE (LAZY OR NOT)
+20 ONERR GOTO 100
+30 READ A,B
+40 IF A<>1 OR B<>2 THEN 1/0
+50 READ C
+60 PRINT "READ PAST LINE 210"
+70 END
+100 E=PEEK(218)+256*PEEK(219)
+110 PRINT "ERROR IN LINE ";E
+120 END
+200 DATA 1,2
+210 DATA 3,)
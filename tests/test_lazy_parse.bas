@@ -0,0 +1,12 @@
+10 REM LAZY PARSING - LINES ARE PARSED WHEN THEY FIRST RUN
+20 READ A, B$: IF A <> 42 OR B$ <> "LAZY" THEN 1/0
+30 ONERR GOTO 100
+40 E = 0: GOTO 900
+50 IF E <> 1 THEN 1/0
+60 GOSUB 700: IF S <> 55 THEN 1/0
+70 PRINT "LAZY PARSE OK"
+80 END
+100 E = E + 1: GOTO 50
+700 S = 0: FOR I = 1 TO 10: S = S + I: NEXT I: RETURN
+800 DATA 42, "LAZY"
+900 FOR = 1 TO
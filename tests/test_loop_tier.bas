@@ -0,0 +1,28 @@
+10 REM LOOP TIER - HOT NUMERIC LOOPS MATCH THE INTERPRETER
+20 DIM A(100), B%(10, 10)
+30 FOR I = 0 TO 100: A(I) = SQR(I) / 3: NEXT I
+40 S = 0
+50 FOR I = 100 TO 0 STEP -1
+60 S = S + A(I) * 0.7
+70 IF A(I) > 2 THEN S = S - 1
+80 NEXT I
+90 IF I <> -1 THEN 1/0
+100 IF ABS(S - 92.6747) > 0.001 THEN 1/0
+110 FOR I = 0 TO 10: FOR J = 0 TO 10
+120 B%(I, J) = I * J - 7.6
+130 NEXT J: NEXT I
+140 IF B%(3, 4) <> 4 OR B%(10, 10) <> 92 THEN 1/0
+150 REM BAIL OUT INSIDE A NESTED LOOP AND RESUME IN THE INTERPRETER
+160 ONERR GOTO 300
+170 C = 0
+180 FOR I = 1 TO 40
+190 FOR J = 1 TO 3
+200 C = C + 1
+210 D = 1 / (I - 30)
+220 NEXT J
+230 NEXT I
+240 IF C <> 118 OR E <> 1 THEN 1/0
+250 PRINT "LOOP TIER OK"
+260 END
+300 IF I <> 30 OR J <> 1 THEN 1/0
+310 E = E + 1: I = 31: J = 0: RESUME
@@ -0,0 +1,15 @@
+10 REM RETURN, NEXT, WEND and RESUME continue mid-line
+20 X=0: FOR I=1 TO 10: X=X+I: NEXT: X=X*10
+25 IF X<>550 THEN 1/0
+30 S=0: FOR I=1 TO 2: FOR J=1 TO 3: S=S+I*J: NEXT J: S=S*10: NEXT I
+35 IF S<>720 THEN 1/0
+40 N=0: GOSUB 200: N=N*10: GOSUB 200: N=N*10
+45 IF N<>110 THEN 1/0
+50 K=0: WHILE K<3: K=K+1: WEND: K=K*10
+55 IF K<>30 THEN 1/0
+60 ONERR GOTO 300
+70 D=0: Q=1/D: Q=Q*10
+75 IF Q=5 AND C=1 THEN PRINT "MID LINE RESUME OK"
+80 END
+200 N=N+1: RETURN
+300 C=C+1: D=2: RESUME
@@ -0,0 +1,18 @@
+10 REM PEEK(222) HOLDS THE APPLESOFT NUMBER OF EACH TRAPPED ERROR
+20 DIM C(7)
+30 FOR I=1 TO 7: READ C(I): NEXT I
+40 ONERR GOTO 500
+50 S=1: READ X
+60 S=2: Y=1/0
+70 S=3: RETURN
+80 S=4: Z(20)=1
+90 S=5: GOTO 9999
+100 S=6: NEXT J
+105 S=7: STORE Q
+110 IF F=0 THEN PRINT "ALL ERROR CODES MATCH"
+120 END
+500 E=PEEK(222)
+510 IF E=C(S) THEN 530
+520 F=F+1: PRINT "ERROR ";S;": CODE ";E;" INSTEAD OF ";C(S)
+530 ON S GOTO 60,70,80,90,100,105,110
+900 DATA 42,133,22,107,90,0,107
@@ -0,0 +1,20 @@
+10 REM PARALLEL LOAD - LINES ARE STORED IN FILE ORDER
+20 REM THE MT TEST VARIANT PARSES THIS FILE ON SEVERAL THREADS
+30 GOSUB 500: IF S <> 10 THEN 1/0
+40 GOSUB 600: IF T <> 3 THEN 1/0
+50 IF FNSQ(4) <> 16 THEN 1/0
+60 GOSUB 700: IF A1 + B1 + C1 + D1 + E1 + F1 <> 21 THEN 1/0
+70 GOTO 100
+80 1/0
+100 PRINT "PARALLEL LOAD OK"
+110 END
+500 S = 0: FOR I = 1 TO 4: S = S + I: NEXT I: RETURN
+600 T = 0: WHILE T < 3: T = T + 1: WEND: RETURN
+700 A1 = 1: B1 = 2: C1 = 3
+710 D1 = 4: E1 = 5: F1 = 6: RETURN
+45 DEF FNSQ(X) = X * X
+REM A LINE WITHOUT A NUMBER IS IGNORED
+70 GOTO 80
+80
+70 GOTO 100
+110 END
@@ -0,0 +1,20 @@
+10 REM PRECEDENCE AND ASSOCIATIVITY OF EXPRESSION OPERATORS
+20 A=0: B=5: C=2: T=(1=1)
+30 REM ^ IS RIGHT-ASSOCIATIVE AND BINDS TIGHTER THAN UNARY MINUS
+40 IF 2^3^2<>512 OR (2^3)^2<>64 THEN 1/0
+50 IF -2^2<>-4 OR -C^2<>-4 OR (-2)^2<>4 THEN 1/0
+60 IF 2*3^2<>18 OR 2+3*4^2/8-1<>7 THEN 1/0
+70 REM + - * / ARE LEFT-ASSOCIATIVE
+80 IF 10-4-3<>3 OR 64/4/2<>8 OR 2-C+1<>1 THEN 1/0
+90 REM NOT TAKES THE WHOLE COMPARISON, NOT A=B IS NOT (A=B)
+100 IF (NOT A=B)<>(NOT (A=B)) OR (NOT A=B)=((NOT A)=B) THEN 1/0
+110 IF NOT 1+1<>0 OR NOT C-2<>T THEN 1/0
+120 REM RELATIONAL OPERATORS BIND LOOSER THAN ARITHMETIC
+130 IF (1+2=3)<>T OR (A<B-6)<>0 OR (C*2>B-2)<>T THEN 1/0
+140 IF ((A<B)<C)<>T OR (A<(B>C))<>T OR ((B<A)<A)<>0 THEN 1/0
+150 REM AND BINDS TIGHTER THAN OR, NOT TIGHTER THAN AND
+160 IF (1 OR 0 AND 0)<>T OR (0 AND 0 OR 1)<>T THEN 1/0
+170 IF (NOT 0 AND 0)<>0 OR (NOT (0 AND 0))<>T THEN 1/0
+180 IF (A=0 OR B=0 AND C=0)<>T OR (A=1 AND B=5 OR C=2)<>T THEN 1/0
+190 IF (A=1 AND (B=5 OR C=2))<>0 THEN 1/0
+200 PRINT "PRECEDENCE OK"
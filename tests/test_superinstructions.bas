@@ -0,0 +1,22 @@
+10 REM SUPERINSTRUCTIONS - FUSED STATEMENTS BEHAVE LIKE THE GENERIC ONES
+20 I = 0
+30 I = I + 1: IF I < 5 THEN 30
+40 IF I <> 5 THEN 1/0
+50 I% = 32766: I% = I% + 1: IF I% <> 32767 THEN 1/0
+60 X = 0.1: X = X + 0.2: Y = 0.1: Y = Y + 0.2 + 0: IF X <> Y THEN 1/0
+70 C = 10: C = 1 + C: C = C - 3: IF C <> 8 THEN 1/0
+80 DIM A(5): FOR K = 0 TO 5: A(K) = 5 - K: NEXT K
+90 N = 0: J = 3: M = 0
+100 IF A(N) > A(J) THEN M = M + 1
+105 N = N + 1: IF N < 6 THEN 100
+110 IF M <> 3 THEN 1/0
+120 N = 3: IF A(N) = A(J) THEN M = 0
+130 IF M <> 0 THEN 1/0
+140 IF A(0) < A(5) THEN 1/0
+150 POKE 232, 77: IF PEEK(232) <> 77 THEN 1/0
+160 S$ = "FUSED": PRINT S$;
+170 ONERR GOTO 210
+180 J = 9: IF A(N) > A(J) THEN PRINT "NOT REACHED"
+190 PRINT "MISSING BAD SUBSCRIPT": GOTO 1
+210 PRINT " OK"
+220 END
@@ -0,0 +1,24 @@
+10 REM VALUE STRINGS - INLINE UP TO 14 CHARACTERS, SHARED HEAP TEXT BEYOND
+20 A$="ABCDEFGHIJKLMN": B$=A$+"O"
+30 IF LEN(A$)<>14 OR LEN(B$)<>15 THEN 1/0
+40 IF RIGHT$(B$,2)<>"NO" OR MID$(B$,14,1)<>"N" THEN 1/0
+50 REM COPIES OF A HEAP STRING SHARE IT; CHANGING ONE LEAVES THE OTHERS
+60 C$=B$: D$=C$: C$=C$+"P"
+70 IF D$<>B$ OR LEN(C$)<>16 OR LEN(D$)<>15 THEN 1/0
+80 DIM S$(3): S$(1)=A$: S$(2)=B$: S$(3)=S$(2)
+90 B$="CHANGED"
+100 IF S$(3)<>"ABCDEFGHIJKLMNO" OR S$(2)<>S$(3) THEN 1/0
+110 IF S$(1)<>A$ OR LEN(S$(1))<>14 THEN 1/0
+120 REM SELF-ASSIGNMENT AT AND PAST THE BOUNDARY
+130 S$(2)=S$(2): D$=D$: A$=A$
+140 IF S$(2)<>D$ OR LEN(S$(2))<>15 OR A$<>S$(1) THEN 1/0
+150 REM GROW ACROSS THE BOUNDARY AND SHRINK BACK
+160 E$="ABCDEFGHIJKLM": E$=E$+"N": IF LEN(E$)<>14 OR E$<>A$ THEN 1/0
+170 E$=E$+E$: IF LEN(E$)<>28 OR MID$(E$,14,2)<>"NA" THEN 1/0
+180 E$=LEFT$(E$,14): IF E$<>A$ THEN 1/0
+190 E$=MID$(D$,2,14): IF E$<>"BCDEFGHIJKLMNO" OR LEN(E$)<>14 THEN 1/0
+200 REM COMPARISONS BETWEEN INLINE AND HEAP STRINGS
+210 IF NOT (A$<D$) OR D$<A$ OR A$=D$ THEN 1/0
+220 IF NOT (LEFT$(D$,14)=A$) OR D$<="ABCDEFGHIJKLMN" THEN 1/0
+230 IF "ABCDEFGHIJKLMNP">D$ THEN PRINT "VALUE STRINGS OK"
+240 END
@@ -0,0 +1,196 @@
+/**
+ * @file tokenizer_keywords.cpp
+ * @brief Check that the tokenizer recognizes every keyword
+ *
+ * Every keyword must come out of the perfect hash table as its own token
+ * type, in upper and lower case, and keywords that begin another keyword
+ * (AT and ATN, TO and TAB, ON and ONERR, ...) must not be confused when
+ * they appear in a line.
+ *
+ * Usage: msbasic_tokenizer_keywords
+ */
+
+#include "tokenizer.h"
+#include <cctype>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+struct Expected {
+  const char *word;
+  TokenType type;
+};
+
+/** @brief Every keyword and its token; kept in step with kKeywords */
+const Expected kExpected[] = {
+    {"PRINT", TokenType::PRINT},       {"INPUT", TokenType::INPUT},
+    {"LET", TokenType::LET},           {"IF", TokenType::IF},
+    {"THEN", TokenType::THEN},         {"ELSE", TokenType::ELSE},
+    {"GOTO", TokenType::GOTO},         {"GOSUB", TokenType::GOSUB},
+    {"RETURN", TokenType::RETURN},     {"FOR", TokenType::FOR},
+    {"TO", TokenType::TO},             {"STEP", TokenType::STEP},
+    {"NEXT", TokenType::NEXT},         {"DIM", TokenType::DIM},
+    {"DATA", TokenType::DATA},         {"READ", TokenType::READ},
+    {"RESTORE", TokenType::RESTORE},   {"REM", TokenType::REM},
+    {"END", TokenType::END},           {"NEW", TokenType::NEW},
+    {"RUN", TokenType::RUN},           {"LIST", TokenType::LIST},
+    {"LOAD", TokenType::LOAD},         {"SAVE", TokenType::SAVE},
+    {"CATALOG", TokenType::CATALOG},   {"CONT", TokenType::CONT},
+    {"DEL", TokenType::DEL},           {"DEF", TokenType::DEF},
+    {"FN", TokenType::FN},             {"ONERR", TokenType::ONERR},
+    {"RESUME", TokenType::RESUME},     {"ON", TokenType::ON},
+    {"AT", TokenType::AT},             {"CLR", TokenType::CLR},
+    {"CLEAR", TokenType::CLR},         {"HOME", TokenType::HOME},
+    {"TEXT", TokenType::TEXT},         {"GR", TokenType::GR},
+    {"HIRES", TokenType::HIRES},       {"HGR", TokenType::HGR},
+    {"HGR2", TokenType::HGR2},         {"CALL", TokenType::CALL},
+    {"PEEK", TokenType::PEEK},         {"POKE", TokenType::POKE},
+    {"GET", TokenType::GET},           {"HTAB", TokenType::HTAB},
+    {"VTAB", TokenType::VTAB},         {"INVERSE", TokenType::INVERSE},
+    {"NORMAL", TokenType::NORMAL},     {"FLASH", TokenType::FLASH},
+    {"STOP", TokenType::STOP},         {"PLOT", TokenType::PLOT},
+    {"HLIN", TokenType::HLIN},         {"VLIN", TokenType::VLIN},
+    {"HPLOT", TokenType::HPLOT},       {"XDRAW", TokenType::XDRAW},
+    {"DRAW", TokenType::DRAW},         {"MOVE", TokenType::MOVE},
+    {"ROTATE", TokenType::ROTATE},     {"SCALE", TokenType::SCALE},
+    {"SHLOAD", TokenType::SHLOAD},     {"SIN", TokenType::SIN},
+    {"COS", TokenType::COS},           {"TAN", TokenType::TAN},
+    {"ATN", TokenType::ATN},           {"EXP", TokenType::EXP},
+    {"LOG", TokenType::LOG},           {"SQR", TokenType::SQR},
+    {"ABS", TokenType::ABS},           {"INT", TokenType::INT},
+    {"SGN", TokenType::SGN},           {"RND", TokenType::RND},
+    {"LEN", TokenType::LEN},           {"VAL", TokenType::VAL},
+    {"ASC", TokenType::ASC},           {"CHR$", TokenType::CHR},
+    {"LEFT$", TokenType::LEFT},        {"RIGHT$", TokenType::RIGHT},
+    {"MID$", TokenType::MID},          {"STR$", TokenType::STR},
+    {"TAB", TokenType::TAB},           {"SPC", TokenType::SPC},
+    {"POS", TokenType::POS},           {"FRE", TokenType::FRE},
+    {"PDL", TokenType::PDL},           {"AND", TokenType::AND},
+    {"OR", TokenType::OR},             {"NOT", TokenType::NOT},
+    {"MOD", TokenType::MOD},           {"TRACE", TokenType::TRACE},
+    {"NOTRACE", TokenType::NOTRACE},   {"RANDOMIZE", TokenType::RANDOMIZE},
+    {"SPEED", TokenType::SPEED},       {"PR", TokenType::PR},
+    {"IN", TokenType::IN},             {"WHILE", TokenType::WHILE},
+    {"WEND", TokenType::WEND},         {"POP", TokenType::POP},
+    {"WAIT", TokenType::WAIT},         {"HIMEM", TokenType::HIMEM},
+    {"LOMEM", TokenType::LOMEM},       {"SCRN", TokenType::SCRN},
+    {"RECALL", TokenType::RECALL},     {"STORE", TokenType::STORE},
+    {"TAPE", TokenType::TAPE},         {"DELETE", TokenType::DELETE},
+    {"RENAME", TokenType::RENAME},     {"PREFIX", TokenType::PREFIX},
+    {"OPEN", TokenType::OPEN},         {"CLOSE", TokenType::CLOSE},
+    {"APPEND", TokenType::APPEND},     {"BLOAD", TokenType::BLOAD},
+    {"BRUN", TokenType::BRUN},         {"BSAVE", TokenType::BSAVE},
+    {"CREATE", TokenType::CREATE},     {"FLUSH", TokenType::FLUSH},
+    {"LOCK", TokenType::LOCK},         {"UNLOCK", TokenType::UNLOCK},
+    {"POSITION", TokenType::POSITION}, {"CHAIN", TokenType::CHAIN},
+    {"EXEC", TokenType::EXEC},         {"CAT", TokenType::CAT},
+    {"WRITE", TokenType::PRODOSWRITE}, {"USR", TokenType::USR},
+};
+
+/**
+ * @brief Table entries that are not words: the tokenizer never reads them
+ *        as one token, but isKeyword() and getKeywordType() know them
+ */
+const Expected kSymbols[] = {
+    {"?", TokenType::PRINT},
+    {"COLOR=", TokenType::COLOR},
+    {"HCOLOR=", TokenType::HCOLOR},
+    {"-", TokenType::DASH},
+};
+
+Tokenizer tokenizer;
+int failures = 0;
+
+void check(bool ok, const std::string &what) {
+  if (!ok) {
+    std::cerr << "FAILED: " << what << "\n";
+    ++failures;
+  }
+}
+
+std::vector<TokenType> types(const std::string &line) {
+  std::vector<Value> constants;
+  std::vector<TokenType> result;
+  for (const Token &token : tokenizer.tokenize(line, constants)) {
+    result.push_back(token.type);
+  }
+  return result;
+}
+
+void expectWord(const std::string &word, TokenType type) {
+  check(types(word) == std::vector<TokenType>{type}, word + " as a token");
+  check(tokenizer.isKeyword(word), word + " as a keyword");
+  check(tokenizer.getKeywordType(word) == type, word + " keyword type");
+}
+
+void expectLine(const std::string &line, std::initializer_list<TokenType> want) {
+  check(types(line) == std::vector<TokenType>(want), "line: " + line);
+}
+} // namespace
+
+int main() {
+  for (const Expected &keyword : kExpected) {
+    std::string lower = keyword.word;
+    for (char &c : lower) {
+      c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    expectWord(keyword.word, keyword.type);
+    expectWord(lower, keyword.type);
+  }
+  for (const Expected &symbol : kSymbols) {
+    check(tokenizer.isKeyword(symbol.word) &&
+              tokenizer.getKeywordType(symbol.word) == symbol.type,
+          std::string(symbol.word) + " keyword type");
+  }
+
+  // Words that only begin or extend a keyword are identifiers
+  for (const char *word : {"A", "ATX", "TOP", "ONE", "INX", "PRT", "HGR3",
+                           "FNA", "CHR", "DATUM"}) {
+    check(types(word) == std::vector<TokenType>{TokenType::IDENTIFIER},
+          std::string(word) + " as an identifier");
+    check(!tokenizer.isKeyword(word), std::string(word) + " not a keyword");
+  }
+
+  using T = TokenType;
+  expectLine("PRINT TAB(3);ATN(1)",
+             {T::PRINT, T::TAB, T::LPAREN, T::NUMBER, T::RPAREN,
+              T::SEMICOLON, T::ATN, T::LPAREN, T::NUMBER, T::RPAREN});
+  expectLine("FOR I=1 TO 9 STEP 2",
+             {T::FOR, T::IDENTIFIER, T::EQUAL, T::NUMBER, T::TO, T::NUMBER,
+              T::STEP, T::NUMBER});
+  expectLine("DRAW 1 AT 2,3: XDRAW 1 AT 2,3",
+             {T::DRAW, T::NUMBER, T::AT, T::NUMBER, T::COMMA, T::NUMBER,
+              T::COLON, T::XDRAW, T::NUMBER, T::AT, T::NUMBER, T::COMMA,
+              T::NUMBER});
+  expectLine("ON X GOTO 10: ONERR GOTO 20",
+             {T::ON, T::IDENTIFIER, T::GOTO, T::NUMBER, T::COLON, T::ONERR,
+              T::GOTO, T::NUMBER});
+  expectLine("IN#1: INPUT A: PR#0: PRINT INT(A)",
+             {T::IN, T::HASH, T::NUMBER, T::COLON, T::INPUT, T::IDENTIFIER,
+              T::COLON, T::PR, T::HASH, T::NUMBER, T::COLON, T::PRINT,
+              T::INT, T::LPAREN, T::IDENTIFIER, T::RPAREN});
+  expectLine("HGR: HGR2: GR: HTAB 1: VTAB 2",
+             {T::HGR, T::COLON, T::HGR2, T::COLON, T::GR, T::COLON, T::HTAB,
+              T::NUMBER, T::COLON, T::VTAB, T::NUMBER});
+  expectLine("TRACE: NOTRACE: A=NOT B",
+             {T::TRACE, T::COLON, T::NOTRACE, T::COLON, T::IDENTIFIER,
+              T::EQUAL, T::NOT, T::IDENTIFIER});
+  expectLine("DEL 1,2: DELETE F: CAT: CATALOG",
+             {T::DEL, T::NUMBER, T::COMMA, T::NUMBER, T::COLON, T::DELETE,
+              T::IDENTIFIER, T::COLON, T::CAT, T::COLON, T::CATALOG});
+  expectLine("A$=MID$(B$,POS(0),1)",
+             {T::IDENTIFIER, T::EQUAL, T::MID, T::LPAREN, T::IDENTIFIER,
+              T::COMMA, T::POS, T::LPAREN, T::NUMBER, T::RPAREN, T::COMMA,
+              T::NUMBER, T::RPAREN});
+  expectLine("print atn(1) to tab(2)",
+             {T::PRINT, T::ATN, T::LPAREN, T::NUMBER, T::RPAREN, T::TO,
+              T::TAB, T::LPAREN, T::NUMBER, T::RPAREN});
+
+  if (failures != 0) {
+    return 1;
+  }
+  std::cout << "TOKENIZER KEYWORDS OK\n";
+  return 0;
+}